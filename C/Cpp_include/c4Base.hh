@@ -41,6 +41,7 @@ struct C4Base {
 
 // Forward references to internal LiteCore classes named in the public headers
 namespace litecore {
+    struct BlobChunk;
     class BlobStore;
     class BlobWriteStream;
     class C4CollectionObserverImpl;
@@ -17,9 +17,12 @@
 #include "fleece/function_ref.hh"
 #include "fleece/FLBase.h"
 #include "fleece/InstanceCounted.hh"
+#include <ctime>
 #include <memory>
 #include <optional>
+#include <shared_mutex>
 #include <unordered_set>
+#include <vector>
 
 C4_ASSUME_NONNULL_BEGIN
 
@@ -103,6 +106,9 @@ struct C4ReadStream
     void                   seek(uint64_t pos);
 
   private:
+    friend struct C4BlobStore;
+    explicit C4ReadStream(std::unique_ptr<litecore::SeekableReadStream>);
+
     std::unique_ptr<litecore::SeekableReadStream> _impl;
 };
 
@@ -141,8 +147,13 @@ struct C4BlobStore : C4Base {
     [[nodiscard]] alloc_slice getContents(C4BlobKey) const;
 
     /// The filesystem path of a blob, or nullslice if no blob with that key exists.
+    /// Throws if the blob isn't stored as a plain file (see `isStoredAsFile`.)
     [[nodiscard]] alloc_slice getFilePath(C4BlobKey) const;
 
+    /// True if the blob is stored as a plain unencrypted file, whose path `getFilePath` returns,
+    /// instead of encrypted, compressed or in chunks.
+    [[nodiscard]] bool isStoredAsFile(C4BlobKey) const;
+
     C4BlobKey createBlob(slice contents, const C4BlobKey* C4NULLABLE expectedKey = nullptr);
     void      deleteBlob(C4BlobKey);
 
@@ -157,8 +168,41 @@ struct C4BlobStore : C4Base {
          Otherwise throws an exception if it's unable to return data. */
     alloc_slice getBlobData(FLDict dict) const;
 
+    //---- Chunked blobs (see kC4DB_ChunkedBlobs):
+
+    /// True if new large blobs are stored as content-defined chunks.
+    [[nodiscard]] bool isChunked() const { return _chunked; }
+
+    /// Minimum size of a blob that's stored in chunks.
+    static constexpr uint64_t kMinChunkedBlobSize = 512 * 1024;
+
+    /// If the blob is stored in chunks, returns its encoded manifest listing them
+    /// (see litecore::DecodeChunkManifest.) Otherwise returns nullslice.
+    [[nodiscard]] alloc_slice getChunkManifest(C4BlobKey) const;
+
+    /// True if the store has a chunk with this digest.
+    [[nodiscard]] bool hasChunk(C4BlobKey chunkKey) const;
+
+    /// The contents of a chunk, given its digest. Returns nullslice if there is no such chunk.
+    [[nodiscard]] alloc_slice getChunkContents(C4BlobKey chunkKey) const;
+
+    //---- Compressed blobs (see kC4DB_CompressedBlobs):
+
+    /// True if new compressible blobs are stored compressed.
+    [[nodiscard]] bool isCompressed() const { return _compressed; }
+
+    /// If the blob is stored compressed, returns a stream that reads its data in raw DEFLATE
+    /// format, without decompressing it. Otherwise returns nullptr.
+    [[nodiscard]] std::unique_ptr<C4ReadStream> openCompressedReadStream(C4BlobKey) const;
+
     // Used internally by C4Database:
-    unsigned deleteAllExcept(const std::unordered_set<C4BlobKey>& inUse);
+
+    /// An unreferenced blob installed (or installed again) more recently than this isn't deleted
+    /// by the Housekeeper, since a document that's about to be saved may be going to refer to it.
+    static constexpr time_t kDeletionGracePeriodSecs = 10 * 60;
+
+    [[nodiscard]] bool isRecentlyInstalled(C4BlobKey) const;
+    unsigned           deleteAllExcept(const std::unordered_set<C4BlobKey>& inUse);
     void     copyBlobsTo(C4BlobStore&);
     void     replaceWith(C4BlobStore&);
 
@@ -167,20 +211,40 @@ struct C4BlobStore : C4Base {
 
     C4BlobStore(const C4BlobStore&) = delete;
 
+    // The kinds of files in the store:
+    enum class FileKind { Blob, Manifest, Chunk, Compressed };
+
   protected:
     friend struct C4ReadStream;
     friend struct C4WriteStream;
 
     [[nodiscard]] litecore::FilePath                            dir() const;
-    [[nodiscard]] litecore::FilePath                            pathForKey(C4BlobKey) const;
+    [[nodiscard]] litecore::FilePath pathForKey(C4BlobKey, FileKind = FileKind::Blob) const;
+    [[nodiscard]] litecore::FilePath existingPathForKey(C4BlobKey, FileKind = FileKind::Blob) const;
     [[nodiscard]] std::unique_ptr<litecore::SeekableReadStream> getReadStream(C4BlobKey) const;
     std::unique_ptr<litecore::BlobWriteStream>                  getWriteStream();
     C4BlobKey install(litecore::BlobWriteStream*, const C4BlobKey* C4NULLABLE expectedKey);
 
   private:
+    [[nodiscard]] litecore::FilePath flatPathForKey(C4BlobKey, FileKind) const;
+    [[nodiscard]] litecore::FilePath shardedPathForKey(C4BlobKey, FileKind) const;
+    [[nodiscard]] std::unique_ptr<litecore::SeekableReadStream> openFile(const litecore::FilePath&) const;
+    [[nodiscard]] std::optional<std::vector<litecore::BlobChunk>> readManifest(C4BlobKey) const;
+    void installFile(litecore::BlobWriteStream*, C4BlobKey, FileKind);
+    void installChunked(litecore::BlobWriteStream*, C4BlobKey);
+    bool installCompressed(litecore::BlobWriteStream*, C4BlobKey);
+    [[nodiscard]] bool blobExists(C4BlobKey) const;
+    bool               touchBlob(C4BlobKey);
+    void forEachBlob(fleece::function_ref<void(const litecore::FilePath&, C4BlobKey, FileKind)>) const;
+    void moveFlatBlobsIntoShards();
+
     std::string const _dirPath;
     C4DatabaseFlags   _flags;
     C4EncryptionKey   _encryptionKey;
+    bool              _sharded{false};     // Are blobs stored in subdirectories? (see kC4DB_ShardedBlobs)
+    bool              _chunked{false};     // Are new large blobs stored in chunks? (see kC4DB_ChunkedBlobs)
+    bool              _compressed{false};  // Are new blobs stored compressed? (see kC4DB_CompressedBlobs)
+    std::shared_mutex _chunkMutex;         // Shared by `installChunked`, exclusive in `deleteAllExcept`
 };
 
 namespace std {
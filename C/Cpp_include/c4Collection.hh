@@ -76,6 +76,13 @@ struct C4Collection
     virtual Retained<C4Document> createDocument(slice docID, slice revBody, C4RevisionFlags revFlags,
                                                 C4Error* outError) = 0;
 
+    /// Performs multiple `putDocument` operations. Docs that don't exist yet are inserted without
+    /// being read first, and the rest are read in one batch, so this is faster than a loop.
+    /// Returns one doc per request, in order; a null doc means that request failed, and its error
+    /// is stored in the corresponding item of `outErrors`, which must have room for `count` items.
+    virtual std::vector<Retained<C4Document>> putDocuments(const C4DocPutRequest* requests, size_t count,
+                                                           C4Error* outErrors) = 0;
+
     // Moves a document to another collection
     virtual void moveDocument(slice docID, C4Collection* toCollection, slice newDocID = fleece::nullslice) = 0;
 
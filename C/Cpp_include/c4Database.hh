@@ -54,6 +54,7 @@ struct C4Database
     static void copyNamed(slice sourcePath, slice destinationName, const Config&);
     static bool deleteNamed(slice name, slice inDirectory);
     static bool deleteAtPath(slice path);
+    static void repackDocumentKeys(slice name, const Config&);
 
     static Retained<C4Database> openNamed(slice name, const Config&);
 
@@ -61,12 +62,17 @@ struct C4Database
 
     static void shutdownLiteCore();
 
+    static void         setCacheBudget(int64_t bytes);
+    static C4CacheUsage getCacheUsage(bool resetPeak = false);
+
     Retained<C4Database> openAgain() const { return openNamed(getName(), getConfiguration()); }
 
-    virtual void close()                                      = 0;
-    virtual void closeAndDeleteFile()                         = 0;
-    virtual void rekey(const C4EncryptionKey* C4NULLABLE key) = 0;
-    virtual void maintenance(C4MaintenanceType)               = 0;
+    virtual void                close()                                      = 0;
+    virtual void                closeAndDeleteFile()                         = 0;
+    virtual void                rekey(const C4EncryptionKey* C4NULLABLE key) = 0;
+    virtual void                maintenance(C4MaintenanceType)               = 0;
+    virtual C4MaintenanceStats  getMaintenanceStats() const                  = 0;
+    virtual C4DocumentKeysStats getDocumentKeysStats() const                 = 0;
 
     // Attributes:
 
@@ -188,6 +194,9 @@ struct C4Database
 
     virtual bool isInTransaction() const noexcept FLPURE = 0;
 
+    virtual void beginBulkImport() = 0;
+    virtual void endBulkImport()   = 0;
+
     // Raw Documents:
 
     static constexpr slice kInfoStore = "info";  /// Raw-document store used for db metadata.
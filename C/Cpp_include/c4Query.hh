@@ -51,6 +51,10 @@ struct C4Query final
     alloc_slice parameters() const noexcept;
     void        setParameters(slice parameters);
 
+    /// If true, the query may use lazy indexes that haven't caught up with recent changes,
+    /// instead of waiting for them to be updated before it runs.
+    void setAllowStaleIndexes(bool allow);
+
     alloc_slice fullTextMatched(const C4FullTextMatch&);
 
     // Running the query:
@@ -119,6 +123,9 @@ struct C4Query final
 
     Retained<litecore::DatabaseImpl>         _database;
     Retained<litecore::Query>                _query;
+    alloc_slice                              _expression;    // For compiling on pooled connections
+    C4QueryLanguage                          _language;      // ditto
+    std::string                              _keyStoreName;  // ditto
     alloc_slice                              _parameters;
     Retained<litecore::LiveQuerier>          _bgQuerier;
     std::unique_ptr<LiveQuerierDelegate>     _bgQuerierDelegate;
@@ -225,6 +225,8 @@ void c4log_enableFatalExceptionBacktrace() C4API {
 
 void c4log_flushLogFiles() C4API { LogDomain::flushLogFiles(); }
 
+void c4log_setAsynchronous(bool async) C4API { LogDomain::setAsynchronous(async); }
+
 void c4log(C4LogDomain c4Domain, C4LogLevel level, const char* fmt, ...) noexcept {
     va_list args;
     va_start(args, fmt);
@@ -234,7 +236,14 @@ void c4log(C4LogDomain c4Domain, C4LogLevel level, const char* fmt, ...) noexcep
 
 void c4vlog(C4LogDomain c4Domain, C4LogLevel level, const char* fmt, va_list args) noexcept {
     try {
-        ((LogDomain*)c4Domain)->vlog((LogLevel)level, fmt, args);
+        auto domain = (LogDomain*)c4Domain;
+        if ( LogDomain::isAsynchronous() ) {
+            // A queued message is formatted later, but the client's format string may not live
+            // that long; so format the message now and queue it with a constant format.
+            if ( domain->willLog((LogLevel)level) ) domain->log((LogLevel)level, "%s", vformat(fmt, args).c_str());
+        } else {
+            domain->vlog((LogLevel)level, fmt, args);
+        }
     } catch ( ... ) {}
 }
 
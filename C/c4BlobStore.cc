@@ -15,13 +15,17 @@
 #include "c4Document+Fleece.h"
 #include "BlobStreams.hh"
 #include "Base64.hh"
+#include "Codec.hh"
 #include "EncryptedStream.hh"
 #include "Error.hh"
 #include "FilePath.hh"
 #include "Logging.hh"
+#include "PlatformIO.hh"
 #include "StringUtil.hh"
 #include "fleece/Fleece.hh"
 #include <array>
+#include <cinttypes>
+#include <ctime>
 
 using namespace std;
 using namespace fleece;
@@ -37,9 +41,11 @@ namespace C4Blob {
 static constexpr slice kBlobDigestStringPrefix = "sha1-",  // prefix of ASCII form of blob key ("digest" property)
         kBlobFilenameSuffix                    = ".blob";  // suffix of blob files in the store
 
+// Suffixes of the files of chunked and compressed blobs, indexed by FileKind:
+static constexpr slice kFilenameSuffixes[] = {kBlobFilenameSuffix, ".chunks", ".chunk", ".blobz"};
+
 static constexpr size_t kBlobDigestStringLength =
-                                ((sizeof(C4BlobKey::bytes) + 2) / 3) * 4,  // Length of base64 w/o prefix
-        kBlobFilenameLength = kBlobDigestStringLength + kBlobFilenameSuffix.size;
+        ((sizeof(C4BlobKey::bytes) + 2) / 3) * 4;  // Length of base64 w/o prefix
 
 static SHA1& digest(C4BlobKey& key) { return (SHA1&)key.bytes; }
 
@@ -69,16 +75,24 @@ std::optional<C4BlobKey> C4BlobKey::withDigestString(slice base64String) {
     return BlobKeyFromBase64(base64String);
 }
 
-static string BlobKeyToFilename(const C4BlobKey& key) {
+using FileKind = C4BlobStore::FileKind;
+
+static string BlobKeyToFilename(const C4BlobKey& key, FileKind kind = FileKind::Blob) {
     // Change '/' characters in the base64 into '_':
     string str = digest(key).asBase64();
     replace(str.begin(), str.end(), '/', '_');
-    str.append(kBlobFilenameSuffix);
+    slice suffix = kFilenameSuffixes[int(kind)];
+    str.append((const char*)suffix.buf, suffix.size);
     return str;
 }
 
-static optional<C4BlobKey> BlobKeyFromFilename(slice filename) {
-    if ( filename.size != kBlobFilenameLength || !filename.hasSuffix(kBlobFilenameSuffix) ) return nullopt;
+static optional<C4BlobKey> BlobKeyFromFilename(slice filename, FileKind* outKind = nullptr) {
+    size_t kind = 0;
+    while ( filename.size != kBlobDigestStringLength + kFilenameSuffixes[kind].size
+            || !filename.hasSuffix(kFilenameSuffixes[kind]) ) {
+        if ( ++kind == std::size(kFilenameSuffixes) ) return nullopt;
+    }
+    if ( outKind ) *outKind = FileKind(kind);
     // Change '_' back into '/' for base64:
     char base64buf[kBlobDigestStringLength];
     memcpy(base64buf, filename.buf, sizeof(base64buf));
@@ -88,8 +102,48 @@ static optional<C4BlobKey> BlobKeyFromFilename(slice filename) {
 
 #pragma mark - C4BLOBSTORE METHODS:
 
+/*  BLOB STORE LAYOUT:
+
+    By default all blob files are in one directory. With kC4DB_ShardedBlobs they're instead in
+    two levels of subdirectories named by the first two bytes of the key in hex, e.g. "3f/a0/",
+    so no directory gets too large. The layout is a property of the store, not of the opener:
+    once a store is sharded it has a marker file, and is treated as sharded from then on.
+
+    Converting a flat store to sharded writes the marker, then moves the files. If that's
+    interrupted, the rest are moved the next time the store is opened; meanwhile, lookups
+    that miss check the other layout too.
+
+    With kC4DB_ChunkedBlobs, new blobs of at least kMinChunkedBlobSize are split into
+    content-defined chunks (see BlobChunker.) Each chunk is stored once, in a ".chunk" file
+    named by its own digest, and the blob is a ".chunks" manifest listing its chunks. Chunks are
+    shared by all blobs that contain them, so they're only deleted by `deleteAllExcept`. An install
+    that reuses a chunk holds `_chunkMutex` shared until its manifest exists, and touches the chunk
+    so that another process's C4BlobStore won't sweep it within the deletion grace period.
+
+    With kC4DB_CompressedBlobs, other new blobs of at least kMinCompressedBlobSize are stored
+    in ".blobz" files, in DEFLATE format (see CompressedBlobReadStream), if that makes them
+    small enough. Encrypted stores don't compress blobs. */
+
+// Smaller blobs would be only one or two chunks:
+static_assert(C4BlobStore::kMinChunkedBlobSize >= 2 * BlobChunker::kMaxChunkSize);
+
+// Smaller blobs aren't worth compressing, since they take up a filesystem block anyway:
+static constexpr uint64_t kMinCompressedBlobSize = 4096;
+
+// A blob is stored compressed only if that makes it at most this fraction of its size:
+static constexpr double kMaxCompressedRatio = 0.9;
+
+// Amount of data compressed at a time:
+static constexpr size_t kCompressionBufferSize = 64 * 1024;
+
+static constexpr const char* kShardedMarkerFilename = "_sharded";
+
 C4BlobStore::C4BlobStore(slice dirPath, C4DatabaseFlags flags, const C4EncryptionKey& key)
-    : _dirPath(dirPath), _flags(flags), _encryptionKey(key) {
+    : _dirPath(dirPath)
+    , _flags(flags)
+    , _encryptionKey(key)
+    , _chunked(flags & kC4DB_ChunkedBlobs)
+    , _compressed((flags & kC4DB_CompressedBlobs) && key.algorithm == kC4EncryptionNone) {
     FilePath dir(_dirPath, "");
     if ( dir.exists() ) {
         dir.mustExistAsDir();
@@ -97,6 +151,18 @@ C4BlobStore::C4BlobStore(slice dirPath, C4DatabaseFlags flags, const C4Encryptio
         if ( !(flags & kC4DB_Create) ) error::_throw(error::NotFound);
         dir.mkdir();
     }
+
+    FilePath marker(_dirPath, kShardedMarkerFilename);
+    _sharded = marker.exists();
+    if ( !(flags & kC4DB_ReadOnly) ) {
+        if ( !_sharded && (flags & kC4DB_ShardedBlobs) ) {
+            FILE* f = fopen_u8(marker.path().c_str(), "w");
+            if ( !f ) error::_throwErrno("Couldn't create %s", marker.path().c_str());
+            fclose(f);
+            _sharded = true;
+        }
+        if ( _sharded ) moveFlatBlobsIntoShards();
+    }
 }
 
 C4BlobStore::~C4BlobStore() = default;
@@ -105,30 +171,150 @@ void C4BlobStore::deleteStore() { dir().delRecursive(); }
 
 FilePath C4BlobStore::dir() const { return {_dirPath, ""}; }
 
-FilePath C4BlobStore::pathForKey(C4BlobKey key) const { return {_dirPath, BlobKeyToFilename(key)}; }
+FilePath C4BlobStore::flatPathForKey(C4BlobKey key, FileKind kind) const {
+    return {_dirPath, BlobKeyToFilename(key, kind)};
+}
+
+FilePath C4BlobStore::shardedPathForKey(C4BlobKey key, FileKind kind) const {
+    char shard[7];
+    snprintf(shard, sizeof(shard), "%02x/%02x/", key.bytes[0], key.bytes[1]);
+    return {_dirPath + shard, BlobKeyToFilename(key, kind)};
+}
+
+// The path where a file with this key belongs.
+FilePath C4BlobStore::pathForKey(C4BlobKey key, FileKind kind) const {
+    return _sharded ? shardedPathForKey(key, kind) : flatPathForKey(key, kind);
+}
+
+// The path where a file with this key is, if it's in the other layout because of an
+// interrupted conversion, or because another C4BlobStore instance converted the store.
+FilePath C4BlobStore::existingPathForKey(C4BlobKey key, FileKind kind) const {
+    FilePath path = pathForKey(key, kind);
+    if ( !path.exists() ) {
+        FilePath otherPath = _sharded ? flatPathForKey(key, kind) : shardedPathForKey(key, kind);
+        if ( otherPath.exists() ) return otherPath;
+    }
+    return path;
+}
+
+void C4BlobStore::moveFlatBlobsIntoShards() {
+    unsigned count = 0;
+    dir().forEachFile([&](const FilePath& path) {
+        if ( path.isDir() ) return;
+        FileKind kind;
+        if ( auto key = BlobKeyFromFilename(path.fileName(), &kind); key ) {
+            FilePath dst = shardedPathForKey(*key, kind);
+            dst.parentDir().parentDir().mkdir();
+            dst.parentDir().mkdir();
+            if ( dst.exists() ) path.del();
+            else
+                path.moveTo(dst);
+            ++count;
+        }
+    });
+    if ( count > 0 ) LogTo(DBLog, "Moved %u blobs into subdirectories of %s", count, _dirPath.c_str());
+}
+
+// Calls the callback for every file in the store, in either layout.
+void C4BlobStore::forEachBlob(function_ref<void(const FilePath&, C4BlobKey, FileKind)> callback) const {
+    auto visit = [&](const FilePath& path) {
+        const string& filename = path.fileName();
+        FileKind      kind;
+        if ( auto key = BlobKeyFromFilename(filename, &kind); key ) callback(path, *key, kind);
+        else if ( filename != kShardedMarkerFilename )
+            Warn("Skipping unknown file '%s' in Attachments directory", filename.c_str());
+    };
+    dir().forEachFile([&](const FilePath& path) {
+        if ( !path.isDir() ) {
+            visit(path);
+        } else if ( path.fileOrDirName().size() == 2 ) {
+            path.forEachFile([&](const FilePath& subdir) {
+                if ( subdir.isDir() ) subdir.forEachFile(visit);
+            });
+        }
+    });
+}
 
 alloc_slice C4BlobStore::getFilePath(C4BlobKey key) const {
-    FilePath path = pathForKey(key);
-    if ( !path.exists() ) return nullslice;
-    else if ( isEncrypted() )
+    FilePath path = existingPathForKey(key);
+    if ( !path.exists() ) {
+        if ( existingPathForKey(key, FileKind::Manifest).exists() )
+            error::_throw(error::UnsupportedOperation, "Blob is stored in chunks, not as a file");
+        if ( existingPathForKey(key, FileKind::Compressed).exists() )
+            error::_throw(error::UnsupportedOperation, "Blob is stored compressed, not as a plain file");
+        return nullslice;
+    } else if ( isEncrypted() )
         error::_throw(error::WrongFormat);
     else
         return alloc_slice(path);
 }
 
+bool C4BlobStore::isStoredAsFile(C4BlobKey key) const { return !isEncrypted() && existingPathForKey(key).exists(); }
+
 int64_t C4BlobStore::getSize(C4BlobKey key) const {
     int64_t length = pathForKey(key).dataSize();
+    if ( length < 0 ) length = existingPathForKey(key).dataSize();
+    if ( length < 0 ) {
+        if ( FilePath path = existingPathForKey(key, FileKind::Compressed); path.exists() )
+            return int64_t(CompressedBlobReadStream::readHeader(*openFile(path)));
+        if ( auto chunks = readManifest(key); chunks ) return int64_t(TotalChunkLength(*chunks));
+    }
     if ( length >= 0 && isEncrypted() ) length -= EncryptedReadStream::kFileSizeOverhead;
     return length;
 }
 
+// Returns the chunks of a chunked blob, or nullopt if there's no manifest for it.
+optional<vector<BlobChunk>> C4BlobStore::readManifest(C4BlobKey key) const {
+    alloc_slice manifest = getChunkManifest(key);
+    if ( !manifest ) return nullopt;
+    auto chunks = DecodeChunkManifest(manifest);
+    if ( !chunks ) error::_throw(error::CorruptData, "Invalid blob chunk manifest");
+    return chunks;
+}
+
+alloc_slice C4BlobStore::getChunkManifest(C4BlobKey key) const {
+    FilePath path = existingPathForKey(key, FileKind::Manifest);
+    if ( !path.exists() ) return nullslice;
+    return openFile(path)->readAll();
+}
+
+bool C4BlobStore::hasChunk(C4BlobKey chunkKey) const {
+    return existingPathForKey(chunkKey, FileKind::Chunk).exists();
+}
+
+alloc_slice C4BlobStore::getChunkContents(C4BlobKey chunkKey) const {
+    FilePath path = existingPathForKey(chunkKey, FileKind::Chunk);
+    if ( !path.exists() ) return nullslice;
+    return openFile(path)->readAll();
+}
+
 alloc_slice C4BlobStore::getContents(C4BlobKey key) const {
     auto reader = getReadStream(key);
     return reader->readAll();
 }
 
 unique_ptr<SeekableReadStream> C4BlobStore::getReadStream(C4BlobKey key) const {
-    return OpenBlobReadStream(pathForKey(key), litecore::EncryptionAlgorithm(_encryptionKey.algorithm),
+    FilePath path = existingPathForKey(key);
+    if ( !path.exists() ) {
+        if ( FilePath zpath = existingPathForKey(key, FileKind::Compressed); zpath.exists() )
+            return make_unique<CompressedBlobReadStream>(openFile(zpath));
+        if ( auto chunks = readManifest(key); chunks ) {
+            return make_unique<ChunkedBlobReadStream>(std::move(*chunks), [this](const C4BlobKey& chunkKey) {
+                return openFile(existingPathForKey(chunkKey, FileKind::Chunk));
+            });
+        }
+    }
+    return openFile(path);
+}
+
+unique_ptr<C4ReadStream> C4BlobStore::openCompressedReadStream(C4BlobKey key) const {
+    FilePath path = existingPathForKey(key, FileKind::Compressed);
+    if ( !path.exists() ) return nullptr;
+    return unique_ptr<C4ReadStream>(new C4ReadStream(CompressedBlobReadStream::openCompressedData(openFile(path))));
+}
+
+unique_ptr<SeekableReadStream> C4BlobStore::openFile(const FilePath& path) const {
+    return OpenBlobReadStream(path, litecore::EncryptionAlgorithm(_encryptionKey.algorithm),
                               slice(&_encryptionKey.bytes, sizeof(_encryptionKey.bytes)));
 }
 
@@ -173,44 +359,186 @@ C4BlobKey C4BlobStore::install(BlobWriteStream* writer, const C4BlobKey* expecte
     writer->close();
     C4BlobKey key = writer->computeKey();
     if ( expectedKey && *expectedKey != key ) error::_throw(error::CorruptData);
-    writer->install(pathForKey(key));
+    uint64_t size     = writer->bytesWritten();
+    bool     chunk    = _chunked && size >= kMinChunkedBlobSize;
+    bool     compress = !chunk && _compressed && size >= kMinCompressedBlobSize;
+    if ( (chunk || compress) && touchBlob(key) ) writer->discard();
+    else if ( chunk )
+        installChunked(writer, key);
+    else if ( !compress || !installCompressed(writer, key) )
+        installFile(writer, key, FileKind::Blob);
     return key;
 }
 
-void C4BlobStore::deleteBlob(C4BlobKey key) { pathForKey(key).del(); }
+// True if the blob exists in any form.
+bool C4BlobStore::blobExists(C4BlobKey key) const {
+    for ( auto kind : {FileKind::Blob, FileKind::Compressed, FileKind::Manifest} ) {
+        if ( existingPathForKey(key, kind).exists() ) return true;
+    }
+    return false;
+}
+
+// If the blob exists, sets its modification time to now (restarting its deletion grace period.)
+bool C4BlobStore::touchBlob(C4BlobKey key) {
+    time_t now = time(nullptr);
+    for ( auto kind : {FileKind::Blob, FileKind::Compressed, FileKind::Manifest} ) {
+        if ( existingPathForKey(key, kind).setLastModified(now) ) return true;
+    }
+    return false;
+}
+
+bool C4BlobStore::isRecentlyInstalled(C4BlobKey key) const {
+    time_t cutoff = time(nullptr) - kDeletionGracePeriodSecs;
+    for ( auto kind : {FileKind::Blob, FileKind::Compressed, FileKind::Manifest} ) {
+        if ( existingPathForKey(key, kind).lastModified() > cutoff ) return true;
+    }
+    return false;
+}
+
+void C4BlobStore::installFile(BlobWriteStream* writer, C4BlobKey key, FileKind kind) {
+    FilePath path = pathForKey(key, kind);
+    if ( _sharded ) {
+        // Another thread may be creating the same directories; mkdir ignores that.
+        path.parentDir().parentDir().mkdir();
+        path.parentDir().mkdir();
+    }
+    writer->install(path);
+}
+
+// Stores a new blob as chunks plus a manifest, reading it back from the writer's temporary file.
+void C4BlobStore::installChunked(BlobWriteStream* writer, C4BlobKey key) {
+    // Keep `deleteAllExcept` from deleting chunks this blob reuses before its manifest exists:
+    shared_lock<shared_mutex> lock(_chunkMutex);
+    auto              src = openFile(writer->tempPath());
+    vector<BlobChunk> chunks;
+    alloc_slice       buffer(2 * BlobChunker::kMaxChunkSize);
+    size_t            bufferUsed = 0;
+    bool              atEOF      = false;
+    unsigned          newChunks  = 0;
+    while ( true ) {
+        if ( !atEOF ) {
+            size_t n = src->read((uint8_t*)buffer.buf + bufferUsed, buffer.size - bufferUsed);
+            bufferUsed += n;
+            atEOF = (bufferUsed < buffer.size);
+        }
+        if ( bufferUsed == 0 ) break;
+        slice  data(buffer.buf, bufferUsed);
+        size_t length = BlobChunker::nextChunkLength(data, atEOF);
+        Assert(length > 0);  // buffer holds at least one maximum-size chunk
+        slice     chunk(data.buf, length);
+        C4BlobKey chunkKey = C4BlobKey::computeDigestOfContent(chunk);
+        // Touching a chunk we share tells a concurrent `deleteAllExcept` in another process to leave
+        // it alone; if it's already gone, write it again.
+        if ( !existingPathForKey(chunkKey, FileKind::Chunk).setLastModified(time(nullptr)) ) {
+            auto chunkWriter = getWriteStream();
+            chunkWriter->write(chunk);
+            installFile(chunkWriter.get(), chunkKey, FileKind::Chunk);
+            ++newChunks;
+        }
+        chunks.push_back({chunkKey, uint32_t(length)});
+        memmove((void*)buffer.buf, data.offset(length), bufferUsed - length);
+        bufferUsed -= length;
+    }
+    src->close();
+
+    // Installing the manifest last makes the blob visible only once all its chunks exist:
+    auto manifestWriter = getWriteStream();
+    manifestWriter->write(EncodeChunkManifest(chunks));
+    installFile(manifestWriter.get(), key, FileKind::Manifest);
+    writer->discard();
+    LogToAt(DBLog, Verbose, "Stored blob %s as %zu chunks (%u new)", key.digestString().c_str(), chunks.size(),
+            newChunks);
+}
+
+// Stores a new blob compressed, reading it back from the writer's temporary file. Returns false,
+// without storing it, if it doesn't compress well.
+bool C4BlobStore::installCompressed(BlobWriteStream* writer, C4BlobKey key) {
+    uint64_t       length = writer->bytesWritten();
+    auto           src    = openFile(writer->tempPath());
+    auto           dst    = getWriteStream();
+    blip::Deflater deflater;
+    alloc_slice    inBuffer(kCompressionBufferSize), outBuffer(2 * kCompressionBufferSize);
+    dst->write(CompressedBlobReadStream::encodeHeader(length));
+    uint64_t bytesRead = 0;
+    size_t   n;
+    while ( (n = src->read((void*)inBuffer.buf, inBuffer.size)) > 0 ) {
+        bytesRead += n;
+        slice_istream input(inBuffer.buf, n);
+        do {
+            slice_ostream output((void*)outBuffer.buf, outBuffer.size);
+            deflater.write(input, output, blip::Codec::Mode::SyncFlush);
+            dst->write(output.output());
+        } while ( input.size > 0 || deflater.unflushedBytes() > 0 );
+        // Stop as soon as it's clear the data doesn't compress well:
+        if ( double(dst->bytesWritten()) > double(bytesRead) * kMaxCompressedRatio ) {
+            LogToAt(DBLog, Verbose, "Blob %s is not compressible; storing it uncompressed",
+                    key.digestString().c_str());
+            return false;
+        }
+    }
+    src->close();
+
+    LogToAt(DBLog, Verbose, "Stored blob %s compressed from %" PRIu64 " to %" PRIu64 " bytes",
+            key.digestString().c_str(), length, dst->bytesWritten());
+    installFile(dst.get(), key, FileKind::Compressed);
+    writer->discard();
+    return true;
+}
+
+void C4BlobStore::deleteBlob(C4BlobKey key) {
+    // (A blob could be in both layouts, if installed by a C4BlobStore unaware of a conversion.)
+    // The chunks of a chunked blob may be shared, so they're left for `deleteAllExcept`.
+    for ( auto kind : {FileKind::Blob, FileKind::Compressed, FileKind::Manifest} ) {
+        shardedPathForKey(key, kind).del();
+        flatPathForKey(key, kind).del();
+    }
+}
 
 #pragma mark - HOUSEKEEPING:
 
 unsigned C4BlobStore::deleteAllExcept(const unordered_set<C4BlobKey>& inUse) {
-    unsigned numDeleted = 0;
-    dir().forEachFile([&](const FilePath& path) {
-        const string& filename = path.fileName();
-        if ( auto key = BlobKeyFromFilename(filename); key ) {
-            if ( find(inUse.cbegin(), inUse.cend(), *key) == inUse.cend() ) {
-                ++numDeleted;
-                LogToAt(DBLog, Verbose, "Deleting unused blob '%s", filename.c_str());
-                path.del();
+    unique_lock<shared_mutex>         lock(_chunkMutex);
+    time_t                            chunkCutoff = time(nullptr) - kDeletionGracePeriodSecs;
+    unsigned                          numDeleted  = 0;
+    unordered_set<C4BlobKey>          chunksInUse;
+    vector<pair<FilePath, C4BlobKey>> chunkFiles;
+    forEachBlob([&](const FilePath& path, C4BlobKey key, FileKind kind) {
+        if ( kind == FileKind::Chunk ) {
+            chunkFiles.emplace_back(path, key);  // can't tell if it's used until all manifests are read
+        } else if ( inUse.find(key) == inUse.end() ) {
+            ++numDeleted;
+            LogToAt(DBLog, Verbose, "Deleting unused blob '%s", path.fileName().c_str());
+            path.del();
+        } else if ( kind == FileKind::Manifest ) {
+            auto chunks = DecodeChunkManifest(openFile(path)->readAll());
+            if ( chunks ) {
+                for ( auto& chunk : *chunks ) chunksInUse.insert(chunk.key);
+            } else {
+                Warn("Invalid blob chunk manifest '%s'", path.fileName().c_str());
             }
-        } else {
-            Warn("Skipping unknown file '%s' in Attachments directory", filename.c_str());
         }
     });
+    for ( auto& [path, key] : chunkFiles ) {
+        // A recently touched chunk may be in use by an install in another process that hasn't
+        // written its manifest yet (file times have only one-second resolution, so the sweep's
+        // start time isn't a safe cutoff.) Give it the same grace period as unreferenced blobs:
+        if ( chunksInUse.find(key) == chunksInUse.end() && path.lastModified() <= chunkCutoff ) {
+            LogToAt(DBLog, Verbose, "Deleting unused blob chunk '%s", path.fileName().c_str());
+            path.del();
+        }
+    }
     return numDeleted;
 }
 
 void C4BlobStore::copyBlobsTo(C4BlobStore& toStore) {
-    dir().forEachFile([&](const FilePath& path) {
-        const string& filename = path.fileName();
-        if ( auto key = BlobKeyFromFilename(filename); key ) {
-            auto    src = getReadStream(*key);
-            auto    dst = toStore.getWriteStream();
-            uint8_t buffer[4096];
-            size_t  bytesRead;
-            while ( (bytesRead = src->read(buffer, sizeof(buffer))) > 0 ) { dst->write(slice(buffer, bytesRead)); }
-            toStore.install(dst.get(), &*key);
-        } else {
-            Warn("Skipping unknown file '%s' in Attachments directory", filename.c_str());
-        }
+    forEachBlob([&](const FilePath&, C4BlobKey key, FileKind kind) {
+        if ( kind == FileKind::Chunk ) return;  // chunks are copied as part of their blobs
+        auto    src = getReadStream(key);
+        auto    dst = toStore.getWriteStream();
+        uint8_t buffer[4096];
+        size_t  bytesRead;
+        while ( (bytesRead = src->read(buffer, sizeof(buffer))) > 0 ) { dst->write(slice(buffer, bytesRead)); }
+        toStore.install(dst.get(), &key);
     });
 }
 
@@ -218,12 +546,17 @@ void C4BlobStore::replaceWith(C4BlobStore& other) {
     other.dir().moveToReplacingDir(dir(), true);
     _flags         = other._flags;
     _encryptionKey = other._encryptionKey;
+    _sharded       = other._sharded;
+    _chunked       = other._chunked;
+    _compressed    = other._compressed;
 }
 
 #pragma mark - STREAMS:
 
 C4ReadStream::C4ReadStream(const C4BlobStore& store, C4BlobKey key) : _impl(store.getReadStream(key)) {}
 
+C4ReadStream::C4ReadStream(unique_ptr<SeekableReadStream> impl) : _impl(std::move(impl)) {}
+
 C4ReadStream::C4ReadStream(C4ReadStream&& other) noexcept : _impl(std::move(other._impl)) {}
 
 C4ReadStream::~C4ReadStream() = default;
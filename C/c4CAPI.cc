@@ -281,6 +281,15 @@ C4Document* c4coll_putDoc(C4Collection* coll, const C4DocPutRequest* rq, size_t*
                                  [&] { return coll->putDocument(*rq, outCommonAncestorIndex, outError).detach(); });
 }
 
+bool c4coll_putDocs(C4Collection* coll, const C4DocPutRequest requests[], size_t count, C4Document* outDocs[],
+                    C4Error outErrors[], C4Error* C4NULLABLE outError) noexcept {
+    returnIfCollectionInvalid(coll, outError, false);
+    return tryCatch(outError, [&] {
+        auto docs = coll->putDocuments(requests, count, outErrors);
+        for ( size_t i = 0; i < count; ++i ) outDocs[i] = docs[i].detach();
+    });
+}
+
 C4Document* c4coll_createDoc(C4Collection* coll, C4String docID, C4Slice revBody, C4RevisionFlags revFlags,
                              C4Error* C4NULLABLE outError) noexcept {
     returnIfCollectionInvalid(coll, outError, nullptr);
@@ -392,6 +401,16 @@ bool c4db_maintenance(C4Database* database, C4MaintenanceType type, C4Error* out
     return tryCatch(outError, [=] { return database->maintenance(type); });
 }
 
+C4MaintenanceStats c4db_getMaintenanceStats(C4Database* database) noexcept { return database->getMaintenanceStats(); }
+
+C4DocumentKeysStats c4db_getDocumentKeysStats(C4Database* database) noexcept {
+    return database->getDocumentKeysStats();
+}
+
+bool c4db_repackDocumentKeysNamed(C4String name, const C4DatabaseConfig2* config, C4Error* outError) noexcept {
+    return tryCatch(outError, [=] { C4Database::repackDocumentKeys(name, *config); });
+}
+
 // semi-deprecated
 C4Timestamp c4db_nextDocExpiration(C4Database* db) noexcept {
     C4Error err;
@@ -450,6 +469,14 @@ void c4db_setExtraInfo(C4Database* database, C4ExtraInfo x) noexcept { database-
 
 bool c4db_isInTransaction(C4Database* database) noexcept { return database->isInTransaction(); }
 
+bool c4db_beginBulkImport(C4Database* database, C4Error* outError) noexcept {
+    return tryCatch(outError, [=] { database->beginBulkImport(); });
+}
+
+bool c4db_endBulkImport(C4Database* database, C4Error* outError) noexcept {
+    return tryCatch(outError, [=] { database->endBulkImport(); });
+}
+
 bool c4db_beginTransaction(C4Database* database, C4Error* outError) noexcept {
     return tryCatch(outError, [=] { database->beginTransaction(); });
 }
@@ -469,6 +496,10 @@ bool c4_shutdown(C4Error* outError) noexcept {
     return tryCatch(outError, [] { C4Database::shutdownLiteCore(); });
 }
 
+void c4_setCacheBudget(int64_t bytes) noexcept { C4Database::setCacheBudget(bytes); }
+
+C4CacheUsage c4_getCacheUsage(bool resetPeak) noexcept { return C4Database::getCacheUsage(resetPeak); }
+
 C4SliceResult c4db_rawQuery(C4Database* database, C4String query, C4Error* outError) noexcept {
     try {
         return C4SliceResult(database->rawQuery(query));
@@ -949,6 +980,8 @@ void c4query_setParameters(C4Query* query, C4String encodedParameters) noexcept
     query->setParameters(encodedParameters);
 }
 
+void c4query_setAllowStaleIndexes(C4Query* query, bool allow) noexcept { query->setAllowStaleIndexes(allow); }
+
 C4QueryEnumerator* c4query_run(C4Query* query, C4Slice encodedParameters, C4Error* outError) noexcept {
     return tryCatch<C4QueryEnumerator*>(outError, [&] { return query->createEnumerator(encodedParameters); });
 }
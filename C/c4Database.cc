@@ -141,8 +141,21 @@ static C4DatabaseConfig newToOldConfig(const C4DatabaseConfig2& config2) {
     return deleteAtPath(path);
 }
 
+/*static*/ void C4Database::repackDocumentKeys(slice name, const Config& config) {
+    Retained<DatabaseImpl> db = DatabaseImpl::open(dbPath(name, config.parentDirectory), newToOldConfig(config));
+    db->repackDocumentKeys();
+    db->close();
+}
+
 /*static*/ void C4Database::shutdownLiteCore() { SQLiteDataFile::shutdown(); }
 
+/*static*/ void C4Database::setCacheBudget(int64_t bytes) { SQLiteDataFile::setCacheBudget(bytes); }
+
+/*static*/ C4CacheUsage C4Database::getCacheUsage(bool resetPeak) {
+    auto usage = SQLiteDataFile::cacheUsage(resetPeak);
+    return {usage.budget, usage.current, usage.peak};
+}
+
 C4Collection* C4Database::getDefaultCollection() const {
     // Make a distinction: If the DB is open and the default collection is deleted
     // then simply return null.  If the DB is closed, an error should occur.
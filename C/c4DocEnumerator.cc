@@ -12,12 +12,15 @@
 
 #include "c4DocEnumerator.hh"
 #include "CollectionImpl.hh"
+#include "DatabaseImpl.hh"
+#include "ReadConnectionPool.hh"
 #include "Record.hh"
 #include "RecordEnumerator.hh"
 #include "RevID.hh"
 #include "VersionVector.hh"
 #include "Error.hh"
 #include "fleece/InstanceCounted.hh"
+#include <optional>
 
 using namespace litecore;
 
@@ -26,17 +29,38 @@ using namespace litecore;
 
 CBL_CORE_API const C4EnumeratorOptions kC4DefaultEnumeratorOptions = {kC4IncludeNonConflicted | kC4IncludeBodies};
 
+// The pooled connection, if any, that a C4DocEnumerator reads from. (It's a base class of Impl so
+// that it's initialized before, and destructed after, the RecordEnumerator that uses it.)
+// An enumerator keeps its connection until it's freed, so it doesn't wait for one to be returned
+// to the pool; if they're all checked out it uses the database's own connection, as before.
+struct C4DocEnumeratorConnection {
+    explicit C4DocEnumeratorConnection(CollectionImpl* collection) {
+        if ( auto pool = collection->dbImpl()->readConnectionPool() ) _connection = pool->tryCheckOut();
+    }
+
+    KeyStore& keyStoreOf(CollectionImpl* collection) {
+        if ( !_connection ) return collection->keyStore();
+        return _connection->dataFile().getKeyStore(collection->keyStore().name());
+    }
+
+  private:
+    std::optional<ReadConnectionPool::Connection> _connection;
+};
+
 class C4DocEnumerator::Impl
-    : public RecordEnumerator
+    : private C4DocEnumeratorConnection
+    , public RecordEnumerator
     , public fleece::InstanceCounted {
   public:
     Impl(C4Collection* collection, sequence_t since, const C4EnumeratorOptions& options)
-        : RecordEnumerator(asInternal(collection)->keyStore(), since, recordOptions(options))
+        : C4DocEnumeratorConnection(asInternal(collection))
+        , RecordEnumerator(keyStoreOf(asInternal(collection)), since, recordOptions(options))
         , _collection(asInternal(collection))
         , _options(options) {}
 
     Impl(C4Collection* collection, const C4EnumeratorOptions& options)
-        : RecordEnumerator(asInternal(collection)->keyStore(), recordOptions(options))
+        : C4DocEnumeratorConnection(asInternal(collection))
+        , RecordEnumerator(keyStoreOf(asInternal(collection)), recordOptions(options))
         , _collection(asInternal(collection))
         , _options(options) {}
 
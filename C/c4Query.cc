@@ -17,8 +17,10 @@
 #include "c4QueryImpl.hh"
 #include "c4Internal.hh"
 
+#include "BackgroundDB.hh"
 #include "DatabaseImpl.hh"
 #include "LiveQuerier.hh"
+#include "ReadConnectionPool.hh"
 
 
 using namespace std;
@@ -31,7 +33,10 @@ CBL_CORE_API const C4QueryOptions kC4DefaultQueryOptions = {};
 C4Query::C4Query(C4Collection* coll, C4QueryLanguage language, slice queryExpression)
     : _database(asInternal(coll)->dbImpl())
     , _query(_database->dataFile()->compileQuery(queryExpression, (QueryLanguage)language,
-                                                 &asInternal(coll)->keyStore())) {}
+                                                 &asInternal(coll)->keyStore()))
+    , _expression(queryExpression)
+    , _language(language)
+    , _keyStoreName(asInternal(coll)->keyStore().name()) {}
 
 C4Query::~C4Query() = default;
 
@@ -76,10 +81,30 @@ void C4Query::setParameters(slice parameters) {
     if ( _bgQuerier ) { _bgQuerier->changeOptions(Query::Options(_parameters)); }
 }
 
+void C4Query::setAllowStaleIndexes(bool allow) {
+    LOCK(_mutex);
+    _query->setAllowStaleIndexes(allow);
+    if ( _bgQuerier ) _bgQuerier->setAllowStaleIndexes(allow);
+}
+
 #pragma mark - ENUMERATOR:
 
 Retained<QueryEnumerator> C4Query::_createEnumerator(slice encodedParameters) {
     Query::Options options(encodedParameters ? encodedParameters : parameters());
+    if ( auto pool = _database->readConnectionPool() ) {
+        // Run the query on a pooled connection, so queries on other threads can run meanwhile.
+        // The enumerator holds a copy of the results, so the connection can go back right away.
+        // Pooled connections are read-only, so lazy indexes are caught up on the background one.
+        if ( !_query->allowStaleIndexes() ) {
+            _database->backgroundDatabase()->dataFile().useLocked([&](DataFile* df) {
+                if ( df ) _query->updateLazyIndexes(*df);
+            });
+        }
+        auto connection = pool->checkOut();
+        auto query      = connection.compileQuery(_expression, QueryLanguage(_language), _keyStoreName);
+        query->setAllowStaleIndexes(_query->allowStaleIndexes());
+        return query->createEnumerator(&options);
+    }
     return _query->createEnumerator(&options);
 }
 
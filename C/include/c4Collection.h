@@ -193,6 +193,23 @@ CBL_CORE_API C4Document* C4NULLABLE c4coll_putDoc(C4Collection* collection, cons
                                                   size_t* C4NULLABLE  outCommonAncestorIndex,
                                                   C4Error* C4NULLABLE outError) C4API;
 
+/** Performs multiple Put operations, like calling \ref c4coll_putDoc for each request but faster:
+    documents that don't exist yet are inserted without being read first, and the existing ones
+    are read in a single batch. Must be called in a transaction.
+    @param collection  The collection to save the documents in.
+    @param requests  An array of `count` Put requests.
+    @param count  The number of requests.
+    @param outDocs  An array with room for `count` documents. On return, each item is the
+                    resulting document, or NULL if that request failed. You must call
+                    \ref c4doc_release on each non-NULL document.
+    @param outErrors  An array with room for `count` errors. On return, each item is the error
+                    that made that request fail, or zero if it succeeded.
+    @param outError  On failure, the error that kept any of the requests from being made.
+    @return  True if the requests were made (even if some of them failed), false on failure. */
+CBL_CORE_API bool c4coll_putDocs(C4Collection* collection, const C4DocPutRequest requests[], size_t count,
+                                 C4Document* C4NULLABLE outDocs[], C4Error outErrors[],
+                                 C4Error* C4NULLABLE outError) C4API;
+
 /** Convenience function to create a new document. This just a wrapper around \ref c4coll_putDoc.
     If the document already exists, it will fail with the error `kC4ErrorConflict`.
     @note  You must call \ref c4doc_release when finished with the document.
@@ -274,6 +291,7 @@ CBL_CORE_API int64_t c4coll_purgeExpiredDocs(C4Collection*, C4Error* C4NULLABLE)
     @param queryLanguage  The language of `indexSpec`, either JSON or N1QL.
     @param indexType  The type of index (value or full-text.)
     @param indexOptions  Options for the index. If NULL, each option will get a default value.
+                 A value index can be made partial by setting the `where` option.
     @param outError  On failure, will be set to the error status.
     @return  True on success, false on failure. */
 CBL_CORE_API bool c4coll_createIndex(C4Collection* collection, C4String name, C4String indexSpec,
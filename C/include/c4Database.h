@@ -98,6 +98,19 @@ CBL_CORE_API bool c4db_rekey(C4Database* database, const C4EncryptionKey* C4NULL
         You don't generally need to do this, but it can be useful in tests. */
 CBL_CORE_API bool c4_shutdown(C4Error* C4NULLABLE outError) C4API;
 
+/** Sets a limit on the memory used by all open databases' caches, shared among them, or 0 for
+    no limit (the default.) Caches stop growing when the total nears the limit, and when it's
+    exceeded, the databases that have gone longest without a transaction give up their unused
+    cached pages. Each database connection's cache is also still limited to 10MB.
+    The budget relies on SQLite's memory statistics, which LiteCore always enables; they add a
+    mutex lock to each of SQLite's memory allocations.
+    @param bytes  The memory budget in bytes, or 0 for none. */
+CBL_CORE_API void c4_setCacheBudget(int64_t bytes) C4API;
+
+/** Returns the current and peak memory used by databases, and the budget if any.
+    @param resetPeak  If true, the peak is reset to the current usage after being read. */
+CBL_CORE_API C4CacheUsage c4_getCacheUsage(bool resetPeak) C4API;
+
 
 /** @} */
 /** \name Accessors
@@ -159,6 +172,26 @@ CBL_CORE_API C4ExtraInfo c4db_getExtraInfo(C4Database* database) C4API;
         For more detail, see the descriptions of the \ref C4MaintenanceType enum constants. */
 CBL_CORE_API bool c4db_maintenance(C4Database* database, C4MaintenanceType type, C4Error* C4NULLABLE outError) C4API;
 
+/** Returns statistics of the WAL checkpoints and incremental vacuums run in the background, if
+        the database was opened with the \ref kC4DB_BackgroundMaintenance flag. (Otherwise they're
+        all zero.) */
+CBL_CORE_API C4MaintenanceStats c4db_getMaintenanceStats(C4Database* database) C4API;
+
+/** Returns statistics of the database's document keys table. */
+CBL_CORE_API C4DocumentKeysStats c4db_getDocumentKeysStats(C4Database* database) C4API;
+
+/** Removes keys no longer used by any document from a database's document keys table, by
+        re-encoding every document. Since the table can only grow otherwise, this is worthwhile
+        after many distinct property names have come and gone. It takes time proportional to the
+        size of the database.
+        The database must not be open, and it must use version vectors.
+        @param name  The database name (without the ".cblite2" extension).
+        @param config  The database configuration (directory and encryption).
+        @param outError  On failure, error info will be stored here.
+        @return  True on success, false on failure. */
+CBL_CORE_API bool c4db_repackDocumentKeysNamed(C4String name, const C4DatabaseConfig2* config,
+                                               C4Error* C4NULLABLE outError) C4API;
+
 
 /** @} */
 /** \name Transactions
@@ -177,6 +210,25 @@ CBL_CORE_API bool c4db_endTransaction(C4Database* database, bool commit, C4Error
 /** Is a transaction active? */
 CBL_CORE_API bool c4db_isInTransaction(C4Database* database) C4API;
 
+/** Enters bulk-import mode, for saving a large number of documents quickly, as when importing a
+        dataset or doing a first pull. Until \ref c4db_endBulkImport is called:
+        - Value indexes are dropped, so saving a document doesn't have to update them. Queries
+          still work, but may be slower. (Full-text, array and predictive indexes are still updated.)
+        - Commits aren't flushed to disk, so a power failure or OS crash may lose them. (The
+          database won't be corrupted; an app crash loses nothing.)
+        - The WAL file is allowed to grow larger before it's copied into the database.
+
+        If the database is closed, or the app exits, without calling \ref c4db_endBulkImport, the
+        indexes are rebuilt when the database is next closed or opened.
+        Must not be called in a transaction. Documents should be saved in large transactions,
+        e.g. with \ref c4coll_putDocs. */
+CBL_CORE_API bool c4db_beginBulkImport(C4Database* database, C4Error* C4NULLABLE outError) C4API;
+
+/** Exits bulk-import mode: rebuilds the indexes dropped by \ref c4db_beginBulkImport and flushes
+        all the imported documents to disk. This can take a while. Must not be called in a
+        transaction. */
+CBL_CORE_API bool c4db_endBulkImport(C4Database* database, C4Error* C4NULLABLE outError) C4API;
+
 
 /** @} */
 /** @} */
@@ -31,13 +31,19 @@ C4API_BEGIN_DECLS
 
 /** Boolean options for C4DatabaseConfig. */
 typedef C4_OPTIONS(uint32_t, C4DatabaseFlags){
-        kC4DB_Create          = 0x01,  ///< Create the file if it doesn't exist
-        kC4DB_ReadOnly        = 0x02,  ///< Open file read-only
-        kC4DB_AutoCompact     = 0x04,  ///< Enable auto-compaction [UNIMPLEMENTED]
-        kC4DB_VersionVectors  = 0x08,  ///< Upgrade DB to version vectors instead of rev trees [EXPERIMENTAL]
-        kC4DB_NoUpgrade       = 0x20,  ///< Disable upgrading an older-version database
-        kC4DB_NonObservable   = 0x40,  ///< Disable database/collection observers, for slightly faster writes
-        kC4DB_FakeVectorClock = 0x80,  ///< Use counters instead of timestamps in version vectors (TESTS ONLY)
+        kC4DB_Create                = 0x01,    ///< Create the file if it doesn't exist
+        kC4DB_ReadOnly              = 0x02,    ///< Open file read-only
+        kC4DB_AutoCompact           = 0x04,    ///< Enable auto-compaction [UNIMPLEMENTED]
+        kC4DB_VersionVectors        = 0x08,    ///< Upgrade DB to version vectors instead of rev trees [EXPERIMENTAL]
+        kC4DB_NoUpgrade             = 0x20,    ///< Disable upgrading an older-version database
+        kC4DB_NonObservable         = 0x40,    ///< Disable database/collection observers, for slightly faster writes
+        kC4DB_FakeVectorClock       = 0x80,    ///< Use counters instead of timestamps in version vectors (TESTS ONLY)
+        kC4DB_ShardedBlobs          = 0x100,   ///< Store blobs in a tree of subdirectories, not one flat directory
+        kC4DB_ChunkedBlobs          = 0x200,   ///< Store large blobs as deduplicated content-defined chunks
+        kC4DB_CompressedBlobs       = 0x400,   ///< Store compressible blobs compressed (not if encrypted)
+        kC4DB_PooledReads           = 0x800,   ///< Run queries & doc enumerators on a pool of extra connections
+        kC4DB_MetadataIndexes       = 0x1000,  ///< Index doc metadata, so enumerating it doesn't read bodies
+        kC4DB_BackgroundMaintenance = 0x2000,  ///< Checkpoint the WAL & vacuum free space in the background
 };
 
 
@@ -78,6 +84,14 @@ typedef struct C4UUID {
     uint8_t bytes[16];
 } C4UUID;
 
+/** SQLite's process-wide memory use, which is mostly the databases' page caches.
+    Returned by \ref c4_getCacheUsage. */
+typedef struct C4CacheUsage {
+    int64_t budget;   ///< The limit set by \ref c4_setCacheBudget, or 0 if none
+    int64_t current;  ///< Bytes currently in use
+    int64_t peak;     ///< Most bytes in use at once, since startup or the last reset
+} C4CacheUsage;
+
 /** @} */
 /** \name Scopes and Collections
     @{ */
@@ -137,6 +151,24 @@ typedef C4_ENUM(uint32_t, C4MaintenanceType){
         kC4FullOptimize,
 };  // *NOTE:* These enum values must match the ones in DataFile::MaintenanceType
 
+/** Statistics of the maintenance done in the background by a database opened with the
+    \ref kC4DB_BackgroundMaintenance flag. Returned by \ref c4db_getMaintenanceStats. */
+typedef struct C4MaintenanceStats {
+    uint64_t checkpoints;        ///< Number of (passive) WAL checkpoints run
+    double   lastCheckpointMS;   ///< Duration of the latest checkpoint, in milliseconds
+    double   maxCheckpointMS;    ///< Duration of the longest checkpoint, in milliseconds
+    double   totalCheckpointMS;  ///< Total duration of all checkpoints, in milliseconds
+    uint64_t vacuumSteps;        ///< Number of incremental vacuums run
+    uint64_t pagesReclaimed;     ///< Number of free pages they gave back to the filesystem
+} C4MaintenanceStats;
+
+/** Statistics of a database's document keys: the table of common dictionary keys that documents
+    refer to by number. Returned by \ref c4db_getDocumentKeysStats. */
+typedef struct C4DocumentKeysStats {
+    uint32_t count;  ///< Number of keys in the table
+    uint64_t reads;  ///< Times the table was (re)read from the database
+} C4DocumentKeysStats;
+
 /** @} */
 /** @} */
 
@@ -56,6 +56,7 @@ C4API_BEGIN_DECLS
           expression is already an array, so there are two levels of nesting.)
         * `WHERE`: An optional expression. Including this creates a _partial index_: documents
           for which this expression returns `false` or `null` will be skipped.
+          (Alternatively, and in N1QL, use the `where` field of `C4IndexOptions`.)
 
         For backwards compatibility, `indexSpecJSON` may be an array; this is treated as if it were
         a dictionary with a `WHAT` key mapping to that array.
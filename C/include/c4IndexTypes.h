@@ -61,6 +61,42 @@ typedef struct {
         To provide a custom list of words, use a string containing the words in lowercase
         separated by spaces. */
     const char* C4NULLABLE stopWords;
+
+    /** Condition that makes a value index _partial_: only documents for which this expression
+        is truthy will be indexed. It's written in the same query language as the index spec,
+        e.g. `type = 'order' AND status = 'open'` in N1QL or `["=",[".type"],"order"]` in JSON.
+        A query whose WHERE clause includes the same condition(s) can use the index.
+        Only supported for value indexes; NULL for a regular (full) index. */
+    const char* C4NULLABLE where;
+
+    /** If true, the index is maintained _lazily_: saving a document only records that it changed,
+        and the index is brought up to date later in the background, in small batches. This keeps
+        writes fast when the indexed expression is expensive to compute.
+        By default a query brings lazy indexes up to date before it runs; call
+        \ref c4query_setAllowStaleIndexes to let a query use a possibly-stale index instead.
+        Only supported for array and predictive indexes. */
+    bool lazy;
+
+    /** If true, a full-text index is stored in an SQLite FTS5 table instead of FTS4. FTS5
+        indexes are smaller, faster to update and to search by prefix, and are ranked by BM25.
+        The query syntax is nearly the same, but FTS5 is stricter about punctuation in search
+        terms (put such terms in double quotes.) Only supported for full-text indexes. */
+    bool useFTS5;
+
+    /** Optional callback that's called while the index is first built, with the approximate
+        fraction of the collection indexed so far (0.0 ... 1.0). Full-text, array and predictive
+        indexes report progress along the way; value indexes only when they start and finish.
+        It's always called with 1.0 when \ref c4coll_createIndex succeeds, even if the index
+        already existed. It's called on the calling thread, from within \ref c4coll_createIndex. */
+    void (*C4NULLABLE progressCallback)(void* C4NULLABLE context, float fraction);
+
+    /** Value passed to `progressCallback`. */
+    void* C4NULLABLE progressContext;
+
+    /** Maximum number of helper threads SQLite may use to sort keys while building the index;
+        0 (the default) uses one fewer than the number of CPU cores. The index is still built in a
+        single transaction, so other writers wait until it's done. */
+    unsigned maxBuildThreads;
 } C4IndexOptions;
 
 /** @} */
@@ -77,6 +77,13 @@ CBL_CORE_API FLStringResult c4log_binaryFilePath(void) C4API;
 /** Ensures all log messages have been written to the current log files. */
 CBL_CORE_API void c4log_flushLogFiles(void) C4API;
 
+/** Turns asynchronous logging on or off. While it's on, logging calls don't wait for each other:
+    each thread's messages are queued, and a background thread formats them, calls the log
+    callback, and writes them to the log files. If a thread logs faster than that, some of its
+    messages below the Warning level are dropped, and the others are written synchronously.
+    \ref c4log_flushLogFiles writes all queued messages before returning. */
+CBL_CORE_API void c4log_setAsynchronous(bool async) C4API;
+
 /** Returns the minimum level of log messages to be written to the log file,
     regardless of what level individual log domains are set to. */
 CBL_CORE_API C4LogLevel c4log_binaryFileLevel(void) C4API;
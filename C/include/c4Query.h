@@ -65,6 +65,14 @@ CBL_CORE_API FLString c4query_columnTitle(C4Query*, unsigned column) C4API;
                 values to bind. Any unbound parameters will be `null`. */
 CBL_CORE_API void c4query_setParameters(C4Query* query, C4String encodedParameters) C4API;
 
+/** Determines whether the query may use lazy indexes (see \ref C4IndexOptions) that haven't
+        yet been updated with recent changes. By default a query first brings them up to date,
+        which can delay it; allowing stale indexes makes it run immediately, possibly missing
+        or returning outdated results for recently changed documents.
+        @param query  The compiled query.
+        @param allow  True to allow the query to use stale lazy indexes. */
+CBL_CORE_API void c4query_setAllowStaleIndexes(C4Query* query, bool allow) C4API;
+
 
 /** Runs a compiled query.
         NOTE: Queries will run much faster if the appropriate properties are indexed.
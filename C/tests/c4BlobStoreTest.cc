@@ -12,6 +12,9 @@
 
 #include "c4Test.hh"  // IWYU pragma: keep
 #include "c4BlobStore.h"
+#include "c4BlobStore.hh"
+#include "FilePath.hh"
+#include "Stopwatch.hh"
 #include <fstream>
 
 using namespace std;
@@ -347,3 +350,385 @@ N_WAY_TEST_CASE_METHOD(BlobStoreTest, "write identical blob", "[blob][C]") {
 
     for ( auto& stream : streams ) { c4stream_closeWriter(stream); }
 }
+
+
+// Opens a standalone blob store in a new temp directory.
+static C4BlobStore* openTempBlobStore(const char* name, C4DatabaseFlags flags, alloc_slice& outDir) {
+    outDir = alloc_slice(TEMPDIR(name));
+    C4Error error;
+    c4blob_deleteStore(c4blob_openStore(outDir, kC4DB_Create, nullptr, nullptr), nullptr);
+    C4BlobStore* store = c4blob_openStore(outDir, flags | kC4DB_Create, nullptr, ERROR_INFO(error));
+    REQUIRE(store);
+    return store;
+}
+
+TEST_CASE("sharded blob store migration", "[blob][C]") {
+    alloc_slice       dir;
+    C4BlobStore*      store = openTempBlobStore("blobs_sharding/", 0, dir);
+    vector<C4BlobKey> keys;
+    C4Error           error;
+    for ( int i = 0; i < 100; i++ ) {
+        string    contents = "Blob number " + to_string(i);
+        C4BlobKey key;
+        REQUIRE(c4blob_create(store, slice(contents), nullptr, &key, WITH_ERROR(&error)));
+        keys.push_back(key);
+    }
+    alloc_slice flatPath = c4blob_getFilePath(store, keys[0], ERROR_INFO(error));
+    REQUIRE(flatPath.hasPrefix(dir));
+    CHECK(!slice(flatPath.buf, flatPath.size).from(dir.size).findByte('/'));
+    c4blob_freeStore(store);
+
+    // The flag converts the existing store:
+    store = c4blob_openStore(dir, kC4DB_ShardedBlobs, nullptr, ERROR_INFO(error));
+    REQUIRE(store);
+    auto checkBlobs = [&] {
+        for ( int i = 0; i < 100; i++ ) {
+            alloc_slice contents = c4blob_getContents(store, keys[i], ERROR_INFO(error));
+            CHECK(contents == slice("Blob number " + to_string(i)));
+        }
+        char shard[10];
+        snprintf(shard, sizeof(shard), "%02x/%02x/", keys[0].bytes[0], keys[0].bytes[1]);
+        alloc_slice path = c4blob_getFilePath(store, keys[0], ERROR_INFO(error));
+        CHECK(path.hasPrefix(string(dir) + shard));
+    };
+    checkBlobs();
+    c4blob_freeStore(store);
+
+    // Once sharded, the store stays that way even if opened without the flag:
+    store = c4blob_openStore(dir, 0, nullptr, ERROR_INFO(error));
+    REQUIRE(store);
+    checkBlobs();
+
+    C4BlobKey newKey;
+    REQUIRE(c4blob_create(store, "New blob"_sl, nullptr, &newKey, WITH_ERROR(&error)));
+    CHECK(c4blob_getSize(store, newKey) == 8);
+    REQUIRE(c4blob_delete(store, newKey, WITH_ERROR(&error)));
+    CHECK(c4blob_getSize(store, newKey) == -1);
+
+    // Garbage collection sees the blobs in the subdirectories:
+    unordered_set<C4BlobKey> inUse(keys.begin(), keys.begin() + 50);
+    CHECK(store->deleteAllExcept(inUse) == 50);
+    CHECK(c4blob_getSize(store, keys[49]) > 0);
+    CHECK(c4blob_getSize(store, keys[50]) == -1);
+    CHECK(c4blob_deleteStore(store, WITH_ERROR(&error)));
+}
+
+TEST_CASE("Sharded blob store benchmark", "[Perf][.slow][blob][C]") {
+    static constexpr unsigned kNumBlobs = 1'000'000;
+    for ( C4DatabaseFlags flags : {C4DatabaseFlags(0), kC4DB_ShardedBlobs} ) {
+        const char*  layout = flags ? "sharded" : "flat";
+        alloc_slice  dir;
+        C4BlobStore* store = openTempBlobStore("blobs_benchmark/", flags, dir);
+
+        vector<C4BlobKey> keys;
+        keys.reserve(kNumBlobs);
+        fleece::Stopwatch st;
+        for ( unsigned i = 0; i < kNumBlobs; i++ ) {
+            string contents = "Blob number " + to_string(i);
+            keys.push_back(store->createBlob(slice(contents)));
+        }
+        C4Log("%s: Creating %u blobs took %.3f sec", layout, kNumBlobs, st.elapsed());
+
+        fleece::Stopwatch st2;
+        for ( unsigned i = 0; i < kNumBlobs; i += 97 ) CHECK(store->getSize(keys[i]) > 0);
+        C4Log("%s: Reading %u blob sizes took %.3f ms", layout, kNumBlobs / 97, st2.elapsedMS());
+
+        unordered_set<C4BlobKey> inUse(keys.begin(), keys.begin() + kNumBlobs / 2);
+        fleece::Stopwatch        st3;
+        CHECK(store->deleteAllExcept(inUse) == kNumBlobs - kNumBlobs / 2);
+        C4Log("%s: Deleting unused blobs took %.3f sec", layout, st3.elapsed());
+
+        C4Error error;
+        CHECK(c4blob_deleteStore(store, WITH_ERROR(&error)));
+    }
+}
+
+// Returns pseudo-random data that's the same every time.
+static string randomBlobData(size_t size, uint64_t seed) {
+    string data(size, '\0');
+    for ( auto& c : data ) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        c = char(seed);
+    }
+    return data;
+}
+
+// Returns the number and total size of the files in the directory with the given extension.
+static pair<unsigned, int64_t> filesWithExtension(slice dir, const char* ext) {
+    pair<unsigned, int64_t> result{};
+    litecore::FilePath(string(dir), "").forEachFile([&](const litecore::FilePath& file) {
+        if ( file.extension() == ext ) {
+            ++result.first;
+            result.second += file.dataSize();
+        }
+    });
+    return result;
+}
+
+TEST_CASE("chunked blob store", "[blob][C][!throws]") {
+    alloc_slice  dir;
+    C4BlobStore* store = openTempBlobStore("blobs_chunked/", kC4DB_ChunkedBlobs, dir);
+    C4Error      error;
+
+    string    original = randomBlobData(2'000'000, 0x1234);
+    C4BlobKey key1     = store->createBlob(slice(original));
+    CHECK(store->getChunkManifest(key1));
+    CHECK(store->getSize(key1) == int64_t(original.size()));
+    CHECK(store->getContents(key1) == slice(original));
+    CHECK(!alloc_slice(c4blob_getFilePath(store, key1, &error)));
+    auto [numChunks1, chunkBytes1] = filesWithExtension(dir, ".chunk");
+    CHECK(numChunks1 >= 8);  // chunks are at most 256KB
+    CHECK(chunkBytes1 == int64_t(original.size()));
+
+    // Read from the middle, across chunk boundaries:
+    C4ReadStream* reader = c4blob_openReadStream(store, key1, ERROR_INFO(error));
+    REQUIRE(reader);
+    REQUIRE(c4stream_seek(reader, 999'000, WITH_ERROR(&error)));
+    string buf(200'000, '\0');
+    CHECK(c4stream_read(reader, buf.data(), buf.size(), &error) == buf.size());
+    CHECK(buf == original.substr(999'000, 200'000));
+    c4stream_close(reader);
+
+    // An edited copy shares all but the chunks around the edit:
+    string    edited = original.substr(0, 1'000'000) + "Hello there!" + original.substr(1'000'000);
+    C4BlobKey key2   = store->createBlob(slice(edited));
+    CHECK(store->getContents(key2) == slice(edited));
+    auto [numChunks2, chunkBytes2] = filesWithExtension(dir, ".chunk");
+    CHECK(numChunks2 > numChunks1);
+    CHECK(numChunks2 <= numChunks1 + 3);
+
+    // Small blobs are stored whole:
+    C4BlobKey smallKey = store->createBlob("tiny"_sl);
+    CHECK(!store->getChunkManifest(smallKey));
+    CHECK(alloc_slice(c4blob_getFilePath(store, smallKey, ERROR_INFO(error))));
+
+    // Deleting a blob leaves its chunks; garbage collection removes the ones not used by others:
+    unordered_set<C4BlobKey> inUse{key2};
+    CHECK(store->deleteAllExcept(inUse) == 2);
+    CHECK(store->getSize(key1) == -1);
+    CHECK(store->getContents(key2) == slice(edited));
+    // (but not chunks written within the grace period, which an install may be about to use)
+    CHECK(filesWithExtension(dir, ".chunk").second == chunkBytes2);
+    time_t longAgo = time(nullptr) - C4BlobStore::kDeletionGracePeriodSecs - 1;
+    litecore::FilePath(string(dir), "").forEachFile([&](const litecore::FilePath& file) {
+        if ( file.extension() == ".chunk" ) file.setLastModified(longAgo);
+    });
+    CHECK(store->deleteAllExcept(inUse) == 0);
+    CHECK(store->getContents(key2) == slice(edited));
+    CHECK(filesWithExtension(dir, ".chunk").second == int64_t(edited.size()));
+
+    // Installing the original again rewrites the chunks that were collected, and reuses the rest:
+    CHECK(store->createBlob(slice(original)) == key1);
+    CHECK(store->getContents(key1) == slice(original));
+    CHECK(filesWithExtension(dir, ".chunk").second == chunkBytes2);
+    CHECK(c4blob_deleteStore(store, WITH_ERROR(&error)));
+}
+
+TEST_CASE("Chunked blob storage benchmark", "[Perf][.slow][blob][C]") {
+    // Stores successive versions of a large binary file, each with a few small edits, as a
+    // document with an attachment being updated would. With chunking, each version adds only
+    // the chunks around its edits; that's also how much a chunk-aware peer would have to download.
+    static constexpr size_t   kBlobSize    = 20'000'000;
+    static constexpr unsigned kNumVersions = 10, kEditsPerVersion = 4;
+    for ( C4DatabaseFlags flags : {C4DatabaseFlags(0), kC4DB_ChunkedBlobs} ) {
+        const char*  layout = flags ? "chunked" : "whole";
+        alloc_slice  dir;
+        C4BlobStore* store = openTempBlobStore("blobs_chunk_benchmark/", flags, dir);
+
+        string            contents = randomBlobData(kBlobSize, 0xC0FFEE);
+        uint64_t          rng      = 12345;
+        int64_t           lastSize = 0;
+        fleece::Stopwatch st;
+        for ( unsigned version = 0; version < kNumVersions; ++version ) {
+            if ( version > 0 ) {
+                for ( unsigned e = 0; e < kEditsPerVersion; ++e ) {
+                    rng          = rng * 6364136223846793005 + 1442695040888963407;
+                    size_t where = (rng >> 16) % contents.size();
+                    if ( e % 2 ) contents.insert(where, randomBlobData(100, rng));
+                    else
+                        contents.replace(where, 100, randomBlobData(100, rng));
+                }
+            }
+            store->createBlob(slice(contents));
+            int64_t size = filesWithExtension(dir, ".blob").second + filesWithExtension(dir, ".chunk").second;
+            C4Log("%s: version %u added %.1f KB", layout, version, (size - lastSize) / 1024.0);
+            lastSize = size;
+        }
+        C4Log("%s: Storing %u versions took %.3f sec; total size %.1f MB", layout, kNumVersions, st.elapsed(),
+              lastSize / 1.0e6);
+
+        C4Error error;
+        CHECK(c4blob_deleteStore(store, WITH_ERROR(&error)));
+    }
+}
+
+N_WAY_TEST_CASE_METHOD(BlobStoreTest, "write and read large blob in one call", "[blob][Encryption][C]") {
+    // Big enough that encrypted streams split the work among threads:
+    const string data = randomBlobData(3'000'000 + 123, 0xBEEF);
+    C4Error      error;
+    C4BlobKey    key;
+    {
+        C4WriteStream* stream = c4blob_openWriteStream(store, ERROR_INFO(error));
+        REQUIRE(stream);
+        REQUIRE(c4stream_write(stream, data.data(), 77, WITH_ERROR(&error)));  // leave a partial block
+        REQUIRE(c4stream_write(stream, data.data() + 77, data.size() - 77, WITH_ERROR(&error)));
+        key = c4stream_computeBlobKey(stream);
+        REQUIRE(c4stream_install(stream, nullptr, WITH_ERROR(&error)));
+        c4stream_closeWriter(stream);
+    }
+
+    C4ReadStream* reader = c4blob_openReadStream(store, key, ERROR_INFO(error));
+    REQUIRE(reader);
+    string readBack(data.size() + 100, '\0');
+    CHECK(c4stream_read(reader, readBack.data(), readBack.size(), ERROR_INFO(error)) == data.size());
+    readBack.resize(data.size());
+    CHECK(readBack == data);
+
+    for ( uint64_t pos : {uint64_t(0), uint64_t(4095), uint64_t(123'456), uint64_t(2'999'999)} ) {
+        INFO("Reading at offset " << pos);
+        REQUIRE(c4stream_seek(reader, pos, WITH_ERROR(&error)));
+        string buf(1'000'000, '\0');
+        size_t n = c4stream_read(reader, buf.data(), buf.size(), ERROR_INFO(error));
+        CHECK(n == min(buf.size(), data.size() - size_t(pos)));
+        CHECK(buf.substr(0, n) == data.substr(pos, n));
+    }
+    c4stream_close(reader);
+}
+
+N_WAY_TEST_CASE_METHOD(BlobStoreTest, "Blob stream benchmark", "[Perf][.slow][blob][Encryption][C]") {
+    static constexpr size_t kBlobSize = 256 << 20, kBufferSize = 1 << 20;
+    static constexpr int    kNumSeeks = 10000;
+    const char*             kind      = encrypted ? "encrypted" : "unencrypted";
+    const string            data      = randomBlobData(kBufferSize, 0xFEED);
+    C4Error                 error;
+
+    fleece::Stopwatch st;
+    C4WriteStream*    writer = c4blob_openWriteStream(store, ERROR_INFO(error));
+    REQUIRE(writer);
+    for ( size_t i = 0; i < kBlobSize; i += kBufferSize )
+        REQUIRE(c4stream_write(writer, data.data(), data.size(), WITH_ERROR(&error)));
+    C4BlobKey key = c4stream_computeBlobKey(writer);
+    REQUIRE(c4stream_install(writer, nullptr, WITH_ERROR(&error)));
+    c4stream_closeWriter(writer);
+    C4Log("%s: Writing %zu MB took %.3f sec (%.0f MB/s)", kind, kBlobSize >> 20, st.elapsed(),
+          (kBlobSize >> 20) / st.elapsed());
+
+    string        buf(kBufferSize, '\0');
+    C4ReadStream* reader = c4blob_openReadStream(store, key, ERROR_INFO(error));
+    REQUIRE(reader);
+    st.reset();
+    size_t total = 0, n;
+    while ( (n = c4stream_read(reader, buf.data(), buf.size(), ERROR_INFO(error))) > 0 ) total += n;
+    CHECK(total == kBlobSize);
+    C4Log("%s: Reading %zu MB took %.3f sec (%.0f MB/s)", kind, kBlobSize >> 20, st.elapsed(),
+          (kBlobSize >> 20) / st.elapsed());
+
+    uint64_t rng = 1;
+    st.reset();
+    for ( int i = 0; i < kNumSeeks; ++i ) {
+        rng = rng * 6364136223846793005 + 1442695040888963407;
+        REQUIRE(c4stream_seek(reader, (rng >> 16) % (kBlobSize - 100), WITH_ERROR(&error)));
+        REQUIRE(c4stream_read(reader, buf.data(), 100, WITH_ERROR(&error)) == 100);
+    }
+    C4Log("%s: %d random seeks+reads took %.3f sec (%.1f us each)", kind, kNumSeeks, st.elapsed(),
+          st.elapsedMS() * 1000.0 / kNumSeeks);
+    c4stream_close(reader);
+}
+
+// Returns JSON-like text that compresses about as well as typical JSON or CSV attachments.
+static string compressibleBlobData(size_t size, uint64_t seed) {
+    string data;
+    data.reserve(size + 100);
+    char line[100];
+    for ( int i = 0; data.size() < size; ++i ) {
+        seed = seed * 6364136223846793005 + 1442695040888963407;
+        snprintf(line, sizeof(line), "{\"id\": %d, \"name\": \"item%05u\", \"price\": %u.%02u, \"inStock\": %s},\n",
+                 i, unsigned(seed >> 40) % 100000, unsigned(seed >> 20) % 1000, unsigned(seed >> 10) % 100,
+                 (seed & 1) ? "true" : "false");
+        data += line;
+    }
+    data.resize(size);
+    return data;
+}
+
+TEST_CASE("compressed blob store", "[blob][C][!throws]") {
+    alloc_slice  dir;
+    C4BlobStore* store = openTempBlobStore("blobs_compressed/", kC4DB_CompressedBlobs, dir);
+    C4Error      error;
+    CHECK(store->isCompressed());
+
+    string    json = compressibleBlobData(200'000, 1);
+    C4BlobKey key  = store->createBlob(slice(json));
+    CHECK(filesWithExtension(dir, ".blob").first == 0);
+    auto [numCompressed, compressedSize] = filesWithExtension(dir, ".blobz");
+    CHECK(numCompressed == 1);
+    CHECK(compressedSize < int64_t(json.size()) / 3);
+    CHECK(store->getSize(key) == int64_t(json.size()));
+    CHECK(store->getContents(key) == slice(json));
+    CHECK(!store->isStoredAsFile(key));
+    CHECK(!alloc_slice(c4blob_getFilePath(store, key, &error)));
+
+    // Random access, forwards and backwards:
+    C4ReadStream* reader = c4blob_openReadStream(store, key, ERROR_INFO(error));
+    REQUIRE(reader);
+    char buf[1000];
+    for ( uint64_t pos : {uint64_t(150'000), uint64_t(1234), uint64_t(99'999), uint64_t(199'500)} ) {
+        INFO("Reading at offset " << pos);
+        REQUIRE(c4stream_seek(reader, pos, WITH_ERROR(&error)));
+        size_t n = c4stream_read(reader, buf, sizeof(buf), ERROR_INFO(error));
+        CHECK(n == min(sizeof(buf), json.size() - size_t(pos)));
+        CHECK(string(buf, n) == json.substr(pos, n));
+    }
+    c4stream_close(reader);
+
+    // The stored compressed data can be read as-is:
+    auto compressed = store->openCompressedReadStream(key);
+    REQUIRE(compressed);
+    CHECK(compressed->getLength() == compressedSize - 12);
+
+    // Incompressible and small blobs are stored as they are:
+    C4BlobKey randomKey = store->createBlob(slice(randomBlobData(100'000, 7)));
+    C4BlobKey smallKey  = store->createBlob("Too small to bother compressing"_sl);
+    CHECK(store->isStoredAsFile(randomKey));
+    CHECK(store->isStoredAsFile(smallKey));
+    CHECK(!store->openCompressedReadStream(randomKey));
+    CHECK(filesWithExtension(dir, ".blob").first == 2);
+
+    unordered_set<C4BlobKey> inUse{randomKey};
+    CHECK(store->deleteAllExcept(inUse) == 2);
+    CHECK(store->getSize(key) == -1);
+    CHECK(filesWithExtension(dir, ".blobz").first == 0);
+    CHECK(c4blob_deleteStore(store, WITH_ERROR(&error)));
+}
+
+TEST_CASE("Compressed blob storage benchmark", "[Perf][.slow][blob][C]") {
+    static constexpr unsigned kNumBlobs = 200;
+    static constexpr size_t   kBlobSize = 1'000'000;
+    vector<string>            blobs;
+    for ( unsigned i = 0; i < kNumBlobs; ++i ) blobs.push_back(compressibleBlobData(kBlobSize, i));
+
+    for ( C4DatabaseFlags flags : {C4DatabaseFlags(0), kC4DB_CompressedBlobs} ) {
+        const char*  layout = flags ? "compressed" : "uncompressed";
+        alloc_slice  dir;
+        C4BlobStore* store = openTempBlobStore("blobs_compress_benchmark/", flags, dir);
+
+        vector<C4BlobKey> keys;
+        fleece::Stopwatch st;
+        for ( auto& blob : blobs ) keys.push_back(store->createBlob(slice(blob)));
+        double  writeTime = st.elapsed();
+        int64_t diskSize  = filesWithExtension(dir, ".blob").second + filesWithExtension(dir, ".blobz").second;
+
+        st.reset();
+        size_t total = 0;
+        for ( auto& key : keys ) total += store->getContents(key).size;
+        CHECK(total == kNumBlobs * kBlobSize);
+        double readTime = st.elapsed();
+
+        C4Log("%s: %u JSON blobs take %.1f MB on disk; writing took %.3f sec, reading %.3f sec", layout, kNumBlobs,
+              diskSize / 1.0e6, writeTime, readTime);
+        C4Error error;
+        CHECK(c4blob_deleteStore(store, WITH_ERROR(&error)));
+    }
+}
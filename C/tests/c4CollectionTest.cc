@@ -459,6 +459,30 @@ N_WAY_TEST_CASE_METHOD(C4CollectionTest, "Collection Expired", "[Collection][C][
     CHECK(c4coll_purgeExpiredDocs(fresh, WITH_ERROR()) == 0);
 }
 
+N_WAY_TEST_CASE_METHOD(C4CollectionTest, "Collection Auto-Expiration After Reopen", "[Collection][C][Expiration]") {
+    // On open, the database finds the collections with expiring docs without opening all of them.
+    // Make sure it finds a named collection whose only expiring doc is deleted, so it's in the
+    // collection's `del_` table:
+    C4Collection* fresh = c4db_createCollection(db, SupaDope, ERROR_INFO());
+    REQUIRE(fresh);
+    REQUIRE(c4db_createCollection(db, Guitars, ERROR_INFO()));
+    createRev(fresh, "expire_me"_sl, kRevID, kFleeceBody);
+    createRev(fresh, "expire_me"_sl, kRev2ID, kC4SliceNull, kRevDeleted);
+    C4Timestamp expire = c4_now() + 1500;
+    REQUIRE(c4coll_setDocExpiration(fresh, "expire_me"_sl, expire, WITH_ERROR()));
+
+    C4Log("---- Reopening DB...");
+    reopenDB();
+    fresh = c4db_getCollection(db, SupaDope, ERROR_INFO());
+    REQUIRE(fresh);
+    CHECK(c4coll_nextDocExpiration(fresh) == expire);
+
+    C4Log("---- Wait till expiration time...");
+    this_thread::sleep_for(1500ms);
+    CHECK_BEFORE(10s, !docExists(fresh, "expire_me"_sl));
+    CHECK_BEFORE(10s, c4coll_nextDocExpiration(fresh) == C4Timestamp::None);
+}
+
 N_WAY_TEST_CASE_METHOD(C4CollectionTest, "Move Doc between Collections", "[Database][Collection][C]") {
     // Create "guitars" collection:
     C4Collection* guitars = c4db_createCollection(db, Guitars, ERROR_INFO());
@@ -353,6 +353,226 @@ N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Enumerator With Info", "[Databa
     CHECK(i == 100);
 }
 
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Enumerator With Metadata Indexes", "[Database][Enumerator][C]") {
+    setupAllDocs();
+    auto        defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    C4Timestamp expire      = c4_now() + 3600 * 1000;
+    REQUIRE(c4coll_setDocExpiration(defaultColl, "doc-007"_sl, expire, WITH_ERROR()));
+
+    // Open another instance with the flag; once it's written to, its metadata-only enumerators use
+    // the covering indexes, and must return the same info as ones reading the table:
+    C4DatabaseConfig2 config = dbConfig();
+    config.flags |= kC4DB_MetadataIndexes;
+    c4::ref<C4Database> indexedDB = c4db_openNamed(kDatabaseName, &config, ERROR_INFO());
+    REQUIRE(indexedDB);
+    auto indexedColl = getCollection(indexedDB, kC4DefaultCollectionSpec);
+    {
+        TransactionHelper t(indexedDB);
+        createRev(indexedDB, "doc-100"_sl, kRevID, kFleeceBody);
+    }
+
+    C4EnumeratorOptions options = kC4DefaultEnumeratorOptions;
+    options.flags &= ~kC4IncludeBodies;
+    for ( bool bySequence : {false, true} ) {
+        c4::ref<C4DocEnumerator> e1 = bySequence ? c4coll_enumerateChanges(defaultColl, 0, &options, ERROR_INFO())
+                                                 : c4coll_enumerateAllDocs(defaultColl, &options, ERROR_INFO());
+        c4::ref<C4DocEnumerator> e2 = bySequence ? c4coll_enumerateChanges(indexedColl, 0, &options, ERROR_INFO())
+                                                 : c4coll_enumerateAllDocs(indexedColl, &options, ERROR_INFO());
+        REQUIRE(e1);
+        REQUIRE(e2);
+        unsigned n = 0;
+        while ( c4enum_next(e1, ERROR_INFO()) ) {
+            REQUIRE(c4enum_next(e2, ERROR_INFO()));
+            C4DocumentInfo info1, info2;
+            REQUIRE(c4enum_getDocumentInfo(e1, &info1));
+            REQUIRE(c4enum_getDocumentInfo(e2, &info2));
+            CHECK(info2.docID == info1.docID);
+            CHECK(info2.revID == info1.revID);
+            CHECK(info2.sequence == info1.sequence);
+            CHECK(info2.flags == info1.flags);
+            CHECK(info2.bodySize == info1.bodySize);
+            CHECK(info2.metaSize == info1.metaSize);
+            CHECK(info2.expiration == info1.expiration);
+            if ( info2.docID == "doc-007"_sl ) CHECK(info2.expiration == expire);
+            ++n;
+        }
+        CHECK(!c4enum_next(e2, ERROR_INFO()));
+        CHECK(n == 100);
+    }
+}
+
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Cache Budget", "[Database][C]") {
+    createNumberedDocs(5000);
+    C4CacheUsage usage = c4_getCacheUsage(false);
+    CHECK(usage.budget == 0);
+    CHECK(usage.current > 0);
+    CHECK(usage.peak >= usage.current);
+
+    // Setting a budget below the current usage frees the idle connections' cached pages:
+    int64_t budget = usage.current / 2;
+    c4_setCacheBudget(budget);
+    C4CacheUsage newUsage = c4_getCacheUsage(true);
+    CHECK(newUsage.budget == budget);
+    CHECK(newUsage.current < usage.current);
+    CHECK(newUsage.peak >= usage.current);
+
+    // The database still works, within the budget:
+    {
+        TransactionHelper t(db);
+        createRev("doc-5001"_sl, kRevID, kFleeceBody);
+    }
+    auto                defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    c4::ref<C4Document> doc         = c4coll_getDoc(defaultColl, "doc-042"_sl, true, kDocGetAll, ERROR_INFO());
+    CHECK(doc);
+
+    c4_setCacheBudget(0);
+    CHECK(c4_getCacheUsage(false).budget == 0);
+}
+
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Background Maintenance", "[Database][C]") {
+    closeDB();
+    C4DatabaseConfig2 config = dbConfig();
+    config.flags |= kC4DB_BackgroundMaintenance;
+    db = c4db_openNamed(kDatabaseName, &config, ERROR_INFO());
+    REQUIRE(db);
+
+    // Create docs, then purge them, leaving lots of free pages:
+    constexpr unsigned kNumDocs = 2000;
+    createNumberedDocs(kNumDocs);
+    {
+        auto              defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+        TransactionHelper t(db);
+        char              docID[20];
+        for ( unsigned i = 1; i <= kNumDocs; i++ ) {
+            snprintf(docID, sizeof(docID), "doc-%03u", i);
+            REQUIRE(c4coll_purgeDoc(defaultColl, c4str(docID), WITH_ERROR()));
+        }
+    }
+
+    // Once the database is idle, the WAL is checkpointed and the free pages vacuumed:
+    CHECK(WaitUntil(5000ms, [&] {
+        C4MaintenanceStats stats = c4db_getMaintenanceStats(db);
+        return stats.checkpoints > 0 && stats.pagesReclaimed > 0;
+    }));
+    C4MaintenanceStats stats = c4db_getMaintenanceStats(db);
+    CHECK(stats.vacuumSteps > 0);
+    CHECK(stats.maxCheckpointMS >= stats.lastCheckpointMS);
+    CHECK(stats.totalCheckpointMS >= stats.maxCheckpointMS);
+}
+
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Bulk Import", "[Database][C]") {
+    auto defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    REQUIRE(c4coll_createIndex(defaultColl, C4STR("byN"), C4STR("n"), kC4N1QLQuery, kC4ValueIndex, nullptr,
+                               WITH_ERROR()));
+    auto usesIndex = [&] {
+        c4::ref<C4Query> query =
+                c4query_new2(db, kC4N1QLQuery, "SELECT meta().id FROM _ WHERE n = 42"_sl, nullptr, ERROR_INFO());
+        REQUIRE(query);
+        string explanation = toString(c4query_explain(query));
+        return explanation.find("USING INDEX byN") != string::npos;
+    };
+    auto importDocs = [&](unsigned first, unsigned last) {
+        TransactionHelper t(db);
+        char              docID[20], json[20];
+        for ( unsigned i = first; i <= last; i++ ) {
+            snprintf(docID, sizeof(docID), "doc-%03u", i);
+            snprintf(json, sizeof(json), "{\"n\":%u}", i);
+            createFleeceRev(db, slice(docID), kRevID, slice(json));
+        }
+    };
+    CHECK(usesIndex());
+
+    C4Error error;
+    CHECK(!c4db_endBulkImport(db, &error));
+    CHECK(error == C4Error{LiteCoreDomain, kC4ErrorInvalidParameter});
+
+    REQUIRE(c4db_beginBulkImport(db, WITH_ERROR()));
+    CHECK(!c4db_beginBulkImport(db, &error));
+    CHECK(error == C4Error{LiteCoreDomain, kC4ErrorInvalidParameter});
+    CHECK(!usesIndex());
+    importDocs(1, 100);
+
+    SECTION("End Bulk Import") {
+        {
+            TransactionHelper t(db);
+            CHECK(!c4db_endBulkImport(db, &error));
+            CHECK(error == C4Error{LiteCoreDomain, kC4ErrorTransactionNotClosed});
+        }
+        REQUIRE(c4db_endBulkImport(db, WITH_ERROR()));
+    }
+    SECTION("Reopen During Bulk Import") {
+        // Closing the database ends bulk-import mode:
+        reopenDB();
+    }
+    SECTION("Crash During Bulk Import") {
+        // A copy of the open database's files is what a crash would leave behind. Opening it
+        // rebuilds the indexes saved in the `deferredIndexes` table:
+        C4DatabaseConfig2 config = *c4db_getConfig2(db);
+        alloc_slice       parentDir(config.parentDirectory);
+        config.parentDirectory = parentDir;
+        litecore::FilePath dbDir(alloc_slice(c4db_getPath(db)).asString(), "");
+        litecore::FilePath copyDir(string(parentDir) + "bulk_import_crash.cblite2" + kPathSeparator, "");
+        copyDir.delRecursive();
+        dbDir.copyTo(copyDir);
+        REQUIRE(c4db_delete(db, WITH_ERROR()));
+        c4db_release(db);
+        db = c4db_openNamed("bulk_import_crash"_sl, &config, ERROR_INFO());
+        REQUIRE(db);
+    }
+    CHECK(usesIndex());
+    importDocs(101, 200);
+
+    // The index is up to date:
+    c4::ref<C4Query> query =
+            c4query_new2(db, kC4N1QLQuery, "SELECT meta().id FROM _ WHERE n >= 99 AND n <= 102 ORDER BY n"_sl,
+                         nullptr, ERROR_INFO());
+    REQUIRE(query);
+    c4::ref<C4QueryEnumerator> e = c4query_run(query, nullslice, ERROR_INFO());
+    REQUIRE(e);
+    vector<string> docIDs;
+    while ( c4queryenum_next(e, ERROR_INFO(error)) )
+        docIDs.emplace_back(slice(FLValue_AsString(FLArrayIterator_GetValue(&e->columns))));
+    CHECK(!error);
+    CHECK(docIDs == vector<string>{"doc-099", "doc-100", "doc-101", "doc-102"});
+}
+
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Repack Document Keys", "[Database][C]") {
+    auto defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    {
+        TransactionHelper t(db);
+        createFleeceRev(db, "old"_sl, kRevID, R"({"alpha":1,"beta":2})"_sl);
+        createFleeceRev(db, "doc"_sl, kRevID, R"({"gamma":3,"delta":{"beta":4}})"_sl);
+        REQUIRE(c4coll_purgeDoc(defaultColl, "old"_sl, WITH_ERROR()));
+    }
+    CHECK(c4db_getDocumentKeysStats(db).count == 4);
+
+    C4DatabaseConfig2 config = dbConfig();
+    C4Error           error;
+    if ( isRevTrees() ) {
+        CHECK(!c4db_repackDocumentKeysNamed(kDatabaseName, &config, &error));
+        CHECK(error == C4Error{LiteCoreDomain, kC4ErrorUnimplemented});
+        return;
+    }
+
+    // Not while the database is open:
+    CHECK(!c4db_repackDocumentKeysNamed(kDatabaseName, &config, &error));
+    CHECK(error == C4Error{LiteCoreDomain, kC4ErrorBusy});
+
+    closeDB();
+    REQUIRE(c4db_repackDocumentKeysNamed(kDatabaseName, &config, WITH_ERROR()));
+    db = c4db_openNamed(kDatabaseName, &config, ERROR_INFO());
+    REQUIRE(db);
+    CHECK(listSharedKeys() == "gamma, delta, beta");
+
+    defaultColl             = getCollection(db, kC4DefaultCollectionSpec);
+    c4::ref<C4Document> doc = c4coll_getDoc(defaultColl, "doc"_sl, true, kDocGetAll, ERROR_INFO());
+    REQUIRE(doc);
+    CHECK(doc->revID == kRevID);
+    FLDict props = c4doc_getProperties(doc);
+    CHECK(FLValue_AsInt(FLDict_Get(props, "gamma"_sl)) == 3);
+    CHECK(FLValue_AsInt(FLDict_Get(FLValue_AsDict(FLDict_Get(props, "delta"_sl)), "beta"_sl)) == 4);
+}
+
 N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Enumerator With History", "[Database][Enumerator][C]") {
     if ( isRevTrees() ) return;
 
@@ -534,6 +754,29 @@ N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Auto-Expiration", "[Database][C
     C4Log("---- Done...");
 }
 
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Auto-Expiration In Batches", "[Database][C][Expiration]") {
+    // More docs than the Housekeeper purges per transaction, all expiring at once:
+    constexpr unsigned kNumDocs = 2500;
+    createNumberedDocs(kNumDocs);
+    auto defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    {
+        TransactionHelper t(db);
+        C4Timestamp       expire = c4_now() + 1000 * ms;
+        char              docID[20];
+        for ( unsigned i = 1; i <= kNumDocs; i++ ) {
+            snprintf(docID, sizeof(docID), "doc-%03u", i);
+            REQUIRE(c4coll_setDocExpiration(defaultColl, slice(docID), expire, WITH_ERROR()));
+        }
+    }
+    createRev("dont_expire_me"_sl, kRevID, kFleeceBody);
+
+    C4Log("---- Wait till expiration time...");
+    this_thread::sleep_for(1000ms);
+    CHECK_BEFORE(15s, c4coll_getDocumentCount(defaultColl) == 1);
+    CHECK(docExists(db, "dont_expire_me"));
+    CHECK(c4coll_nextDocExpiration(defaultColl) == 0);
+}
+
 N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Auto-Expiration After Reopen", "[Database][C][Expiration]") {
     createRev("expire_me_first"_sl, kRevID, kFleeceBody);
     auto expire      = c4_now() + 1500 * ms;
@@ -746,6 +989,78 @@ N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Compact", "[Database][C][Blob]"
     REQUIRE(c4db_maintenance(db, kC4IntegrityCheck, WITH_ERROR()));
 }
 
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Incremental Blob GC", "[Database][C][Blob]") {
+    // Blobs whose last reference goes away are deleted in the background, without compacting.
+    // (The test backdates blob files by path, which encrypted blob stores don't expose.)
+    if ( isEncrypted() ) return;
+    C4Slice        doc1ID = C4STR("doc001"), doc2ID = C4STR("doc002"), doc3ID = C4STR("doc003");
+    vector<string> atts1{"This is the first attachment"}, atts2{"This is the second attachment"};
+    C4BlobKey      key1, key2;
+    {
+        TransactionHelper t(db);
+        key1 = addDocWithAttachments(doc1ID, atts1, "text/plain")[0];
+        key2 = addDocWithAttachments(doc2ID, atts2, "text/plain")[0];
+        addDocWithAttachments(doc3ID, atts2, "text/plain");
+    }
+    C4BlobStore* store = c4db_getBlobStore(db, ERROR_INFO());
+    REQUIRE(store);
+
+    // Blobs installed recently aren't deleted, since a doc about to be saved may refer to them,
+    // so make these look older than that:
+    auto backdate = [&](C4BlobKey key) {
+        alloc_slice path(c4blob_getFilePath(store, key, ERROR_INFO()));
+        REQUIRE(path);
+        REQUIRE(litecore::FilePath(string(path), "").setLastModified(time(nullptr) - 24 * 3600));
+    };
+    backdate(key1);
+    backdate(key2);
+
+    // A blob created but never referenced isn't known to the reference counts:
+    C4BlobKey unrefKey;
+    REQUIRE(c4blob_create(store, "unreferenced"_sl, nullptr, &unrefKey, WITH_ERROR()));
+
+    createNewRev(db, doc1ID, kC4SliceNull, kRevDeleted);
+    CHECK_BEFORE(5s, c4blob_getSize(store, key1) == -1);
+
+    // The counts persist across reopening; the second blob has two references:
+    reopenDB();
+    store = c4db_getBlobStore(db, ERROR_INFO());
+    createNewRev(db, doc2ID, kC4SliceNull, kRevDeleted);
+    {
+        TransactionHelper t(db);
+        REQUIRE(c4coll_purgeDoc(getCollection(db, kC4DefaultCollectionSpec), doc1ID, WITH_ERROR()));
+    }
+    CHECK(c4blob_getSize(store, key2) > 0);
+    {
+        TransactionHelper t(db);
+        REQUIRE(c4coll_purgeDoc(getCollection(db, kC4DefaultCollectionSpec), doc3ID, WITH_ERROR()));
+    }
+    CHECK_BEFORE(5s, c4blob_getSize(store, key2) == -1);
+    CHECK(c4blob_getSize(store, unrefKey) > 0);
+
+    // A blob that was installed recently isn't deleted when its count drops to zero:
+    C4Slice   doc4ID = C4STR("doc004"), doc5ID = C4STR("doc005");
+    C4BlobKey key4, key5;
+    {
+        TransactionHelper t(db);
+        key4 = addDocWithAttachments(doc4ID, {"This is the fourth attachment"}, "text/plain")[0];
+        key5 = addDocWithAttachments(doc5ID, {"This is the fifth attachment"}, "text/plain")[0];
+    }
+    backdate(key5);
+    {
+        TransactionHelper t(db);
+        createNewRev(db, doc4ID, kC4SliceNull, kRevDeleted);
+        createNewRev(db, doc5ID, kC4SliceNull, kRevDeleted);
+    }
+    CHECK_BEFORE(5s, c4blob_getSize(store, key5) == -1);
+    CHECK(c4blob_getSize(store, key4) > 0);
+
+    // Compaction still deletes everything unreferenced:
+    REQUIRE(c4db_maintenance(db, kC4Compact, WITH_ERROR()));
+    CHECK(c4blob_getSize(store, unrefKey) == -1);
+    CHECK(c4blob_getSize(store, key4) == -1);
+}
+
 N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database copy", "[Database][C]") {
     static constexpr slice kNuName = "nudb";
 
@@ -829,6 +1144,36 @@ N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database copy", "[Database][C]") {
     c4db_release(nudb);
 }
 
+N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database copy with blobs", "[Database][C][Blob]") {
+    static constexpr slice    kNuName   = "nudb";
+    static constexpr unsigned kNumBlobs = 50;
+
+    C4BlobStore*      store = c4db_getBlobStore(db, ERROR_INFO());
+    vector<C4BlobKey> keys(kNumBlobs);
+    for ( unsigned i = 0; i < kNumBlobs; ++i ) {
+        string content = "This is blob #" + to_string(i) + string(i * 1000, '*');
+        REQUIRE(c4blob_create(store, slice(content), nullptr, &keys[i], WITH_ERROR()));
+    }
+    createRev("doc001"_sl, kRevID, kFleeceBody);
+
+    C4DatabaseConfig2 config = *c4db_getConfig2(db);
+    C4Error           error;
+    if ( !c4db_deleteNamed(kNuName, config.parentDirectory, &error) ) { REQUIRE(error.code == 0); }
+    string srcPathStr = toString(c4db_getPath(db));
+    REQUIRE(c4db_copyNamed(slice(srcPathStr), kNuName, &config, WITH_ERROR()));
+
+    auto nudb = c4db_openNamed(kNuName, &config, ERROR_INFO());
+    REQUIRE(nudb);
+    CHECK(c4coll_getDocumentCount(getCollection(nudb, kC4DefaultCollectionSpec)) == 1);
+    C4BlobStore* nuStore = c4db_getBlobStore(nudb, ERROR_INFO());
+    for ( unsigned i = 0; i < kNumBlobs; ++i ) {
+        alloc_slice content(c4blob_getContents(nuStore, keys[i], WITH_ERROR()));
+        CHECK(content == slice("This is blob #" + to_string(i) + string(i * 1000, '*')));
+    }
+    REQUIRE(c4db_delete(nudb, WITH_ERROR()));
+    c4db_release(nudb);
+}
+
 N_WAY_TEST_CASE_METHOD(C4DatabaseTest, "Database Config2 And ExtraInfo", "[Database][C]") {
     C4DatabaseConfig2 config = {};
     config.parentDirectory   = slice(TempDir());
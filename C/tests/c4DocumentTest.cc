@@ -563,6 +563,55 @@ N_WAY_TEST_CASE_METHOD(C4Test, "Document Put", "[Document][C]") {
     }
 }
 
+N_WAY_TEST_CASE_METHOD(C4Test, "Document Put Multiple", "[Document][C]") {
+    auto              defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    C4Error           error;
+    TransactionHelper t(db);
+
+    c4::ref<C4Document> existing = c4coll_createDoc(defaultColl, "existing"_sl, kFleeceBody, 0, ERROR_INFO(error));
+    REQUIRE(existing);
+    c4::ref<C4Document> other = c4coll_createDoc(defaultColl, "other"_sl, kFleeceBody, 0, ERROR_INFO(error));
+    REQUIRE(other);
+
+    auto            body       = json2fleece("{'ok':'go'}");
+    C4Slice         history[1] = {existing->revID};
+    C4DocPutRequest rqs[5]     = {};
+    for ( auto& rq : rqs ) {
+        rq.body = body;
+        rq.save = true;
+    }
+    rqs[0].docID        = "new"_sl;       // creates a doc
+    rqs[1].docID        = "existing"_sl;  // updates a doc
+    rqs[1].history      = history;
+    rqs[1].historyCount = 1;
+    rqs[2].docID        = "other"_sl;  // conflicts with an existing doc
+    rqs[3].docID        = "new"_sl;    // conflicts with the doc created by rqs[0]
+    // rqs[4] has no docID, so one is generated
+
+    C4Document* docs[5];
+    C4Error     errors[5];
+    REQUIRE(c4coll_putDocs(defaultColl, rqs, 5, docs, errors, ERROR_INFO(error)));
+
+    REQUIRE(docs[0]);
+    CHECK(docs[0]->docID == "new"_sl);
+    CHECK(errors[0].code == 0);
+    REQUIRE(docs[1]);
+    CHECK(docs[1]->revID != existing->revID);
+    CHECK(docs[1]->sequence > other->sequence);
+    CHECK(!docs[2]);
+    CHECK(errors[2] == C4Error{LiteCoreDomain, kC4ErrorConflict});
+    CHECK(!docs[3]);
+    CHECK(errors[3] == C4Error{LiteCoreDomain, kC4ErrorConflict});
+    REQUIRE(docs[4]);
+    CHECK(docs[4]->docID.size > 0);
+    for ( auto doc : docs ) c4doc_release(doc);
+
+    CHECK(c4coll_getDocumentCount(defaultColl) == 4);
+    c4::ref<C4Document> updated = c4coll_getDoc(defaultColl, "existing"_sl, true, kDocGetCurrentRev, ERROR_INFO(error));
+    REQUIRE(updated);
+    CHECK(fleece2json(c4doc_getRevisionBody(updated)) == "{ok:\"go\"}");
+}
+
 N_WAY_TEST_CASE_METHOD(C4Test, "Document create from existing rev", "[Document][C]") {
     C4Error           error;
     TransactionHelper t(db);
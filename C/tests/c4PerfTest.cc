@@ -28,6 +28,7 @@
 #include <thread>
 #include <fstream>
 #include <cinttypes>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #ifndef _MSC_VER
@@ -368,6 +369,217 @@ N_WAY_TEST_CASE_METHOD(PerfTest, "Import Wikipedia", "[Perf][C][.slow]") {
     readRandomDocs(numDocs, 100000);
 }
 
+N_WAY_TEST_CASE_METHOD(PerfTest, "Bulk upsert", "[Perf][C][.slow]") {
+    // Saves docs in batches, once with c4coll_putDoc per doc and once with c4coll_putDocs,
+    // first creating them and then updating them:
+    static constexpr unsigned kNumDocs = 100000, kBatchSize = 1000;
+    auto                      defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+    alloc_slice               body        = json2fleece("{'name':'Zegpold','age':35,'tags':['a','b','c']}");
+
+    for ( bool bulk : {false, true} ) {
+        vector<alloc_slice> docIDs(kNumDocs), revIDs(kNumDocs);
+        for ( unsigned i = 0; i < kNumDocs; ++i ) {
+            char docID[20];
+            snprintf(docID, sizeof(docID), "%s-%06u", (bulk ? "bulk" : "loop"), i);
+            docIDs[i] = alloc_slice(docID);
+        }
+
+        for ( int pass = 0; pass < 2; ++pass ) {
+            Stopwatch st;
+            for ( unsigned start = 0; start < kNumDocs; start += kBatchSize ) {
+                vector<C4DocPutRequest> rqs(kBatchSize);
+                for ( unsigned j = 0; j < kBatchSize; ++j ) {
+                    C4DocPutRequest& rq = rqs[j];
+                    rq                  = {};
+                    rq.docID            = docIDs[start + j];
+                    rq.body             = body;
+                    rq.save             = true;
+                    if ( pass > 0 ) {
+                        rq.history      = (C4String*)&revIDs[start + j];
+                        rq.historyCount = 1;
+                    }
+                }
+
+                TransactionHelper   t(db);
+                vector<C4Document*> docs(kBatchSize);
+                C4Error             error;
+                if ( bulk ) {
+                    vector<C4Error> errors(kBatchSize);
+                    REQUIRE(c4coll_putDocs(defaultColl, rqs.data(), kBatchSize, docs.data(), errors.data(),
+                                           WITH_ERROR(&error)));
+                } else {
+                    for ( unsigned j = 0; j < kBatchSize; ++j )
+                        docs[j] = c4coll_putDoc(defaultColl, &rqs[j], nullptr, WITH_ERROR(&error));
+                }
+                for ( unsigned j = 0; j < kBatchSize; ++j ) {
+                    REQUIRE(docs[j]);
+                    revIDs[start + j] = alloc_slice(docs[j]->revID);
+                    c4doc_release(docs[j]);
+                }
+            }
+            st.stop();
+            char what[100];
+            snprintf(what, sizeof(what), "%s docs %s", (pass ? "Updating" : "Creating"),
+                     (bulk ? "with c4coll_putDocs" : "with a c4coll_putDoc loop"));
+            st.printReport(what, kNumDocs, "doc");
+        }
+    }
+}
+
+N_WAY_TEST_CASE_METHOD(PerfTest, "Bulk import", "[Perf][C][.slow]") {
+    // Imports docs into a collection with a value index, once normally and once in bulk-import
+    // mode. The number of docs can be set with the environment variable LITECORE_BULK_IMPORT_DOCS.
+    unsigned numDocs = 5000000;
+    if ( const char* env = getenv("LITECORE_BULK_IMPORT_DOCS") ) numDocs = unsigned(atol(env));
+    static constexpr unsigned kBatchSize = 10000;
+
+    for ( bool bulk : {false, true} ) {
+        deleteAndRecreateDB();
+        auto defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+        REQUIRE(c4coll_createIndex(defaultColl, C4STR("byN"), C4STR("n"), kC4N1QLQuery, kC4ValueIndex, nullptr,
+                                   WITH_ERROR()));
+        Stopwatch st;
+        if ( bulk ) REQUIRE(c4db_beginBulkImport(db, WITH_ERROR()));
+        for ( unsigned start = 0; start < numDocs; start += kBatchSize ) {
+            TransactionHelper t(db);
+            char              docID[20], json[50];
+            for ( unsigned i = start; i < min(start + kBatchSize, numDocs); ++i ) {
+                snprintf(docID, sizeof(docID), "doc-%08u", i);
+                snprintf(json, sizeof(json), "{\"n\":%u,\"name\":\"Zegpold\"}", (i * 7919) % numDocs);
+                createFleeceRev(db, slice(docID), kRevID, slice(json));
+            }
+        }
+        if ( bulk ) REQUIRE(c4db_endBulkImport(db, WITH_ERROR()));
+        st.stop();
+        st.printReport(bulk ? "Importing docs in bulk-import mode" : "Importing docs normally", numDocs, "doc");
+    }
+}
+
+N_WAY_TEST_CASE_METHOD(PerfTest, "Concurrent queries", "[Perf][C][.slow]") {
+    // Runs a query on several threads at once: on a database instance opened with
+    // kC4DB_PooledReads, and for comparison on one without it, which the threads have to take
+    // turns using.
+    static constexpr unsigned kNumDocs = 20000, kQueriesPerThread = 40;
+    {
+        TransactionHelper t(db);
+        auto              defaultColl = getCollection(db, kC4DefaultCollectionSpec);
+        for ( unsigned i = 0; i < kNumDocs; ++i ) {
+            char docID[20], json[100];
+            snprintf(docID, sizeof(docID), "doc-%06u", i);
+            snprintf(json, sizeof(json), R"({"n":%u,"name":"Zegpold %u","tags":["a","b","c"]})", i, i % 1000);
+            createFleeceRev(defaultColl, slice(docID), kRevID, slice(json));
+        }
+    }
+
+    for ( bool pooled : {false, true} ) {
+        C4DatabaseConfig2 config = dbConfig();
+        if ( pooled ) config.flags |= kC4DB_PooledReads;
+        C4Database* queryDB = c4db_openNamed(kDatabaseName, &config, ERROR_INFO());
+        REQUIRE(queryDB);
+        C4Query* query = c4query_new2(queryDB, kC4N1QLQuery,
+                                      "SELECT n FROM _ WHERE n % 7 = 0 AND name LIKE '%9%' ORDER BY n DESC"_sl,
+                                      nullptr, ERROR_INFO());
+        REQUIRE(query);
+        mutex queryMutex;  // only used without the pool
+
+        for ( unsigned numThreads : {1u, 2u, 4u, 8u} ) {
+            atomic<unsigned> failures{0};
+            vector<thread>   threads;
+            Stopwatch        st;
+            for ( unsigned t = 0; t < numThreads; ++t ) {
+                threads.emplace_back([&] {
+                    for ( unsigned i = 0; i < kQueriesPerThread; ++i ) {
+                        unique_lock<mutex> lock(queryMutex, defer_lock);
+                        if ( !pooled ) lock.lock();
+                        C4QueryEnumerator* e = c4query_run(query, nullslice, nullptr);
+                        if ( !e ) {
+                            ++failures;
+                            continue;
+                        }
+                        // Only running the query needs the lock; the enumerator has a copy of the rows.
+                        if ( lock.owns_lock() ) lock.unlock();
+                        while ( c4queryenum_next(e, nullptr) ) {}
+                        c4queryenum_release(e);
+                    }
+                });
+            }
+            for ( auto& th : threads ) th.join();
+            st.stop();
+            CHECK(failures == 0);
+            char what[100];
+            snprintf(what, sizeof(what), "Queries on %u threads, %s", numThreads,
+                     (pooled ? "with pooled reads" : "taking turns"));
+            st.printReport(what, numThreads * kQueriesPerThread, "query");
+        }
+
+        c4query_release(query);
+        REQUIRE(c4db_close(queryDB, WITH_ERROR()));
+        c4db_release(queryDB);
+    }
+}
+
+N_WAY_TEST_CASE_METHOD(PerfTest, "Open database latency", "[Perf][C][.slow]") {
+    // Measures opening and closing a database with many collections, a few of which have docs
+    // with expiration times, as a service opening databases on demand would.
+    static constexpr unsigned kNumCollections = 100, kNumOpens = 200;
+    {
+        TransactionHelper t(db);
+        for ( unsigned i = 0; i < kNumCollections; ++i ) {
+            string           name = "coll" + to_string(i);
+            C4CollectionSpec spec{slice(name), "scope"_sl};
+            C4Collection*    coll = createCollection(db, spec);
+            REQUIRE(coll);
+            createFleeceRev(coll, "doc"_sl, kRevID, R"({"n":1})"_sl);
+            if ( i % 25 == 0 ) {
+                REQUIRE(c4coll_setDocExpiration(coll, "doc"_sl, c4_now() + 3600 * 1000, WITH_ERROR()));
+            }
+        }
+    }
+
+    Benchmark b;
+    for ( unsigned i = 0; i < kNumOpens; ++i ) {
+        b.start();
+        C4Database* other = c4db_openNamed(kDatabaseName, &dbConfig(), ERROR_INFO());
+        REQUIRE(other);
+        REQUIRE(c4db_close(other, WITH_ERROR()));
+        b.stop();
+        c4db_release(other);
+    }
+    fprintf(stderr, "Opening & closing a database with %u collections: ", kNumCollections);
+    b.printReport(1, "open");
+}
+
+N_WAY_TEST_CASE_METHOD(PerfTest, "Copy prebuilt database with blobs", "[Perf][C][.slow]") {
+    // Copies a database holding 10GB of blobs, as an app provisioning a prebuilt database would.
+    // The total size in MB can be set with the environment variable LITECORE_PREBUILT_BLOB_MB.
+    static constexpr size_t kBlobSize = 10 * 1024 * 1024;
+    static constexpr slice  kNuName   = "prebuilt_copy";
+    size_t                  totalMB   = 10 * 1024;
+    if ( const char* env = getenv("LITECORE_PREBUILT_BLOB_MB") ) totalMB = size_t(atol(env));
+    size_t numBlobs = max(totalMB * 1024 * 1024 / kBlobSize, size_t(1));
+
+    C4BlobStore* store = c4db_getBlobStore(db, ERROR_INFO());
+    REQUIRE(store);
+    alloc_slice content(kBlobSize);
+    for ( size_t i = 0; i < kBlobSize; ++i ) ((uint8_t*)content.buf)[i] = uint8_t(rand());
+    for ( size_t i = 0; i < numBlobs; ++i ) {
+        memcpy((void*)content.buf, &i, sizeof(i));  // make each blob unique
+        C4BlobKey key;
+        REQUIRE(c4blob_create(store, content, nullptr, &key, WITH_ERROR()));
+    }
+    createNumberedDocs(1000);
+
+    C4DatabaseConfig2 config     = dbConfig();
+    string            srcPathStr = toString(c4db_getPath(db));
+    C4Error           error;
+    if ( !c4db_deleteNamed(kNuName, config.parentDirectory, &error) ) { REQUIRE(error.code == 0); }
+    Stopwatch st;
+    REQUIRE(c4db_copyNamed(slice(srcPathStr), kNuName, &config, WITH_ERROR()));
+    st.stop();
+    st.printReport("Copying prebuilt database", numBlobs * kBlobSize / (1024 * 1024), "MB");
+    REQUIRE(c4db_deleteNamed(kNuName, config.parentDirectory, WITH_ERROR()));
+}
+
 #ifdef LITECORE_PERF_TESTING_MODE
 // This test will be automated soon, and switched to [Perf]
 N_WAY_TEST_CASE_METHOD(PerfTest, "Push and pull names data", "[PerfManual][C][.slow]") {
@@ -14,6 +14,8 @@
 #include "c4Collection.h"
 #include "c4Observer.h"
 #include "StringUtil.hh"
+#include <algorithm>
+#include <atomic>
 #include <thread>
 using namespace std;
 
@@ -56,6 +58,69 @@ N_WAY_TEST_CASE_METHOD(C4QueryTest, "C4Query Basic", "[Query][C]") {
     CHECK(run().size() == 10);
 }
 
+N_WAY_TEST_CASE_METHOD(C4QueryTest, "C4Query pooled reads", "[Query][C]") {
+    // Open another instance with a pool of read connections:
+    C4DatabaseConfig2 config = dbConfig();
+    config.flags |= kC4DB_PooledReads;
+    C4Database* pooledDB = c4db_openNamed(kDatabaseName, &config, ERROR_INFO());
+    REQUIRE(pooledDB);
+    string   queryStr    = json5("{WHAT:[['._id']],WHERE:['=',['.contact.address.state'],'CA']}");
+    C4Query* pooledQuery = c4query_new2(pooledDB, kC4JSONQuery, c4str(queryStr.c_str()), nullptr, ERROR_INFO());
+    REQUIRE(pooledQuery);
+
+    auto countRows = [](C4Query* q) -> int {
+        C4QueryEnumerator* e = c4query_run(q, nullslice, nullptr);
+        if ( !e ) return -1;
+        int n = 0;
+        while ( c4queryenum_next(e, nullptr) ) ++n;
+        c4queryenum_release(e);
+        return n;
+    };
+
+    // Query on several threads at once:
+    atomic<int>    wrongCounts{0};
+    vector<thread> threads;
+    for ( int t = 0; t < 4; ++t ) {
+        threads.emplace_back([&] {
+            for ( int i = 0; i < 20; ++i ) {
+                if ( countRows(pooledQuery) != 8 ) ++wrongCounts;
+            }
+        });
+    }
+    for ( auto& t : threads ) t.join();
+    CHECK(wrongCounts == 0);
+
+    // Enumerate docs:
+    C4Collection*    pooledColl = c4db_getDefaultCollection(pooledDB, nullptr);
+    C4DocEnumerator* e          = c4coll_enumerateAllDocs(pooledColl, nullptr, ERROR_INFO());
+    REQUIRE(e);
+    int nDocs = 0;
+    while ( c4enum_next(e, nullptr) ) ++nDocs;
+    c4enum_free(e);
+    CHECK(nDocs == 100);
+
+    // A query in a transaction sees its uncommitted changes:
+    const char* caDoc = R"({"contact":{"address":{"state":"CA"}}})";
+    REQUIRE(c4db_beginTransaction(pooledDB, WITH_ERROR()));
+    createFleeceRev(pooledDB, C4STR("uncommitted"), kRevID, c4str(caDoc));
+    CHECK(countRows(pooledQuery) == 9);
+    REQUIRE(c4db_endTransaction(pooledDB, false, WITH_ERROR()));
+    CHECK(countRows(pooledQuery) == 8);
+
+    // A query sees changes committed by another instance:
+    createFleeceRev(db, C4STR("committed"), kRevID, c4str(caDoc));
+    CHECK(countRows(pooledQuery) == 9);
+
+    // Closing the database doesn't wait for an open doc enumerator to be freed:
+    e = c4coll_enumerateAllDocs(pooledColl, nullptr, ERROR_INFO());
+    REQUIRE(e);
+    CHECK(c4enum_next(e, nullptr));
+    c4query_release(pooledQuery);
+    REQUIRE(c4db_close(pooledDB, WITH_ERROR()));
+    c4enum_free(e);
+    c4db_release(pooledDB);
+}
+
 N_WAY_TEST_CASE_METHOD(C4QueryTest, "C4Query LIKE", "[Query][C]") {
     SECTION("General") {
         compile(json5("['LIKE', ['.name.first'], '%j%']"));
@@ -608,6 +673,23 @@ N_WAY_TEST_CASE_METHOD(C4QueryTest, "C4Query FTS with join", "[Query][C][FTS]")
     CHECK(count == femaleCount);
 }
 
+N_WAY_TEST_CASE_METHOD(C4QueryTest, "C4Query FTS index build progress", "[Query][C][FTS]") {
+    vector<float>  reports;
+    C4IndexOptions options{};
+    options.progressCallback = [](void* context, float fraction) {
+        ((vector<float>*)context)->push_back(fraction);
+    };
+    options.progressContext = &reports;
+    options.maxBuildThreads = 1;
+    auto defaultColl        = getCollection(db, kC4DefaultCollectionSpec);
+    REQUIRE(c4coll_createIndex(defaultColl, C4STR("byStreet"), C4STR("[[\".contact.address.street\"]]"),
+                               kC4JSONQuery, kC4FullTextIndex, &options, WITH_ERROR()));
+    REQUIRE(reports.size() >= 2);
+    CHECK(reports.front() == 0.0f);
+    CHECK(reports.back() == 1.0f);
+    CHECK(std::is_sorted(reports.begin(), reports.end()));
+}
+
 N_WAY_TEST_CASE_METHOD(C4QueryTest, "C4Query FTS with accents", "[Query][C][FTS]") {
     // https://github.com/couchbase/couchbase-lite-core/issues/723
     C4Error        err;
@@ -18,6 +18,7 @@
 #    include <MacTypes.h>
 #    include <CommonCrypto/CommonCrypto.h>
 #else
+#    include "mbedtls/aes.h"
 #    include "mbedtls/cipher.h"
 #    include "mbedtls/pkcs5.h"
 #endif
@@ -48,6 +49,29 @@ namespace litecore {
         return outSize;
     }
 
+    struct AES256Cipher::Impl {
+        CCCryptorRef cryptor{nullptr};
+    };
+
+    AES256Cipher::AES256Cipher(bool encrypt, slice key) : _impl(new Impl) {
+        DebugAssert(key.size == kCCKeySizeAES256);
+        CCCryptorStatus status = CCCryptorCreate((encrypt ? kCCEncrypt : kCCDecrypt), kCCAlgorithmAES, 0, key.buf,
+                                                 key.size, nullptr, &_impl->cryptor);
+        if ( status != kCCSuccess ) error::_throw(error::CryptoError);
+    }
+
+    AES256Cipher::~AES256Cipher() { CCCryptorRelease(_impl->cryptor); }
+
+    void AES256Cipher::crypt(slice iv, mutable_slice dst, slice src) {
+        DebugAssert(iv.size == kCCBlockSizeAES128, "IV is wrong size");
+        DebugAssert(dst.size == src.size && src.size % kCCBlockSizeAES128 == 0);
+        size_t          outSize;
+        CCCryptorStatus status = CCCryptorReset(_impl->cryptor, iv.buf);
+        if ( status == kCCSuccess )
+            status = CCCryptorUpdate(_impl->cryptor, src.buf, src.size, dst.buf, dst.size, &outSize);
+        if ( status != kCCSuccess ) error::_throw(error::CryptoError);
+    }
+
     bool DeriveKeyFromPassword(slice password, void* outKey, size_t keyLength) {
         int status = CCKeyDerivationPBKDF(kCCPBKDF2, (const char*)password.buf, password.size,
                                           (const uint8_t*)kPBKDFSalt.buf, kPBKDFSalt.size, kCCPRFHmacAlgSHA256,
@@ -98,6 +122,38 @@ namespace litecore {
         return AES(kAES256KeySize, MBEDTLS_CIPHER_AES_256_CBC, encrypt, key, iv, padding, dst, src);
     }
 
+    // mbedTLS uses AES-NI (or the ARMv8 crypto extensions) by itself when the CPU has them.
+    struct AES256Cipher::Impl {
+        mbedtls_aes_context context;
+        int                 mode;
+    };
+
+    AES256Cipher::AES256Cipher(bool encrypt, slice key) : _impl(new Impl) {
+        DebugAssert(key.size == kAES256KeySize);
+        mbedtls_aes_init(&_impl->context);
+        _impl->mode = encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+        auto keyBytes = (const unsigned char*)key.buf;
+        int  err      = encrypt ? mbedtls_aes_setkey_enc(&_impl->context, keyBytes, 256)
+                                : mbedtls_aes_setkey_dec(&_impl->context, keyBytes, 256);
+        if ( err ) {
+            mbedtls_aes_free(&_impl->context);
+            error::_throw(error::CryptoError);
+        }
+    }
+
+    AES256Cipher::~AES256Cipher() { mbedtls_aes_free(&_impl->context); }
+
+    void AES256Cipher::crypt(slice iv, mutable_slice dst, slice src) {
+        DebugAssert(iv.size == kAESBlockSize, "IV is wrong size");
+        DebugAssert(dst.size == src.size && src.size % kAESBlockSize == 0);
+        unsigned char ivBuf[kAESBlockSize];  // mbedTLS updates the IV as it goes
+        memcpy(ivBuf, iv.buf, kAESBlockSize);
+        if ( mbedtls_aes_crypt_cbc(&_impl->context, _impl->mode, src.size, ivBuf, (const unsigned char*)src.buf,
+                                   (unsigned char*)dst.buf)
+             != 0 )
+            error::_throw(error::CryptoError);
+    }
+
     bool DeriveKeyFromPassword(slice password, void* outKey, size_t keyLength) {
         const mbedtls_md_info_t* digestType = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
         if ( !digestType ) return false;
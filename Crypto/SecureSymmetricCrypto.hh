@@ -12,6 +12,7 @@
 
 #pragma once
 #include "Base.hh"
+#include <memory>
 
 namespace litecore {
 
@@ -27,6 +28,24 @@ namespace litecore {
                   fleece::mutable_slice dst,      // output buffer & capacity
                   slice                 src);                     // input data
 
+    /** AES256 CBC encryption or decryption, without padding, with a key that's set up once and
+        then used for many messages. This avoids the per-call setup cost of `AES256`, and uses the
+        platform's hardware-accelerated implementation (e.g. AES-NI) when available.
+        Not thread-safe: use one instance per thread. */
+    class AES256Cipher {
+      public:
+        AES256Cipher(bool encrypt, slice key);
+        ~AES256Cipher();
+
+        /// Encrypts or decrypts `src` into `dst`, which may be the same buffer. Both must have the
+        /// same size, a multiple of kAESBlockSize.
+        void crypt(slice iv, fleece::mutable_slice dst, slice src);
+
+      private:
+        struct Impl;
+        std::unique_ptr<Impl> _impl;
+    };
+
     /** Converts a password string into a key using PBKDF2. */
     bool DeriveKeyFromPassword(slice password, void* outKey, size_t keyLength);
 
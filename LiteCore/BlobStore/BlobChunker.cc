@@ -0,0 +1,99 @@
+//
+// BlobChunker.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "BlobChunker.hh"
+#include <array>
+#include <cstring>
+
+namespace litecore {
+    using namespace std;
+
+    // Random values mixed into the rolling hash, one per byte value. They're generated by
+    // SplitMix64 from a fixed seed, so every peer finds the same boundaries.
+    static constexpr auto kGear = [] {
+        array<uint64_t, 256> table{};
+        uint64_t             x = 0x4c697465436f7265;
+        for ( auto& entry : table ) {
+            x += 0x9e3779b97f4a7c15;
+            uint64_t z = x;
+            z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z          = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            entry      = z ^ (z >> 31);
+        }
+        return table;
+    }();
+
+    // Number of top hash bits that must be zero at a boundary, before and after the average size.
+    // (The average is 2^16 bytes.) Each shift of the hash moves the oldest byte's contribution
+    // out, so the top bit depends on the last 64 bytes.
+    static constexpr unsigned kStrictBits = 18, kLooseBits = 14;
+
+    size_t BlobChunker::nextChunkLength(slice data, bool atEOF) {
+        if ( data.size <= kMinChunkSize ) return atEOF ? data.size : 0;
+        auto     bytes = (const uint8_t*)data.buf;
+        size_t   end   = min(data.size, kMaxChunkSize), avgEnd = min(end, kAvgChunkSize);
+        uint64_t hash  = 0;
+        size_t   i     = kMinChunkSize;
+        for ( ; i < avgEnd; ++i ) {
+            hash = (hash << 1) + kGear[bytes[i]];
+            if ( (hash >> (64 - kStrictBits)) == 0 ) return i + 1;
+        }
+        for ( ; i < end; ++i ) {
+            hash = (hash << 1) + kGear[bytes[i]];
+            if ( (hash >> (64 - kLooseBits)) == 0 ) return i + 1;
+        }
+        return (end == kMaxChunkSize || atEOF) ? end : 0;
+    }
+
+#pragma mark - MANIFEST:
+
+    // A manifest is a 4-byte header followed by, for each chunk, its 20-byte digest and its
+    // length as a 32-bit big-endian integer.
+    static constexpr slice  kManifestHeader    = "LCK1";
+    static constexpr size_t kManifestEntrySize = sizeof(C4BlobKey) + 4;
+
+    alloc_slice EncodeChunkManifest(const vector<BlobChunk>& chunks) {
+        alloc_slice manifest(kManifestHeader.size + chunks.size() * kManifestEntrySize);
+        auto        dst = (uint8_t*)manifest.buf;
+        memcpy(dst, kManifestHeader.buf, kManifestHeader.size);
+        dst += kManifestHeader.size;
+        for ( auto& chunk : chunks ) {
+            memcpy(dst, chunk.key.bytes, sizeof(chunk.key.bytes));
+            dst += sizeof(chunk.key.bytes);
+            for ( int shift = 24; shift >= 0; shift -= 8 ) *dst++ = uint8_t(chunk.length >> shift);
+        }
+        return manifest;
+    }
+
+    optional<vector<BlobChunk>> DecodeChunkManifest(slice manifest) {
+        if ( !manifest.hasPrefix(kManifestHeader) ) return nullopt;
+        manifest.moveStart(kManifestHeader.size);
+        if ( manifest.size == 0 || manifest.size % kManifestEntrySize != 0 ) return nullopt;
+        vector<BlobChunk> chunks(manifest.size / kManifestEntrySize);
+        auto              src = (const uint8_t*)manifest.buf;
+        for ( auto& chunk : chunks ) {
+            memcpy(chunk.key.bytes, src, sizeof(chunk.key.bytes));
+            src += sizeof(chunk.key.bytes);
+            chunk.length = 0;
+            for ( int i = 0; i < 4; ++i ) chunk.length = (chunk.length << 8) | *src++;
+            if ( chunk.length == 0 || chunk.length > BlobChunker::kMaxChunkSize ) return nullopt;
+        }
+        return chunks;
+    }
+
+    uint64_t TotalChunkLength(const vector<BlobChunk>& chunks) {
+        uint64_t total = 0;
+        for ( auto& chunk : chunks ) total += chunk.length;
+        return total;
+    }
+
+}  // namespace litecore
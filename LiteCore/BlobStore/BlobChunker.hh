@@ -0,0 +1,55 @@
+//
+// BlobChunker.hh
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#pragma once
+#include "Base.hh"
+#include "c4BlobStoreTypes.h"
+#include <optional>
+#include <vector>
+
+namespace litecore {
+
+    /** One piece of a blob that's stored in chunks: the chunk's own digest, and its length. */
+    struct BlobChunk {
+        C4BlobKey key;
+        uint32_t  length;
+    };
+
+    /** Content-defined chunking: splits data into chunks whose boundaries depend only on the
+        nearby bytes, not on their offset. An edit to a large blob then changes only the chunks it
+        touches, and the rest are identical to (and can be shared with) the previous version's.
+
+        Boundaries are found with a "gear" rolling hash as in FastCDC: a chunk ends where the
+        hash's top bits are zero. A stricter test is used before the average size and a looser one
+        after it, which keeps most chunk sizes near the average. */
+    class BlobChunker {
+      public:
+        static constexpr size_t kMinChunkSize = 16 * 1024;
+        static constexpr size_t kAvgChunkSize = 64 * 1024;
+        static constexpr size_t kMaxChunkSize = 256 * 1024;
+
+        /// Returns the length of the chunk at the start of `data`. If there's no boundary in it and
+        /// it's shorter than kMaxChunkSize, returns 0 since more data is needed -- unless `atEOF`
+        /// is true, in which case the chunk is all of `data`.
+        static size_t nextChunkLength(slice data, bool atEOF);
+    };
+
+    /// Encodes the manifest of a chunked blob, i.e. the list of its chunks.
+    alloc_slice EncodeChunkManifest(const std::vector<BlobChunk>&);
+
+    /// Decodes a chunk manifest. Returns nullopt if the data isn't a valid manifest.
+    std::optional<std::vector<BlobChunk>> DecodeChunkManifest(slice);
+
+    /// The total length of the chunks.
+    uint64_t TotalChunkLength(const std::vector<BlobChunk>&);
+
+}  // namespace litecore
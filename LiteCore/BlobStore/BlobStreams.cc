@@ -12,9 +12,12 @@
 
 
 #include "BlobStreams.hh"
+#include "Codec.hh"
 #include "EncryptedStream.hh"
+#include "Endian.hh"
 #include "Error.hh"
 #include "Logging.hh"
+#include <algorithm>
 
 namespace litecore {
     using namespace std;
@@ -26,14 +29,170 @@ namespace litecore {
 
 #pragma mark - BLOB READ STREAM:
 
+    // Blobs at least this large are read through a memory-map instead of stdio.
+    static constexpr int64_t kMinMappedBlobSize = 64 * 1024;
+
     unique_ptr<SeekableReadStream> OpenBlobReadStream(const FilePath& blobFile, EncryptionAlgorithm algorithm,
                                                       slice encryptionKey) {
-        SeekableReadStream* reader = new FileReadStream(blobFile);
+        SeekableReadStream* reader;
+#ifndef _WIN32
+        // Blob files are never modified once installed, so it's safe to map them. (If the blob
+        // is deleted, the mapping stays valid until it's closed.)
+        if ( blobFile.dataSize() >= kMinMappedBlobSize ) reader = new MappedFileReadStream(blobFile);
+        else
+#endif
+            reader = new FileReadStream(blobFile);
         if ( algorithm != EncryptionAlgorithm::kNoEncryption )
             reader = new EncryptedReadStream(shared_ptr<SeekableReadStream>(reader), algorithm, encryptionKey);
         return unique_ptr<SeekableReadStream>{reader};
     }
 
+#pragma mark - CHUNKED BLOB READ STREAM:
+
+    ChunkedBlobReadStream::ChunkedBlobReadStream(vector<BlobChunk> chunks, ChunkOpener opener)
+        : _chunks(std::move(chunks)), _openChunk(std::move(opener)) {
+        _chunkStarts.reserve(_chunks.size() + 1);
+        uint64_t pos = 0;
+        for ( auto& chunk : _chunks ) {
+            _chunkStarts.push_back(pos);
+            pos += chunk.length;
+        }
+        _chunkStarts.push_back(pos);
+    }
+
+    void ChunkedBlobReadStream::seek(uint64_t pos) {
+        _pos = min(pos, getLength());
+        // Find the last chunk starting at or before _pos:
+        _curChunk  = size_t(upper_bound(_chunkStarts.begin(), _chunkStarts.end() - 1, _pos) - _chunkStarts.begin()) - 1;
+        _curStream = nullptr;
+    }
+
+    size_t ChunkedBlobReadStream::read(void* dst, size_t count) {
+        size_t bytesRead = 0;
+        while ( bytesRead < count && _pos < getLength() ) {
+            uint64_t chunkEnd = _chunkStarts[_curChunk + 1];
+            if ( !_curStream ) {
+                _curStream = _openChunk(_chunks[_curChunk].key);
+                if ( _pos > _chunkStarts[_curChunk] ) _curStream->seek(_pos - _chunkStarts[_curChunk]);
+            }
+            size_t n = _curStream->read((uint8_t*)dst + bytesRead,
+                                        size_t(min(uint64_t(count - bytesRead), chunkEnd - _pos)));
+            if ( n == 0 ) error::_throw(error::CorruptData, "Blob chunk is shorter than expected");
+            bytesRead += n;
+            _pos += n;
+            if ( _pos == chunkEnd ) {
+                _curStream = nullptr;
+                ++_curChunk;
+            }
+        }
+        return bytesRead;
+    }
+
+    void ChunkedBlobReadStream::close() {
+        _curStream = nullptr;
+        _chunks.clear();
+        _chunkStarts = {0};
+        _curChunk    = 0;
+        _pos         = 0;
+    }
+
+#pragma mark - COMPRESSED BLOB READ STREAM:
+
+    static constexpr slice  kCompressedBlobHeader     = "LCZ1";
+    static constexpr size_t kCompressedReadBufferSize = 32 * 1024;
+
+    alloc_slice CompressedBlobReadStream::encodeHeader(uint64_t length) {
+        alloc_slice header(kHeaderSize);
+        memcpy((void*)header.buf, kCompressedBlobHeader.buf, kCompressedBlobHeader.size);
+        uint64_t encodedLength = endian::enc64(length);
+        memcpy((uint8_t*)header.buf + kCompressedBlobHeader.size, &encodedLength, sizeof(encodedLength));
+        return header;
+    }
+
+    uint64_t CompressedBlobReadStream::readHeader(SeekableReadStream& file) {
+        uint8_t header[kHeaderSize];
+        if ( file.read(header, kHeaderSize) < kHeaderSize
+             || !slice(header, kHeaderSize).hasPrefix(kCompressedBlobHeader) )
+            error::_throw(error::CorruptData, "Invalid compressed blob header");
+        uint64_t length;
+        memcpy(&length, header + kCompressedBlobHeader.size, sizeof(length));
+        return endian::dec64(length);
+    }
+
+    // Reads the compressed data that follows a compressed blob's header.
+    class CompressedDataReadStream final : public SeekableReadStream {
+      public:
+        explicit CompressedDataReadStream(unique_ptr<SeekableReadStream> file) : _file(std::move(file)) {
+            CompressedBlobReadStream::readHeader(*_file);
+        }
+
+        [[nodiscard]] uint64_t getLength() const override {
+            return _file->getLength() - CompressedBlobReadStream::kHeaderSize;
+        }
+
+        void   seek(uint64_t pos) override { _file->seek(pos + CompressedBlobReadStream::kHeaderSize); }
+        size_t read(void* dst, size_t count) override { return _file->read(dst, count); }
+        void   close() override { _file->close(); }
+
+      private:
+        unique_ptr<SeekableReadStream> _file;
+    };
+
+    unique_ptr<SeekableReadStream> CompressedBlobReadStream::openCompressedData(unique_ptr<SeekableReadStream> file) {
+        return make_unique<CompressedDataReadStream>(std::move(file));
+    }
+
+    CompressedBlobReadStream::CompressedBlobReadStream(unique_ptr<SeekableReadStream> file)
+        : _file(std::move(file))
+        , _inflater(make_unique<blip::Inflater>())
+        , _length(readHeader(*_file))
+        , _inputBuffer(kCompressedReadBufferSize) {}
+
+    CompressedBlobReadStream::~CompressedBlobReadStream() = default;
+
+    void CompressedBlobReadStream::restart() {
+        _file->seek(kHeaderSize);
+        _inflater = make_unique<blip::Inflater>();
+        _input    = nullslice;
+        _pos      = 0;
+    }
+
+    void CompressedBlobReadStream::seek(uint64_t pos) {
+        pos = min(pos, _length);
+        if ( pos < _pos ) restart();
+        // Decompress and discard the data before `pos`:
+        uint8_t buffer[4096];
+        while ( _pos < pos ) read(buffer, size_t(min(uint64_t(sizeof(buffer)), pos - _pos)));
+    }
+
+    size_t CompressedBlobReadStream::read(void* dst, size_t count) {
+        count = size_t(min(uint64_t(count), _length - _pos));
+        slice_ostream output(dst, count);
+        while ( output.capacity() > 0 ) {
+            if ( _input.size == 0 ) {
+                size_t n = _file->read((void*)_inputBuffer.buf, _inputBuffer.size);
+                if ( n == 0 ) error::_throw(error::CorruptData, "Compressed blob is truncated");
+                _input = slice(_inputBuffer.buf, n);
+            }
+            slice_istream input(_input);
+            size_t        capacity = output.capacity();
+            _inflater->write(input, output, blip::Codec::Mode::NoFlush);
+            if ( input.size == _input.size && output.capacity() == capacity )
+                error::_throw(error::CorruptData, "Invalid compressed blob data");
+            _input = input;
+        }
+        _pos += count;
+        return count;
+    }
+
+    void CompressedBlobReadStream::close() {
+        if ( _file ) {
+            _file->close();
+            _file = nullptr;
+        }
+        _inflater = nullptr;
+    }
+
 #pragma mark - BLOB WRITE STREAM:
 
     BlobWriteStream::BlobWriteStream(const string& blobsDir, EncryptionAlgorithm algorithm, slice encryptionKey) {
@@ -74,7 +233,13 @@ namespace litecore {
         close();
         if ( !dstPath.exists() ) {
             _tmpPath.setReadOnly(true);
-            _tmpPath.moveTo(dstPath);
+            try {
+                _tmpPath.moveTo(dstPath);
+            } catch ( ... ) {
+                // Another writer may have installed the same blob since the check above:
+                if ( !dstPath.exists() ) throw;
+                deleteTempFile();
+            }
         } else {
             // If the destination already exists, then this blob
             // already exists and doesn't need to be written again
@@ -83,6 +248,12 @@ namespace litecore {
         _installed = true;
     }
 
+    void BlobWriteStream::discard() {
+        close();
+        deleteTempFile();
+        _installed = true;
+    }
+
     bool BlobWriteStream::deleteTempFile() {
         bool ok = false;
         try {
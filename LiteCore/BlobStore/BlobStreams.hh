@@ -12,19 +12,84 @@
 
 #pragma once
 #include "c4BlobStoreTypes.h"
+#include "BlobChunker.hh"
 #include "FilePath.hh"
 #include "SecureDigest.hh"
 #include "Stream.hh"
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace litecore {
+    namespace blip {
+        class Inflater;
+    }
 
     /** Returns a stream for reading a blob from the given file in the BlobStore. */
     unique_ptr<SeekableReadStream> OpenBlobReadStream(const FilePath& blobFile, EncryptionAlgorithm,
                                                       slice           encryptionKey);
 
+    /** A stream that reads a blob stored as a series of chunks, opening each chunk as it's reached. */
+    class ChunkedBlobReadStream final : public SeekableReadStream {
+      public:
+        using ChunkOpener = std::function<unique_ptr<SeekableReadStream>(const C4BlobKey&)>;
+
+        ChunkedBlobReadStream(std::vector<BlobChunk>, ChunkOpener);
+
+        [[nodiscard]] uint64_t getLength() const override { return _chunkStarts.back(); }
+
+        void   seek(uint64_t pos) override;
+        size_t read(void* dst NONNULL, size_t count) override;
+        void   close() override;
+
+      private:
+        std::vector<BlobChunk>         _chunks;
+        std::vector<uint64_t>          _chunkStarts;  // Offset of each chunk, plus the total length
+        ChunkOpener                    _openChunk;
+        size_t                         _curChunk{0};  // Index of the chunk containing _pos
+        unique_ptr<SeekableReadStream> _curStream;    // Stream on the current chunk, if open
+        uint64_t                       _pos{0};       // Current read position in the blob
+    };
+
+    /** A stream that reads a blob stored compressed: a header containing its length, followed by
+        its data in raw DEFLATE format. Seeking backwards has to start decompressing over again
+        from the beginning, so it's slow. */
+    class CompressedBlobReadStream final : public SeekableReadStream {
+      public:
+        static constexpr size_t kHeaderSize = 12;
+
+        /// The header to write before the compressed data of a blob of the given length.
+        static alloc_slice encodeHeader(uint64_t length);
+
+        /// Reads the header from the start of a compressed blob file, and returns the blob's length.
+        static uint64_t readHeader(SeekableReadStream& file);
+
+        /// Returns a stream that reads just the compressed data of a compressed blob file,
+        /// without decompressing it.
+        static unique_ptr<SeekableReadStream> openCompressedData(unique_ptr<SeekableReadStream> file);
+
+        explicit CompressedBlobReadStream(unique_ptr<SeekableReadStream> file);
+        ~CompressedBlobReadStream() override;
+
+        [[nodiscard]] uint64_t getLength() const override { return _length; }
+
+        void   seek(uint64_t pos) override;
+        size_t read(void* dst NONNULL, size_t count) override;
+        void   close() override;
+
+      private:
+        void restart();
+
+        unique_ptr<SeekableReadStream> _file;
+        unique_ptr<blip::Inflater>     _inflater;
+        uint64_t                       _length;
+        uint64_t                       _pos{0};       // Current read position in the blob
+        alloc_slice                    _inputBuffer;  // Compressed data read from the file
+        slice                          _input;        // The part of _inputBuffer not yet decompressed
+    };
+
     /** A stream for writing a new blob. */
     class BlobWriteStream final : public WriteStream {
       public:
@@ -46,6 +111,13 @@ namespace litecore {
             file must have the same contents.) */
         void install(const FilePath& dstPath);
 
+        /** Deletes the temporary file without installing it, because its contents have been
+            stored some other way. */
+        void discard();
+
+        /** The temporary file the data has been written to. */
+        [[nodiscard]] const FilePath& tempPath() const { return _tmpPath; }
+
       private:
         bool deleteTempFile();
 
@@ -14,9 +14,18 @@
 #include "Error.hh"
 #include "Logging.hh"
 #include "PlatformIO.hh"
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
 #include <memory>
 
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 namespace litecore {
     using namespace std;
 
@@ -78,6 +87,46 @@ namespace litecore {
         return bytesRead;
     }
 
+#ifndef _WIN32
+    MappedFileReadStream::MappedFileReadStream(const FilePath& path) {
+        int fd = ::open(path.path().c_str(), O_RDONLY | O_CLOEXEC);
+        if ( fd < 0 ) error::_throwErrno();
+        struct stat s {};
+        int         err = 0;
+        if ( ::fstat(fd, &s) != 0 ) {
+            err = errno;
+        } else if ( s.st_size > 0 ) {
+            void* mapping = ::mmap(nullptr, size_t(s.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if ( mapping == MAP_FAILED ) {
+                err = errno;
+            } else {
+                // The reader will usually go straight through the file:
+                ::madvise(mapping, size_t(s.st_size), MADV_SEQUENTIAL);
+                _contents = slice(mapping, size_t(s.st_size));
+            }
+        }
+        ::close(fd);  // the mapping doesn't need the fd
+        if ( err ) error::_throw(error::POSIX, err);
+    }
+
+    MappedFileReadStream::~MappedFileReadStream() { close(); }
+
+    void MappedFileReadStream::seek(uint64_t pos) { _pos = size_t(std::min(pos, uint64_t(_contents.size))); }
+
+    size_t MappedFileReadStream::read(void* dst, size_t count) {
+        count = std::min(count, _contents.size - _pos);
+        memcpy(dst, _contents.offset(_pos), count);
+        _pos += count;
+        return count;
+    }
+
+    void MappedFileReadStream::close() {
+        if ( _contents ) ::munmap((void*)_contents.buf, _contents.size);
+        _contents = nullslice;
+        _pos      = 0;
+    }
+#endif
+
     void FileWriteStream::write(slice data) {
         if ( _file ) {
             if ( fwrite(data.buf, 1, data.size, _file) < data.size ) checkErr(_file);
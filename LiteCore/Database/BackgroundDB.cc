@@ -59,7 +59,7 @@ namespace litecore {
 
             bool commit;
             try {
-                commit = task(keyStore, &sequenceTracker);
+                commit = task(keyStore, &sequenceTracker, t);
             } catch ( const exception& ) {
                 t.abort();
                 sequenceTracker.endTransaction(false);
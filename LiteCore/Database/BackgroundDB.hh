@@ -29,7 +29,7 @@ namespace litecore {
 
         access_lock<DataFile*>& dataFile() { return _dataFile; }
 
-        using TransactionTask = function_ref<bool(KeyStore&, SequenceTracker*)>;
+        using TransactionTask = function_ref<bool(KeyStore&, SequenceTracker*, ExclusiveTransaction&)>;
 
         void useInTransaction(slice keyStoreName, TransactionTask task);
 
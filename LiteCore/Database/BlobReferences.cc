@@ -0,0 +1,163 @@
+//
+// BlobReferences.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "BlobReferences.hh"
+#include "DataFile.hh"
+#include "Error.hh"
+#include "KeyStore.hh"
+#include "Record.hh"
+#include "RecordEnumerator.hh"
+#include "Logging.hh"
+#include <algorithm>
+
+namespace litecore {
+    using namespace std;
+
+    // Keys in the info store:
+    static constexpr slice kValidKey        = "blobRefsValid";
+    static constexpr slice kSweptThroughKey = "blobRefsSweptThrough";
+
+    // Separates the KeyStore name from the docID in a kDocBlobsStoreName key. (KeyStore names
+    // can't contain it, so the first occurrence is unambiguous.)
+    static constexpr char kDocKeySeparator = '/';
+
+    static_assert(sizeof(C4BlobKey) == 20);
+
+    BlobReferences::BlobReferences(DataFile& dataFile, ExclusiveTransaction& t)
+        : _transaction(t)
+        , _infoStore(dataFile.getKeyStore(DataFile::kInfoKeyStoreName, KeyStore::noSequences))
+        , _refCounts(dataFile.getKeyStore(kRefCountsStoreName, KeyStore::withSequences))
+        , _docBlobs(dataFile.getKeyStore(kDocBlobsStoreName, KeyStore::noSequences)) {}
+
+    bool BlobReferences::isValid() const {
+        Record rec(kValidKey);
+        return _infoStore.read(rec) && rec.bodyAsUInt() != 0;
+    }
+
+    void BlobReferences::markValid() {
+        Record rec(kValidKey);
+        rec.setBodyAsUInt(1);
+        _infoStore.setKV(rec, _transaction);
+    }
+
+    alloc_slice BlobReferences::docKey(slice keyStoreName, slice docID) {
+        alloc_slice key(keyStoreName.size + 1 + docID.size);
+        memcpy((void*)key.buf, keyStoreName.buf, keyStoreName.size);
+        ((char*)key.buf)[keyStoreName.size] = kDocKeySeparator;
+        memcpy((char*)key.buf + keyStoreName.size + 1, docID.buf, docID.size);
+        return key;
+    }
+
+    // Adds `delta` to a blob's reference count. Returns true if the count dropped to zero.
+    bool BlobReferences::addToCount(const C4BlobKey& blobKey, int delta) {
+        Record rec(blobKey.digestString());
+        _refCounts.read(rec);
+        int64_t count = int64_t(rec.bodyAsUInt()) + delta;
+        if ( count < 0 ) {
+            // Shouldn't happen while the counts are valid, but don't let it wrap around:
+            LogToAt(DBLog, Verbose, "Blob %s has negative ref-count", blobKey.digestString().c_str());
+            count = 0;
+        }
+        rec.setBodyAsUInt(uint64_t(count));
+        // Every update gets a new sequence; `takeUnreferenced` looks at the recently updated ones.
+        _refCounts.set(rec, true, _transaction);
+        return count == 0;
+    }
+
+    bool BlobReferences::setDocument(slice keyStoreName, slice docID, vector<C4BlobKey> keys) {
+        auto byBytes = [](const C4BlobKey& a, const C4BlobKey& b) { return memcmp(a.bytes, b.bytes, 20) < 0; };
+        sort(keys.begin(), keys.end(), byBytes);
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+        // The doc's record body is its sorted blob keys, concatenated:
+        Record rec(docKey(keyStoreName, docID));
+        if ( !_docBlobs.read(rec) && keys.empty() ) return false;
+        slice oldBody = rec.body();
+        if ( oldBody.size % sizeof(C4BlobKey) != 0 ) error::_throw(error::CorruptData, "Invalid blob refs record");
+        auto oldBegin = (const C4BlobKey*)oldBody.buf, oldEnd = (const C4BlobKey*)oldBody.end();
+        slice newBody(keys.data(), keys.size() * sizeof(C4BlobKey));
+        if ( newBody == oldBody ) return false;
+
+        vector<C4BlobKey> removed, added;
+        set_difference(oldBegin, oldEnd, keys.begin(), keys.end(), back_inserter(removed), byBytes);
+        set_difference(keys.begin(), keys.end(), oldBegin, oldEnd, back_inserter(added), byBytes);
+
+        bool unreferenced = false;
+        for ( auto& key : added ) addToCount(key, +1);
+        for ( auto& key : removed ) unreferenced |= addToCount(key, -1);
+
+        if ( keys.empty() ) _docBlobs.del(rec.key(), _transaction);
+        else
+            _docBlobs.setKV(rec.key(), newBody, _transaction);
+        return unreferenced;
+    }
+
+    void BlobReferences::moveDocument(slice keyStoreName, slice docID, slice toKeyStoreName, slice toDocID) {
+        // The blobs' counts don't change; the record just gets a new key.
+        Record rec(docKey(keyStoreName, docID));
+        if ( !_docBlobs.read(rec) ) return;
+        _docBlobs.del(rec.key(), _transaction);
+        _docBlobs.setKV(docKey(toKeyStoreName, toDocID), rec.body(), _transaction);
+    }
+
+    void BlobReferences::reset() {
+        _infoStore.del(kValidKey, _transaction);
+        _infoStore.del(kSweptThroughKey, _transaction);
+        for ( KeyStore* store : {&_refCounts, &_docBlobs} ) {
+            vector<alloc_slice>       keys;
+            RecordEnumerator::Options options;
+            options.sortOption    = kUnsorted;
+            options.contentOption = kMetaOnly;
+            RecordEnumerator e(*store, options);
+            while ( e.next() ) keys.push_back(e->key());
+            e.close();
+            for ( auto& key : keys ) store->del(key, _transaction);
+        }
+    }
+
+    vector<C4BlobKey> BlobReferences::takeUnreferenced(unsigned limit, bool& more) {
+        vector<C4BlobKey> result;
+        more = false;
+        if ( !isValid() ) return result;
+
+        // Counts that dropped to zero were updated, so they have sequences after the last sweep:
+        Record checkpoint(kSweptThroughKey);
+        _infoStore.read(checkpoint);
+        auto sweptThrough = sequence_t(checkpoint.bodyAsUInt());
+
+        // Every count scanned, zero or not, counts against the limit, so that a sweep after many
+        // updates is spread over several transactions instead of reading the whole store at once:
+        vector<alloc_slice> unreferenced;
+        {
+            RecordEnumerator::Options options;
+            options.sortOption = kAscending;
+            RecordEnumerator e(_refCounts, sweptThrough, options);
+            for ( unsigned scanned = 0; e.next(); ++scanned ) {
+                if ( scanned >= limit ) {
+                    more = true;
+                    break;
+                }
+                sweptThrough = e->sequence();
+                if ( e->bodyAsUInt() == 0 ) unreferenced.push_back(e->key());
+            }
+        }
+
+        for ( auto& digest : unreferenced ) {
+            _refCounts.del(digest, _transaction);
+            if ( auto key = C4BlobKey::withDigestString(digest); key ) result.push_back(*key);
+        }
+        checkpoint.setBodyAsUInt(uint64_t(sweptThrough));
+        _infoStore.setKV(checkpoint, _transaction);
+        return result;
+    }
+
+}  // namespace litecore
@@ -0,0 +1,80 @@
+//
+// BlobReferences.hh
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#pragma once
+#include "Base.hh"
+#include "c4BlobStoreTypes.h"
+#include <vector>
+
+namespace litecore {
+    class DataFile;
+    class ExclusiveTransaction;
+    class KeyStore;
+
+    /** Persistent reference counts of blobs, which let unused blobs be garbage-collected
+        incrementally instead of by scanning every document.
+
+        Two KeyStores hold the state: one maps each document (that has blobs) to the keys of all
+        the blobs referenced by any of its revisions; the other maps each blob key to the number of
+        documents referencing it. When a count drops to zero the blob becomes a candidate for
+        deletion, and `takeUnreferenced` returns candidates in bounded batches.
+
+        The counts are only trustworthy if every change to a document's blobs has been recorded,
+        so they're not used until `rebuild` has been called after a full scan of the documents
+        (which happens during compaction.) Until then `takeUnreferenced` returns nothing.
+
+        This is a lightweight object that just caches KeyStore references; create one as needed.
+        All methods must be called within the given transaction. */
+    class BlobReferences {
+      public:
+        BlobReferences(DataFile&, ExclusiveTransaction&);
+
+        /// True if the reference counts have been built, and are being maintained.
+        [[nodiscard]] bool isValid() const;
+
+        /// Records the set of blobs referenced by a document; the keys need not be sorted or unique.
+        /// Returns true if this caused any blob's count to drop to zero.
+        bool setDocument(slice keyStoreName, slice docID, std::vector<C4BlobKey> keys);
+
+        /// Records that a document has been purged. Returns true if any blob's count dropped to zero.
+        bool removeDocument(slice keyStoreName, slice docID) { return setDocument(keyStoreName, docID, {}); }
+
+        /// Records that a document has been moved and/or renamed.
+        void moveDocument(slice keyStoreName, slice docID, slice toKeyStoreName, slice toDocID);
+
+        /// Erases all reference counts and marks them as invalid, in preparation for a full scan.
+        /// The caller then calls `setDocument` for every document with blobs, then `markValid`.
+        void reset();
+
+        /// Marks the reference counts as valid, after a full scan.
+        void markValid();
+
+        /// Scans up to `limit` updated reference counts, returns the keys of the blobs among them that
+        /// are no longer referenced, and forgets about those; the caller should delete the blobs
+        /// before committing. Sets `more` to true if there are more counts to scan.
+        /// Returns nothing if the counts aren't valid.
+        std::vector<C4BlobKey> takeUnreferenced(unsigned limit, bool& more);
+
+        static constexpr slice kRefCountsStoreName = "blobrefs";  ///< blob key -> reference count
+        static constexpr slice kDocBlobsStoreName  = "blobdocs";  ///< doc -> its blob keys
+
+      private:
+        static alloc_slice docKey(slice keyStoreName, slice docID);
+        bool               addToCount(const C4BlobKey&, int delta);
+
+        ExclusiveTransaction& _transaction;
+        KeyStore&             _infoStore;
+        KeyStore&             _refCounts;
+        KeyStore&             _docBlobs;
+    };
+
+}  // namespace litecore
@@ -18,6 +18,7 @@
 #include "c4Internal.hh"
 #include "c4Observer.hh"
 #include "DatabaseImpl.hh"
+#include "BlobReferences.hh"
 #include "TreeDocument.hh"
 #include "VectorDocument.hh"
 #include "SequenceTracker.hh"
@@ -105,12 +106,21 @@ namespace litecore {
         }
 
         void transactionEnding(ExclusiveTransaction* transaction, bool committing) {
+            bool changed = false;
             if ( _sequenceTracker ) {
                 auto st = _sequenceTracker->useLocked();
+                changed = committing && st->changedDuringTransaction();
                 // Notify other Database instances on this file:
-                if ( committing && st->changedDuringTransaction() ) transaction->notifyCommitted(st);
+                if ( changed ) transaction->notifyCommitted(st);
                 st->endTransaction(committing);
             }
+
+            // Let the Housekeeper bring lazy indexes up to date with the changes:
+            if ( changed && isValid() && keyStore().lazyIndexesNeedUpdate() ) scheduleLazyIndexUpdate();
+
+            // ...and delete blobs that are no longer referenced:
+            if ( committing && _blobsUnreferenced && isValid() ) scheduleBlobSweep();
+            _blobsUnreferenced = false;
         }
 
         void externalTransactionCommitted(const SequenceTracker& sourceTracker) {
@@ -120,23 +130,71 @@ namespace litecore {
 #pragma mark - BLOBS:
 
         void findBlobReferences(const fleece::function_ref<bool(FLDict)>& blobCallback) override {
-            uint64_t                  numRevisions = 0;
             RecordEnumerator::Options options;
             options.onlyBlobs  = true;
             options.sortOption = kUnsorted;
             RecordEnumerator e(keyStore(), options);
             while ( e.next() ) {
                 Retained<C4Document> doc = _documentFactory->newDocumentInstance(e.record());
-                doc->selectCurrentRevision();
-                do {
-                    if ( doc->loadRevisionBody() ) {
-                        FLDict body = doc->getProperties();
-                        C4Blob::findBlobReferences(body, blobCallback);
-                        C4Blob::findAttachmentReferences(body, blobCallback);
-                        ++numRevisions;
-                    }
-                } while ( doc->selectNextRevision() );
+                findBlobReferences(doc, blobCallback);
+            }
+        }
+
+        // Calls the callback for every blob referenced by any revision of a document.
+        // (Changes the document's selected revision.)
+        static void findBlobReferences(C4Document* doc, const fleece::function_ref<bool(FLDict)>& blobCallback) {
+            doc->selectCurrentRevision();
+            do {
+                if ( doc->loadRevisionBody() ) {
+                    FLDict body = doc->getProperties();
+                    C4Blob::findBlobReferences(body, blobCallback);
+                    C4Blob::findAttachmentReferences(body, blobCallback);
+                }
+            } while ( doc->selectNextRevision() );
+        }
+
+        // Records the blobs referenced by every document in the persistent reference counts,
+        // and adds their keys to `usedKeys`. Called during compaction.
+        void rebuildBlobReferences(BlobReferences& refs, std::unordered_set<C4BlobKey>& usedKeys) {
+            RecordEnumerator::Options options;
+            options.onlyBlobs  = true;
+            options.sortOption = kUnsorted;
+            RecordEnumerator e(keyStore(), options);
+            while ( e.next() ) {
+                Retained<C4Document>   doc  = _documentFactory->newDocumentInstance(e.record());
+                std::vector<C4BlobKey> keys = blobKeysOf(doc);
+                usedKeys.insert(keys.begin(), keys.end());
+                refs.setDocument(keyStore().name(), doc->docID(), std::move(keys));
+            }
+        }
+
+        // Updates the blob reference counts after a document is saved.
+        void updateBlobReferences(C4Document* doc) {
+            BlobReferences* refs = dbImpl()->blobReferences();
+            if ( !refs ) return;
+            std::vector<C4BlobKey> keys;
+            if ( doc->flags() & kDocHasAttachments ) {
+                // Scan the revisions just saved, which are in memory; then restore the selection.
+                alloc_slice selectedRevID(doc->selectedRev().revID);
+                keys = blobKeysOf(doc);
+                doc->selectRevision(selectedRevID, false);
             }
+            if ( refs->setDocument(keyStore().name(), doc->docID(), std::move(keys)) ) _blobsUnreferenced = true;
+        }
+
+        void removeBlobReferences(slice docID) {
+            if ( BlobReferences* refs = dbImpl()->blobReferences() ) {
+                if ( refs->removeDocument(keyStore().name(), docID) ) _blobsUnreferenced = true;
+            }
+        }
+
+        static std::vector<C4BlobKey> blobKeysOf(C4Document* doc) {
+            std::vector<C4BlobKey> keys;
+            findBlobReferences(doc, [&](FLDict blob) {
+                if ( auto key = C4Blob::keyFromDigestProperty(blob); key ) keys.push_back(*key);
+                return true;
+            });
+            return keys;
         }
 
 #pragma mark - DOCUMENTS:
@@ -231,16 +289,7 @@ namespace litecore {
         Retained<C4Document> putDocument(const C4DocPutRequest& rq, size_t* outCommonAncestorIndex,
                                          C4Error* outError) override {
             dbImpl()->mustBeInTransaction();
-            if ( rq.docID.buf && !C4Document::isValidDocID(rq.docID) ) error::_throw(error::BadDocID);
-            if ( rq.existingRevision || rq.historyCount > 0 ) AssertParam(rq.docID.buf, "Missing docID");
-            if ( rq.existingRevision ) {
-                AssertParam(rq.historyCount > 0, "No history");
-            } else {
-                AssertParam(rq.historyCount <= 1, "Too much history");
-                AssertParam(rq.historyCount > 0 || !(rq.revFlags & kRevDeleted),
-                            "Can't create a new already-deleted document");
-                AssertParam(rq.remoteDBID == 0, "remoteDBID cannot be used when existingRevision=false");
-            }
+            checkPutRequest(rq);
 
             int                  commonAncestorIndex = 0;
             Retained<C4Document> doc;
@@ -250,32 +299,8 @@ namespace litecore {
                 // If there's already a record, doc will be null, so we'll continue down regular path.
             }
             if ( !doc ) {
-                if ( rq.existingRevision ) {
-                    // Insert existing revision:
-                    doc = getDocument(rq.docID, false, kDocGetAll);
-                    C4Error err;
-                    commonAncestorIndex = doc->putExistingRevision(rq, &err);
-                    if ( commonAncestorIndex < 0 ) {
-                        throwIfUnexpected(err, outError);
-                        doc                 = nullptr;
-                        commonAncestorIndex = 0;
-                    }
-                } else {
-                    // Create new revision:
-                    alloc_slice docID = (rq.docID.buf) ? alloc_slice(rq.docID) : C4Document::createDocID();
-
-                    slice parentRevID;
-                    if ( rq.historyCount > 0 ) parentRevID = rq.history[0];
-
-                    doc = getDocument(docID, false, kDocGetAll);
-                    C4Error err;
-                    if ( !doc->checkNewRev(parentRevID, rq.revFlags, rq.allowConflict, &err)
-                         || !doc->putNewRevision(rq, &err) ) {
-                        throwIfUnexpected(err, outError);
-                        doc = nullptr;
-                    }
-                    commonAncestorIndex = 0;
-                }
+                alloc_slice docID = (rq.docID.buf) ? alloc_slice(rq.docID) : C4Document::createDocID();
+                std::tie(doc, commonAncestorIndex) = putRevision(getDocument(docID, false, kDocGetAll), rq, outError);
             }
 
             Assert(commonAncestorIndex >= 0, "Unexpected conflict in c4doc_put");
@@ -283,6 +308,84 @@ namespace litecore {
             return doc;
         }
 
+        std::vector<Retained<C4Document>> putDocuments(const C4DocPutRequest* rqs, size_t count,
+                                                       C4Error* outErrors) override {
+            dbImpl()->mustBeInTransaction();
+            std::vector<Retained<C4Document>> docs(count);
+            std::vector<size_t>               toRead, toPutLater;
+            std::vector<slice>                readIDs;
+            std::unordered_set<slice>         docIDs;
+
+            // First insert the new docs, which doesn't require reading anything:
+            for ( size_t i = 0; i < count; ++i ) {
+                const C4DocPutRequest& rq = rqs[i];
+                outErrors[i]              = {};
+                try {
+                    checkPutRequest(rq);
+                    if ( !rq.docID.buf || !rq.save || !docIDs.insert(rq.docID).second ) {
+                        // Nothing to read ahead of time, or the doc is changed by an earlier request:
+                        toPutLater.push_back(i);
+                    } else if ( !isNewDocPutRequest(rq) || !(docs[i] = putNewDoc(rq).first) ) {
+                        toRead.push_back(i);
+                        readIDs.push_back(rq.docID);
+                    }
+                } catch ( ... ) { outErrors[i] = C4Error::fromCurrentException(); }
+            }
+
+            // Then read the existing docs in one batch, and add the revisions to them:
+            if ( !toRead.empty() ) {
+                std::vector<Record> records = keyStore().readMany(readIDs, kEntireBody);
+                for ( size_t j = 0; j < toRead.size(); ++j ) {
+                    size_t i = toRead[j];
+                    try {
+                        docs[i] = putRevision(newDocumentInstance(records[j]), rqs[i], &outErrors[i]).first;
+                    } catch ( ... ) { outErrors[i] = C4Error::fromCurrentException(); }
+                }
+            }
+
+            for ( size_t i : toPutLater ) {
+                try {
+                    docs[i] = putDocument(rqs[i], nullptr, &outErrors[i]);
+                } catch ( ... ) { outErrors[i] = C4Error::fromCurrentException(); }
+            }
+            return docs;
+        }
+
+        // Throws if a PutRequest is invalid.
+        static void checkPutRequest(const C4DocPutRequest& rq) {
+            if ( rq.docID.buf && !C4Document::isValidDocID(rq.docID) ) error::_throw(error::BadDocID);
+            if ( rq.existingRevision || rq.historyCount > 0 ) AssertParam(rq.docID.buf, "Missing docID");
+            if ( rq.existingRevision ) {
+                AssertParam(rq.historyCount > 0, "No history");
+            } else {
+                AssertParam(rq.historyCount <= 1, "Too much history");
+                AssertParam(rq.historyCount > 0 || !(rq.revFlags & kRevDeleted),
+                            "Can't create a new already-deleted document");
+                AssertParam(rq.remoteDBID == 0, "remoteDBID cannot be used when existingRevision=false");
+            }
+        }
+
+        // Adds the revision described by a PutRequest to a document that's been read from the db.
+        // Returns a null doc on conflict.
+        static pair<Retained<C4Document>, int> putRevision(Retained<C4Document> doc, const C4DocPutRequest& rq,
+                                                           C4Error* outError) {
+            C4Error err;
+            if ( rq.existingRevision ) {
+                // Insert existing revision:
+                int commonAncestorIndex = doc->putExistingRevision(rq, &err);
+                if ( commonAncestorIndex >= 0 ) return {doc, commonAncestorIndex};
+            } else {
+                // Create new revision:
+                slice parentRevID;
+                if ( rq.historyCount > 0 ) parentRevID = rq.history[0];
+                if ( doc->checkNewRev(parentRevID, rq.revFlags, rq.allowConflict, &err)
+                     && doc->putNewRevision(rq, &err) )
+                    return {doc, 0};
+            }
+            throwIfUnexpected(err, outError);
+            return {nullptr, 0};
+        }
+
         // Is this a PutRequest that doesn't require a Record to exist already?
         bool isNewDocPutRequest(const C4DocPutRequest& rq) const {
             if ( rq.deltaCB ) return false;
@@ -309,7 +412,10 @@ namespace litecore {
         void moveDocument(slice docID, C4Collection* toCollection, slice newDocID) override {
             C4Database::Transaction t(getDatabase());
             if ( newDocID ) C4Document::requireValidDocID(newDocID);
-            keyStore().moveTo(docID, ((CollectionImpl*)toCollection)->keyStore(), dbImpl()->transaction(), newDocID);
+            KeyStore& toStore = ((CollectionImpl*)toCollection)->keyStore();
+            keyStore().moveTo(docID, toStore, dbImpl()->transaction(), newDocID);
+            if ( BlobReferences* refs = dbImpl()->blobReferences() )
+                refs->moveDocument(keyStore().name(), docID, toStore.name(), (newDocID ? newDocID : docID));
             // DOES NOT NOTIFY SEQUENCE TRACKER! (should it?)
             t.commit();
         }
@@ -352,6 +458,7 @@ namespace litecore {
             C4Database::Transaction t(dbImpl());
             if ( !keyStore().del(docID, dbImpl()->transaction()) ) return false;
             if ( _sequenceTracker ) _sequenceTracker->useLocked()->documentPurged(docID);
+            removeBlobReferences(docID);
             t.commit();
             return true;
         }
@@ -359,14 +466,19 @@ namespace litecore {
         C4Timestamp nextDocExpiration() const override { return keyStore().nextExpiration(); }
 
         int64_t purgeExpiredDocs() override {
-            C4Database::Transaction t(getDatabase());
-            int64_t                 count;
+            C4Database::Transaction  t(getDatabase());
+            int64_t                  count;
+            std::vector<alloc_slice> expired;
             if ( _sequenceTracker ) {
                 auto st = _sequenceTracker->useLocked();
-                count   = keyStore().expireRecords([&](slice docID) { st->documentPurged(docID); });
+                count   = keyStore().expireRecords([&](slice docID) {
+                    st->documentPurged(docID);
+                    expired.emplace_back(docID);
+                });
             } else {
-                count = keyStore().expireRecords();
+                count = keyStore().expireRecords([&](slice docID) { expired.emplace_back(docID); });
             }
+            for ( auto& docID : expired ) removeBlobReferences(docID);
             t.commit();
             return count;
         }
@@ -380,6 +492,16 @@ namespace litecore {
             }
         }
 
+        void scheduleLazyIndexUpdate() {
+            startHousekeeping();
+            if ( _housekeeper ) _housekeeper->lazyIndexesChanged();
+        }
+
+        void scheduleBlobSweep() {
+            startHousekeeping();
+            if ( _housekeeper ) _housekeeper->blobsUnreferenced(getDatabase()->getBlobStore());
+        }
+
         bool stopHousekeeping() {
             if ( !_housekeeper ) return false;
             _housekeeper->stop();
@@ -396,6 +518,7 @@ namespace litecore {
                          const C4IndexOptions* indexOptions = nullptr) override {
             keyStore().createIndex(indexName, indexSpec, (QueryLanguage)indexLanguage, (IndexSpec::Type)indexType,
                                    (const IndexSpec::Options*)indexOptions);
+            if ( indexOptions && indexOptions->lazy ) scheduleLazyIndexUpdate();
         }
 
         void deleteIndex(slice indexName) override { keyStore().deleteIndex(indexName); }
@@ -421,6 +544,10 @@ namespace litecore {
                             FLEncoder_WriteString(enc, slice("n1ql"));
                             break;
                     }
+                    if ( spec.isLazy() ) {
+                        FLEncoder_WriteKey(enc, slice("lazy"));
+                        FLEncoder_WriteBool(enc, true);
+                    }
                     FLEncoder_EndDict(enc);
                 } else {
                     FLEncoder_WriteString(enc, slice(spec.name));
@@ -456,6 +583,7 @@ namespace litecore {
         unique_ptr<DocumentFactory>              _documentFactory;  // creates C4Document instances
         unique_ptr<access_lock<SequenceTracker>> _sequenceTracker;  // Doc change tracker/notifier
         Retained<Housekeeper>                    _housekeeper;      // for expiration/cleanup tasks
+        bool _blobsUnreferenced{false};  // True if the current transaction left blobs unreferenced
     };
 
     static inline CollectionImpl* asInternal(C4Collection* coll) { return (CollectionImpl*)coll; }
@@ -12,6 +12,8 @@
 
 #include "DatabaseImpl.hh"
 #include "CollectionImpl.hh"
+#include "Defer.hh"
+#include "DocumentKeys.hh"
 #include "VectorRecord.hh"
 #include "RecordEnumerator.hh"
 #include "RevID.hh"
@@ -19,6 +21,7 @@
 #include "VersionVector.hh"
 #include "Error.hh"
 #include "StringUtil.hh"
+#include "SharedKeys.hh"
 #include "fleece/Expert.hh"
 #include <cinttypes>
 #include <utility>
@@ -174,5 +177,59 @@ namespace litecore {
         return nuDoc.encodeBodyAndExtra();
     }
 
+    void DatabaseImpl::repackDocumentKeys() {
+        mustNotBeInTransaction();
+        if ( !(_config.flags & kC4DB_VersionVectors) )
+            error::_throw(error::Unimplemented, "Repacking document keys requires version vectors");
+
+        // Every connection caches the key table and assumes it only grows, so no other connection
+        // may be open while the keys are renumbered:
+        stopBackgroundTasks();
+        unsigned otherConnections = 0;
+        _dataFile->forOtherDataFiles([&](DataFile*) { ++otherConnections; });
+        if ( otherConnections > 0 )
+            error::_throw(error::Busy, "Can't repack document keys while the database is open elsewhere");
+
+        size_t oldKeyCount = _dataFile->documentKeys()->count();
+        LogTo(DBLog, "*** Repacking document keys ***");
+
+        // Re-encode every document with a new, empty key table, which ends up holding only the
+        // keys still in use:
+        Retained<SharedKeys> newKeys = new SharedKeys();
+        FLEncoder            enc     = FLEncoder_New();
+        DEFER { FLEncoder_Free(enc); };
+        FLEncoder_SetSharedKeys(enc, (FLSharedKeys)newKeys.get());
+
+        ExclusiveTransaction t(dataFile());
+        uint64_t             docCount = 0;
+        for ( string& ksName : _dataFile->allKeyStoreNames() ) {
+            if ( !SQLiteDataFile::keyStoreNameIsCollection(ksName) ) continue;
+            KeyStore&                 keyStore = _dataFile->getKeyStore(ksName);
+            RecordEnumerator::Options options;
+            options.sortOption     = kUnsorted;
+            options.includeDeleted = true;
+            options.contentOption  = kEntireBody;
+            RecordEnumerator e(keyStore, options);
+            while ( e.next() ) {
+                const Record& rec = e.record();
+                VectorRecord  doc(keyStore, Versioning::Vectors, rec);
+                doc.setEncoder(enc);
+                auto [body, extra] = doc.encodeBodyAndExtra();
+
+                RecordUpdate update(rec);
+                update.body  = body;
+                update.extra = extra;
+                Assert(keyStore.set(update, false, t) > 0_seq);
+                ++docCount;
+            }
+        }
+
+        _dataFile->getKeyStore(DataFile::kInfoKeyStoreName, KeyStore::noSequences)
+                .setKV("SharedKeys"_sl, newKeys->stateData(), t);
+        t.commit();
+        LogTo(DBLog, "\t%" PRIu64 " documents re-encoded; %zu document keys reduced to %zu", docCount, oldKeyCount,
+              newKeys->count());
+    }
+
 
 }  // namespace litecore
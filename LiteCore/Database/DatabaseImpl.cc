@@ -18,7 +18,10 @@
 #include "c4Private.h"
 #include "c4BlobStore.hh"
 #include "BackgroundDB.hh"
+#include "DatabaseMaintainer.hh"
 #include "DataFile.hh"
+#include "DocumentKeys.hh"
+#include "ReadConnectionPool.hh"
 #include "Record.hh"
 #include "SequenceTracker.hh"
 #include "FleeceImpl.hh"
@@ -133,6 +136,7 @@ namespace litecore {
         options.writeable           = (_config.flags & kC4DB_ReadOnly) == 0;
         options.upgradeable         = (_config.flags & kC4DB_NoUpgrade) == 0;
         options.useDocumentKeys     = true;
+        options.metadataIndexes     = (_config.flags & kC4DB_MetadataIndexes) != 0;
         options.encryptionAlgorithm = (EncryptionAlgorithm)_config.encryptionKey.algorithm;
         if ( options.encryptionAlgorithm != kNoEncryption ) {
 #ifdef COUCHBASE_ENTERPRISE
@@ -199,6 +203,8 @@ namespace litecore {
             // First-time initialization:
             (void)generateUUID(kPublicUUIDKey);
             (void)generateUUID(kPrivateUUIDKey);
+            // A new database has no blobs, so its (empty) blob reference counts are already valid:
+            BlobReferences(*_dataFile, transaction()).markValid();
         } else {
             // Should never occur (existing db must have its versioning marked!)
             error::_throw(error::WrongFormat);
@@ -265,6 +271,9 @@ namespace litecore {
 
         destructExtraInfo(extraInfo);
 
+        if ( _maintainer ) _maintainer->stop();  // It uses _backgroundDB
+        if ( _readPool ) _readPool->close();     // Checked-out connections may outlive me
+
         // Eagerly close the data file to ensure that no other instances will
         // be trying to use me as a delegate (for example in externalTransactionCommitted)
         // after I'm already in an invalid state.
@@ -332,25 +341,48 @@ namespace litecore {
         if ( what == kC4Compact ) garbageCollectBlobs();
     }
 
+    void DatabaseImpl::beginBulkImport() {
+        mustNotBeInTransaction();
+        _dataFile->beginBulkImport();
+    }
+
+    void DatabaseImpl::endBulkImport() {
+        mustNotBeInTransaction();
+        _dataFile->endBulkImport();
+    }
+
+    C4MaintenanceStats DatabaseImpl::getMaintenanceStats() const {
+        return _maintainer ? _maintainer->stats() : C4MaintenanceStats{};
+    }
+
+    C4DocumentKeysStats DatabaseImpl::getDocumentKeysStats() const {
+        auto keys = _dataFile->documentKeysImpl();
+        if ( !keys ) return {};
+        auto stats = keys->stats();
+        return {uint32_t(stats.count), stats.reads};
+    }
+
     void DatabaseImpl::garbageCollectBlobs() {
         // Lock the database to avoid any other thread creating a new blob, since if it did
         // I might end up deleting it during the sweep phase (deleteAllExcept).
         mustNotBeInTransaction();
         ExclusiveTransaction t(dataFile());
 
+        // Scan all the documents, rebuilding the blob reference counts from scratch. This also
+        // corrects any counts left too high by operations that don't track blobs, like deleting
+        // a collection, and makes the counts valid if they weren't already.
+        BlobReferences refs(*_dataFile, t);
+        refs.reset();
         unordered_set<C4BlobKey> usedDigests;
-        auto                     blobCallback = [&](FLDict blob) {
-            if ( auto key = C4Blob::keyFromDigestProperty(blob); key ) usedDigests.insert(*key);
-            return true;
-        };
-
-        forAllCollections([&](C4Collection* coll) { asInternal(coll)->findBlobReferences(blobCallback); });
+        forAllCollections([&](C4Collection* coll) { asInternal(coll)->rebuildBlobReferences(refs, usedDigests); });
+        refs.markValid();
 
         // Now delete all blobs that don't have one of the referenced keys:
         auto numDeleted = getBlobStore().deleteAllExcept(usedDigests);
         if ( numDeleted > 0 || !usedDigests.empty() ) {
             LogTo(DBLog, "    ...deleted %u blobs (%zu remaining)", numDeleted, usedDigests.size());
         }
+        t.commit();
     }
 
     BackgroundDB* DatabaseImpl::backgroundDatabase() {
@@ -358,6 +390,10 @@ namespace litecore {
         return _backgroundDB.get();
     }
 
+    ReadConnectionPool* DatabaseImpl::readConnectionPool() const {
+        return isInTransaction() ? nullptr : _readPool.get();
+    }
+
     void DatabaseImpl::stopBackgroundTasks() {
         // We can't hold the _collectionsMutex while calling stopHousekeeping(), or a deadlock may
         // result. So first enumerate the collections, then make the calls:
@@ -368,15 +404,33 @@ namespace litecore {
         }
         for ( auto& coll : collections ) asInternal(coll)->stopHousekeeping();
 
+        if ( _maintainer ) _maintainer->stop();
         if ( _backgroundDB ) _backgroundDB->close();
+        if ( _readPool ) _readPool->close();
     }
 
     void DatabaseImpl::startBackgroundTasks() {
-        for ( const string& name : _dataFile->allKeyStoreNames() ) {
+        if ( _config.flags & kC4DB_PooledReads ) {
+            if ( !_readPool ) {
+                _readPool = new ReadConnectionPool(this, ReadConnectionPool::defaultCapacity());
+            } else {
+                _readPool->reopen();
+            }
+        }
+
+        if ( (_config.flags & kC4DB_BackgroundMaintenance) && !(_config.flags & kC4DB_ReadOnly) ) {
+            if ( !_maintainer ) _maintainer = new DatabaseMaintainer(backgroundDatabase());
+            _maintainer->start();
+        }
+
+        // Only look at the KeyStores that may need it, to avoid opening every collection:
+        for ( const string& name : _dataFile->keyStoresNeedingHousekeeping() ) {
             if ( CollectionSpec collSpec = keyStoreNameToCollectionSpec(name); collSpec.name ) {
-                if ( _dataFile->getKeyStore(name).nextExpiration() > C4Timestamp::None ) {
+                KeyStore& keyStore = _dataFile->getKeyStore(name);
+                if ( keyStore.nextExpiration() > C4Timestamp::None ) {
                     asInternal(getCollection(collSpec))->startHousekeeping();
                 }
+                if ( keyStore.lazyIndexesNeedUpdate() ) asInternal(getCollection(collSpec))->scheduleLazyIndexUpdate();
             }
         }
     }
@@ -667,6 +721,16 @@ namespace litecore {
 
     bool DatabaseImpl::isInTransaction() const noexcept { return _transactionLevel > 0; }
 
+    BlobReferences* DatabaseImpl::blobReferences() {
+        // Check validity once per transaction; it can only change during compaction, which
+        // can't happen concurrently with this transaction.
+        if ( !_blobRefs ) {
+            _blobRefs.emplace(*_dataFile, transaction());
+            _blobRefsValid = _blobRefs->isValid();
+        }
+        return _blobRefsValid ? &*_blobRefs : nullptr;
+    }
+
     void DatabaseImpl::mustBeInTransaction() const {
         if ( !isInTransaction() ) error::_throw(error::NotInTransaction);
     }
@@ -686,6 +750,7 @@ namespace litecore {
                 throw;
             }
             _cleanupTransaction(commit);
+            if ( commit && _maintainer ) _maintainer->databaseChanged();
         }
     }
 
@@ -694,6 +759,7 @@ namespace litecore {
         // checkOpen performed inside forAllOpenCollections
         forAllOpenCollections(
                 [&](C4Collection* coll) { asInternal(coll)->transactionEnding(_transaction, committed); });
+        _blobRefs.reset();
         delete _transaction;
         _transaction = nullptr;
     }
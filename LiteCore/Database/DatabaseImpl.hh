@@ -15,6 +15,7 @@
 #include "c4Private.h"
 #include "c4Database.hh"
 #include "c4DocumentTypes.h"
+#include "BlobReferences.hh"
 #include "DataFile.hh"
 #include "FilePath.hh"
 #include "HybridClock.hh"
@@ -22,6 +23,7 @@
 #include "fleece/function_ref.hh"
 #include "fleece/slice.hh"
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 C4_ASSUME_NONNULL_BEGIN
@@ -36,7 +38,9 @@ namespace fleece::impl {
 namespace litecore {
     class BackgroundDB;
     class BlobStore;
+    class DatabaseMaintainer;
     class Housekeeper;
+    class ReadConnectionPool;
     class RevTreeRecord;
     class SequenceTracker;
 
@@ -65,6 +69,11 @@ namespace litecore {
 
         BackgroundDB* backgroundDatabase();
 
+        /// The pool of connections that queries and document enumerators read from, if the
+        /// kC4DB_PooledReads flag is set. Returns null if it isn't, or if a transaction is open,
+        /// since the pooled connections can't see its changes.
+        ReadConnectionPool* readConnectionPool() const;
+
         fleece::impl::Encoder& sharedEncoder() const;
 
         HybridClock& versionClock() const { return _versionClock; }
@@ -77,6 +86,11 @@ namespace litecore {
         void                  mustBeInTransaction() const;
         void                  mustNotBeInTransaction() const;
 
+        /// The blob reference counts, which must be updated when documents' blobs change.
+        /// Returns null if they aren't valid yet, in which case they needn't be maintained.
+        /// Must be called within a transaction.
+        BlobReferences* C4NULLABLE blobReferences();
+
         uint32_t maxRevTreeDepth();
         void     setMaxRevTreeDepth(uint32_t depth);
 
@@ -124,6 +138,16 @@ namespace litecore {
 
         alloc_slice rawQuery(slice query) override { return dataFile()->rawQuery(query.asString()); }
 
+        C4MaintenanceStats  getMaintenanceStats() const override;
+        C4DocumentKeysStats getDocumentKeysStats() const override;
+
+        /// Re-encodes all documents so that unused keys can be removed from the document keys
+        /// table. No other connection to the database may be open.
+        void repackDocumentKeys();
+
+        void beginBulkImport() override;
+        void endBulkImport() override;
+
         void lockClientMutex() noexcept override { _clientMutex.lock(); }
 
         void unlockClientMutex() noexcept override { _clientMutex.unlock(); }
@@ -185,13 +209,17 @@ namespace litecore {
         mutable std::recursive_mutex              _collectionsMutex;
         mutable CollectionsMap                    _collections;
         ExclusiveTransaction* C4NULLABLE          _transaction{nullptr};  // Current ExclusiveTransaction, or null
-        int                                       _transactionLevel{0};   // Nesting level of transactions
+        std::atomic<int>                          _transactionLevel{0};   // Nesting level of transactions
         mutable unique_ptr<fleece::impl::Encoder> _encoder;               // Shared Fleece Encoder
         mutable FLEncoder C4NULLABLE              _flEncoder{nullptr};    // Ditto, for clients
         mutable unique_ptr<C4BlobStore>           _blobStore;             // Blob storage
+        std::optional<BlobReferences>             _blobRefs;              // Blob ref-counts, in a transaction
+        bool                                      _blobRefsValid{false};  // Are _blobRefs being maintained?
         uint32_t                                  _maxRevTreeDepth{0};    // Max revision-tree depth
         std::recursive_mutex                      _clientMutex;           // Mutex for c4db_lock/unlock
         unique_ptr<BackgroundDB>                  _backgroundDB;          // for background operations
+        Retained<ReadConnectionPool>              _readPool;              // for concurrent reads
+        Retained<DatabaseMaintainer>              _maintainer;            // for WAL checkpoints & vacuuming
         mutable SourceID                          _mySourceID;            // My identifier in version vectors
         mutable HybridClock                       _versionClock;          // Version-vector clock
     };
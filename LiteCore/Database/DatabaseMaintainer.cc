@@ -0,0 +1,117 @@
+//
+// DatabaseMaintainer.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "DatabaseMaintainer.hh"
+#include "BackgroundDB.hh"
+#include "DataFile.hh"
+#include "Logging.hh"
+#include <algorithm>
+
+namespace litecore {
+    using namespace actor;
+    using namespace std;
+
+    DatabaseMaintainer::DatabaseMaintainer(BackgroundDB* bgdb)
+        : Actor(DBLog, "DatabaseMaintainer"), _bgdb(bgdb), _timer([this] { queueRun(); }) {}
+
+    void DatabaseMaintainer::start() { enqueue(FUNCTION_TO_QUEUE(DatabaseMaintainer::_start)); }
+
+    void DatabaseMaintainer::stop() {
+        enqueue(FUNCTION_TO_QUEUE(DatabaseMaintainer::_stop));
+        waitTillCaughtUp();
+    }
+
+    void DatabaseMaintainer::_start() {
+        logVerbose("Maintainer: started.");
+        _stopped = false;
+        _timer.fireAfter(kInterval);
+    }
+
+    void DatabaseMaintainer::_stop() {
+        _stopped = true;
+        _timer.stop();
+        logVerbose("Maintainer: stopped.");
+    }
+
+    void DatabaseMaintainer::databaseChanged() {
+        _lastChange = clock::now().time_since_epoch().count();
+        _changed    = true;
+    }
+
+    C4MaintenanceStats DatabaseMaintainer::stats() const {
+        lock_guard lock(_statsMutex);
+        return _stats;
+    }
+
+    void DatabaseMaintainer::queueRun() {
+        // Coalesce timer firings with a series of vacuum steps already in progress:
+        if ( !_runQueued.exchange(true) ) enqueue(FUNCTION_TO_QUEUE(DatabaseMaintainer::_run));
+    }
+
+    void DatabaseMaintainer::_run() {
+        _runQueued = false;
+        if ( _stopped ) return;
+        bool more = false;
+        _bgdb->dataFile().useLocked([&](DataFile* df) {
+            if ( !df ) return;
+            try {
+                more = maintain(*df);
+            } catch ( const exception& x ) { warn("Maintainer: caught exception: %s", x.what()); }
+        });
+        // If there's more vacuuming to do, re-enqueue, letting other tasks run first:
+        if ( more ) queueRun();
+        else
+            _timer.fireAfter(kInterval);
+    }
+
+    // Does what the database currently needs; returns true to be called again right away.
+    bool DatabaseMaintainer::maintain(DataFile& df) {
+        bool idle  = clock::now() - clock::time_point(clock::duration(_lastChange.load())) >= kIdleTime;
+        auto space = df.spaceStats();
+
+        // Checkpoint the WAL if it's changed, as soon as there's a lull in writing -- or sooner if
+        // it's getting big, since that makes reads slower and the eventual checkpoint longer.
+        if ( _changed && (idle || space.walPages * space.pageSize >= kCheckpointWALSize) ) {
+            _changed = false;
+            auto    start     = clock::now();
+            int64_t remaining = df.passiveCheckpoint();
+            double  ms        = chrono::duration<double, milli>(clock::now() - start).count();
+            if ( remaining > 0 ) _changed = true;  // A reader kept some pages from being copied; retry later
+            lock_guard lock(_statsMutex);
+            ++_stats.checkpoints;
+            _stats.lastCheckpointMS = ms;
+            _stats.maxCheckpointMS  = max(_stats.maxCheckpointMS, ms);
+            _stats.totalCheckpointMS += ms;
+        }
+
+        // Vacuum only while idle, since it has to hold the file lock that writers need.
+        if ( !idle || !_canVacuum || space.freePages == 0 ) return false;
+        if ( space.freePages * space.pageSize < kVacuumFreeSize
+             && double(space.freePages) < double(space.pageCount) * kVacuumFreeFraction )
+            return false;
+        int64_t freed = df.incrementalVacuum(kVacuumStepPages);
+        logVerbose("Maintainer: vacuumed %" PRIi64 " of %" PRIi64 " free pages", freed, space.freePages);
+        if ( freed == 0 ) {
+            // The database predates incremental vacuuming (see SQLiteDataFile::_vacuum); only a
+            // compaction will fix that.
+            _canVacuum = false;
+            return false;
+        }
+        {
+            lock_guard lock(_statsMutex);
+            ++_stats.vacuumSteps;
+            _stats.pagesReclaimed += freed;
+        }
+        return freed < space.freePages;
+    }
+
+}  // namespace litecore
@@ -0,0 +1,84 @@
+//
+// DatabaseMaintainer.hh
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#pragma once
+#include "Base.hh"
+#include "Actor.hh"
+#include "Timer.hh"
+#include "c4DatabaseTypes.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace litecore {
+    class BackgroundDB;
+    class DataFile;
+
+    /** Keeps a database file's write-ahead log and free space in check while it's open, so that
+        neither has to wait for an explicit compaction: it runs passive WAL checkpoints, which
+        don't block readers or writers, and vacuums free pages a slice at a time, which holds the
+        file lock only briefly. It works on the BackgroundDB's connection, waking up periodically
+        and doing only what the WAL size, the amount of free space and the time since the last
+        commit call for. */
+    class DatabaseMaintainer : public actor::Actor {
+      public:
+        using clock = std::chrono::steady_clock;
+
+        explicit DatabaseMaintainer(BackgroundDB* NONNULL);
+
+        /// Asynchronously starts the periodic maintenance.
+        void start();
+
+        /// Synchronously stops the maintenance. After this returns it will do nothing.
+        void stop();
+
+        /// Informs the maintainer that a transaction has been committed. (Thread-safe and cheap.)
+        void databaseChanged();
+
+        /// Returns the statistics of the maintenance done so far.
+        C4MaintenanceStats stats() const;
+
+        /// How often the maintainer checks whether there's anything to do.
+        static constexpr auto kInterval = std::chrono::seconds(1);
+
+        /// How long the database must go without commits to count as idle.
+        static constexpr auto kIdleTime = std::chrono::milliseconds(500);
+
+        /// Size of the WAL's uncheckpointed pages at which it's checkpointed even if the database
+        /// isn't idle.
+        static constexpr int64_t kCheckpointWALSize = 1024 * 1024;
+
+        /// Free space at which the database is vacuumed, in bytes or as a fraction of the file.
+        static constexpr int64_t kVacuumFreeSize     = 1024 * 1024;
+        static constexpr double  kVacuumFreeFraction = 0.1;
+
+        /// Max number of pages to free per vacuum step.
+        static constexpr int64_t kVacuumStepPages = 256;
+
+      private:
+        void _start();
+        void _stop();
+        void queueRun();
+        void _run();
+        bool maintain(DataFile&);
+
+        BackgroundDB*           _bgdb;
+        actor::Timer            _timer;
+        std::atomic<bool>       _runQueued{false};
+        std::atomic<bool>       _changed{true};    // Any commits since the last checkpoint?
+        std::atomic<clock::rep> _lastChange{0};    // Time of the last commit
+        bool                    _stopped{true};    // Set by _stop, cleared by _start
+        bool                    _canVacuum{true};  // Cleared if vacuuming has no effect
+        mutable std::mutex      _statsMutex;
+        C4MaintenanceStats      _stats{};
+    };
+}  // namespace litecore
@@ -15,9 +15,11 @@
 #include "DatabaseImpl.hh"
 #include "SequenceTracker.hh"
 #include "BackgroundDB.hh"
+#include "BlobReferences.hh"
 #include "DataFile.hh"
 #include "Logging.hh"
 #include "StringUtil.hh"
+#include <algorithm>
 
 namespace litecore {
     using namespace actor;
@@ -26,7 +28,7 @@ namespace litecore {
     Housekeeper::Housekeeper(C4Collection* coll)
         : Actor(DBLog, format("Housekeeper for %s", asInternal(coll)->fullName().c_str()))
         , _keyStoreName(asInternal(coll)->keyStore().name())
-        , _expiryTimer([this] { _doExpiration(); })
+        , _expiryTimer([this] { queueExpiration(); })
         , _collection(coll) {}
 
     void Housekeeper::start() {
@@ -44,7 +46,7 @@ namespace litecore {
         logVerbose("Housekeeper: stopped.");
     }
 
-    void Housekeeper::_scheduleExpiration(bool onlyIfEarlier) {
+    bool Housekeeper::_openBackgroundDB() {
         // CBL-3626: Opening the background database synchronously will
         // cause a deadlock when setting document expiration inside of
         // a transaction (inBatch) if it is the first time that document
@@ -55,13 +57,18 @@ namespace litecore {
         if ( !_bgdb && _collection && _collection->isValid() ) {
             _bgdb       = asInternal(_collection->getDatabase())->backgroundDatabase();
             _collection = nullptr;  // No longer needed, release the retain
-            logInfo("Housekeeper: opening background database to monitor expiration...");
+            logInfo("Housekeeper: opening background database...");
         }
 
         if ( !_bgdb ) {
             logError("Housekeeping unable to start, collection is closed and/or deleted!");
-            return;
+            return false;
         }
+        return true;
+    }
+
+    void Housekeeper::_scheduleExpiration(bool onlyIfEarlier) {
+        if ( !_openBackgroundDB() ) return;
 
         auto nextExp = _bgdb->dataFile().useLocked<expiration_t>([&](DataFile* df) {
             if ( !df ) { return expiration_t::None; }
@@ -90,20 +97,114 @@ namespace litecore {
         }
     }
 
+    void Housekeeper::queueExpiration() {
+        // Coalesce timer firings with a series of batches already in progress:
+        if ( !_expirationQueued.exchange(true) ) enqueue(FUNCTION_TO_QUEUE(Housekeeper::_doExpiration));
+    }
+
     void Housekeeper::_doExpiration() {
-        logVerbose("Housekeeper: expiring documents...");
-        _bgdb->useInTransaction(_keyStoreName, [&](KeyStore& keyStore, SequenceTracker* sequenceTracker) -> bool {
-            if ( sequenceTracker ) {
-                keyStore.expireRecords([&](slice docID) { sequenceTracker->documentPurged(docID); });
-            } else {
-                keyStore.expireRecords();
+        _expirationQueued = false;
+        if ( !_expiring ) {
+            logVerbose("Housekeeper: expiring documents...");
+            _expiring        = true;
+            _expiredCount    = 0;
+            _expirationStart = chrono::steady_clock::now();
+        }
+
+        // Purge one batch per transaction, so that when many documents expire at once, foreground
+        // writers don't have to wait long for the database lock; if there's more to do, re-enqueue,
+        // letting other tasks run first. Each batch is committed, so if the database is closed
+        // partway through, the rest are purged the next time it's opened.
+        unsigned count          = 0;
+        bool     anyBlobsUnrefd = false;
+        _bgdb->useInTransaction(_keyStoreName, [&](KeyStore& keyStore, SequenceTracker* sequenceTracker,
+                                                   ExclusiveTransaction& t) -> bool {
+            vector<alloc_slice> expired;
+            count = keyStore.expireRecords(
+                    [&](slice docID) {
+                        if ( sequenceTracker ) sequenceTracker->documentPurged(docID);
+                        expired.emplace_back(docID);
+                    },
+                    kExpirationBatchSize);
+            if ( BlobReferences refs(keyStore.dataFile(), t); refs.isValid() ) {
+                for ( auto& docID : expired ) anyBlobsUnrefd |= refs.removeDocument(keyStore.name(), docID);
             }
             return true;
         });
+        _expiredCount += count;
+        if ( anyBlobsUnrefd && _blobStore ) blobsUnreferenced(*_blobStore.load());
 
+        if ( count >= kExpirationBatchSize ) {
+            queueExpiration();
+            return;
+        }
+
+        _expiring = false;
+        if ( _expiredCount > 0 ) {
+            double secs = chrono::duration<double>(chrono::steady_clock::now() - _expirationStart).count();
+            logInfo("Housekeeper: purged %u expired docs in %.3f sec (%.0f docs/sec)", _expiredCount, secs,
+                    _expiredCount / max(secs, 1e-6));
+        }
         _scheduleExpiration(false);
     }
 
+    void Housekeeper::lazyIndexesChanged() {
+        // Coalesce notifications from multiple commits into a single queued update:
+        if ( !_lazyIndexUpdateQueued.exchange(true) ) enqueue(FUNCTION_TO_QUEUE(Housekeeper::_updateLazyIndexes));
+    }
+
+    void Housekeeper::_updateLazyIndexes() {
+        _lazyIndexUpdateQueued = false;
+        if ( !_openBackgroundDB() ) return;
+
+        // Update one batch per transaction, so foreground writers don't have to wait long for
+        // the database lock; if there's more to do, re-enqueue, letting other tasks run first.
+        bool more = false;
+        _bgdb->useInTransaction(_keyStoreName, [&](KeyStore& keyStore, SequenceTracker*, ExclusiveTransaction&) -> bool {
+            more = keyStore.updateLazyIndexes(kLazyIndexBatchSize);
+            return true;
+        });
+        logVerbose("Housekeeper: updated lazy indexes%s", (more ? "; more to do" : ""));
+        if ( more ) lazyIndexesChanged();
+    }
+
+    void Housekeeper::blobsUnreferenced(C4BlobStore& blobStore) {
+        _blobStore = &blobStore;
+        if ( !_blobSweepQueued.exchange(true) )
+            enqueue(FUNCTION_TO_QUEUE(Housekeeper::_sweepUnreferencedBlobs));
+    }
+
+    void Housekeeper::_sweepUnreferencedBlobs() {
+        _blobSweepQueued = false;
+        if ( !_openBackgroundDB() ) return;
+
+        // Deleting the blobs within the transaction keeps a document that references one from
+        // being saved meanwhile. But blobs are installed outside any transaction, before the
+        // document that will reference them is saved, so a blob (re)installed recently is left
+        // alone; if nothing references it after all, compaction will delete it.
+        // One batch per transaction, to avoid blocking foreground writers.
+        bool         more       = false;
+        unsigned     numDeleted = 0, numSkipped = 0;
+        C4BlobStore* blobStore  = _blobStore;
+        _bgdb->useInTransaction(_keyStoreName, [&](KeyStore& keyStore, SequenceTracker*,
+                                                   ExclusiveTransaction& t) -> bool {
+            BlobReferences refs(keyStore.dataFile(), t);
+            for ( C4BlobKey key : refs.takeUnreferenced(kBlobSweepBatchSize, more) ) {
+                if ( blobStore->isRecentlyInstalled(key) ) {
+                    ++numSkipped;
+                } else {
+                    blobStore->deleteBlob(key);
+                    ++numDeleted;
+                }
+            }
+            return true;
+        });
+        logVerbose("Housekeeper: deleted %u unreferenced blobs, skipped %u recent ones%s", numDeleted, numSkipped,
+                   (more ? "; more to do" : ""));
+        if ( more && !_blobSweepQueued.exchange(true) )
+            enqueue(FUNCTION_TO_QUEUE(Housekeeper::_sweepUnreferencedBlobs));
+    }
+
     void Housekeeper::documentExpirationChanged(expiration_t exp) {
         // This doesn't have to be enqueued, since Timer is thread-safe.
         if ( exp == expiration_t::None ) return;
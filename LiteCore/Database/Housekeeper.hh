@@ -15,7 +15,10 @@
 #include "Record.hh"
 #include "Actor.hh"
 #include "Timer.hh"
+#include <atomic>
+#include <chrono>
 
+struct C4BlobStore;
 struct C4Collection;
 
 namespace litecore {
@@ -36,15 +39,43 @@ namespace litecore {
         /// reschedule its next expiration for earlier if necessary.
         void documentExpirationChanged(expiration_t exp);
 
+        /// Informs the Housekeeper that documents covered by lazy indexes have changed, so it
+        /// can update those indexes in the background.
+        void lazyIndexesChanged();
+
+        /// Informs the Housekeeper that some blobs in this blob store are no longer referenced by
+        /// any document, so it can delete them in the background.
+        void blobsUnreferenced(C4BlobStore&);
+
+        /// Max number of changed documents to re-index per transaction, when updating lazy indexes.
+        static constexpr unsigned kLazyIndexBatchSize = 1000;
+
+        /// Max number of expired documents to purge per transaction.
+        static constexpr unsigned kExpirationBatchSize = 1000;
+
+        /// Max number of blob reference counts to scan (and so blobs to delete) per transaction.
+        static constexpr unsigned kBlobSweepBatchSize = 1000;
+
       private:
         void _start();
         void _stop();
+        bool _openBackgroundDB();
         void _scheduleExpiration(bool onlyIfEarlier);
+        void queueExpiration();
         void _doExpiration();
+        void _updateLazyIndexes();
+        void _sweepUnreferencedBlobs();
 
-        alloc_slice                    _keyStoreName;
-        BackgroundDB*                  _bgdb{nullptr};
-        actor::Timer                   _expiryTimer;
-        fleece::Retained<C4Collection> _collection;  // Used for initialization only
+        alloc_slice                           _keyStoreName;
+        BackgroundDB*                         _bgdb{nullptr};
+        actor::Timer                          _expiryTimer;
+        std::atomic<bool>                     _expirationQueued{false};
+        bool                                  _expiring{false};  // True while expiring a series of batches
+        unsigned                              _expiredCount{0};  // Docs purged so far in this series
+        std::chrono::steady_clock::time_point _expirationStart;
+        std::atomic<bool>                     _lazyIndexUpdateQueued{false};
+        std::atomic<C4BlobStore*>             _blobStore{nullptr};
+        std::atomic<bool>                     _blobSweepQueued{false};
+        fleece::Retained<C4Collection>        _collection;  // Used for initialization only
     };
 }  // namespace litecore
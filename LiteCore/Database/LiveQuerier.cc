@@ -40,7 +40,8 @@ namespace litecore {
         , _expression(query->expression())
         , _language(query->language())
         , _continuous(continuous)
-        , _delegate(delegate) {
+        , _delegate(delegate)
+        , _allowStaleIndexes(query->allowStaleIndexes()) {
         logInfo("Created on Query %s", query->loggingName().c_str());
         // Note that we don't keep a reference to `_query`, because it's tied to `db`, but we
         // need to run the query on `_backgroundDB`. So instead we save the query text and
@@ -147,6 +148,7 @@ namespace litecore {
                     if ( _continuous ) _backgroundDB->addTransactionObserver(this);
                 }
                 // Now run the query:
+                _query->setAllowStaleIndexes(_allowStaleIndexes);
                 newQE = _query->createEnumerator(&options);
             }
             catchError(&error);
@@ -45,6 +45,10 @@ namespace litecore {
             stopped, the function will be no-ops. */
         void changeOptions(const Query::Options& options);
 
+        /** Sets whether the query may use lazy indexes that haven't caught up with recent changes.
+            Takes effect the next time the query runs. */
+        void setAllowStaleIndexes(bool allow) { _allowStaleIndexes = allow; }
+
         void stop();
 
         /** The callback for getting the current result. */
@@ -84,6 +88,7 @@ namespace litecore {
         bool                      _continuous;           // Do I keep running until stopped?
         bool                      _waitingToRun{false};  // Is a call to _runQuery scheduled?
         std::atomic<bool>         _stopping{false};      // Has stop() been called?
+        std::atomic<bool>         _allowStaleIndexes;    // Copied to `_query` before it runs
     };
 
 }  // namespace litecore
@@ -16,11 +16,73 @@
 #include "Error.hh"
 #include "FilePath.hh"
 #include "Logging.hh"
+#include <algorithm>
+#include <atomic>
 #include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace litecore {
     using namespace std;
 
+    // Creates directory `to` and its subdirectories mirroring `from`, and adds the files in them to
+    // `items` as (source, destination) pairs.
+    static void collectFiles(const FilePath& from, const FilePath& to, vector<pair<FilePath, FilePath>>& items) {
+        to.mkdir();
+        from.forEachFile([&](const FilePath& f) {
+            if ( f.isDir() ) collectFiles(f, to[f.fileOrDirName() + "/"], items);
+            else
+                items.emplace_back(f, to[f.fileOrDirName()]);
+        });
+    }
+
+    // Copies the files in directory `from` into new directory `to`, several at a time.
+    // (A blob store's files are spread across shard subdirectories, so the directories are
+    // created first and then all the files are shared out among the threads.)
+    static void copyDirInParallel(const FilePath& from, const FilePath& to) {
+        vector<pair<FilePath, FilePath>> items;
+        collectFiles(from, to, items);
+
+        atomic<size_t> next{0};
+        auto           copyItems = [&] {
+            try {
+                for ( size_t i; (i = next++) < items.size(); ) {
+                    auto& [src, dst] = items[i];
+                    src.copyTo(dst);
+                }
+            } catch ( ... ) {
+                next = items.size();  // Make the other threads stop
+                throw;
+            }
+        };
+
+        unsigned             nThreads = min(clamp(thread::hardware_concurrency(), 2u, 8u), unsigned(items.size()));
+        vector<future<void>> workers;
+        for ( unsigned n = 1; n < nThreads; ++n ) workers.push_back(async(launch::async, copyItems));
+        copyItems();
+        for ( auto& worker : workers ) worker.get();
+    }
+
+    // Copies a database bundle. The blobs, which may be most of the data, are copied on other
+    // threads, so the returned future must be waited on before the copy is complete.
+    static future<void> copyBundle(const FilePath& from, const FilePath& to) {
+        if ( !from.isDir() ) {
+            from.copyTo(to);
+            return {};
+        }
+        to.mkdir();
+        optional<FilePath> blobs;
+        from.forEachFile([&](const FilePath& f) {
+            if ( f.isDir() && f.fileOrDirName() == "Attachments" ) blobs = f;
+            else
+                f.copyTo(to[f.fileOrDirName() + (f.isDir() ? "/" : "")]);
+        });
+        if ( !blobs ) return {};
+        return async(launch::async, [blobs = *blobs, to] { copyDirInParallel(blobs, to["Attachments/"]); });
+    }
+
     void CopyPrebuiltDB(const litecore::FilePath& from, const litecore::FilePath& to, const C4DatabaseConfig* config) {
         if ( !from.exists() ) {
             Warn("No database exists at %s, cannot copy!", from.path().c_str());
@@ -37,8 +99,9 @@ namespace litecore {
 
         FilePath temp = FilePath::sharedTempDirectory(std::string(to.parentDir())).mkTempDir();
         temp.delRecursive();
-        from.copyTo(temp);
+        auto copyingBlobs = copyBundle(from, temp);
 
+        // Open the copy while its blobs are still being copied:
         {
             Retained<C4Database> db;
             try {
@@ -55,6 +118,7 @@ namespace litecore {
             asInternal(db)->resetUUIDs();
             db->close();
         }
+        if ( copyingBlobs.valid() ) copyingBlobs.get();
 
         try {
             Log("Moving source DB to destination DB...");
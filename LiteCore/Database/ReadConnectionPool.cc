@@ -0,0 +1,159 @@
+//
+// ReadConnectionPool.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "ReadConnectionPool.hh"
+#include "DatabaseImpl.hh"
+#include "Query.hh"
+#include "Error.hh"
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+namespace litecore {
+    using namespace std;
+
+    // A connection's compiled queries are all dropped when there are more than this many.
+    static constexpr size_t kMaxCachedQueries = 50;
+
+    struct ReadConnectionPool::Connection::Entry {
+        unique_ptr<DataFile>                    dataFile;
+        unordered_map<string, Retained<Query>> queries;     // Compiled queries, by language+keystore+expr
+        unsigned                                generation;  // Pool's generation when this was opened
+
+        ~Entry() {
+            queries.clear();  // Queries must be freed before their DataFile
+            dataFile.reset();
+        }
+    };
+
+    ReadConnectionPool::ReadConnectionPool(DatabaseImpl* db, unsigned capacity)
+        : _database(db), _capacity(max(capacity, 1u)) {}
+
+    ReadConnectionPool::~ReadConnectionPool() { close(); }
+
+    unsigned ReadConnectionPool::defaultCapacity() { return clamp(thread::hardware_concurrency(), 2u, 8u); }
+
+    void ReadConnectionPool::close() {
+        // Don't wait for checked-out connections: a doc enumerator keeps its connection until it's
+        // freed, which may be after the database is closed. `release` will close them.
+        vector<unique_ptr<Connection::Entry>> closing;
+        {
+            unique_lock lock(_mutex);
+            _closed = true;
+            ++_generation;
+            for ( auto entry : _idle ) closing.push_back(extract(entry));
+            _idle.clear();
+            _cond.notify_all();
+        }
+        // (`closing` is destructed now, closing the idle connections outside the lock.)
+    }
+
+    void ReadConnectionPool::reopen() {
+        unique_lock lock(_mutex);
+        _closed = false;
+    }
+
+    ReadConnectionPool::Connection ReadConnectionPool::checkOut() { return {this, acquire(true)}; }
+
+    optional<ReadConnectionPool::Connection> ReadConnectionPool::tryCheckOut() {
+        if ( auto entry = acquire(false) ) return Connection(this, entry);
+        return nullopt;
+    }
+
+    ReadConnectionPool::Connection::Entry* ReadConnectionPool::acquire(bool wait) {
+        unique_lock lock(_mutex);
+        while ( true ) {
+            if ( _closed ) error::_throw(error::NotOpen);
+            if ( !_idle.empty() ) {
+                auto entry = _idle.back();
+                _idle.pop_back();
+                ++_busyCount;
+                return entry;
+            }
+            // (With none idle, every connection open or opening is busy.)
+            if ( _busyCount < _capacity ) break;
+            if ( !wait ) return nullptr;
+            _cond.wait(lock);
+        }
+
+        // Open a new connection. This is slow, so do it without holding the lock; counting it as
+        // busy reserves its place in the pool. If the pool is closed meanwhile, the connection's
+        // old generation makes `release` close it.
+        ++_busyCount;
+        auto entry        = make_unique<Connection::Entry>();
+        entry->generation = _generation;
+        lock.unlock();
+        try {
+            DataFile*         mainFile = _database->dataFile();
+            DataFile::Options options  = mainFile->options();
+            options.create = options.upgradeable = options.writeable = false;
+            entry->dataFile.reset(mainFile->openAnother(this, &options));
+            entry->dataFile->setDatabaseTag(kDatabaseTag_BackgroundDB);
+        } catch ( ... ) {
+            lock.lock();
+            --_busyCount;
+            _cond.notify_all();
+            throw;
+        }
+        lock.lock();
+        _connections.push_back(std::move(entry));
+        return _connections.back().get();
+    }
+
+    void ReadConnectionPool::release(Connection::Entry* entry) {
+        unique_ptr<Connection::Entry> closing;
+        unique_lock                   lock(_mutex);
+        --_busyCount;
+        if ( _closed || entry->generation != _generation ) {
+            // The pool was closed while this connection was checked out, so close it now:
+            closing = extract(entry);
+        } else {
+            _idle.push_back(entry);
+        }
+        _cond.notify_all();
+        lock.unlock();  // (Close `closing`, if any, outside the lock.)
+    }
+
+    unique_ptr<ReadConnectionPool::Connection::Entry> ReadConnectionPool::extract(Connection::Entry* entry) {
+        auto i = find_if(_connections.begin(), _connections.end(), [&](auto& e) { return e.get() == entry; });
+        Assert(i != _connections.end());
+        auto result = std::move(*i);
+        _connections.erase(i);
+        return result;
+    }
+
+    string ReadConnectionPool::databaseName() const { return _database->databaseName(); }
+
+    alloc_slice ReadConnectionPool::blobAccessor(const fleece::impl::Dict* dict) const {
+        return _database->blobAccessor(dict);
+    }
+
+#pragma mark - CONNECTION:
+
+    ReadConnectionPool::Connection::~Connection() {
+        if ( _entry ) _pool->release(_entry);
+    }
+
+    DataFile& ReadConnectionPool::Connection::dataFile() const { return *_entry->dataFile; }
+
+    Retained<Query> ReadConnectionPool::Connection::compileQuery(slice expression, QueryLanguage language,
+                                                                 const string& keyStoreName) {
+        string key = to_string(int(language)) + ':' + keyStoreName + ':' + string(expression);
+        if ( auto i = _entry->queries.find(key); i != _entry->queries.end() ) return i->second;
+        DataFile& df    = *_entry->dataFile;
+        auto      query = df.compileQuery(expression, language, &df.getKeyStore(keyStoreName));
+        if ( _entry->queries.size() >= kMaxCachedQueries ) _entry->queries.clear();
+        _entry->queries.emplace(std::move(key), query);
+        return query;
+    }
+
+}  // namespace litecore
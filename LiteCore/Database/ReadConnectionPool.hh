@@ -0,0 +1,103 @@
+//
+// ReadConnectionPool.hh
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#pragma once
+#include "DataFile.hh"
+#include "fleece/RefCounted.hh"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace litecore {
+    class DatabaseImpl;
+    class Query;
+
+    /** A pool of extra connections to a database's file, used for reading so that queries and
+        document enumerators on several threads can run at once instead of taking turns on the
+        database's own connection. (SQLite's WAL mode lets readers run concurrently with each
+        other and with a writer.)
+
+        Connections are opened read-only, on demand, up to the pool's capacity, and stay open until
+        the pool is closed. A caller checks one out, uses it, and returns it by destroying the
+        `Connection`. Each read on a connection sees a consistent snapshot of the committed data,
+        but not any changes in the database's current transaction; DatabaseImpl doesn't use the
+        pool then.
+
+        This class is thread-safe. */
+    class ReadConnectionPool final
+        : public fleece::RefCounted
+        , private DataFile::Delegate {
+      public:
+        ReadConnectionPool(DatabaseImpl*, unsigned capacity);
+
+        /// The default capacity: one connection per CPU core, within reason.
+        static unsigned defaultCapacity();
+
+        /// Closes the idle connections. Checked-out ones are closed when they're returned, so this
+        /// doesn't wait for them. Until `reopen` is called, checking out a connection throws NotOpen.
+        void close();
+
+        /// Allows connections to be checked out again after `close`.
+        void reopen();
+
+        /** A connection checked out of the pool. It's returned when this object is destroyed. */
+        class Connection {
+          public:
+            Connection(Connection&& c) noexcept : _pool(std::move(c._pool)), _entry(c._entry) { c._entry = nullptr; }
+
+            ~Connection();
+
+            DataFile& dataFile() const;
+
+            /// Returns a Query compiled on this connection, which may be one compiled earlier.
+            Retained<Query> compileQuery(slice expression, QueryLanguage, const string& keyStoreName);
+
+          private:
+            friend class ReadConnectionPool;
+            struct Entry;
+
+            Connection(ReadConnectionPool* pool, Entry* entry) : _pool(pool), _entry(entry) {}
+
+            Retained<ReadConnectionPool> _pool;  // Keeps the pool alive while I'm checked out
+            Entry*                       _entry;
+        };
+
+        /// Checks out a connection, waiting for one to be returned if they're all in use.
+        Connection checkOut();
+
+        /// Checks out a connection, or returns nullopt if they're all in use.
+        std::optional<Connection> tryCheckOut();
+
+      private:
+        ~ReadConnectionPool() override;
+
+        Connection::Entry*                 acquire(bool wait);
+        void                               release(Connection::Entry*);
+        std::unique_ptr<Connection::Entry> extract(Connection::Entry*);
+
+        [[nodiscard]] string databaseName() const override;
+        alloc_slice          blobAccessor(const fleece::impl::Dict*) const override;
+
+        DatabaseImpl*                                   _database;
+        unsigned const                                  _capacity;
+        std::mutex                                      _mutex;
+        std::condition_variable                         _cond;
+        std::vector<std::unique_ptr<Connection::Entry>> _connections;    // All open connections
+        std::vector<Connection::Entry*>                 _idle;           // Open connections not checked out
+        unsigned                                        _busyCount{0};   // Connections checked out or opening
+        unsigned                                        _generation{0};  // Incremented by every `close`
+        bool                                            _closed{false};
+    };
+
+}  // namespace litecore
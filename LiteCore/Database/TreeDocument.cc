@@ -15,6 +15,7 @@
 #include "DatabaseImpl.hh"
 #include "Record.hh"
 #include "RevTreeRecord.hh"
+#include "RawRevTree.hh"
 #include "DeepIterator.hh"
 #include "Delimiter.hh"
 #include "Error.hh"
@@ -321,6 +322,7 @@ namespace litecore {
                 case litecore::RevTreeRecord::kConflict:
                     return false;
                 case litecore::RevTreeRecord::kNoNewSequence:
+                    asInternal(collection())->updateBlobReferences(this);
                     return true;
                 case litecore::RevTreeRecord::kNewSequence:
                     _selected.flags &= ~kRevNew;
@@ -329,6 +331,7 @@ namespace litecore {
                         if ( _selected.sequence == 0_seq ) _selected.sequence = _sequence;
                         asInternal(collection())->documentSaved(this);
                     }
+                    asInternal(collection())->updateBlobReferences(this);
                     return true;
                 default:
                     Assert(false, "Invalid save result received");
@@ -660,26 +663,31 @@ namespace litecore {
             revID.parse(revMap[rec.key]);
             auto                          revGeneration = revID.getRevID().generation();
             C4FindDocAncestorsResultFlags status        = {};
-            RevTree                       tree(rec.body, rec.extra, 0_seq);
-            auto                          current = tree.currentRevision();
-
-            if ( remoteDBID == RevTree::kDefaultRemoteID && (rec.flags & DocumentFlags::kSynced) ) {
-                // CBL-2579: Special case where the main remote DB is pending local update
-                // of its remote ancestor
-                tree.setLatestRevisionOnRemote(RevTree::kDefaultRemoteID, current);
-            }
+            // Read-only, so there's no need to decode the tree into a RevTree:
+            RevTreeView tree(rec.body, rec.extra);
+            auto        current = tree.currentRevision();
 
             // Does it exist in the doc?
-            if ( const Rev* rev = tree[revID.getRevID()] ) {
-                if ( rev->isBodyAvailable() ) status |= kRevsHaveLocal;
-                if ( remoteDBID && rev == tree.latestRevisionOnRemote(remoteDBID) ) status |= kRevsAtThisRemote;
-                if ( current != rev ) {
-                    if ( rev->isAncestorOf(current) ) status |= kRevsLocalIsNewer;
+            if ( auto rev = tree.get(revID.getRevID()) ) {
+                if ( rev->bodyAvailable ) status |= kRevsHaveLocal;
+                if ( remoteDBID ) {
+                    unsigned remoteRev;
+                    if ( remoteDBID == RevTree::kDefaultRemoteID && (rec.flags & DocumentFlags::kSynced) ) {
+                        // CBL-2579: Special case where the main remote DB is pending local update
+                        // of its remote ancestor
+                        remoteRev = current.index;
+                    } else {
+                        remoteRev = tree.latestRevisionOnRemote(remoteDBID);
+                    }
+                    if ( rev->index == remoteRev ) status |= kRevsAtThisRemote;
+                }
+                if ( current.index != rev->index ) {
+                    if ( tree.isAncestorOf(rev->index, current.index) ) status |= kRevsLocalIsNewer;
                     else
                         status |= kRevsConflict;
                 }
             } else {
-                if ( current->revID.generation() < revGeneration ) status |= kRevsLocalIsOlder;
+                if ( current.revID.generation() < revGeneration ) status |= kRevsLocalIsOlder;
                 else
                     status |= kRevsConflict;
             }
@@ -692,15 +700,16 @@ namespace litecore {
             result << statusChar << '[';
             char      expandedBuf[100];
             delimiter delim(",");
-            for ( auto rev : tree.allRevisions() ) {
-                if ( rev->revID.generation() < revGeneration && !(mustHaveBodies && !rev->isBodyAvailable()) ) {
+            tree.forEachRevision([&](const RevTreeView::RevInfo& rev) {
+                if ( rev.revID.generation() < revGeneration && !(mustHaveBodies && !rev.bodyAvailable) ) {
                     slice_ostream expanded(expandedBuf, sizeof(expandedBuf));
-                    if ( rev->revID.expandInto(expanded) ) {
+                    if ( rev.revID.expandInto(expanded) ) {
                         result << delim << '"' << expanded.output() << '"';
-                        if ( delim.count() >= maxAncestors ) break;
+                        if ( delim.count() >= maxAncestors ) return false;
                     }
                 }
-            }
+                return true;
+            });
             result << ']';
             return alloc_slice(result.str());
         };
@@ -481,6 +481,7 @@ namespace litecore {
                     return true;
                 case VectorRecord::kNoNewSequence:
                     _updateDocFields();  // flags may have changed
+                    asInternal(collection())->updateBlobReferences(this);
                     return true;
                 case VectorRecord::kConflict:
                     return false;
@@ -495,6 +496,7 @@ namespace litecore {
                                                     SPLAT(revID), (uint64_t)_sequence);
                     }
                     asInternal(collection())->documentSaved(this);
+                    asInternal(collection())->updateBlobReferences(this);
                     return true;
             }
             return false;  // unreachable
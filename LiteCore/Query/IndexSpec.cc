@@ -14,6 +14,7 @@
 #include "IndexSpec.hh"
 #include "QueryParser+Private.hh"
 #include "Error.hh"
+#include "StringUtil.hh"
 #include "Doc.hh"
 #include "fleece/FLMutable.h"
 #include "n1ql_parser.hh"
@@ -30,7 +31,15 @@ namespace litecore {
         , type(type_)
         , expression(std::move(expression_))
         , queryLanguage(queryLanguage_)
-        , options(opt ? std::make_optional(*opt) : std::optional<Options>()) {}
+        , options(opt ? std::make_optional(*opt) : std::optional<Options>())
+        , whereClause((opt && opt->where) ? alloc_slice(slice(opt->where)) : alloc_slice()) {
+        if ( opt && opt->progressCallback ) {
+            progress = [callback = opt->progressCallback, context = opt->progressContext](float fraction) {
+                callback(context, fraction);
+            };
+        }
+        if ( opt ) maxBuildThreads = opt->maxBuildThreads;
+    }
 
     IndexSpec::IndexSpec(IndexSpec&&) = default;
     IndexSpec::~IndexSpec()           = default;
@@ -43,33 +52,43 @@ namespace litecore {
         }
     }
 
-    Doc* IndexSpec::doc() const {
-        if ( !_doc ) {
-            switch ( queryLanguage ) {
-                case QueryLanguage::kJSON:
-                    try {
-                        _doc = Doc::fromJSON(expression);
-                    } catch ( const FleeceException& ) {
-                        error::_throw(error::InvalidQuery, "Invalid JSON in index expression");
-                    }
-                    break;
-                case QueryLanguage::kN1QL:
-                    try {
-                        int           errPos;
-                        FLMutableDict result = n1ql::parse(string(expression), &errPos);
-                        if ( !result ) { throw Query::parseError("N1QL syntax error in index expression", errPos); }
-                        alloc_slice json = ((MutableDict*)result)->toJSON(true);
-                        FLMutableDict_Release(result);
-                        _doc = Doc::fromJSON(json);
-                    } catch ( const std::runtime_error& ) {
-                        error::_throw(error::InvalidQuery, "Invalid N1QL in index expression");
+    // Parses an index expression (or partial-index condition) in the given language into a Doc.
+    // N1QL is parsed as a result list, so the Doc's root will be a dict with a "WHAT" array.
+    static Retained<Doc> parseIndexExpression(slice expression, QueryLanguage language, const char* what) {
+        switch ( language ) {
+            case QueryLanguage::kJSON:
+                try {
+                    return Doc::fromJSON(expression);
+                } catch ( const FleeceException& ) {
+                    error::_throw(error::InvalidQuery, "Invalid JSON in index %s", what);
+                }
+            case QueryLanguage::kN1QL:
+                try {
+                    int           errPos;
+                    FLMutableDict result = n1ql::parse(string(expression), &errPos);
+                    if ( !result ) {
+                        throw Query::parseError(format("N1QL syntax error in index %s", what).c_str(), errPos);
                     }
-                    break;
-            }
+                    alloc_slice json = ((MutableDict*)result)->toJSON(true);
+                    FLMutableDict_Release(result);
+                    return Doc::fromJSON(json);
+                } catch ( const std::runtime_error& ) {
+                    error::_throw(error::InvalidQuery, "Invalid N1QL in index %s", what);
+                }
         }
+        error::_throw(error::InvalidParameter, "Unknown query language");
+    }
+
+    Doc* IndexSpec::doc() const {
+        if ( !_doc ) _doc = parseIndexExpression(expression, queryLanguage, "expression");
         return _doc;
     }
 
+    Doc* IndexSpec::whereDoc() const {
+        if ( !_whereDoc && whereClause ) _whereDoc = parseIndexExpression(whereClause, queryLanguage, "condition");
+        return _whereDoc;
+    }
+
     const Array* IndexSpec::what() const {
         const Array* what;
         if ( auto dict = doc()->asDict(); dict ) {
@@ -84,10 +103,23 @@ namespace litecore {
     }
 
     const Array* IndexSpec::where() const {
-        if ( auto dict = doc()->asDict(); dict ) {
-            if ( auto whereVal = qp::getCaseInsensitive(dict, "WHERE"); whereVal )
-                return qp::requiredArray(whereVal, "Index WHERE term");
+        const Value* whereVal = nullptr;
+        if ( auto dict = doc()->asDict(); dict ) whereVal = qp::getCaseInsensitive(dict, "WHERE");
+
+        if ( auto wdoc = whereDoc(); wdoc ) {
+            if ( whereVal )
+                error::_throw(error::InvalidQuery, "Index has both a WHERE term and a 'where' option");
+            whereVal = wdoc->root();
+            if ( queryLanguage == QueryLanguage::kN1QL ) {
+                // The N1QL parser returns the condition as the single item of a "WHAT" list:
+                auto list = qp::requiredArray(qp::getCaseInsensitive(whereVal->asDict(), "WHAT"),
+                                              "Index WHERE term");
+                if ( list->count() != 1 ) error::_throw(error::InvalidQuery, "Index WHERE term must be one expression");
+                whereVal = list->get(0);
+            }
         }
+
+        if ( whereVal ) return qp::requiredArray(whereVal, "Index WHERE term");
         return nullptr;
     }
 
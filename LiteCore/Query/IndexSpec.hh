@@ -12,6 +12,7 @@
 
 #pragma once
 #include "Base.hh"
+#include <functional>
 #include <optional>
 #include <string>
 
@@ -40,8 +41,18 @@ namespace litecore {
             bool        ignoreDiacritics;  ///< True to strip diacritical marks/accents from letters
             bool        disableStemming;   ///< Disables stemming
             const char* stopWords;         ///< NULL for default, or comma-delimited string, or empty
+            const char* where;             ///< NULL, or condition for a partial index (value indexes only)
+            bool        lazy;              ///< Update index in background (array/predictive indexes only)
+            bool        useFTS5;           ///< Use SQLite FTS5 instead of FTS4 (full-text indexes only)
+            void (*progressCallback)(void* context, float fraction);  ///< Sets `progress` (below)
+            void*    progressContext;  ///< Passed to `progressCallback`
+            unsigned maxBuildThreads;  ///< Sets `maxBuildThreads` (below)
         };
 
+        /** Callback invoked while an index is being built, with the approximate fraction of the
+            collection that's been indexed so far (0.0 ... 1.0). */
+        using ProgressCallback = std::function<void(float fraction)>;
+
         IndexSpec(std::string name_, Type type_, alloc_slice expression_,
                   QueryLanguage queryLanguage = QueryLanguage::kJSON, const Options* opt = nullptr);
 
@@ -62,19 +73,30 @@ namespace litecore {
         /** The required WHAT clause: the list of expressions to index */
         const fleece::impl::Array* NONNULL what() const;
 
-        /** The optional WHERE clause: the condition for a partial index */
+        /** The optional WHERE clause: the condition for a partial index. This comes either from a
+            `WHERE` key in the JSON expression, or from the `where` option. */
         const fleece::impl::Array* where() const;
 
+        /** True if a partial-index condition was given via the `where` option. */
+        bool hasWhereOption() const { return !whereClause.empty(); }
+
+        /** True if the index should be updated lazily, in the background, instead of on every save. */
+        bool isLazy() const { return options && options->lazy; }
+
         std::string const            name;
         Type const                   type;
         alloc_slice const            expression;
         QueryLanguage                queryLanguage;
         std::optional<Options> const options;
+        alloc_slice const            whereClause;  ///< Copy of `options->where`, in `queryLanguage`
+        ProgressCallback             progress;            ///< Optional; reports progress of building the index
+        unsigned                     maxBuildThreads{0};  ///< Max helper threads for sorting keys; 0 = auto
 
       private:
         fleece::impl::Doc* doc() const;
+        fleece::impl::Doc* whereDoc() const;
 
-        mutable Retained<fleece::impl::Doc> _doc;
+        mutable Retained<fleece::impl::Doc> _doc, _whereDoc;
     };
 
 }  // namespace litecore
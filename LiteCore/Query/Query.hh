@@ -62,6 +62,17 @@ namespace litecore {
 
         virtual void close() { _dataFile = nullptr; }
 
+        /** If true, the query may run against lazy indexes that haven't yet caught up with recent
+            changes; otherwise (the default) they're brought up to date before the query runs. */
+        void setAllowStaleIndexes(bool allow) { _allowStaleIndexes = allow; }
+
+        bool allowStaleIndexes() const { return _allowStaleIndexes; }
+
+        /** Brings any lazy indexes on the collections this query reads up to date, using `df`,
+            which is another writeable connection to the same file. (A query compiled on a
+            read-only connection can't update them itself.) */
+        virtual void updateLazyIndexes(DataFile& df) {}
+
         struct Options {
             Options() = default;
 
@@ -101,10 +112,11 @@ namespace litecore {
         std::string  loggingIdentifier() const override;
 
       private:
-        DataFile*     _dataFile;
-        alloc_slice   _expression;
-        QueryLanguage _language;
-        bool          _disposed{false};
+        DataFile*         _dataFile;
+        alloc_slice       _expression;
+        QueryLanguage     _language;
+        bool              _disposed{false};
+        std::atomic<bool> _allowStaleIndexes{false};
     };
 
     /** Iterator/enumerator of query results. Abstract class created by Query::createEnumerator. */
@@ -560,8 +560,10 @@ namespace litecore {
                 Warn("The collecion is not specified. Hacked it to default.");
                 coAlias = _dbAlias;
             }
-            _sql << " JOIN " << sqlIdentifier(table) << " AS " << alias << " ON " << alias
-                 << ".docid = " << sqlIdentifier(coAlias) << ".rowid";
+            // (FTS5 tables have no `docid` column, just `rowid`.)
+            const char* docidColumn = _delegate.isFTS5Table(table) ? "rowid" : "docid";
+            _sql << " JOIN " << sqlIdentifier(table) << " AS " << alias << " ON " << alias << "." << docidColumn
+                 << " = " << sqlIdentifier(coAlias) << ".rowid";
         }
     }
 
@@ -1391,12 +1393,16 @@ namespace litecore {
         // Special case: "array_count(propertyname)" turns into a call to fl_count:
         if ( op.caseEquivalent(kArrayCountFnName) && writeNestedPropertyOpIfAny(kCountFnName, operands) ) return;
 
-        // Special case: in "rank(ftsName)" the param has to be a matchinfo() call:
+        // Special case: in "rank(ftsName)" the param has to be a matchinfo() call.
+        // FTS5 has built-in BM25 ranking instead; it returns more negative values for better matches.
         if ( op.caseEquivalent(kRankFnName) ) {
             string fts = FTSTableName(operands[0]).first;
             auto   i   = _indexJoinTables.find(fts);
             if ( i == _indexJoinTables.end() ) fail("rank() can only be called on FTS indexes");
-            _sql << "rank(matchinfo(" << i->second << "." << sqlIdentifier(i->first) << "))";
+            if ( _delegate.isFTS5Table(fts) )
+                _sql << "(-bm25(" << i->second << "." << sqlIdentifier(i->first) << "))";
+            else
+                _sql << "rank(matchinfo(" << i->second << "." << sqlIdentifier(i->first) << "))";
             return;
         }
 
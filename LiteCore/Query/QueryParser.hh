@@ -68,6 +68,8 @@ namespace litecore {
 #ifdef COUCHBASE_ENTERPRISE
             [[nodiscard]] virtual string predictiveTableName(const string& onTable, const string& property) const = 0;
 #endif
+            /// True if the FTS table is an FTS5 table rather than FTS4.
+            [[nodiscard]] virtual bool isFTS5Table(const string& tableName) const { return false; }
         };
 
         QueryParser(const Delegate& delegate, string defaultCollectionName, string defaultTableName)
@@ -18,9 +18,11 @@
 #include "SQLiteCpp/Database.h"
 #include "SQLUtil.hh"
 #include "StringUtil.hh"
+#include "Stopwatch.hh"
 #include "Array.hh"
 #include "Encoder.hh"
 #include "sqlite3.h"
+#include <algorithm>
 
 using namespace std;
 using namespace fleece;
@@ -106,6 +108,13 @@ namespace litecore {
         LogTo(QueryLog, "Deleting %s index '%s'", spec.typeName(), spec.name.c_str());
         unregisterIndex(spec.name);
         if ( spec.type != IndexSpec::kFullText ) exec(CONCAT("DROP INDEX IF EXISTS " << sqlIdentifier(spec.name)));
+        if ( spec.type == IndexSpec::kValue && _bulkImport ) {
+            // Don't rebuild it at the end of the bulk import:
+            SQLite::Statement stmt(*this, "DELETE FROM deferredIndexes WHERE name=?");
+            stmt.bindNoCopy(1, spec.name);
+            LogStatement(stmt);
+            stmt.exec();
+        }
         if ( !spec.indexTableName.empty() ) garbageCollectIndexTable(spec.indexTableName);
     }
 
@@ -126,6 +135,148 @@ namespace litecore {
             sql << "DROP TRIGGER IF EXISTS \"" << tableName << "::" << kTriggerSuffixes[i] << "\";";
         }
         exec(sql.str());
+
+        if ( hasLazyIndexes() ) {
+            for ( const char* table : {"lazyIndexes", "lazyIndexQueue"} ) {
+                SQLite::Statement stmt(*this, CONCAT("DELETE FROM " << table << " WHERE indexTableName=?"));
+                stmt.bindNoCopy(1, tableName);
+                LogStatement(stmt);
+                stmt.exec();
+            }
+        }
+    }
+
+#pragma mark - LAZY INDEXES:
+
+    /*  A lazy index table isn't updated by triggers; instead the triggers just add the rowid of
+        the changed document to `lazyIndexQueue`. Later, `updateLazyIndexes` takes a batch of rowids
+        off the queue, deletes their rows from the index table and recomputes them, using the SQL
+        statement stored in the `lazyIndexes` table. That statement has two parameters: the index
+        table name and the highest docid in the batch. */
+
+    // The result is cached, but another connection may have created a lazy index since;
+    // pass `recheck` to look at the schema again.
+    bool SQLiteDataFile::hasLazyIndexes(bool recheck) {
+        if ( recheck || !_hasLazyIndexes ) {
+            string sql;
+            _hasLazyIndexes = getSchema("lazyIndexes", "table", "lazyIndexes", sql);
+        }
+        return *_hasLazyIndexes;
+    }
+
+    // True if the index table is maintained lazily, i.e. is registered in `lazyIndexes`.
+    bool SQLiteDataFile::isLazyIndexTable(const string& indexTableName) {
+        if ( indexTableName.empty() || !hasLazyIndexes(true) ) return false;
+        SQLite::Statement stmt(*this, "SELECT 1 FROM lazyIndexes WHERE indexTableName=?");
+        stmt.bindNoCopy(1, indexTableName);
+        return stmt.executeStep();
+    }
+
+    void SQLiteDataFile::ensureLazyIndexTablesExist() {
+        if ( hasLazyIndexes() ) return;
+        if ( !inTransaction() ) error::_throw(error::NotInTransaction);
+        _exec("CREATE TABLE lazyIndexes (indexTableName TEXT PRIMARY KEY, keyStore TEXT NOT NULL,"
+              " updateSQL TEXT NOT NULL); "
+              "CREATE TABLE lazyIndexQueue (indexTableName TEXT NOT NULL, docid INTEGER NOT NULL,"
+              " PRIMARY KEY (indexTableName, docid)) WITHOUT ROWID");
+        _hasLazyIndexes = true;
+    }
+
+    bool SQLiteDataFile::lazyIndexesNeedUpdate(const string& keyStoreName) {
+        if ( !hasLazyIndexes() ) return false;
+        SQLite::Statement stmt(*this, "SELECT 1 FROM lazyIndexes JOIN lazyIndexQueue USING (indexTableName) "
+                                      "WHERE keyStore=? LIMIT 1");
+        stmt.bindNoCopy(1, keyStoreName);
+        return stmt.executeStep();
+    }
+
+    bool SQLiteDataFile::updateLazyIndexes(const string& keyStoreName, unsigned maxDocs) {
+        if ( !hasLazyIndexes(true) ) return false;
+        if ( !inTransaction() ) error::_throw(error::NotInTransaction);
+
+        vector<pair<string, string>> tables;
+        {
+            SQLite::Statement stmt(*this, "SELECT indexTableName, updateSQL FROM lazyIndexes WHERE keyStore=?");
+            stmt.bindNoCopy(1, keyStoreName);
+            while ( stmt.executeStep() ) tables.emplace_back(stmt.getColumn(0).getString(), stmt.getColumn(1));
+        }
+
+        for ( auto& [tableName, updateSQL] : tables ) {
+            if ( maxDocs == 0 ) break;
+
+            // Find the highest queued docid in this batch:
+            int64_t lastDocID = INT64_MAX;
+            {
+                SQLite::Statement stmt(*this, "SELECT docid FROM lazyIndexQueue WHERE indexTableName=? "
+                                              "ORDER BY docid LIMIT 1 OFFSET ?");
+                stmt.bindNoCopy(1, tableName);
+                stmt.bind(2, (long long)maxDocs - 1);
+                if ( stmt.executeStep() ) lastDocID = stmt.getColumn(0).getInt64();
+            }
+
+            // Remove the batch's stale rows, recompute them, then dequeue the batch:
+            SQLite::Statement del(*this, CONCAT("DELETE FROM " << sqlIdentifier(tableName)
+                                                              << " WHERE docid IN (SELECT docid FROM lazyIndexQueue"
+                                                                 " WHERE indexTableName=?1 AND docid <= ?2)"));
+            SQLite::Statement update(*this, updateSQL);
+            SQLite::Statement dequeue(*this, "DELETE FROM lazyIndexQueue WHERE indexTableName=?1 AND docid <= ?2");
+            for ( SQLite::Statement* stmt : {&del, &update, &dequeue} ) {
+                stmt->bindNoCopy(1, tableName);
+                stmt->bind(2, (long long)lastDocID);
+                LogStatement(*stmt);
+            }
+            del.exec();
+            update.exec();
+            auto nDocs = unsigned(dequeue.exec());
+            LogTo(QueryLog, "Updated lazy index table '%s' for %u changed docs", tableName.c_str(), nDocs);
+            maxDocs -= std::min(nDocs, maxDocs);
+        }
+        return lazyIndexesNeedUpdate(keyStoreName);
+    }
+
+#pragma mark - BULK IMPORT:
+
+    /*  During a bulk import, value indexes are dropped and their SQL saved in `deferredIndexes`;
+        `restoreDeferredIndexes` recreates them afterwards, which sorts all the rows at once instead
+        of inserting each into each index. (FTS, array and predictive indexes are left alone: they're
+        updated by triggers, and couldn't be rebuilt without their creation options.) */
+
+    void SQLiteDataFile::deferValueIndexes() {
+        if ( !inTransaction() ) error::_throw(error::NotInTransaction);
+        _exec("CREATE TABLE IF NOT EXISTS deferredIndexes (name TEXT PRIMARY KEY, sql TEXT NOT NULL)");
+        if ( !indexTableExists() ) return;
+        {
+            SQLite::Statement stmt(*this, "INSERT OR IGNORE INTO deferredIndexes (name, sql) "
+                                          "SELECT m.name, m.sql FROM sqlite_master m JOIN indexes i ON m.name=i.name "
+                                          "WHERE m.type='index' AND i.type=?");
+            stmt.bind(1, IndexSpec::kValue);
+            LogStatement(stmt);
+            stmt.exec();
+        }
+        vector<string> names;
+        {
+            SQLite::Statement stmt(*this, "SELECT name FROM deferredIndexes");
+            while ( stmt.executeStep() ) names.push_back(stmt.getColumn(0).getString());
+        }
+        for ( auto& name : names ) exec(CONCAT("DROP INDEX IF EXISTS " << sqlIdentifier(name)));
+        LogTo(QueryLog, "Bulk import: deferred %zu value indexes", names.size());
+    }
+
+    void SQLiteDataFile::restoreDeferredIndexes() {
+        if ( !inTransaction() ) error::_throw(error::NotInTransaction);
+        string schema;
+        if ( !getSchema("deferredIndexes", "table", "deferredIndexes", schema) ) return;
+        vector<pair<string, string>> indexes;
+        {
+            SQLite::Statement stmt(*this, "SELECT name, sql FROM deferredIndexes");
+            while ( stmt.executeStep() ) indexes.emplace_back(stmt.getColumn(0).getString(), stmt.getColumn(1));
+        }
+        for ( auto& [name, sql] : indexes ) {
+            fleece::Stopwatch st;
+            exec(sql);
+            LogTo(QueryLog, "Bulk import: rebuilt index '%s' in %.3f sec", name.c_str(), st.elapsed());
+        }
+        _exec("DROP TABLE deferredIndexes");
     }
 
 #pragma mark - GETTING INDEX INFO:
@@ -193,8 +344,14 @@ namespace litecore {
     SQLiteIndexSpec SQLiteDataFile::specFromStatement(SQLite::Statement& stmt) {
         alloc_slice expressionJSON;
         if ( string col = stmt.getColumn(2).getString(); !col.empty() ) expressionJSON = col;
-        return {stmt.getColumn(0).getString(), (IndexSpec::Type)stmt.getColumn(1).getInt(), expressionJSON,
-                stmt.getColumn(3).getString(), stmt.getColumn(4).getString()};
+        auto   type           = (IndexSpec::Type)stmt.getColumn(1).getInt();
+        string indexTableName = stmt.getColumn(4).getString();
+        // Laziness is recorded by the index table's presence in `lazyIndexes`:
+        IndexSpec::Options lazyOptions{};
+        lazyOptions.lazy = true;
+        bool lazy = (type == IndexSpec::kArray || type == IndexSpec::kPredictive) && isLazyIndexTable(indexTableName);
+        return {stmt.getColumn(0).getString(), type, expressionJSON, stmt.getColumn(3).getString(), indexTableName,
+                lazy ? &lazyOptions : nullptr};
     }
 
     void SQLiteDataFile::inspectIndex(slice name, int64_t& outRowCount, alloc_slice* outRows) {
@@ -0,0 +1,175 @@
+//
+// SQLiteFTS5Extensions.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "SQLite_Internal.hh"
+#include <sqlite3.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include "fts3_tokenizer.h"
+}
+
+using namespace std;
+
+namespace litecore {
+
+#pragma mark - TOKENIZER:
+
+    /*  FTS5 can't use FTS3/4 tokenizer modules directly, so this adapter exposes the `unicodesn`
+        tokenizer (stemming, stop-words, diacritic removal) through the FTS5 tokenizer API.
+        Both APIs report each token's UTF-8 byte range, so tokens pass straight through. The one
+        difference is that FTS5 numbers token positions itself, so stop-words don't leave gaps
+        in the positions as they do in FTS4. */
+
+    struct FTS5TokenizerAdapter {
+        const sqlite3_tokenizer_module* module;
+        sqlite3_tokenizer*              tokenizer;
+    };
+
+    static int fts5TokenizerCreate(void* moduleCtx, const char** azArg, int nArg, Fts5Tokenizer** ppOut) {
+        auto               module    = (const sqlite3_tokenizer_module*)moduleCtx;
+        sqlite3_tokenizer* tokenizer = nullptr;
+        int                rc        = module->xCreate(nArg, azArg, &tokenizer);
+        if ( rc != SQLITE_OK ) return rc;
+        tokenizer->pModule = module;  // FTS3 expects the caller to set this
+        *ppOut             = (Fts5Tokenizer*)new FTS5TokenizerAdapter{module, tokenizer};
+        return SQLITE_OK;
+    }
+
+    static void fts5TokenizerDelete(Fts5Tokenizer* fts5Tokenizer) {
+        auto adapter = (FTS5TokenizerAdapter*)fts5Tokenizer;
+        adapter->module->xDestroy(adapter->tokenizer);
+        delete adapter;
+    }
+
+    static int fts5Tokenize(Fts5Tokenizer* fts5Tokenizer, void* pCtx, int /*flags*/, const char* pText, int nText,
+                            int (*xToken)(void*, int, const char*, int, int, int)) {
+        auto                      adapter = (FTS5TokenizerAdapter*)fts5Tokenizer;
+        sqlite3_tokenizer_cursor* cursor  = nullptr;
+        int rc = adapter->module->xOpen(adapter->tokenizer, (pText ? pText : ""), nText, &cursor);
+        if ( rc != SQLITE_OK ) return rc;
+        cursor->pTokenizer = adapter->tokenizer;  // FTS3 expects the caller to set this
+
+        const char* token;
+        int         nToken, start, end, position;
+        while ( (rc = adapter->module->xNext(cursor, &token, &nToken, &start, &end, &position)) == SQLITE_OK ) {
+            rc = xToken(pCtx, 0, token, nToken, start, end);
+            if ( rc != SQLITE_OK ) break;
+        }
+        adapter->module->xClose(cursor);
+        return (rc == SQLITE_DONE) ? SQLITE_OK : rc;
+    }
+
+#pragma mark - OFFSETS FUNCTION:
+
+    /*  An FTS5 auxiliary function that returns the same string as FTS4's `offsets()`: groups of
+        four space-separated integers -- column number, query term number, byte offset and byte
+        length -- one group per matched token. SQLiteQueryEnumerator parses this to produce the
+        full-text match info, so FTS4 and FTS5 indexes look the same to clients. */
+    static void fts5Offsets(const Fts5ExtensionApi* api, Fts5Context* fts, sqlite3_context* ctx, int /*nArg*/,
+                            sqlite3_value** /*args*/) {
+        // FTS4 numbers each token of the query; FTS5 reports phrases, so compute the number of
+        // each phrase's first token:
+        int         nPhrase = api->xPhraseCount(fts);
+        vector<int> firstTermOfPhrase(nPhrase + 1);
+        for ( int p = 0; p < nPhrase; ++p )
+            firstTermOfPhrase[p + 1] = firstTermOfPhrase[p] + api->xPhraseSize(fts, p);
+
+        int nInst = 0;
+        int rc    = api->xInstCount(fts, &nInst);
+
+        // Byte ranges of the tokens in each column, indexed by token position; built on demand:
+        using TokenRanges = vector<pair<int, int>>;
+        unordered_map<int, TokenRanges> columnTokens;
+        auto                            tokensInColumn = [&](int col) -> TokenRanges& {
+            auto [i, isNew] = columnTokens.try_emplace(col);
+            if ( isNew && rc == SQLITE_OK ) {
+                const char* text;
+                int         nText;
+                rc = api->xColumnText(fts, col, &text, &nText);
+                if ( rc == SQLITE_OK ) {
+                    rc = api->xTokenize(fts, text, nText, &i->second,
+                                        [](void* rangesPtr, int tflags, const char*, int, int start, int end) {
+                                            if ( !(tflags & FTS5_TOKEN_COLOCATED) )
+                                                ((TokenRanges*)rangesPtr)->emplace_back(start, end);
+                                            return SQLITE_OK;
+                                        });
+                }
+            }
+            return i->second;
+        };
+
+        string result;
+        char   buf[64];
+        for ( int inst = 0; inst < nInst && rc == SQLITE_OK; ++inst ) {
+            int phrase, col, offset;
+            rc = api->xInst(fts, inst, &phrase, &col, &offset);
+            if ( rc != SQLITE_OK ) break;
+            TokenRanges& tokens = tokensInColumn(col);
+            for ( int t = 0; t < api->xPhraseSize(fts, phrase); ++t ) {
+                auto pos = size_t(offset + t);
+                if ( pos >= tokens.size() ) break;
+                auto [start, end] = tokens[pos];
+                snprintf(buf, sizeof(buf), "%s%d %d %d %d", (result.empty() ? "" : " "), col,
+                         firstTermOfPhrase[phrase] + t, start, end - start);
+                result += buf;
+            }
+        }
+
+        if ( rc == SQLITE_OK ) sqlite3_result_text(ctx, result.data(), int(result.size()), SQLITE_TRANSIENT);
+        else
+            sqlite3_result_error_code(ctx, rc);
+    }
+
+#pragma mark - REGISTRATION:
+
+    // Returns the FTS5 API object of a database connection. See https://sqlite.org/fts5.html#extending_fts5
+    static fts5_api* getFTS5API(sqlite3* db) {
+        fts5_api*     api  = nullptr;
+        sqlite3_stmt* stmt = nullptr;
+        if ( sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &stmt, nullptr) == SQLITE_OK ) {
+            sqlite3_bind_pointer(stmt, 1, (void*)&api, "fts5_api_ptr", nullptr);
+            sqlite3_step(stmt);
+        }
+        sqlite3_finalize(stmt);
+        return api;
+    }
+
+    // Returns a registered FTS3 tokenizer module, by asking the `fts3_tokenizer()` function.
+    static const sqlite3_tokenizer_module* getFTS3Tokenizer(sqlite3* db, const char* name) {
+        const sqlite3_tokenizer_module* module = nullptr;
+        sqlite3_stmt*                   stmt   = nullptr;
+        if ( sqlite3_prepare_v2(db, "SELECT fts3_tokenizer(?1)", -1, &stmt, nullptr) == SQLITE_OK ) {
+            sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+            if ( sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_bytes(stmt, 0) == sizeof(module) )
+                memcpy((void*)&module, sqlite3_column_blob(stmt, 0), sizeof(module));
+        }
+        sqlite3_finalize(stmt);
+        return module;
+    }
+
+    int RegisterFTS5Extensions(sqlite3* db) {
+        fts5_api* api = getFTS5API(db);
+        if ( !api ) return SQLITE_ERROR;
+        auto unicodesn = getFTS3Tokenizer(db, "unicodesn");
+        if ( !unicodesn ) return SQLITE_ERROR;
+
+        fts5_tokenizer tokenizer = {fts5TokenizerCreate, fts5TokenizerDelete, fts5Tokenize};
+        int rc = api->xCreateTokenizer(api, "unicodesn", (void*)unicodesn, &tokenizer, nullptr);
+        if ( rc == SQLITE_OK ) rc = api->xCreateFunction(api, "offsets", nullptr, fts5Offsets, nullptr);
+        return rc;
+    }
+
+}  // namespace litecore
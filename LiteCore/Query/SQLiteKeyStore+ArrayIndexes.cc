@@ -25,11 +25,11 @@ namespace litecore {
 
     bool SQLiteKeyStore::createArrayIndex(const IndexSpec& spec) {
         Array::iterator iExprs(spec.what());
-        string          arrayTableName = createUnnestedTable(iExprs.value());
+        string          arrayTableName = createUnnestedTable(iExprs.value(), spec);
         return createIndex(spec, arrayTableName, ++iExprs);
     }
 
-    string SQLiteKeyStore::createUnnestedTable(const Value* expression) {
+    string SQLiteKeyStore::createUnnestedTable(const Value* expression, const IndexSpec& spec) {
         // Derive the table name from the expression it unnests:
         string      kvTableName = tableName();
         QueryParser qp(db(), "", kvTableName);
@@ -51,15 +51,19 @@ namespace litecore {
             db().exec(sql);
 
             qp.setBodyColumnName("new.body");
-            string eachExpr = qp.eachExpressionSQL(expression);
+            string eachExpr  = qp.eachExpressionSQL(expression);
+            string insertSQL = CONCAT("INSERT INTO " << sqlIdentifier(unnestTableName)
+                                                     << " (docid, i, body) "
+                                                        "SELECT new.rowid, _each.rowid, _each.value "
+                                                     << "FROM " << sqlIdentifier(kvTableName) << " as new, " << eachExpr
+                                                     << " AS _each");
+            if ( spec.isLazy() ) {
+                setUpLazyIndexTable(unnestTableName, insertSQL, "WHERE (new.flags & 1) = 0", "new.rowid");
+                return unnestTableName;
+            }
 
             // Populate the index-table with data from existing documents:
-            db().exec(CONCAT("INSERT INTO " << sqlIdentifier(unnestTableName)
-                                            << " (docid, i, body) "
-                                               "SELECT new.rowid, _each.rowid, _each.value "
-                                            << "FROM " << sqlIdentifier(kvTableName) << " as new, " << eachExpr
-                                            << " AS _each "
-                                               "WHERE (new.flags & 1) = 0"));
+            populateIndexTable(spec, insertSQL, "WHERE (new.flags & 1) = 0", "new.rowid");
 
             // Set up triggers to keep the index-table up to date
             // ...on insertion:
@@ -80,6 +84,8 @@ namespace litecore {
                           deleteTriggerExpr);
             createTrigger(unnestTableName, "postupdate", "AFTER UPDATE OF body, flags", "WHEN (new.flags & 1 = 0)",
                           insertTriggerExpr);
+        } else {
+            checkIndexTableLaziness(unnestTableName, spec);
         }
         return unnestTableName;
     }
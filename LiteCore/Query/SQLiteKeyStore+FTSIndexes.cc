@@ -30,11 +30,16 @@ using namespace fleece::impl;
 
 namespace litecore {
 
-    static void writeTokenizerOptions(stringstream& sql, const IndexSpec::Options*);
+    static void writeTokenizerOptions(stringstream& sql, const IndexSpec::Options*, bool fts5);
 
     // Creates a FTS index.
     bool SQLiteKeyStore::createFTSIndex(const IndexSpec& spec) {
         auto ftsTableName = db().FTSTableName(tableName(), spec.name);
+        bool fts5         = spec.options && spec.options->useFTS5;
+        // FTS5 tables have no `docid` column; in FTS4 it's an alias of `rowid`, but we keep using it
+        // so existing FTS4 schemas and triggers stay identical:
+        const char* docidColumn = fts5 ? "rowid" : "docid";
+
         // Collect the name of each FTS column and the SQL expression that populates it:
         QueryParser qp(db(), collectionName(), tableName());
         qp.setBodyColumnName("new.body");
@@ -54,28 +59,41 @@ namespace litecore {
         // Build the SQL that creates an FTS table, including the tokenizer options:
         {
             stringstream sql;
-            sql << "CREATE VIRTUAL TABLE " << sqlIdentifier(ftsTableName) << " USING fts4(" << columns << ", ";
-            writeTokenizerOptions(sql, spec.optionsPtr());
+            sql << "CREATE VIRTUAL TABLE " << sqlIdentifier(ftsTableName) << " USING " << (fts5 ? "fts5" : "fts4")
+                << "(" << columns << ", ";
+            if ( fts5 ) {
+                // FTS5 takes the tokenizer name and arguments as a single string:
+                sql << "tokenize='";
+                writeTokenizerOptions(sql, spec.optionsPtr(), true);
+                sql << "'";
+            } else {
+                sql << "tokenize=";
+                writeTokenizerOptions(sql, spec.optionsPtr(), false);
+            }
             sql << ")";
             if ( !db().createIndex(spec, this, ftsTableName, sql.str()) ) return false;
         }
 
         // Index the existing records:
-        db().exec(CONCAT("INSERT INTO " << sqlIdentifier(ftsTableName) << " (docid, " << columns
-                                        << ") "
-                                           "SELECT rowid, "
-                                        << exprs << " FROM " << quotedTableName() << " AS new " << whereNewSQL));
+        populateIndexTable(spec,
+                           CONCAT("INSERT INTO " << sqlIdentifier(ftsTableName) << " (" << docidColumn << ", " << columns
+                                                 << ") "
+                                                    "SELECT rowid, "
+                                                 << exprs << " FROM " << quotedTableName() << " AS new"),
+                           whereNewSQL, "new.rowid");
 
         // Set up triggers to keep the FTS table up to date
         // ...on insertion:
-        string insertNewSQL = CONCAT("INSERT INTO " << sqlIdentifier(ftsTableName) << " (docid, " << columns
+        string insertNewSQL = CONCAT("INSERT INTO " << sqlIdentifier(ftsTableName) << " (" << docidColumn << ", "
+                                                    << columns
                                                     << ") "
                                                        "VALUES (new.rowid, "
                                                     << exprs << ")");
         createTrigger(ftsTableName, "ins", "AFTER INSERT", whereNewSQL, insertNewSQL);
 
         // ...on delete:
-        string deleteOldSQL = CONCAT("DELETE FROM " << sqlIdentifier(ftsTableName) << " WHERE docid = old.rowid");
+        string deleteOldSQL =
+                CONCAT("DELETE FROM " << sqlIdentifier(ftsTableName) << " WHERE " << docidColumn << " = old.rowid");
         createTrigger(ftsTableName, "del", "AFTER DELETE", whereOldSQL, deleteOldSQL);
 
         // ...on update:
@@ -84,10 +102,11 @@ namespace litecore {
         return true;
     }
 
-    // subroutine that generates the option string passed to the FTS tokenizer
-    static void writeTokenizerOptions(stringstream& sql, const IndexSpec::Options* options) {
+    // subroutine that generates the tokenizer name and options passed to the FTS tokenizer.
+    // For FTS5 these go inside a single-quoted string, so they mustn't contain single quotes.
+    static void writeTokenizerOptions(stringstream& sql, const IndexSpec::Options* options, bool fts5) {
         // See https://www.sqlite.org/fts3.html#tokenizer . 'unicodesn' is our custom tokenizer.
-        sql << "tokenize=unicodesn";
+        sql << "unicodesn";
         if ( options ) {
             // Get the language code (options->language might have a country too, like "en_US")
             string languageCode;
@@ -100,6 +119,7 @@ namespace litecore {
                 string arg(options->stopWords);
                 replace(arg, '"', ' ');
                 replace(arg, ',', ' ');
+                if ( fts5 ) replace(arg, '\'', ' ');
                 sql << " \"stopwordlist=" << arg << "\"";
             } else if ( options->language ) {
                 sql << " \"stopwords=" << languageCode << "\"";
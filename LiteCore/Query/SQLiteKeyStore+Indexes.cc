@@ -13,11 +13,17 @@
 
 #include "SQLiteKeyStore.hh"
 #include "SQLiteDataFile.hh"
+#include "SQLite_Internal.hh"
 #include "QueryParser.hh"
 #include "Error.hh"
 #include "StringUtil.hh"
 #include "Stopwatch.hh"
 #include "Array.hh"
+#include "Defer.hh"
+#include "SQLiteCpp/SQLiteCpp.h"
+#include "SQLUtil.hh"
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 using namespace fleece;
@@ -47,6 +53,21 @@ namespace litecore {
 
     bool SQLiteKeyStore::createIndex(const IndexSpec& spec) {
         spec.validateName();
+        if ( spec.hasWhereOption() && spec.type != IndexSpec::kValue )
+            error::_throw(error::InvalidParameter, "Only value indexes can have a 'where' condition");
+        if ( spec.isLazy() && spec.type != IndexSpec::kArray && spec.type != IndexSpec::kPredictive )
+            error::_throw(error::InvalidParameter, "Only array and predictive indexes can be lazy");
+        if ( spec.options && spec.options->useFTS5 && spec.type != IndexSpec::kFullText )
+            error::_throw(error::InvalidParameter, "Only full-text indexes can use FTS5");
+
+        // CREATE INDEX sorts all the keys; let SQLite's sorter spread that over more threads than
+        // it's normally allowed to use:
+        unsigned threads = spec.maxBuildThreads;
+        if ( threads == 0 ) threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        int savedThreads = db().setSorterThreads(int(threads));
+        DEFER { db().setSorterThreads(savedThreads); };
+
+        if ( spec.progress ) spec.progress(0.0f);
 
         Stopwatch            st;
         ExclusiveTransaction t(db());
@@ -76,6 +97,7 @@ namespace litecore {
             QueryLog.log((time < 3.0 ? LogLevel::Info : LogLevel::Warning), "Created index '%s' in %.3f sec",
                          spec.name.c_str(), time);
         }
+        if ( spec.progress ) spec.progress(1.0f);  // even if the index already existed
         return created;
     }
 
@@ -89,6 +111,91 @@ namespace litecore {
         return db().createIndex(spec, this, sourceTableName, sql);
     }
 
+    // Runs an `INSERT ... SELECT ... FROM` statement that fills an index table from this table;
+    // `whereSQL` is its WHERE clause, if any. If the spec has a progress callback, the source rows
+    // are processed in ranges of `rowidColumn` so that progress can be reported along the way.
+    void SQLiteKeyStore::populateIndexTable(const IndexSpec& spec, const string& insertSQL, const string& whereSQL,
+                                            string_view rowidColumn) {
+        if ( !spec.progress ) {
+            db().exec(CONCAT(insertSQL << " " << whereSQL));
+            return;
+        }
+
+        static constexpr int64_t kRowsPerChunk = 10000;
+        int64_t                  maxRowid = db().intQuery(("SELECT max(rowid) FROM " + quotedTableName()).c_str());
+
+        string sql = insertSQL + " WHERE ";
+        if ( !whereSQL.empty() ) {
+            Assert(hasPrefix(whereSQL, "WHERE "));
+            sql += "(" + whereSQL.substr(6) + ") AND ";
+        }
+        sql += CONCAT(rowidColumn << " > ? AND " << rowidColumn << " <= ?");
+
+        SQLite::Statement stmt(db(), sql);
+        LogStatement(stmt);
+        for ( int64_t start = 0; start < maxRowid; start += kRowsPerChunk ) {
+            stmt.bind(1, (long long)start);
+            stmt.bind(2, (long long)(start + kRowsPerChunk));
+            stmt.exec();
+            stmt.reset();
+            spec.progress(float(std::min(start + kRowsPerChunk, maxRowid)) / float(maxRowid));
+        }
+    }
+
+    // An existing index table is shared by every index on the same expression, so it can't be
+    // lazy for one of them and eagerly updated for another.
+    void SQLiteKeyStore::checkIndexTableLaziness(const string& indexTableName, const IndexSpec& spec) {
+        if ( db().isLazyIndexTable(indexTableName) != spec.isLazy() ) {
+            error::_throw(error::InvalidParameter,
+                          "Index table '%s' is already used by a %s index; delete that index first",
+                          indexTableName.c_str(), spec.isLazy() ? "non-lazy" : "lazy");
+        }
+    }
+
+    // Sets up a newly-created index table to be updated lazily: instead of triggers that update
+    // the table, it gets triggers that enqueue the changed docs' rowids, and every existing doc is
+    // enqueued. `insertSQL`, `whereSQL` and `rowidColumn` are as in `populateIndexTable`.
+    void SQLiteKeyStore::setUpLazyIndexTable(const string& indexTableName, const string& insertSQL,
+                                             const string& whereSQL, string_view rowidColumn) {
+        db().ensureLazyIndexTablesExist();
+
+        string updateSQL = insertSQL + " WHERE ";
+        if ( !whereSQL.empty() ) {
+            Assert(hasPrefix(whereSQL, "WHERE "));
+            updateSQL += "(" + whereSQL.substr(6) + ") AND ";
+        }
+        updateSQL += CONCAT(rowidColumn << " IN (SELECT docid FROM lazyIndexQueue"
+                                           " WHERE indexTableName=?1 AND docid <= ?2)");
+        {
+            SQLite::Statement stmt(db(), "INSERT INTO lazyIndexes (indexTableName, keyStore, updateSQL) "
+                                         "VALUES (?, ?, ?)");
+            stmt.bindNoCopy(1, indexTableName);
+            stmt.bindNoCopy(2, name());
+            stmt.bindNoCopy(3, updateSQL);
+            LogStatement(stmt);
+            stmt.exec();
+        }
+
+        // Queue up all the existing documents:
+        db().exec(CONCAT("INSERT INTO lazyIndexQueue (indexTableName, docid) SELECT "
+                         << sqlString(indexTableName) << ", rowid FROM " << quotedTableName()
+                         << " WHERE (flags & 1) = 0"));
+
+        // ...and any document that changes later:
+        static constexpr const char* kTriggers[][3] = {{"ins", "AFTER INSERT", "new"},
+                                                       {"del", "BEFORE DELETE", "old"},
+                                                       {"upd", "AFTER UPDATE OF body, flags", "new"}};
+        for ( auto& [suffix, operation, row] : kTriggers ) {
+            createTrigger(indexTableName, suffix, operation, "",
+                          CONCAT("INSERT OR IGNORE INTO lazyIndexQueue (indexTableName, docid) VALUES ("
+                                 << sqlString(indexTableName) << ", " << row << ".rowid)"));
+        }
+    }
+
+    bool SQLiteKeyStore::lazyIndexesNeedUpdate() { return db().lazyIndexesNeedUpdate(name()); }
+
+    bool SQLiteKeyStore::updateLazyIndexes(unsigned maxDocs) { return db().updateLazyIndexes(name(), maxDocs); }
+
     void SQLiteKeyStore::deleteIndex(slice name) {
         ExclusiveTransaction t(db());
         auto                 spec = db().getIndex(name);
@@ -129,6 +236,25 @@ namespace litecore {
         _createFlagsIndex("blobs", DocumentFlags::kHasAttachments, _createdBlobsIndex);
     }
 
+    // Creates covering indexes, by key and by sequence, of every column a metadata-only
+    // enumeration reads (see newEnumeratorImpl), so that it can scan an index instead of the
+    // table, whose rows contain the bodies. The `length` expressions are indexed too; SQLite
+    // reads their values from the index instead of evaluating them on the table row.
+    // This is called by the first write, in its transaction, rather than by an enumerator, which
+    // may be on a read-only connection; until a write, enumerations just scan the table.
+    void SQLiteKeyStore::createMetadataIndexes() {
+        if ( !_createdMetadataIndexes ) {
+            addExpiration();  // the indexes have to cover the `expiration` column
+            db().execWithLock(subst("CREATE INDEX IF NOT EXISTS \"kv_@_meta_keys\" ON kv_@ "
+                                    "(key, sequence, flags, version, length(body), length(extra), expiration)"));
+            if ( _capabilities.sequences ) {
+                db().execWithLock(subst("CREATE INDEX IF NOT EXISTS \"kv_@_meta_seqs\" ON kv_@ "
+                                        "(sequence, flags, key, version, length(body), length(extra), expiration)"));
+            }
+            _createdMetadataIndexes = true;
+        }
+    }
+
     vector<IndexSpec> SQLiteKeyStore::getIndexes() const {
         vector<IndexSpec> result;
         for ( auto& spec : db().getIndexes(this) ) result.push_back(std::move(spec));
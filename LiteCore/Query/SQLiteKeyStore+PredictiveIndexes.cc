@@ -36,7 +36,7 @@ namespace litecore {
         // Create a table of the PREDICTION results:
         auto pred = MutableArray::newArray(expression);
         if ( pred->count() > 3 ) pred->remove(3, pred->count() - 3);
-        string predTableName = createPredictionTable(pred);
+        string predTableName = createPredictionTable(pred, spec);
 
         // The final parameters are the result properties to create a SQL index on:
         Array::iterator i(expression);
@@ -54,7 +54,7 @@ namespace litecore {
         return createIndex(spec, predTableName, i);
     }
 
-    string SQLiteKeyStore::createPredictionTable(const Value* expression) {
+    string SQLiteKeyStore::createPredictionTable(const Value* expression, const IndexSpec& spec) {
         // Derive the table name from the expression (path) it unnests:
         auto        kvTableName   = tableName();
         auto        q_kvTableName = quotedTableName();
@@ -74,12 +74,18 @@ namespace litecore {
                   expression->toJSONString().c_str());
             db().exec(sql);
 
-            // Populate the index-table with data from existing documents:
             string predictExpr = qp.expressionSQL(expression);
-            db().exec(CONCAT("INSERT INTO " << sqlIdentifier(predTableName)
-                                            << " (docid, body) "
-                                               "SELECT rowid, "
-                                            << predictExpr << "FROM " << q_kvTableName << " WHERE (flags & 1) = 0"));
+            string insertSQL   = CONCAT("INSERT INTO " << sqlIdentifier(predTableName)
+                                                       << " (docid, body) "
+                                                          "SELECT rowid, "
+                                                       << predictExpr << "FROM " << q_kvTableName);
+            if ( spec.isLazy() ) {
+                setUpLazyIndexTable(predTableName, insertSQL, "WHERE (flags & 1) = 0", "rowid");
+                return predTableName;
+            }
+
+            // Populate the index-table with data from existing documents:
+            populateIndexTable(spec, insertSQL, "WHERE (flags & 1) = 0", "rowid");
 
             // Set up triggers to keep the index-table up to date
             // ...on insertion:
@@ -102,6 +108,8 @@ namespace litecore {
                           deleteTriggerExpr);
             createTrigger(predTableName, "postupdate", "AFTER UPDATE OF body, flags", "WHEN (new.flags) & 1 = 0",
                           insertTriggerExpr);
+        } else {
+            checkIndexTableLaziness(predTableName, spec);
         }
         return predTableName;
     }
@@ -29,6 +29,8 @@
 #include "SQLiteCpp/Column.h"
 #include "fleece/FLMutable.h"
 #include <sqlite3.h>
+#include <algorithm>
+#include <climits>
 #include <memory>
 #include <numeric>  // std::accumulate
 #include <sstream>
@@ -151,7 +153,7 @@ namespace litecore {
 
             if ( !_matchedTextStatement ) {
                 auto&  df             = (SQLiteDataFile&)dataFile();
-                string sql            = "SELECT * FROM \"" + expr + "\" WHERE docid=?";
+                string sql            = "SELECT * FROM \"" + expr + "\" WHERE rowid=?";  // (FTS5 has no docid)
                 _matchedTextStatement = std::make_unique<SQLite::Statement>(df, sql, true);
             }
 
@@ -191,6 +193,31 @@ namespace litecore {
 
         QueryEnumerator* createEnumerator(const Options* options) override;
 
+        // Brings any lazy indexes on the collections I read up to date.
+        void updateLazyIndexes() { updateLazyIndexes(dataFile()); }
+
+        void updateLazyIndexes(DataFile& onFile) override {
+            auto& df = (SQLiteDataFile&)onFile;
+            if ( !df.options().writeable || !df.hasLazyIndexes(true) ) return;
+            // My KeyStores may belong to another connection, so look up df's by name:
+            vector<KeyStore*> keyStores;
+            for ( auto ks : _keyStores ) keyStores.push_back(&df.getKeyStore(ks->name()));
+            auto needsUpdate = [&] {
+                return std::any_of(keyStores.begin(), keyStores.end(),
+                                   [](KeyStore* ks) { return ks->lazyIndexesNeedUpdate(); });
+            };
+            auto update = [&] {
+                for ( auto ks : keyStores ) ks->updateLazyIndexes(UINT_MAX);
+            };
+            if ( df.inTransaction() ) {
+                update();
+            } else if ( needsUpdate() ) {
+                ExclusiveTransaction t(df);
+                update();
+                t.commit();
+            }
+        }
+
         shared_ptr<SQLite::Statement> statement() const {
             if ( !_statement ) error::_throw(error::NotOpen);
             return _statement;
@@ -527,6 +554,8 @@ namespace litecore {
     // The factory method that creates a SQLite QueryEnumerator, but only if the database has
     // changed since lastSeq.
     QueryEnumerator* SQLiteQuery::createEnumerator(const Options* options) {
+        if ( !allowStaleIndexes() ) updateLazyIndexes();
+
         // Start a read-only transaction, to ensure that the result of lastSequence() and purgeCount() will be
         // consistent with the query results.
         ReadOnlyTransaction t(dataFile());
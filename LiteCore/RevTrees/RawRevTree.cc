@@ -193,4 +193,87 @@ namespace litecore {
         }
     }
 
+#pragma mark - REVTREEVIEW:
+
+    RevTreeView::RevTreeView(slice body, slice extra)
+        : _tree(extra ? extra : body), _hasSeparateBody(body && extra) {
+        // Unlike decodeTree, this has to check every rev's bounds, since it reads them in place:
+        const void* end = _tree.end();
+        auto        raw = firstRev();
+        while ( true ) {
+            if ( offsetby(raw, sizeof(uint32_t)) > end )
+                error::_throw(error::CorruptRevisionData, "RevTreeView: tree is truncated");
+            if ( !raw->isValid() ) break;
+            auto next = raw->next();
+            if ( next > end || (const void*)next <= (const void*)&raw->revID[raw->revIDLen] )
+                error::_throw(error::CorruptRevisionData, "RevTreeView: invalid revision size");
+            raw = next;
+            ++_count;
+        }
+        if ( _count > UINT16_MAX ) error::_throw(error::CorruptRevisionData, "RevTreeView: too many revisions");
+        _remoteEntries = offsetby(raw, sizeof(uint32_t));
+        if ( ((uint8_t*)end - (uint8_t*)_remoteEntries) % sizeof(RemoteEntry) != 0 )
+            error::_throw(error::CorruptRevisionData, "RevTreeView: invalid remote entries");
+    }
+
+    const RawRevision* RevTreeView::rawRev(unsigned index) const {
+        Assert(index < _count);
+        auto raw = firstRev();
+        for ( ; index > 0; --index ) raw = raw->next();
+        return raw;
+    }
+
+    RevTreeView::RevInfo RevTreeView::info(const RawRevision* raw, unsigned index) const {
+        auto parent = endian::dec16(raw->parentIndex_BE);
+        if ( parent != RawRevision::kNoParent && parent >= _count )
+            error::_throw(error::CorruptRevisionData, "RevTreeView: invalid parent index");
+        bool hasBody = (raw->flags & RawRevision::kHasData) || (index == 0 && _hasSeparateBody);
+        return {index, revid(raw->revID, raw->revIDLen), (Rev::Flags)(raw->flags & ~RawRevision::kPersistentOnlyFlags),
+                (parent == RawRevision::kNoParent) ? kNoRev : parent, hasBody};
+    }
+
+    RevTreeView::RevInfo RevTreeView::get(unsigned index) const { return info(rawRev(index), index); }
+
+    optional<RevTreeView::RevInfo> RevTreeView::get(revid revID) const {
+        unsigned index = 0;
+        for ( auto raw = firstRev(); raw->isValid(); raw = raw->next(), ++index ) {
+            if ( revID == slice(raw->revID, raw->revIDLen) ) return info(raw, index);
+        }
+        return nullopt;
+    }
+
+    bool RevTreeView::isAncestorOf(unsigned ancestor, unsigned rev) const {
+        // Walk up the parent chain from `rev`. Parents are usually stored after their children,
+        // so keep scanning forward, and only start over from the beginning when they're not:
+        auto     raw   = rawRev(rev);
+        unsigned index = rev;
+        while ( index != ancestor ) {
+            auto parent = endian::dec16(raw->parentIndex_BE);
+            if ( parent == RawRevision::kNoParent ) return false;
+            if ( parent >= _count ) error::_throw(error::CorruptRevisionData, "RevTreeView: invalid parent index");
+            if ( parent < index ) {
+                raw   = firstRev();
+                index = 0;
+            }
+            for ( ; index < parent; ++index ) raw = raw->next();
+        }
+        return true;
+    }
+
+    unsigned RevTreeView::latestRevisionOnRemote(RevTree::RemoteID remote) const {
+        Assert(remote != RevTree::kNoRemoteID);
+        // The remote map ends at the 0/0 mark, or the end of the data (see encodeTree):
+        for ( auto entry = (const RemoteEntry*)_remoteEntries; entry < _tree.end(); ++entry ) {
+            RevTree::RemoteID remoteID = endian::dec16(entry->remoteDBID_BE);
+            if ( remoteID == 0 ) break;
+            if ( remoteID == remote ) {
+                unsigned revIndex = endian::dec16(entry->revIndex_BE);
+                if ( revIndex >= _count )
+                    error::_throw(error::CorruptRevisionData, "RevTreeView: invalid remote rev index");
+                return revIndex;
+            }
+        }
+        return kNoRev;
+    }
+
 }  // namespace litecore
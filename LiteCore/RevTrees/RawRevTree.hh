@@ -14,7 +14,9 @@
 #include "fleece/slice.hh"
 #include "RevTree.hh"
 #include "Endian.hh"
+#include <climits>
 #include <deque>
+#include <optional>
 #include <vector>
 
 namespace litecore {
@@ -83,8 +85,67 @@ namespace litecore {
         static size_t sizeToWrite(const Rev&);
         void          copyTo(Rev& dst, const std::deque<Rev>&) const;
         RawRevision*  copyFrom(const Rev& rev);
+
+        friend class RevTreeView;
     };
 
 #pragma pack()
 
+    /** A read-only view of an encoded rev-tree, that answers common queries directly from the
+        encoded data, without decoding it into a RevTree or allocating memory.
+        Revisions are identified by index, in the same order as `RevTree::allRevisions`; so the
+        current revision is index 0. To modify the tree, decode it into a RevTree instead. */
+    class RevTreeView {
+      public:
+        static constexpr unsigned kNoRev = UINT_MAX;
+
+        /// Takes the same `body` and `extra` as `RevTree::decode`. The data is not copied, so it
+        /// must remain valid. Throws CorruptRevisionData if the tree is malformed.
+        RevTreeView(slice body, slice extra);
+
+        /// Metadata of a single revision.
+        struct RevInfo {
+            unsigned   index;          ///< Index in the tree
+            revid      revID;          ///< Revision ID (compressed); points into the encoded tree
+            Rev::Flags flags;          ///< Same flags as `Rev::flags`
+            unsigned   parentIndex;    ///< Index of parent, or kNoRev
+            bool       bodyAvailable;  ///< Same as `Rev::isBodyAvailable()`
+        };
+
+        [[nodiscard]] unsigned size() const FLPURE { return _count; }
+
+        [[nodiscard]] RevInfo get(unsigned index) const;
+
+        /// Returns the revision with the given revID, if it exists.
+        [[nodiscard]] std::optional<RevInfo> get(revid) const;
+
+        [[nodiscard]] RevInfo currentRevision() const { return get(0u); }
+
+        /// True if `ancestor` is `rev` or one of its ancestors; same as `Rev::isAncestorOf`.
+        [[nodiscard]] bool isAncestorOf(unsigned ancestor, unsigned rev) const;
+
+        /// The index of the current revision on a remote database, or kNoRev if none.
+        [[nodiscard]] unsigned latestRevisionOnRemote(RevTree::RemoteID) const;
+
+        /// Calls `callback(const RevInfo&)` on each revision in order, until it returns false.
+        template <class CALLBACK>
+        void forEachRevision(CALLBACK callback) const {
+            unsigned index = 0;
+            for ( auto raw = firstRev(); raw->isValid(); raw = raw->next() ) {
+                if ( !callback(info(raw, index++)) ) break;
+            }
+        }
+
+      private:
+        [[nodiscard]] const RawRevision* firstRev() const { return (const RawRevision*)_tree.buf; }
+
+        [[nodiscard]] const RawRevision* rawRev(unsigned index) const;
+        [[nodiscard]] RevInfo            info(const RawRevision*, unsigned index) const;
+
+        slice       _tree;              // The encoded tree
+        const void* _remoteEntries;     // Start of the remote-rev entries, after the revs
+        unsigned    _count{0};          // Number of revs
+        bool        _hasSeparateBody;   // Is the current rev's body stored outside the tree?
+    };
+
 }  // namespace litecore
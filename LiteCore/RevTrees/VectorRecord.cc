@@ -18,8 +18,10 @@
 #include "DeDuplicateEncoder.hh"
 #include "Error.hh"
 #include "SecureDigest.hh"
+#include "SmallVector.hh"
 #include "StringUtil.hh"
 #include "fleece/Expert.hh"
+#include <algorithm>
 #include <ostream>
 #include <sstream>
 
@@ -502,13 +504,145 @@ namespace litecore {
         return {body, extra};
     }
 
+    namespace {
+        /** Feeds the canonical JSON form of a Fleece value into a SHA1Builder, without ever
+            materializing the JSON. The output must be byte-for-byte identical to
+            `FLValue_ToJSONX(value, false, true)`, since it determines revIDs: the common cases
+            (collections, plain strings, integers, booleans, null) are written directly, and anything
+            else -- floats, data, strings that need escaping -- is delegated to Fleece's encoder. */
+        class CanonicalJSONDigester {
+          public:
+            explicit CanonicalJSONDigester(SHA1Builder& sha) : _sha(sha) {}
+
+            ~CanonicalJSONDigester() { flush(); }
+
+            void writeValue(Value value) {
+                switch ( value.type() ) {
+                    case kFLDict:
+                        writeDict(value.asDict());
+                        break;
+                    case kFLArray:
+                        {
+                            write('[');
+                            bool first = true;
+                            for ( Array::iterator i(value.asArray()); i; ++i ) {
+                                if ( !first ) write(',');
+                                first = false;
+                                writeValue(i.value());
+                            }
+                            write(']');
+                            break;
+                        }
+                    case kFLString:
+                        {
+                            slice str = value.asString();
+                            if ( !needsEscaping(str) ) {
+                                write('"');
+                                write(str);
+                                write('"');
+                            } else {
+                                writeWithFleece(value);
+                            }
+                            break;
+                        }
+                    case kFLNumber:
+                        if ( value.isInteger() ) {
+                            char buf[24];
+                            int  n = value.isUnsigned()
+                                             ? snprintf(buf, sizeof(buf), "%llu", (unsigned long long)value.asUnsigned())
+                                             : snprintf(buf, sizeof(buf), "%lld", (long long)value.asInt());
+                            write(slice(buf, n));
+                        } else {
+                            writeWithFleece(value);
+                        }
+                        break;
+                    case kFLBoolean:
+                        write(value.asBool() ? "true"_sl : "false"_sl);
+                        break;
+                    case kFLNull:
+                        write("null"_sl);
+                        break;
+                    default:
+                        writeWithFleece(value);
+                        break;
+                }
+            }
+
+          private:
+            void writeDict(Dict dict) {
+                // Canonical JSON orders keys bytewise:
+                smallVector<pair<slice, Value>, 16> items;
+                items.reserve(dict.count());
+                for ( Dict::iterator i(dict); i; ++i ) items.emplace_back(i.keyString(), i.value());
+                std::sort(items.begin(), items.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+                write('{');
+                bool first = true;
+                for ( auto& [key, value] : items ) {
+                    if ( !first ) write(',');
+                    first = false;
+                    if ( !needsEscaping(key) ) {
+                        write('"');
+                        write(key);
+                        write('"');
+                    } else {
+                        JSONEncoder enc;  // (rare)
+                        enc.writeString(key);
+                        write(enc.finish());
+                    }
+                    write(':');
+                    writeValue(value);
+                }
+                write('}');
+            }
+
+            static bool needsEscaping(slice str) {
+                return std::any_of((const uint8_t*)str.buf, (const uint8_t*)str.end(),
+                                   [](uint8_t c) { return c < 0x20 || c == '"' || c == '\\' || c == 0x7F; });
+            }
+
+            void writeWithFleece(Value value) {
+                alloc_slice json = FLValue_ToJSONX(value, false, true);
+                write(json);
+            }
+
+            void write(char c) {
+                if ( _used == sizeof(_buffer) ) flush();
+                _buffer[_used++] = c;
+            }
+
+            void write(slice s) {
+                if ( _used + s.size > sizeof(_buffer) ) {
+                    flush();
+                    if ( s.size > sizeof(_buffer) ) {
+                        _sha << s;
+                        return;
+                    }
+                }
+                memcpy(&_buffer[_used], s.buf, s.size);
+                _used += s.size;
+            }
+
+            void flush() {
+                if ( _used > 0 ) _sha << slice(_buffer, _used);
+                _used = 0;
+            }
+
+            SHA1Builder& _sha;
+            size_t       _used{0};
+            char         _buffer[4096];  // Coalesces small writes, since each SHA update has overhead
+        };
+    }  // namespace
+
     alloc_slice VectorRecord::generateRevID(Dict body, revid parentRevID, DocumentFlags flags) {
-        // Get SHA-1 digest of (length-prefixed) parent rev ID, deletion flag, and JSON:
-        alloc_slice json = FLValue_ToJSONX(body, false, true);
+        // Get SHA-1 digest of (length-prefixed) parent rev ID, deletion flag, and canonical JSON:
         parentRevID.setSize(min(parentRevID.size, size_t(255)));
-        auto     revLen     = (uint8_t)parentRevID.size;
-        uint8_t  delByte    = (flags & DocumentFlags::kDeleted) != 0;
-        SHA1     digest     = (SHA1Builder() << revLen << parentRevID << delByte << json).finish();
+        auto        revLen  = (uint8_t)parentRevID.size;
+        uint8_t     delByte = (flags & DocumentFlags::kDeleted) != 0;
+        SHA1Builder sha;
+        sha << revLen << parentRevID << delByte;
+        CanonicalJSONDigester(sha).writeValue(body);
+        SHA1     digest     = sha.finish();
         unsigned generation = parentRevID ? parentRevID.generation() + 1 : 1;
         return alloc_slice(revidBuffer(generation, slice(digest)).getRevID());
     }
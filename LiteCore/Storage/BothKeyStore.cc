@@ -64,6 +64,27 @@ namespace litecore {
         return seq;
     }
 
+    std::vector<Record> BothKeyStore::readMany(const std::vector<slice>& keys, ContentOption content) const {
+        auto records = _liveStore->readMany(keys, content);
+
+        // Look for the ones that weren't found in the dead store:
+        std::vector<slice>  recheckKeys;
+        std::vector<size_t> recheckIndexes;
+        for ( size_t i = 0; i < keys.size(); ++i ) {
+            if ( !records[i].exists() ) {
+                recheckKeys.push_back(keys[i]);
+                recheckIndexes.push_back(i);
+            }
+        }
+        if ( !recheckKeys.empty() ) {
+            auto dead = _deadStore->readMany(recheckKeys, content);
+            for ( size_t i = 0; i < dead.size(); ++i ) {
+                if ( dead[i].exists() ) records[recheckIndexes[i]] = std::move(dead[i]);
+            }
+        }
+        return records;
+    }
+
     std::vector<alloc_slice> BothKeyStore::withDocBodies(const std::vector<slice>& docIDs,
                                                          WithDocBodyCallback       callback) {
         // First, delegate to the live store:
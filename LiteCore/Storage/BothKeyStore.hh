@@ -36,6 +36,8 @@ namespace litecore {
             return _liveStore->read(rec, readBy, content) || _deadStore->read(rec, readBy, content);
         }
 
+        std::vector<Record> readMany(const std::vector<slice>& keys, ContentOption content) const override;
+
         sequence_t set(const RecordUpdate& rec, bool updateSequence, ExclusiveTransaction& transaction) override;
 
         void setKV(slice key, slice version, slice value, ExclusiveTransaction& transaction) override {
@@ -82,8 +84,10 @@ namespace litecore {
 
         expiration_t nextExpiration() override;
 
-        unsigned expireRecords(std::optional<ExpirationCallback> callback) override {
-            return _liveStore->expireRecords(callback) + _deadStore->expireRecords(callback);
+        unsigned expireRecords(std::optional<ExpirationCallback> callback, unsigned maxRecords) override {
+            unsigned expired = _liveStore->expireRecords(callback, maxRecords);
+            if ( expired < maxRecords ) expired += _deadStore->expireRecords(callback, maxRecords - expired);
+            return expired;
         }
 
         //// QUERIES & INDEXES:
@@ -100,6 +104,10 @@ namespace litecore {
 
         [[nodiscard]] std::vector<IndexSpec> getIndexes() const override { return _liveStore->getIndexes(); }
 
+        bool lazyIndexesNeedUpdate() override { return _liveStore->lazyIndexesNeedUpdate(); }
+
+        bool updateLazyIndexes(unsigned maxDocs) override { return _liveStore->updateLazyIndexes(maxDocs); }
+
 
       protected:
         void reopen() override {
@@ -165,7 +165,9 @@ namespace litecore {
         if ( !isOpen() ) error::_throw(error::NotOpen);
     }
 
-    DataFile* DataFile::openAnother(Delegate* delegate) { return factory().openFile(_path, delegate, &_options); }
+    DataFile* DataFile::openAnother(Delegate* delegate, const Options* options) {
+        return factory().openFile(_path, delegate, options ? options : &_options);
+    }
 
     void DataFile::rekey(EncryptionAlgorithm alg, slice newKey) {
         if ( alg != kNoEncryption ) error::_throw(error::UnsupportedEncryption);
@@ -309,6 +311,8 @@ namespace litecore {
         return keys;
     }
 
+    DocumentKeys* DataFile::documentKeysImpl() const { return static_cast<DocumentKeys*>(documentKeys()); }
+
 #pragma mark - QUERIES:
 
     void DataFile::registerQuery(Query* query) {
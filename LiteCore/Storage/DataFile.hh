@@ -33,6 +33,7 @@ namespace fleece::impl {
 namespace litecore {
 
     class Query;
+    class DocumentKeys;
     class ExclusiveTransaction;
     class SequenceTracker;
 
@@ -75,6 +76,7 @@ namespace litecore {
             bool                   writeable : 1;        ///< If false, db is opened read-only
             bool                   useDocumentKeys : 1;  ///< Use SharedKeys for Fleece docs
             bool                   upgradeable : 1;      ///< DB schema can be upgraded
+            bool                   metadataIndexes : 1;  ///< Index metadata for body-free enumeration
             EncryptionAlgorithm    encryptionAlgorithm;  ///< What encryption (if any)
             alloc_slice            encryptionKey;        ///< Encryption key, if encrypting
             DatabaseTag            dbTag;
@@ -102,8 +104,9 @@ namespace litecore {
         /** Closes the database and deletes its file. */
         void deleteDataFile();
 
-        /** Opens another instance on the same file. */
-        DataFile* openAnother(Delegate* NONNULL);
+        /** Opens another instance on the same file. If `options` is given it's used instead of
+            this instance's options, e.g. to open a read-only instance. */
+        DataFile* openAnother(Delegate* NONNULL, const Options* options = nullptr);
 
         DatabaseTag databaseTag() const { return _options.dbTag; }
 
@@ -124,12 +127,46 @@ namespace litecore {
         /** Perform database maintenance of some type. Returns false if not supported. */
         virtual void maintenance(MaintenanceType) = 0;
 
+        /** The file's use of space, for deciding when to do background maintenance. */
+        struct SpaceStats {
+            int64_t pageSize;
+            int64_t pageCount;  ///< Pages in the database file
+            int64_t freePages;  ///< Unused pages, which a vacuum would give back to the filesystem
+            int64_t walPages;   ///< Pages in the write-ahead log not yet copied into the database
+        };
+
+        virtual SpaceStats spaceStats() = 0;
+
+        /** Copies as much of the write-ahead log into the database file as it can, without waiting
+            for or blocking readers and writers. Returns the number of log pages it couldn't copy
+            because readers are still using them. */
+        virtual int64_t passiveCheckpoint() = 0;
+
+        /** Gives up to `maxPages` free pages back to the filesystem. This takes the file lock,
+            but only for the time it takes to move that many pages. Returns the number freed. */
+        virtual int64_t incrementalVacuum(int64_t maxPages) = 0;
+
+        /** Enters bulk-import mode, for saving large numbers of records quickly: value indexes
+            are dropped, to be rebuilt by `endBulkImport`, and commits aren't flushed to disk.
+            Their definitions are saved in the file, so if it's closed or the process exits
+            before `endBulkImport`, they're rebuilt the next time it's opened. */
+        virtual void beginBulkImport() = 0;
+
+        /** Exits bulk-import mode, rebuilding the indexes and flushing everything to disk. */
+        virtual void endBulkImport() = 0;
+
+        /** True between `beginBulkImport` and `endBulkImport`. */
+        virtual bool inBulkImport() const = 0;
+
         virtual void rekey(EncryptionAlgorithm, slice newKey);
 
         Delegate* delegate() const { return _delegate; }
 
         fleece::impl::SharedKeys* documentKeys() const;
 
+        /// The same object as `documentKeys`, as its actual class.
+        DocumentKeys* documentKeysImpl() const;
+
 
         void forOtherDataFiles(function_ref<void(DataFile*)> fn);
 
@@ -164,6 +201,11 @@ namespace litecore {
         /** The names of all existing KeyStores (whether opened yet or not) */
         virtual std::vector<std::string> allKeyStoreNames() const = 0;
 
+        /** The names of the KeyStores that may need background housekeeping, because they contain
+            records with expiration times or have lazy indexes to update. This is much faster than
+            checking each KeyStore, since it doesn't have to open them. */
+        virtual std::vector<std::string> keyStoresNeedingHousekeeping() = 0;
+
         void closeKeyStore(const std::string& name);
 
         /** Permanently deletes a KeyStore. */
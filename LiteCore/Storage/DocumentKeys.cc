@@ -0,0 +1,26 @@
+//
+// DocumentKeys.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "DocumentKeys.hh"
+
+namespace litecore {
+    using namespace std;
+
+    bool DocumentKeys::read() {
+        ++_reads;
+        Record r = _keyStore.get("SharedKeys"_sl);
+        return loadFrom(r.body());
+    }
+
+    DocumentKeys::Stats DocumentKeys::stats() const { return {count(), _reads.load()}; }
+
+}  // namespace litecore
@@ -15,6 +15,7 @@
 #include "DataFile.hh"
 #include "Record.hh"
 #include "SharedKeys.hh"
+#include <atomic>
 
 namespace litecore {
     using namespace fleece;
@@ -25,17 +26,22 @@ namespace litecore {
         explicit DocumentKeys(DataFile& db)
             : _db(db), _keyStore(_db.getKeyStore(DataFile::kInfoKeyStoreName, KeyStore::noSequences)) {}
 
+        struct Stats {
+            size_t   count;  ///< Number of keys in the table
+            uint64_t reads;  ///< Times the table was read from the database
+        };
+
+        Stats stats() const;
+
       protected:
-        bool read() override {
-            Record r = _keyStore.get("SharedKeys"_sl);
-            return loadFrom(r.body());
-        }
+        bool read() override;
 
         void write(slice encodedData) override { _keyStore.setKV("SharedKeys"_sl, encodedData, _db.transaction()); }
 
       private:
-        DataFile& _db;
-        KeyStore& _keyStore;
+        DataFile&             _db;
+        KeyStore&             _keyStore;
+        std::atomic<uint64_t> _reads{0};
     };
 
 }  // namespace litecore
@@ -59,6 +59,13 @@ namespace litecore {
         return rec;
     }
 
+    std::vector<Record> KeyStore::readMany(const std::vector<slice>& keys, ContentOption option) const {
+        std::vector<Record> records;
+        records.reserve(keys.size());
+        for ( slice key : keys ) records.push_back(get(key, option));
+        return records;
+    }
+
     void KeyStore::set(Record& rec, bool updateSequence, ExclusiveTransaction& t) {
         if ( auto seq = set(RecordUpdate(rec), updateSequence, t); seq > 0_seq ) {
             rec.setExists();
@@ -14,6 +14,7 @@
 #define LITECORE_CPP_API 1
 #include "IndexSpec.hh"
 #include "RecordEnumerator.hh"
+#include <climits>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -91,6 +92,12 @@ namespace litecore {
         [[nodiscard]] Record get(slice key, ContentOption = kEntireBody) const;
         [[nodiscard]] Record get(sequence_t, ContentOption = kEntireBody) const;
 
+        /** Reads multiple records by key, returning them in the same order as the keys. A key
+            that isn't found produces a Record that doesn't exist. The keys must be unique.
+            This is faster than calling `get` for each key. */
+        [[nodiscard]] virtual std::vector<Record> readMany(const std::vector<slice>& keys,
+                                                           ContentOption = kEntireBody) const;
+
         using WithDocBodyCallback = function_ref<alloc_slice(const RecordUpdate&)>;
 
         /** Invokes the callback once for each document found in the database.
@@ -169,9 +176,13 @@ namespace litecore {
 
         using ExpirationCallback = function_ref<void(slice docID)>;
 
-        /** Deletes all records whose expiration time is in the past.
+        /** Deletes records whose expiration time is in the past, soonest-expiring first.
+            @param callback  If given, is called with the key of each record before it's deleted.
+            @param maxRecords  The maximum number of records to delete. If this many are deleted,
+                               the caller should call again (in a new transaction) to get the rest.
             @return  The number of records deleted */
-        virtual unsigned expireRecords(std::optional<ExpirationCallback> = std::nullopt) = 0;
+        virtual unsigned expireRecords(std::optional<ExpirationCallback> callback = std::nullopt,
+                                       unsigned maxRecords = UINT_MAX) = 0;
 
 
         //////// Queries:
@@ -196,6 +207,14 @@ namespace litecore {
         virtual void                                 deleteIndex(slice name) = 0;
         [[nodiscard]] virtual std::vector<IndexSpec> getIndexes() const      = 0;
 
+        /** True if documents have changed since this KeyStore's lazy indexes were last updated. */
+        [[nodiscard]] virtual bool lazyIndexesNeedUpdate() { return false; }
+
+        /** Brings lazy indexes up to date with documents changed since they were last updated,
+            processing at most `maxDocs` changed documents. Must be called within a transaction.
+            @return  True if there are more changes left to process. */
+        virtual bool updateLazyIndexes(unsigned maxDocs) { return false; }
+
         // public for complicated reasons; clients should never call it
         virtual ~KeyStore() = default;
 
@@ -29,7 +29,11 @@
 #include "Stopwatch.hh"
 #include "StringUtil.hh"
 #include "fleece/Fleece.hh"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
+#include <set>
 #include <sqlite3.h>
 #include <sstream>
 #include <mutex>
@@ -75,9 +79,16 @@ namespace litecore {
     // SQLite cache size (per connection)
     static const size_t kCacheSize = 10 * MB;
 
+    // When over the cache budget, free idle connections' caches until usage is below this fraction
+    static const double kCacheBudgetTarget = 0.9;
+
     // Maximum size WAL journal will be left at after a commit
     static const int64_t kJournalSize = 5 * MB;
 
+    // WAL size (in pages) at which a commit checkpoints it; SQLite's default, and during a bulk import
+    static const int kAutoCheckpointPages           = 1000;
+    static const int kBulkImportAutoCheckpointPages = 25000;
+
     // Amount of file to memory-map
 #if TARGET_OS_OSX || TARGET_OS_SIMULATOR
     static const int kMMapSize = -1;  // Avoid possible file corruption hazard on macOS
@@ -143,6 +154,10 @@ namespace litecore {
         };
         Assert(sqlite3_libversion_number() >= 300900, "LiteCore requires SQLite 3.9+");
         sqlite3_config(SQLITE_CONFIG_LOG, sqlite3_log_callback, NULL);
+        // The cache budget (see setCacheBudget) needs SQLite's memory statistics. Some builds turn them
+        // off by default, since they add a mutex lock to every allocation; that cost is small
+        // next to the I/O a database connection does.
+        sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 1);
 #if defined(_MSC_VER) && !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
         setSqliteTempDirectory();
 #endif
@@ -179,6 +194,7 @@ namespace litecore {
     void SQLiteDataFile::reopen() {
         DataFile::reopen();
         reopenSQLiteHandle();
+        _hasLazyIndexes.reset();
         decrypt();
 
         withFileLock([this] {
@@ -244,6 +260,8 @@ namespace litecore {
         RegisterSQLiteFunctions(sqlite, {delegate(), documentKeys()});
         int rc = register_unicodesn_tokenizer(sqlite);
         if ( rc != SQLITE_OK ) warn("Unable to register FTS tokenizer: SQLite err %d", rc);
+        else if ( rc = RegisterFTS5Extensions(sqlite); rc != SQLITE_OK )
+            warn("Unable to register FTS5 tokenizer: SQLite err %d", rc);
 
         withFileLock([this] {
             if ( !upgradeSchema(SchemaVersion::WithDeletedTable, "Migrating deleted docs to `del_` tables", [&] {
@@ -264,6 +282,19 @@ namespace litecore {
                 error::_throw(error::CantUpgradeDatabase);
             }
         });
+
+        // Rebuild any indexes left deferred by a bulk import that didn't finish, unless another
+        // connection is still doing it:
+        if ( string sql; options().writeable && getSchema("deferredIndexes", "table", "deferredIndexes", sql) ) {
+            bool otherImporting = false;
+            forOtherDataFiles([&](DataFile* other) { otherImporting = otherImporting || other->inBulkImport(); });
+            if ( !otherImporting ) {
+                logInfo("Rebuilding indexes deferred by an unfinished bulk import...");
+                ExclusiveTransaction t(this);
+                restoreDeferredIndexes();
+                t.commit();
+            }
+        }
     }
 
     bool SQLiteDataFile::upgradeSchema(SchemaVersion minVersion, const char* what, function_ref<void()> upgrade) {
@@ -306,6 +337,27 @@ namespace litecore {
         return true;
     }
 
+    /*  The number of pages in the WAL that haven't been copied into the database yet, shared by all
+        connections to the file. (The size of the -wal file doesn't say, since it doesn't shrink.)
+        After each commit, SQLite's WAL hook tells the connection how many pages the WAL has, and a
+        checkpoint says how many of them it copied. Once all are copied, the next write transaction
+        starts the WAL over from the beginning, which shows up as the page count going down. */
+    struct SQLiteDataFile::WALState : public RefCounted {
+        void committed(int64_t pages) {
+            if ( pages < _pages.exchange(pages) ) _checkpointed = 0;
+        }
+
+        void checkpointed(int64_t pages, int64_t checkpointed) {
+            _pages        = pages;
+            _checkpointed = checkpointed;
+        }
+
+        int64_t uncheckpointedPages() const { return max(_pages - _checkpointed, int64_t(0)); }
+
+      private:
+        atomic<int64_t> _pages{0}, _checkpointed{0};
+    };
+
     void SQLiteDataFile::reopenSQLiteHandle() {
         // We are about to replace the sqlite3 handle, so the compiled statements
         // need to be cleared
@@ -316,7 +368,32 @@ namespace litecore {
 
         int sqlFlags = options().writeable ? SQLite::OPEN_READWRITE : SQLite::OPEN_READONLY;
         if ( options().create ) sqlFlags |= SQLite::OPEN_CREATE;
-        _sqlDb = make_unique<SQLite::Database>(filePath().path().c_str(), sqlFlags, kBusyTimeoutSecs * 1000);
+        auto sqlDb = make_unique<SQLite::Database>(filePath().path().c_str(), sqlFlags, kBusyTimeoutSecs * 1000);
+        registerOpenFile(this, false);  // so rebalanceCache doesn't see the handle change
+        _sqlDb = std::move(sqlDb);
+        noteActivity();
+        registerOpenFile(this, true);
+
+        // Track the WAL's size. This replaces SQLite's own WAL hook, which does the auto-checkpoints,
+        // so it does those too:
+        _autoCheckpointPages        = _bulkImport ? kBulkImportAutoCheckpointPages : kAutoCheckpointPages;
+        Retained<WALState> walState = new WALState;
+        _walState = (WALState*)addSharedObject("SQLiteDataFile::WALState", walState).get();
+        sqlite3_wal_hook(
+                _sqlDb->getHandle(),
+                [](void* context, sqlite3* db, const char* dbName, int walPages) -> int {
+                    auto self = (SQLiteDataFile*)context;
+                    self->_walState->committed(walPages);
+                    if ( walPages >= self->_autoCheckpointPages ) {
+                        int walFrames = 0, checkpointedFrames = 0;
+                        if ( sqlite3_wal_checkpoint_v2(db, dbName, SQLITE_CHECKPOINT_PASSIVE, &walFrames,
+                                                       &checkpointedFrames)
+                             == SQLITE_OK )
+                            self->_walState->checkpointed(walFrames, checkpointedFrames);
+                    }
+                    return SQLITE_OK;
+                },
+                this);
     }
 
     void SQLiteDataFile::ensureSchemaVersionAtLeast(SchemaVersion version) {
@@ -336,6 +413,16 @@ namespace litecore {
         _getPurgeCntStmt.reset();
         _setPurgeCntStmt.reset();
         if ( _sqlDb ) {
+            registerOpenFile(this, false);
+            if ( _bulkImport && !forDelete ) {
+                try {
+                    endBulkImport();
+                } catch ( const std::exception& x ) {
+                    // The indexes are still saved in `deferredIndexes`, so the next open rebuilds them:
+                    warn("Couldn't end bulk import while closing: %s", x.what());
+                }
+            }
+            _bulkImport = false;
             if ( options().writeable ) {
                 withFileLock([this]() {
                     optimize();
@@ -511,6 +598,7 @@ namespace litecore {
 
     void SQLiteDataFile::_beginTransaction(ExclusiveTransaction*) {
         checkOpen();
+        noteActivity();
         _exec("BEGIN");
     }
 
@@ -519,14 +607,92 @@ namespace litecore {
         forOpenKeyStores([commit](KeyStore& ks) { ks.transactionWillEnd(commit); });
 
         exec(commit ? "COMMIT" : "ROLLBACK");
+        if ( !commit ) _hasLazyIndexes.reset();  // the lazy-index tables may have been rolled back
+        rebalanceCache();
     }
 
     void SQLiteDataFile::beginReadOnlyTransaction() {
         checkOpen();
+        noteActivity();
         _exec("SAVEPOINT roTransaction");
     }
 
-    void SQLiteDataFile::endReadOnlyTransaction() { _exec("RELEASE SAVEPOINT roTransaction"); }
+    void SQLiteDataFile::endReadOnlyTransaction() {
+        _exec("RELEASE SAVEPOINT roTransaction");
+        rebalanceCache();
+    }
+
+#pragma mark - CACHE BUDGET:
+
+    // All open SQLiteDataFiles, so that rebalanceCache can find the idle ones.
+    // (Never destructed, since files may still be closing at exit.)
+    static mutex&                   sOpenFilesMutex = *new mutex;
+    static condition_variable&      sReleasedMemory = *new condition_variable;
+    static vector<SQLiteDataFile*>& sOpenFiles      = *new vector<SQLiteDataFile*>;
+    static bool                     sRebalancing    = false;  // Is a thread in rebalanceCache?
+
+    void SQLiteDataFile::noteActivity() {
+        _lastActivity = chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    void SQLiteDataFile::registerOpenFile(SQLiteDataFile* file, bool open) {
+        unique_lock lock(sOpenFilesMutex);
+        // Don't let the handle go away while rebalanceCache is freeing its memory:
+        if ( !open ) sReleasedMemory.wait(lock, [file] { return !file->_releasingMemory; });
+        auto i = find(sOpenFiles.begin(), sOpenFiles.end(), file);
+        if ( open && i == sOpenFiles.end() ) sOpenFiles.push_back(file);
+        else if ( !open && i != sOpenFiles.end() )
+            sOpenFiles.erase(i);
+    }
+
+    /*static*/ void SQLiteDataFile::setCacheBudget(int64_t bytes) {
+        (void)sqliteFactory();  // Configures SQLite, which must happen before it's initialized
+        // The soft heap limit makes SQLite's page caches recycle their own pages, instead of
+        // allocating more, once the process is near the limit:
+        sqlite3_soft_heap_limit64(max(bytes, int64_t(0)));
+        LogTo(DBLog, "SQLite cache budget set to %" PRIi64 " bytes", bytes);
+        rebalanceCache();
+    }
+
+    /*static*/ SQLiteDataFile::CacheUsage SQLiteDataFile::cacheUsage(bool resetPeak) {
+        (void)sqliteFactory();
+        return {sqlite3_soft_heap_limit64(-1), sqlite3_memory_used(), sqlite3_memory_highwater(resetPeak)};
+    }
+
+    // A connection only recycles its own cache, so one that's gone idle would keep its pages
+    // while busy ones are squeezed. When over budget, this frees the unused pages of the
+    // connections that have gone longest without a transaction, until usage is back under target.
+    /*static*/ void SQLiteDataFile::rebalanceCache() {
+        int64_t budget = sqlite3_soft_heap_limit64(-1);
+        if ( budget <= 0 || sqlite3_memory_used() <= budget ) return;
+
+        unique_lock lock(sOpenFilesMutex);
+        if ( sRebalancing ) return;  // Another thread is already on it
+        sRebalancing = true;
+        vector<SQLiteDataFile*> files = sOpenFiles;
+        sort(files.begin(), files.end(),
+             [](SQLiteDataFile* a, SQLiteDataFile* b) { return a->_lastActivity < b->_lastActivity; });
+        auto target = int64_t(double(budget) * kCacheBudgetTarget);
+        int  count  = 0;
+        for ( SQLiteDataFile* file : files ) {
+            if ( sqlite3_memory_used() <= target ) break;
+            if ( find(sOpenFiles.begin(), sOpenFiles.end(), file) == sOpenFiles.end() ) continue;  // closed
+            // SQLite waits for any other thread using the connection, so don't block opening and
+            // closing meanwhile; instead, closing this file waits in registerOpenFile.
+            // (SQLite serializes calls on a connection, so this is safe while another thread uses it.)
+            file->_releasingMemory = true;
+            lock.unlock();
+            sqlite3_db_release_memory(file->_sqlDb->getHandle());
+            lock.lock();
+            file->_releasingMemory = false;
+            sReleasedMemory.notify_all();
+            ++count;
+        }
+        sRebalancing = false;
+        lock.unlock();
+        LogVerbose(DBLog, "Over cache budget: freed memory of %d connection(s); now using %" PRIi64 " of %" PRIi64,
+                   count, sqlite3_memory_used(), budget);
+    }
 
     int SQLiteDataFile::_exec(const string& sql) {
         LogTo(SQL, "%s", sql.c_str());
@@ -560,6 +726,12 @@ namespace litecore {
         return st.executeStep() ? st.getColumn(0) : 0;
     }
 
+    // Sets the number of helper threads SQLite's sorter may use (e.g. in CREATE INDEX or ORDER BY),
+    // returning the previous limit. A negative value leaves the limit unchanged.
+    int SQLiteDataFile::setSorterThreads(int threads) {
+        return sqlite3_limit(_sqlDb->getHandle(), SQLITE_LIMIT_WORKER_THREADS, threads);
+    }
+
     unique_ptr<SQLite::Statement> SQLiteDataFile::compile(const char* sql) const {
         checkOpen();
         try {
@@ -605,6 +777,54 @@ namespace litecore {
         return getSchema(finalName, "table", finalName, sql);
     }
 
+    vector<string> SQLiteDataFile::keyStoresNeedingHousekeeping() {
+        checkOpen();
+        set<string> names;
+
+        // Find the tables with an `expiration` column; they have a partial index on it (see
+        // SQLiteKeyStore::addExpiration.) Then ask them all, in one query, which have any
+        // expiration times, which the index can answer without scanning the table.
+        vector<string> tables;
+        {
+            SQLite::Statement stmt(*_sqlDb, "SELECT tbl_name FROM sqlite_master"
+                                            " WHERE type='index' AND name GLOB 'kv_*_expiration'");
+            LogStatement(stmt);
+            while ( stmt.executeStep() ) tables.push_back(stmt.getColumn(0).getString());
+        }
+        // (A compound SELECT is limited to 500 terms by default, so use batches of fewer.)
+        static constexpr size_t kTablesPerQuery = 250;
+        for ( size_t start = 0; start < tables.size(); start += kTablesPerQuery ) {
+            stringstream sql;
+            for ( size_t i = start; i < min(start + kTablesPerQuery, tables.size()); ++i ) {
+                string quotedTable = tables[i];
+                replace(quotedTable, "\"", "\"\"");
+                if ( i > start ) sql << " UNION ALL ";
+                sql << "SELECT " << i << " WHERE EXISTS (SELECT 1 FROM \"" << quotedTable
+                    << "\" WHERE expiration IS NOT NULL)";
+            }
+            SQLite::Statement stmt(*_sqlDb, sql.str());
+            LogStatement(stmt);
+            while ( stmt.executeStep() ) {
+                string name = tables[stmt.getColumn(0).getInt()].substr(3);  // remove "kv_"
+                if ( hasPrefix(name, kDeletedKeyStorePrefix) ) name = name.substr(kDeletedKeyStorePrefix.size());
+                names.insert(SQLiteKeyStore::transformCollectionName(name, false));
+            }
+        }
+
+        if ( hasLazyIndexes() ) {
+            SQLite::Statement stmt(*_sqlDb, "SELECT DISTINCT keyStore FROM lazyIndexes"
+                                            " JOIN lazyIndexQueue USING (indexTableName)");
+            LogStatement(stmt);
+            while ( stmt.executeStep() ) names.insert(stmt.getColumn(0).getString());
+        }
+        return {names.begin(), names.end()};
+    }
+
+    bool SQLiteDataFile::isFTS5Table(const string& tableName) const {
+        string sql;
+        return getSchema(tableName, "table", tableName, sql) && sql.find("USING fts5(") != string::npos;
+    }
+
     // Returns true if an index/table exists in the database with the given type and SQL schema OR
     // Returns true if the given sql is empty and the schema doesn't exist.
     bool SQLiteDataFile::schemaExistsWithSQL(const string& name, const string& type, const string& tableName,
@@ -825,6 +1045,34 @@ namespace litecore {
             warn("auto_vacuum mode did not take effect after running full VACUUM!");
     }
 
+    DataFile::SpaceStats SQLiteDataFile::spaceStats() {
+        checkOpen();
+        return {intQuery("PRAGMA page_size"), intQuery("PRAGMA page_count"), intQuery("PRAGMA freelist_count"),
+                _walState->uncheckpointedPages()};
+    }
+
+    int64_t SQLiteDataFile::passiveCheckpoint() {
+        checkOpen();
+        int walFrames = 0, checkpointedFrames = 0;
+        int rc        = sqlite3_wal_checkpoint_v2(_sqlDb->getHandle(), nullptr, SQLITE_CHECKPOINT_PASSIVE, &walFrames,
+                                                  &checkpointedFrames);
+        if ( rc != SQLITE_OK && rc != SQLITE_BUSY ) error::_throw(error::SQLite, rc);
+        logVerbose("Passive checkpoint: %d of %d WAL pages checkpointed", checkpointedFrames, walFrames);
+        if ( rc == SQLITE_OK ) _walState->checkpointed(walFrames, checkpointedFrames);
+        return max(walFrames - checkpointedFrames, 0);
+    }
+
+    int64_t SQLiteDataFile::incrementalVacuum(int64_t maxPages) {
+        checkOpen();
+        int64_t freed = 0;
+        withFileLock([&] {
+            int64_t freePages = intQuery("PRAGMA freelist_count");
+            _exec(format("PRAGMA incremental_vacuum(%" PRIi64 ")", maxPages));
+            freed = freePages - intQuery("PRAGMA freelist_count");
+        });
+        return freed;
+    }
+
     void SQLiteDataFile::vacuum(bool always) noexcept {
         try {
             _vacuum(always);
@@ -881,6 +1129,38 @@ namespace litecore {
         }
     }
 
+    void SQLiteDataFile::beginBulkImport() {
+        checkOpen();
+        if ( _bulkImport ) error::_throw(error::InvalidParameter, "Already in bulk-import mode");
+        logInfo("Beginning bulk import");
+        {
+            ExclusiveTransaction t(this);
+            deferValueIndexes();
+            t.commit();
+        }
+        // Don't flush commits to disk, and let the WAL grow larger before checkpointing it:
+        _exec("PRAGMA synchronous=off");
+        _autoCheckpointPages = kBulkImportAutoCheckpointPages;
+        _bulkImport = true;
+    }
+
+    void SQLiteDataFile::endBulkImport() {
+        checkOpen();
+        if ( !_bulkImport ) error::_throw(error::InvalidParameter, "Not in bulk-import mode");
+        fleece::Stopwatch st;
+        _exec("PRAGMA synchronous=normal");
+        _autoCheckpointPages = kAutoCheckpointPages;
+        {
+            ExclusiveTransaction t(this);
+            restoreDeferredIndexes();
+            t.commit();
+        }
+        _bulkImport = false;
+        // Copy the WAL into the database and truncate it; this also flushes the unsynced commits:
+        withFileLock([this] { _exec("PRAGMA wal_checkpoint(TRUNCATE)"); });
+        logInfo("Ended bulk import; rebuilding indexes & checkpointing took %.3f sec", st.elapsed());
+    }
+
     alloc_slice SQLiteDataFile::rawQuery(const string& query) {
         SQLite::Statement stmt(*_sqlDb, query);
         int               nCols = stmt.getColumnCount();
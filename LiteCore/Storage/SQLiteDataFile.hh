@@ -16,6 +16,7 @@
 #include "QueryParser.hh"
 #include "IndexSpec.hh"
 #include "UnicodeCollator.hh"
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -51,11 +52,35 @@ namespace litecore {
         void     integrityCheck();
         void     maintenance(MaintenanceType) override;
 
+        SpaceStats spaceStats() override;
+        int64_t    passiveCheckpoint() override;
+        int64_t    incrementalVacuum(int64_t maxPages) override;
+        void       beginBulkImport() override;
+        void       endBulkImport() override;
+
+        bool inBulkImport() const override { return _bulkImport.load(); }
+
         static void shutdown() {}
 
+        /** SQLite's heap memory use, which is mostly the connections' page caches. */
+        struct CacheUsage {
+            int64_t budget;   ///< The limit set by `setCacheBudget`, or 0 if none
+            int64_t current;  ///< Bytes currently allocated
+            int64_t peak;     ///< Most bytes allocated at once, since startup or the last reset
+        };
+
+        /// Sets a process-wide limit on SQLite's memory use, shared by all connections, or 0 for
+        /// none. Caches stop growing near the limit, and when it's exceeded the connections
+        /// least recently used have their unused cache pages freed.
+        static void setCacheBudget(int64_t bytes);
+
+        /// Returns SQLite's current and peak memory use, optionally resetting the peak.
+        static CacheUsage cacheUsage(bool resetPeak = false);
+
         operator SQLite::Database&() { return *_sqlDb; }
 
         std::vector<std::string> allKeyStoreNames() const override;
+        std::vector<std::string> keyStoresNeedingHousekeeping() override;
         bool                     keyStoreExists(const std::string& name) const override;
         void                     deleteKeyStore(const std::string& name) override;
 
@@ -102,6 +127,7 @@ namespace litecore {
         string      collectionTableName(const string& collection, DeletionStatus) const override;
         std::string FTSTableName(const string& collection, const std::string& property) const override;
         std::string unnestedTableName(const string& collection, const std::string& property) const override;
+        bool        isFTS5Table(const std::string& tableName) const override;
 #ifdef COUCHBASE_ENTERPRISE
         std::string predictiveTableName(const string& collection, const std::string& property) const override;
 #endif
@@ -129,6 +155,7 @@ namespace litecore {
         int                                exec(const std::string& sql);
         int                                execWithLock(const std::string& sql);
         int64_t                            intQuery(const char* query);
+        int                                setSorterThreads(int);
         void                               optimizeAndVacuum();
 
         // Indexes:
@@ -138,6 +165,12 @@ namespace litecore {
         std::optional<SQLiteIndexSpec> getIndex(slice name);
         std::vector<SQLiteIndexSpec>   getIndexes(const KeyStore*);
 
+        // Lazy indexes:
+        bool hasLazyIndexes(bool recheck = false);
+        bool isLazyIndexTable(const std::string& indexTableName);
+        bool lazyIndexesNeedUpdate(const std::string& keyStoreName);
+        bool updateLazyIndexes(const std::string& keyStoreName, unsigned maxDocs);
+
       private:
         friend class SQLiteKeyStore;
         friend class SQLiteQuery;
@@ -158,6 +191,8 @@ namespace litecore {
             Current = WithDeletedTable
         };
 
+        struct WALState;
+
         void reopenSQLiteHandle();
         void ensureSchemaVersionAtLeast(SchemaVersion);
         bool upgradeSchema(SchemaVersion minVersion, const char* what, function_ref<void()>);
@@ -165,6 +200,10 @@ namespace litecore {
         void decrypt();
         bool _decrypt(EncryptionAlgorithm, slice key);
         int  _exec(const std::string& sql);
+        void noteActivity();
+
+        static void registerOpenFile(SQLiteDataFile*, bool open);
+        static void rebalanceCache();
 
         bool                         indexTableExists() const;
         void                         ensureIndexTableExists();
@@ -172,8 +211,11 @@ namespace litecore {
                                                    const std::string& indexTableName);
         void                         unregisterIndex(slice indexName);
         void                         garbageCollectIndexTable(const std::string& tableName);
-        static SQLiteIndexSpec       specFromStatement(SQLite::Statement& stmt);
+        SQLiteIndexSpec              specFromStatement(SQLite::Statement& stmt);
         std::vector<SQLiteIndexSpec> getIndexesOldStyle(const KeyStore* store = nullptr);
+        void                         ensureLazyIndexTablesExist();
+        void                         deferValueIndexes();
+        void                         restoreDeferredIndexes();
 
         unique_ptr<SQLite::Database>          _sqlDb;  // SQLite database object
         std::unique_ptr<SQLiteKeyStore>       _realDefaultKeyStore;
@@ -181,12 +223,18 @@ namespace litecore {
         mutable unique_ptr<SQLite::Statement> _getPurgeCntStmt, _setPurgeCntStmt;
         CollationContextVector                _collationContexts;
         SchemaVersion                         _schemaVersion{SchemaVersion::None};
+        std::optional<bool>                   _hasLazyIndexes;     // Cached result of hasLazyIndexes()
+        std::atomic<int64_t>                  _lastActivity{0};    // steady_clock time of last transaction
+        std::atomic<bool>                     _bulkImport{false};  // In bulk-import mode?
+        Retained<WALState>                    _walState;           // Counts the WAL's uncheckpointed pages
+        int _autoCheckpointPages{0};   // WAL pages at which a commit checkpoints it (set on open)
+        bool _releasingMemory{false};  // Is rebalanceCache using my handle? (guarded by sOpenFilesMutex)
     };
 
     struct SQLiteIndexSpec : public IndexSpec {
         SQLiteIndexSpec(const std::string& name, IndexSpec::Type type, alloc_slice expressionJSON, std::string ksName,
-                        std::string itName)
-            : IndexSpec(name, type, std::move(expressionJSON))
+                        std::string itName, const IndexSpec::Options* opt = nullptr)
+            : IndexSpec(name, type, std::move(expressionJSON), QueryLanguage::kJSON, opt)
             , keyStoreName(std::move(ksName))
             , indexTableName(std::move(itName)) {}
 
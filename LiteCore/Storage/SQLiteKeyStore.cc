@@ -179,6 +179,7 @@ namespace litecore {
         if ( !commit ) {
             if ( _uncommittedExpirationColumn ) _hasExpirationColumn = false;
             if ( _uncommitedTable ) { close(); }
+            _createdMetadataIndexes = false;  // they may have been rolled back
         }
 
         _uncommittedExpirationColumn = false;
@@ -256,6 +257,53 @@ namespace litecore {
         return true;
     }
 
+    vector<Record> SQLiteKeyStore::readMany(const vector<slice>& keys, ContentOption content) const {
+        // Keys are looked up in batches, each with one statement using a big "IN (...)" clause.
+        // The statement for a full batch is cached; the last, partial batch compiles its own.
+        static constexpr size_t kBatchSize = 100;
+
+        vector<Record> records;
+        records.reserve(keys.size());
+        unordered_map<slice, size_t> indices;  // maps key -> index in records[]
+        indices.reserve(keys.size());
+        for ( slice key : keys ) {
+            indices.insert({key, records.size()});
+            records.emplace_back(key);
+        }
+
+        lock_guard<mutex> lock(_stmtMutex);
+        for ( size_t start = 0; start < keys.size(); start += kBatchSize ) {
+            size_t n = min(kBatchSize, keys.size() - start);
+            // Note: In this SELECT statement the result column order must match RecordColumn.
+            string sql = "SELECT sequence, flags, key, version";
+            sql += (content >= kCurrentRevOnly) ? ", body" : ", length(body)";
+            sql += (content >= kEntireBody) ? ", extra" : ", length(extra)";
+            sql += " FROM kv_@ WHERE key IN (?";
+            for ( size_t i = 1; i < n; ++i ) sql += ",?";
+            sql += ")";
+
+            unique_ptr<SQLite::Statement> partialStmt;
+            SQLite::Statement*            stmt;
+            if ( n == kBatchSize ) {
+                stmt = &compileCached(sql);
+            } else {
+                partialStmt = compile(subst(sql.c_str()).c_str());
+                stmt        = partialStmt.get();
+            }
+            for ( size_t i = 0; i < n; ++i ) {
+                slice key = keys[start + i];
+                stmt->bindNoCopy(int(i + 1), (const char*)key.buf, (int)key.size);
+            }
+
+            UsingStatement u(*stmt);
+            while ( stmt->executeStep() ) {
+                auto i = indices.find(getColumnAsSlice(*stmt, RecordColumn::Key));
+                if ( i != indices.end() ) setRecordMetaAndBody(records[i->second], *stmt, content, false, true);
+            }
+        }
+        return records;
+    }
+
     void SQLiteKeyStore::setKV(slice key, slice version, slice value, ExclusiveTransaction& t) {
         DebugAssert(key.size > 0);
         DebugAssert(!_capabilities.sequences);
@@ -275,6 +323,7 @@ namespace litecore {
     sequence_t SQLiteKeyStore::set(const RecordUpdate& rec, bool updateSequence, ExclusiveTransaction&) {
         DebugAssert(rec.key.size > 0);
         DebugAssert(_capabilities.sequences);
+        if ( _db.options().metadataIndexes ) createMetadataIndexes();
 
         // About subsequences: Rather than adding another column, we store the subsequence in the
         // `flags` column, left-shifted so it doesn't interfere with the defined flag bits.
@@ -566,15 +615,18 @@ namespace litecore {
         return next;
     }
 
-    unsigned SQLiteKeyStore::expireRecords(optional<ExpirationCallback> callback) {
-        if ( !mayHaveExpiration() ) return 0;
+    unsigned SQLiteKeyStore::expireRecords(optional<ExpirationCallback> callback, unsigned maxRecords) {
+        if ( !mayHaveExpiration() || maxRecords == 0 ) return 0;
         expiration_t t       = now();
         unsigned     expired = 0;
         bool         none    = false;
+        // The SELECT and DELETE use the same ordering and limit, so in a transaction they see the
+        // same records. (The order uses the expiration index; `key` breaks ties deterministically.)
         if ( callback ) {
-            auto&          stmt = compileCached("SELECT key FROM kv_@ WHERE expiration <= ?");
+            auto& stmt = compileCached("SELECT key FROM kv_@ WHERE expiration <= ?1 ORDER BY expiration, key LIMIT ?2");
             UsingStatement u(stmt);
             stmt.bind(1, (long long)t);
+            stmt.bind(2, (long long)maxRecords);
             none = true;
             while ( stmt.executeStep() ) {
                 none = false;
@@ -582,8 +634,12 @@ namespace litecore {
             }
         }
         if ( !none ) {
-            expired = db().exec(
-                    format("DELETE FROM %s WHERE expiration <= %" PRId64, _quotedTableName.c_str(), (int64_t)t));
+            auto& stmt = compileCached("DELETE FROM kv_@ WHERE key IN (SELECT key FROM kv_@ WHERE expiration <= ?1 "
+                                       "ORDER BY expiration, key LIMIT ?2)");
+            UsingStatement u(stmt);
+            stmt.bind(1, (long long)t);
+            stmt.bind(2, (long long)maxRecords);
+            expired = stmt.exec();
         }
         db()._logInfo("Purged %u expired documents", expired);
         return expired;
@@ -58,6 +58,7 @@ namespace litecore {
         MUST_USE_RESULT static std::string transformCollectionName(const std::string& name, bool mangle);
 
         bool read(Record& rec, ReadBy, ContentOption) const override;
+        std::vector<Record> readMany(const std::vector<slice>& keys, ContentOption) const override;
 
         sequence_t set(const RecordUpdate&, bool updateSequence, ExclusiveTransaction&) override;
         void       setKV(slice key, slice version, slice value, ExclusiveTransaction&) override;
@@ -72,7 +73,7 @@ namespace litecore {
         bool         setExpiration(slice key, expiration_t) override;
         expiration_t getExpiration(slice key) override;
         expiration_t nextExpiration() override;
-        unsigned     expireRecords(std::optional<ExpirationCallback>) override;
+        unsigned     expireRecords(std::optional<ExpirationCallback>, unsigned maxRecords) override;
 
         bool supportsIndexes(IndexSpec::Type t) const override { return true; }
 
@@ -81,11 +82,15 @@ namespace litecore {
         void                   deleteIndex(slice name) override;
         std::vector<IndexSpec> getIndexes() const override;
 
+        bool lazyIndexesNeedUpdate() override;
+        bool updateLazyIndexes(unsigned maxDocs) override;
+
         std::vector<alloc_slice> withDocBodies(const std::vector<slice>& docIDs, WithDocBodyCallback callback) override;
 
         void createSequenceIndex();
         void createConflictsIndex();
         void createBlobsIndex();
+        void createMetadataIndexes();
 
         /// Adds the `expiration` column to the table. Called only by SQLiteQuery.
         void addExpiration() override;
@@ -130,13 +135,18 @@ namespace litecore {
         bool createIndex(const IndexSpec&, const std::string& sourceTableName,
                          fleece::impl::ArrayIterator& expressions);
         void _createFlagsIndex(const char* indexName NONNULL, DocumentFlags flag, bool& created);
+        void populateIndexTable(const IndexSpec&, const std::string& insertSQL, const std::string& whereSQL,
+                                std::string_view rowidColumn);
+        void setUpLazyIndexTable(const std::string& indexTableName, const std::string& insertSQL,
+                                 const std::string& whereSQL, std::string_view rowidColumn);
+        void checkIndexTableLaziness(const std::string& indexTableName, const IndexSpec&);
         bool createFTSIndex(const IndexSpec&);
         bool createArrayIndex(const IndexSpec&);
-        std::string createUnnestedTable(const fleece::impl::Value* arrayPath);
+        std::string createUnnestedTable(const fleece::impl::Value* arrayPath, const IndexSpec&);
 
 #ifdef COUCHBASE_ENTERPRISE
         bool        createPredictiveIndex(const IndexSpec&);
-        std::string createPredictionTable(const fleece::impl::Value* arrayPath);
+        std::string createPredictionTable(const fleece::impl::Value* arrayPath, const IndexSpec&);
         void        garbageCollectPredictiveIndexes();
 #endif
 
@@ -146,6 +156,7 @@ namespace litecore {
         mutable std::mutex     _stmtMutex;
         mutable StatementCache _stmtCache;
         bool                   _createdSeqIndex{false}, _createdConflictsIndex{false}, _createdBlobsIndex{false};
+        bool                   _createdMetadataIndexes{false};
         bool                   _lastSequenceChanged{false};
         bool                   _purgeCountChanged{false};
         mutable bool           _purgeCountValid{false};  // TODO: Use optional class from C++17
@@ -61,4 +61,8 @@ namespace litecore {
     };
 
     void RegisterSQLiteFunctions(sqlite3* db, fleeceFuncContext);
+
+    // Registers the `unicodesn` tokenizer and `offsets()` function with FTS5. Must be called after
+    // the FTS3 `unicodesn` tokenizer has been registered. Returns a SQLite status code.
+    int RegisterFTS5Extensions(sqlite3* db);
 }  // namespace litecore
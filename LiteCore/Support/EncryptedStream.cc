@@ -17,6 +17,8 @@
 #include "SecureSymmetricCrypto.hh"
 #include "Endian.hh"
 #include <algorithm>
+#include <exception>
+#include <thread>
 #include <utility>
 
 /*
@@ -45,6 +47,10 @@
     the PKCS7 padding would increase its length, making it overflow.
  
     Finally, the nonce is appended to the end of the stream.
+
+    Since every block has its own IV, blocks can be encrypted and decrypted independently. Large
+    reads and writes take advantage of this by processing many blocks at once, split among
+    several threads.
  */
 
 
@@ -54,15 +60,63 @@ namespace litecore {
 
     extern LogDomain BlobLog;
 
-    void EncryptedStream::initEncryptor(EncryptionAlgorithm alg, slice encryptionKey, slice nonce) {
+    // Batches smaller than this many blocks per thread aren't worth splitting up:
+    static constexpr size_t kMinBlocksPerThread = 64;
+    static constexpr size_t kMaxThreads         = 8;
+
+    // Maximum number of blocks EncryptedWriteStream encrypts before writing them:
+    static constexpr size_t kMaxWriteBatchBlocks = 1024;
+
+    void EncryptedStream::initEncryptor(EncryptionAlgorithm alg, slice encryptionKey, slice nonce, bool encrypting) {
         if ( alg != kAES256 ) error::_throw(error::UnsupportedEncryption);
 
         memcpy(&_key, encryptionKey.buf, kAES256KeySize);
         memcpy(&_nonce, nonce.buf, kAES256KeySize);
+        _encrypting = encrypting;
+        _cipher     = make_unique<AES256Cipher>(encrypting, slice(_key, sizeof(_key)));
     }
 
     EncryptedStream::~EncryptedStream() = default;
 
+    // Encrypts or decrypts whole blocks (not the final one) from `src` to `dst`, which may be the
+    // same. Large batches are split among threads, each with its own cipher.
+    void EncryptedStream::cryptBlocks(uint64_t firstBlockID, size_t nBlocks, const uint8_t* src, uint8_t* dst) {
+        auto cryptRange = [=](AES256Cipher& cipher, size_t begin, size_t end) {
+            for ( size_t i = begin; i < end; ++i ) {
+                uint64_t iv[2]  = {0, endian::enc64(firstBlockID + i)};
+                size_t   offset = i * kFileBlockSize;
+                cipher.crypt(slice(iv, sizeof(iv)), mutable_slice(dst + offset, kFileBlockSize),
+                             slice(src + offset, kFileBlockSize));
+            }
+        };
+
+        size_t nThreads = min({size_t(thread::hardware_concurrency()), kMaxThreads, nBlocks / kMinBlocksPerThread});
+        if ( nThreads <= 1 ) {
+            cryptRange(*_cipher, 0, nBlocks);
+            return;
+        }
+
+        size_t                perThread = (nBlocks + nThreads - 1) / nThreads;
+        vector<exception_ptr> errors(nThreads);
+        vector<thread>        threads;
+        for ( size_t t = 1; t < nThreads; ++t ) {
+            threads.emplace_back([&, t] {
+                try {
+                    AES256Cipher cipher(_encrypting, slice(_key, sizeof(_key)));
+                    cryptRange(cipher, min(nBlocks, t * perThread), min(nBlocks, (t + 1) * perThread));
+                } catch ( ... ) { errors[t] = current_exception(); }
+            });
+        }
+        // The current thread does the first range:
+        try {
+            cryptRange(*_cipher, 0, perThread);
+        } catch ( ... ) { errors[0] = current_exception(); }
+        for ( auto& th : threads ) th.join();
+        for ( auto& error : errors ) {
+            if ( error ) rethrow_exception(error);
+        }
+    }
+
 
 #pragma mark - WRITER:
 
@@ -73,7 +127,7 @@ namespace litecore {
         uint8_t       buf[kAES256KeySize];
         mutable_slice nonce(buf, sizeof(buf));
         SecureRandomize(nonce);
-        initEncryptor(alg, encryptionKey, nonce);
+        initEncryptor(alg, encryptionKey, nonce, true);
     }
 
     EncryptedWriteStream::~EncryptedWriteStream() {
@@ -87,14 +141,31 @@ namespace litecore {
         ++_blockID;
         uint8_t       cipherBuf[kFileBlockSize + kAESBlockSize];
         mutable_slice ciphertext(cipherBuf, sizeof(cipherBuf));
-        ciphertext.size =
-                AES256(true, slice(&_key, sizeof(_key)), slice(iv, sizeof(iv)), finalBlock, ciphertext, plaintext);
+        if ( finalBlock ) {
+            ciphertext.size =
+                    AES256(true, slice(&_key, sizeof(_key)), slice(iv, sizeof(iv)), true, ciphertext, plaintext);
+        } else {
+            ciphertext.size = plaintext.size;
+            _cipher->crypt(slice(iv, sizeof(iv)), ciphertext, plaintext);
+        }
         _output->write(ciphertext);
         LogVerbose(BlobLog, "WRITE #%2llu: %llu bytes, final=%d --> %llu bytes ciphertext",
                    (unsigned long long)(_blockID - 1), (unsigned long long)plaintext.size, finalBlock,
                    (unsigned long long)ciphertext.size);
     }
 
+    // Encrypts and writes a number of whole blocks at once.
+    void EncryptedWriteStream::writeBlocks(slice plaintext) {
+        size_t nBlocks = plaintext.size / kFileBlockSize;
+        DebugAssert(nBlocks * kFileBlockSize == plaintext.size, "Not a whole number of blocks");
+        _cipherBatch.resize(max(_cipherBatch.size(), plaintext.size));
+        cryptBlocks(_blockID, nBlocks, (const uint8_t*)plaintext.buf, _cipherBatch.data());
+        _blockID += nBlocks;
+        _output->write(slice(_cipherBatch.data(), plaintext.size));
+        LogVerbose(BlobLog, "WRITE #%2llu-%llu: %llu bytes", (unsigned long long)(_blockID - nBlocks),
+                   (unsigned long long)(_blockID - 1), (unsigned long long)plaintext.size);
+    }
+
     void EncryptedWriteStream::write(slice plaintext) {
         slice_istream in(plaintext);
         // Fill the current partial block buffer:
@@ -107,8 +178,11 @@ namespace litecore {
         // Write the completed buffer:
         writeBlock(slice(_buffer, kFileBlockSize), false);
 
-        // Write entire blocks:
-        while ( in.size >= kFileBlockSize ) writeBlock(in.readAll(kFileBlockSize), false);
+        // Write entire blocks, in batches:
+        while ( in.size >= kFileBlockSize ) {
+            size_t nBlocks = min(in.size / kFileBlockSize, kMaxWriteBatchBlocks);
+            writeBlocks(in.readAll(nBlocks * kFileBlockSize));
+        }
 
         // Save remainder (if any) in the buffer.
         memcpy(_buffer, in.buf, in.size);
@@ -139,7 +213,7 @@ namespace litecore {
         if ( _input->read(buf, sizeof(buf)) < sizeof(buf) ) error::_throw(error::CorruptData);
         _input->seek(0);
 
-        initEncryptor(alg, encryptionKey, slice(buf, sizeof(buf)));
+        initEncryptor(alg, encryptionKey, slice(buf, sizeof(buf)), false);
     }
 
     void EncryptedReadStream::close() {
@@ -160,14 +234,33 @@ namespace litecore {
 
         uint64_t iv[2] = {0, endian::enc64(_blockID)};
         ++_blockID;
-        size_t outputSize = AES256(false, slice(_key, sizeof(_key)), slice(iv, sizeof(iv)), finalBlock, output,
-                                   slice(blockBuf, bytesRead));
+        size_t outputSize;
+        if ( finalBlock ) {
+            outputSize = AES256(false, slice(_key, sizeof(_key)), slice(iv, sizeof(iv)), true, output,
+                                slice(blockBuf, bytesRead));
+        } else {
+            if ( bytesRead < kFileBlockSize ) error::_throw(error::CorruptData);
+            outputSize = kFileBlockSize;
+            _cipher->crypt(slice(iv, sizeof(iv)), mutable_slice(output.buf, outputSize), slice(blockBuf, bytesRead));
+        }
         LogVerbose(BlobLog, "READ  #%2llu: %llu bytes, final=%d --> %llu bytes ciphertext",
                    (unsigned long long)(_blockID - 1), (unsigned long long)bytesRead, finalBlock,
                    (unsigned long long)outputSize);
         return outputSize;
     }
 
+    // Reads & decrypts the next `nBlocks` whole blocks (not including the final block) into `output`
+    size_t EncryptedReadStream::readBlocksFromFile(mutable_slice output, size_t nBlocks) {
+        DebugAssert(_blockID + nBlocks <= _finalBlockID);
+        size_t size = nBlocks * kFileBlockSize;
+        if ( _input->read(output.buf, size) < size ) error::_throw(error::CorruptData);
+        cryptBlocks(_blockID, nBlocks, (const uint8_t*)output.buf, (uint8_t*)output.buf);
+        _blockID += nBlocks;
+        LogVerbose(BlobLog, "READ  #%2llu-%llu: %llu bytes", (unsigned long long)(_blockID - nBlocks),
+                   (unsigned long long)(_blockID - 1), (unsigned long long)size);
+        return size;
+    }
+
     // Reads the next block from the file into _buffer
     void EncryptedReadStream::fillBuffer() {
         _bufferBlockID = _blockID;
@@ -189,7 +282,10 @@ namespace litecore {
         // If there's decrypted data in the buffer, copy it to the output:
         readFromBuffer(remaining);
         if ( remaining.capacity() > 0 && _blockID <= _finalBlockID ) {
-            // Read & decrypt as many blocks as possible from the file to the output:
+            // Read & decrypt as many whole blocks as possible, at once, directly into the output:
+            auto nBlocks = size_t(min(uint64_t(remaining.capacity() / kFileBlockSize), _finalBlockID - _blockID));
+            if ( nBlocks > 0 ) remaining.advance(readBlocksFromFile(remaining.buffer(), nBlocks));
+            // Then the final block, if there's room for it:
             while ( remaining.capacity() >= kFileBlockSize && _blockID <= _finalBlockID ) {
                 remaining.advance(readBlockFromFile(remaining.buffer()));
             }
@@ -14,8 +14,10 @@
 #include "Stream.hh"
 #include "slice_stream.hh"
 #include <memory>
+#include <vector>
 
 namespace litecore {
+    class AES256Cipher;
 
     /** Abstract base class of EncryptedReadStream and EncryptedWriteStream. */
     class EncryptedStream {
@@ -26,15 +28,18 @@ namespace litecore {
 
       protected:
         EncryptedStream() = default;
-        void initEncryptor(EncryptionAlgorithm alg, slice encryptionKey, slice nonce);
+        void initEncryptor(EncryptionAlgorithm alg, slice encryptionKey, slice nonce, bool encrypting);
         virtual ~EncryptedStream();
+        void cryptBlocks(uint64_t firstBlockID, size_t nBlocks, const uint8_t* src, uint8_t* dst);
 
-        EncryptionAlgorithm _alg{};
-        uint8_t             _key[kKeySize]{};
-        uint8_t             _nonce[kKeySize]{};
-        uint8_t             _buffer[kFileBlockSize]{};  // stores partially read/written blocks across calls
-        size_t              _bufferPos{0};              // Indicates how much of buffer is used
-        uint64_t            _blockID{0};                // Next block ID to be encrypted/decrypted (counter)
+        EncryptionAlgorithm           _alg{};
+        bool                          _encrypting{};
+        std::unique_ptr<AES256Cipher> _cipher;                    // Encrypts/decrypts all but the final block
+        uint8_t                       _key[kKeySize]{};
+        uint8_t                       _nonce[kKeySize]{};
+        uint8_t                       _buffer[kFileBlockSize]{};  // stores partially read/written blocks across calls
+        size_t                        _bufferPos{0};              // Indicates how much of buffer is used
+        uint64_t                      _blockID{0};                // Next block ID to be encrypted/decrypted (counter)
     };
 
     /** Encrypts data written to it, and writes it to a wrapped WriteStream. */
@@ -50,8 +55,10 @@ namespace litecore {
 
       private:
         void writeBlock(slice plaintext, bool finalBlock);
+        void writeBlocks(slice plaintext);
 
-        std::shared_ptr<WriteStream> _output;  // Wrapped stream that will write the ciphertext
+        std::shared_ptr<WriteStream> _output;       // Wrapped stream that will write the ciphertext
+        std::vector<uint8_t>         _cipherBatch;  // Ciphertext of multiple blocks, written at once
     };
 
     /** Provides (random) access to a data stream encrypted by EncryptedWriteStream. */
@@ -68,6 +75,7 @@ namespace litecore {
 
       private:
         size_t readBlockFromFile(fleece::mutable_slice);
+        size_t readBlocksFromFile(fleece::mutable_slice, size_t nBlocks);
         void   readFromBuffer(fleece::slice_ostream& dst);
         void   fillBuffer();
         void   findLength();
@@ -33,6 +33,8 @@
 #        include <CoreFoundation/CoreFoundation.h>
 #    elif defined(__linux__)
 #        include "strlcat.h"
+#        include <linux/fs.h>  // for FICLONE
+#        include <sys/ioctl.h>
 #        include <sys/sendfile.h>
 #    endif
 #else
@@ -51,6 +53,33 @@ using namespace fleece;
 using namespace litecore;
 
 #ifdef __linux__
+// Copies a file without reading it into user space: first by making a copy-on-write clone (btrfs,
+// XFS...), then with copy_file_range, which may share blocks or copy server-side too.
+// Returns 1 on success, 0 if neither is supported for these files, or -1 on error (with errno set.)
+static int clonefile(int read_fd, int write_fd, size_t size) {
+#    ifdef FICLONE
+    if ( ioctl(write_fd, FICLONE, read_fd) == 0 ) return 1;
+#    endif
+#    if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+    loff_t inOffset = 0, outOffset = 0;
+    while ( size_t(outOffset) < size ) {
+        ssize_t bytes = copy_file_range(read_fd, &inOffset, write_fd, &outOffset, size - outOffset, 0);
+        if ( bytes < 0 ) {
+            if ( outOffset == 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) )
+                return 0;
+            return -1;
+        } else if ( bytes == 0 ) {
+            if ( outOffset == 0 ) return 0;
+            errno = EIO;  // File got shorter?
+            return -1;
+        }
+    }
+    return 1;
+#    else
+    return 0;
+#    endif
+}
+
 static int copyfile(const char* from, const char* to) {
     int         read_fd, write_fd;
     off_t       offset = 0;
@@ -73,7 +102,16 @@ static int copyfile(const char* from, const char* to) {
         return write_fd;
     }
 
-    size_t  expected = stat_buf.st_size;
+    int cloned = clonefile(read_fd, write_fd, stat_buf.st_size);
+    if ( cloned < 0 ) {
+        int e = errno;
+        close(read_fd);
+        close(write_fd);
+        errno = e;
+        return -1;
+    }
+
+    size_t  expected = cloned ? 0 : stat_buf.st_size;
     ssize_t bytes    = 0;
     while ( bytes < expected ) {
         expected -= bytes;
@@ -402,6 +440,14 @@ namespace litecore {
         return s.st_mtime;
     }
 
+    bool FilePath::setLastModified(time_t modTime) const {
+        if ( utime_u8(path().c_str(), modTime) != 0 ) {
+            if ( errno == ENOENT ) return false;
+            error::_throwErrno();
+        }
+        return true;
+    }
+
     bool FilePath::exists() const noexcept {
         lc_stat_t s;
         return stat_u8(path().c_str(), &s) == 0;
@@ -119,6 +119,9 @@ namespace litecore {
         /** Returns the date at which this file was last modified, or -1 if the file does not exist */
         [[nodiscard]] time_t lastModified() const;
 
+        /** Sets the file's modification date. Returns false if the file does not exist. */
+        bool setLastModified(time_t) const;
+
         /**
          * The return values of mkdir(), del(), and delRecursive() are almost never used throughout our code,
          * so making them nodiscard causes a lot of compilation warnings (and thereby errors with -Werror).
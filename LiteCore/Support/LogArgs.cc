@@ -0,0 +1,280 @@
+//
+// LogArgs.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "LogArgs.hh"
+#include <algorithm>
+#include <cctype>
+
+#if __APPLE__
+#    include <CoreFoundation/CFBase.h>
+#    include <CoreFoundation/CFString.h>
+#endif
+
+using namespace std;
+using namespace fleece;
+
+namespace litecore {
+
+    bool LogFormatSpec::next(const char* c, LogFormatSpec& spec) {
+        c = strchr(c, '%');
+        if ( !c ) return false;
+        spec.start   = c++;
+        bool minus   = false;
+        spec.dotStar = false;
+        if ( *c == '-' ) {
+            minus = true;
+            ++c;
+        }
+        c += strspn(c, "#0- +'");
+        while ( isdigit(*c) ) ++c;
+        if ( *c == '.' ) {
+            ++c;
+            if ( *c == '*' ) {
+                spec.dotStar = true;
+                ++c;
+            } else {
+                while ( isdigit(*c) ) ++c;
+            }
+        }
+        spec.modifier = c;
+        c += strspn(c, "hljtzq");
+
+        // (These size rules match the ones LogEncoder has always used.)
+        if ( c[-1] == 'q' ) spec.size = kLongLong;
+        else if ( c[-1] == 'z' )
+            spec.size = kSizeT;
+        else if ( c[-1] != 'l' )
+            spec.size = kInt;
+        else if ( c[-2] != 'l' )
+            spec.size = kLong;
+        else
+            spec.size = kLongLong;
+
+        switch ( *c ) {
+            case 'c':
+            case 'd':
+            case 'i':
+                spec.kind = kSigned;
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                spec.kind = kUnsigned;
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                spec.kind = kDouble;
+                break;
+            case 's':
+                spec.kind = (minus && !spec.dotStar) ? kToken : kString;
+                break;
+            case 'p':
+                spec.kind = kPointer;
+                break;
+#if __APPLE__
+            case '@':
+                spec.kind = kObject;
+                break;
+#endif
+            case '%':
+                spec.kind = kPercent;
+                break;
+            default:
+                spec.kind = kUnknown;
+                spec.end  = c;
+                return true;
+        }
+        spec.end = c + 1;
+        return true;
+    }
+
+#pragma mark - LOGARGS:
+
+    LogArgs::LogArgs(const char* format, va_list args) {
+        VaListLogArgs source(args);
+        LogFormatSpec spec{};
+        for ( const char* c = format; LogFormatSpec::next(c, spec); c = spec.end ) {
+            switch ( spec.kind ) {
+                case LogFormatSpec::kSigned:
+                    append(source.nextSigned(spec));
+                    break;
+                case LogFormatSpec::kUnsigned:
+                    append(source.nextUnsigned(spec));
+                    break;
+                case LogFormatSpec::kDouble:
+                    append(source.nextDouble());
+                    break;
+                case LogFormatSpec::kString:
+                    appendString(source.nextString(spec));
+                    break;
+                case LogFormatSpec::kToken:
+                    append(source.nextToken());
+                    break;
+                case LogFormatSpec::kPointer:
+                    append(source.nextPointer());
+                    break;
+                case LogFormatSpec::kObject:
+                    appendString(source.nextObjectDescription());
+                    break;
+                case LogFormatSpec::kPercent:
+                    break;
+                case LogFormatSpec::kUnknown:
+                    return;  // Can't tell what the remaining args are
+            }
+        }
+    }
+
+    void LogArgs::appendString(slice str) {
+        append(uint32_t(str.size));
+        _data.append((const char*)str.buf, str.size);
+    }
+
+    slice LogArgs::Reader::readString() {
+        auto  size = read<uint32_t>();
+        slice str(_pos, size);
+        _pos += size;
+        return str;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+    string LogArgs::format(const char* format) const {
+        Reader        args(*this);
+        string        result;
+        string        specStr;
+        char          buf[64];
+        LogFormatSpec spec{};
+        const char*   c = format;
+        for ( ; LogFormatSpec::next(c, spec); c = spec.end ) {
+            result.append(c, spec.start);
+            if ( spec.kind == LogFormatSpec::kUnknown ) {
+                result += spec.start;  // Can't format the rest
+                return result;
+            }
+            if ( spec.kind == LogFormatSpec::kPercent ) {
+                result += '%';
+                continue;
+            }
+
+            // Rebuild the substitution with a length modifier that fits the copied value:
+            specStr.assign(spec.start, spec.modifier);
+            int n;
+            switch ( spec.kind ) {
+                case LogFormatSpec::kSigned:
+                    if ( spec.end[-1] == 'c' ) {
+                        n = snprintf(buf, sizeof(buf), (specStr + 'c').c_str(), int(args.nextSigned(spec)));
+                    } else {
+                        specStr += "ll";
+                        n = snprintf(buf, sizeof(buf), (specStr + spec.end[-1]).c_str(), args.nextSigned(spec));
+                    }
+                    break;
+                case LogFormatSpec::kUnsigned:
+                    specStr += "ll";
+                    n = snprintf(buf, sizeof(buf), (specStr + spec.end[-1]).c_str(), args.nextUnsigned(spec));
+                    break;
+                case LogFormatSpec::kDouble:
+                    n = snprintf(buf, sizeof(buf), (specStr + spec.end[-1]).c_str(), args.nextDouble());
+                    break;
+                case LogFormatSpec::kPointer:
+                    n = snprintf(buf, sizeof(buf), (specStr + 'p').c_str(), (void*)args.nextPointer());
+                    break;
+                default:
+                    {
+                        // A string of any kind:
+                        string str = (spec.kind == LogFormatSpec::kToken) ? string(args.nextToken())
+                                                                          : string(args.nextString(spec));
+                        if ( spec.dotStar ) specStr.resize(specStr.size() - 2);  // remove ".*"
+                        if ( specStr == "%" || specStr == "%-" ) {
+                            result += str;
+                            continue;
+                        }
+                        n = snprintf(nullptr, 0, (specStr + 's').c_str(), str.c_str());
+                        if ( n > 0 ) {
+                            size_t pos = result.size();
+                            result.resize(pos + n + 1);
+                            snprintf(&result[pos], n + 1, (specStr + 's').c_str(), str.c_str());
+                            result.resize(pos + n);
+                        }
+                        continue;
+                    }
+            }
+            if ( n > 0 ) result.append(buf, min(size_t(n), sizeof(buf) - 1));
+        }
+        result += c;
+        return result;
+    }
+
+#pragma GCC diagnostic pop
+
+#pragma mark - VA_LIST:
+
+    long long VaListLogArgs::nextSigned(const LogFormatSpec& spec) {
+        switch ( spec.size ) {
+            case LogFormatSpec::kLongLong:
+                return va_arg(_args, long long);
+            case LogFormatSpec::kSizeT:
+                return va_arg(_args, ptrdiff_t);
+            case LogFormatSpec::kLong:
+                return va_arg(_args, long);
+            default:
+                return va_arg(_args, int);
+        }
+    }
+
+    unsigned long long VaListLogArgs::nextUnsigned(const LogFormatSpec& spec) {
+        switch ( spec.size ) {
+            case LogFormatSpec::kLongLong:
+                return va_arg(_args, unsigned long long);
+            case LogFormatSpec::kSizeT:
+                return va_arg(_args, size_t);
+            case LogFormatSpec::kLong:
+                return va_arg(_args, unsigned long);
+            default:
+                return va_arg(_args, unsigned int);
+        }
+    }
+
+    slice VaListLogArgs::nextString(const LogFormatSpec& spec) {
+        if ( spec.dotStar ) {
+            size_t size = va_arg(_args, int);
+            return {va_arg(_args, const char*), size};
+        } else {
+            const char* str = va_arg(_args, const char*);
+            return slice(str ? str : "(null)");
+        }
+    }
+
+    string VaListLogArgs::nextObjectDescription() {
+#if __APPLE__
+        // "%@" substitutes an Objective-C or CoreFoundation object's description.
+        CFTypeRef param = va_arg(_args, CFTypeRef);
+        if ( param == nullptr ) return "(null)";
+        CFStringRef description;
+        if ( CFGetTypeID(param) == CFStringGetTypeID() ) description = (CFStringRef)param;
+        else
+            description = CFCopyDescription(param);
+        string result = string(nsstring_slice(description));
+        if ( description != param ) CFRelease(description);
+        return result;
+#else
+        return "";
+#endif
+    }
+
+}  // namespace litecore
@@ -0,0 +1,122 @@
+//
+// LogArgs.hh
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#pragma once
+#include "fleece/slice.hh"
+#include "c4Compat.h"
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace litecore {
+
+    /** One `%` substitution in a log format string. */
+    struct LogFormatSpec {
+        enum Kind : uint8_t {
+            kPercent,   ///< "%%"; takes no argument
+            kSigned,    ///< d, i, c
+            kUnsigned,  ///< u, x, X
+            kDouble,    ///< e, f, g, a (any case)
+            kString,    ///< s, including "%.*s" which takes a length first
+            kToken,     ///< "%-s": a string constant, which LogEncoder writes as a token
+            kPointer,   ///< p
+            kObject,    ///< "%@": an Objective-C or CoreFoundation object (Apple only)
+            kUnknown,   ///< Unsupported; the format can't be used past this point
+        };
+
+        enum Size : uint8_t { kInt, kLong, kLongLong, kSizeT };
+
+        const char* start;     ///< The '%'
+        const char* modifier;  ///< The length modifier (e.g. "ll"), or the type if there's none
+        const char* end;       ///< Just past the type character
+        Kind        kind;
+        Size        size;
+        bool        dotStar;  ///< Is the precision "*", taking an int argument?
+
+        /// Finds the next substitution in a format string, starting at `format`.
+        /// Returns false if there are no more.
+        static bool next(const char* format, LogFormatSpec& spec);
+    };
+
+    /** A log message's arguments, copied out of a `va_list` so that the message can be formatted
+        or encoded later, on another thread. The arguments' types come from the format string.
+
+        Strings are copied, except for "%-s" tokens: those must be string constants, since
+        LogEncoder identifies them by address, so only their pointers are kept. */
+    class LogArgs {
+      public:
+        LogArgs() = default;
+        LogArgs(const char* format, va_list args) __printflike(2, 0);
+
+        /// Returns the message formatted as by `vsnprintf`.
+        [[nodiscard]] std::string format(const char* format) const;
+
+        /** Reads the arguments back in order. Each method must be called for a substitution of
+            the corresponding kind. (`VaListLogArgs` has the same interface, for use in templates.) */
+        class Reader {
+          public:
+            explicit Reader(const LogArgs& args) : _pos((const uint8_t*)args._data.data()) {}
+
+            long long          nextSigned(const LogFormatSpec&) { return read<long long>(); }
+            unsigned long long nextUnsigned(const LogFormatSpec&) { return read<unsigned long long>(); }
+            double             nextDouble() { return read<double>(); }
+            fleece::slice      nextString(const LogFormatSpec&) { return readString(); }
+            const char*        nextToken() { return read<const char*>(); }
+            size_t             nextPointer() { return read<size_t>(); }
+            std::string        nextObjectDescription() { return std::string(readString()); }
+
+          private:
+            fleece::slice readString();
+
+            template <class T>
+            T read() {
+                T value;
+                memcpy(&value, _pos, sizeof(T));
+                _pos += sizeof(T);
+                return value;
+            }
+
+            const uint8_t* _pos;
+        };
+
+      private:
+        template <class T>
+        void append(T value) {
+            _data.append((const char*)&value, sizeof(T));
+        }
+
+        void appendString(fleece::slice);
+
+        std::string _data;
+    };
+
+    /** Reads arguments from a `va_list`, with the same interface as `LogArgs::Reader`. */
+    class VaListLogArgs {
+      public:
+        explicit VaListLogArgs(va_list args) { va_copy(_args, args); }
+
+        ~VaListLogArgs() { va_end(_args); }
+
+        long long          nextSigned(const LogFormatSpec&);
+        unsigned long long nextUnsigned(const LogFormatSpec&);
+        double             nextDouble() { return va_arg(_args, double); }
+        fleece::slice      nextString(const LogFormatSpec&);
+        const char*        nextToken() { return va_arg(_args, const char*); }
+        size_t             nextPointer() { return va_arg(_args, size_t); }
+        std::string        nextObjectDescription();
+
+      private:
+        va_list _args;
+    };
+
+}  // namespace litecore
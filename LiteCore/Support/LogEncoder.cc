@@ -11,19 +11,16 @@
 //
 
 #include "LogEncoder.hh"
+#include "LogArgs.hh"
 #include "LogDecoder.hh"
 #include "Endian.hh"
 #include "StringUtil.hh"
 #include "varint.hh"
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <ctime>
 
-#if __APPLE__
-#    include <CoreFoundation/CFBase.h>
-#    include <CoreFoundation/CFString.h>
-#endif
-
 using namespace std;
 using namespace fleece;
 
@@ -44,6 +41,7 @@ namespace litecore {
         uint8_t header[2] = {LogDecoder::kFormatVersion, sizeof(void*)};
         _writer.write(&header, sizeof(header));
         auto now = LogDecoder::now();
+        _start   = {now.secs, now.microsecs};
         _writeUVarInt(now.secs);
         _lastElapsed = -(int)now.microsecs;  // so first delta will be accurate
         _st.reset();
@@ -79,10 +77,31 @@ namespace litecore {
 
     void LogEncoder::vlog(const char* domain, const map<unsigned, string>& objectMap, ObjectRef object,
                           const char* format, va_list args) {
+        VaListLogArgs source(args);
+        _log(domain, objectMap, object, format, source, nullptr);
+    }
+
+    void LogEncoder::log(const char* domain, const map<unsigned, string>& objectMap, ObjectRef object,
+                         const char* format, const LogArgs& args, Timestamp when) {
+        LogArgs::Reader source(args);
+        _log(domain, objectMap, object, format, source, &when);
+    }
+
+    template <class ARGS>
+    void LogEncoder::_log(const char* domain, const map<unsigned, string>& objectMap, ObjectRef object,
+                          const char* format, ARGS& args, const Timestamp* when) {
         lock_guard<mutex> lock(_mutex);
 
-        // Write the number of ticks elapsed since the last message:
-        auto     elapsed = _timeElapsed();
+        // Write the number of ticks elapsed since the last message. A message with its own timestamp
+        // is placed relative to the start time, but never before the previous message:
+        int64_t elapsed;
+        if ( when ) {
+            elapsed = int64_t(when->secs - _start.secs) * kTicksPerSec
+                      + (int64_t(when->microsecs) - int64_t(_start.microsecs)) * kTicksPerSec / 1000000;
+            elapsed = std::max(elapsed, _lastElapsed);
+        } else {
+            elapsed = _timeElapsed();
+        }
         uint64_t delta   = elapsed - _lastElapsed;
         _lastElapsed     = elapsed;
         _writeUVarInt(delta);
@@ -106,133 +125,58 @@ namespace litecore {
 
         _writeStringToken(format);
 
-        // Parse the format string looking for substitutions:
-        for ( const char* c = format; *c != '\0'; ++c ) {
-            if ( *c == '%' ) {
-                bool minus   = false;
-                bool dotStar = false;
-                ++c;
-                if ( *c == '-' ) {
-                    minus = true;
-                    ++c;
-                }
-                c += strspn(c, "#0- +'");
-                while ( isdigit(*c) ) ++c;
-                if ( *c == '.' ) {
-                    ++c;
-                    if ( *c == '*' ) {
-                        dotStar = true;
-                        ++c;
-                    } else {
-                        while ( isdigit(*c) ) ++c;
+        // Write the arguments of the format string's substitutions:
+        LogFormatSpec spec{};
+        for ( const char* c = format; LogFormatSpec::next(c, spec); c = spec.end ) {
+            switch ( spec.kind ) {
+                case LogFormatSpec::kSigned:
+                    {
+                        long long param = args.nextSigned(spec);
+                        uint8_t   sign  = (param < 0) ? 1 : 0;
+                        _writer.write(&sign, 1);
+                        _writeUVarInt(abs(param));
+                        break;
                     }
-                }
-                c += strspn(c, "hljtzq");
-
-                switch ( *c ) {
-                    case 'c':
-                    case 'd':
-                    case 'i':
-                        {
-                            long long param;
-                            if ( c[-1] == 'q' ) param = va_arg(args, long long);
-                            else if ( c[-1] == 'z' )
-                                param = va_arg(args, ptrdiff_t);
-                            else if ( c[-1] != 'l' )
-                                param = va_arg(args, int);
-                            else if ( c[-2] != 'l' )
-                                param = va_arg(args, long);
-                            else
-                                param = va_arg(args, long long);
-                            uint8_t sign = (param < 0) ? 1 : 0;
-                            _writer.write(&sign, 1);
-                            _writeUVarInt(abs(param));
-                            break;
-                        }
-                    case 'u':
-                    case 'x':
-                    case 'X':
-                        {
-                            unsigned long long param;
-                            if ( c[-1] == 'q' ) param = va_arg(args, unsigned long long);
-                            else if ( c[-1] == 'z' )
-                                param = va_arg(args, size_t);
-                            else if ( c[-1] != 'l' )
-                                param = va_arg(args, unsigned int);
-                            else if ( c[-2] != 'l' )
-                                param = va_arg(args, unsigned long);
-                            else
-                                param = va_arg(args, unsigned long long);
-                            _writeUVarInt(param);
-                            break;
-                        }
-                    case 'e':
-                    case 'E':
-                    case 'f':
-                    case 'F':
-                    case 'g':
-                    case 'G':
-                    case 'a':
-                    case 'A':
-                        {
-                            fleece::endian::littleEndianDouble param = va_arg(args, double);
-                            _writer.write(&param, sizeof(param));
-                            break;
-                        }
-                    case 's':
-                        {
-                            const char* str;
-                            size_t      size;
-                            if ( dotStar ) {
-                                size = va_arg(args, int);
-                                str  = va_arg(args, const char*);
-                            } else {
-                                str  = va_arg(args, const char*);
-                                size = strlen(str);
-                            }
-                            if ( minus && !dotStar ) {
-                                _writeStringToken(str);
-                            } else {
-                                _writeUVarInt(size);
-                                if ( size > 0 ) _writer.write(str, size);
-                            }
-                            break;
-                        }
-                    case 'p':
-                        {
-                            size_t param = va_arg(args, size_t);
-                            if ( sizeof(param) == 8 ) param = fleece::endian::encLittle64(param);
-                            else
-                                param = fleece::endian::encLittle32((uint32_t)param);
-                            _writer.write(&param, sizeof(param));
-                            break;
-                        }
-#if __APPLE__
-                    case '@':
-                        {
-                            // "%@" substitutes an Objective-C or CoreFoundation object's description.
-                            CFTypeRef param = va_arg(args, CFTypeRef);
-                            if ( param == nullptr ) {
-                                _writeUVarInt(6);
-                                _writer.write("(null)", 6);
-                            } else {
-                                CFStringRef description;
-                                if ( CFGetTypeID(param) == CFStringGetTypeID() ) description = (CFStringRef)param;
-                                else
-                                    description = CFCopyDescription(param);
-                                nsstring_slice descSlice(description);
-                                _writeUVarInt(descSlice.size);
-                                _writer.write(descSlice);
-                                if ( description != param ) CFRelease(description);
-                            }
-                            break;
-                        }
-#endif
-                    case '%':
+                case LogFormatSpec::kUnsigned:
+                    _writeUVarInt(args.nextUnsigned(spec));
+                    break;
+                case LogFormatSpec::kDouble:
+                    {
+                        fleece::endian::littleEndianDouble param = args.nextDouble();
+                        _writer.write(&param, sizeof(param));
                         break;
-                    default:
-                        throw invalid_argument("Unknown type in LogEncoder format string");
-                }
+                    }
+                case LogFormatSpec::kString:
+                    {
+                        slice str = args.nextString(spec);
+                        _writeUVarInt(str.size);
+                        if ( str.size > 0 ) _writer.write(str);
+                        break;
+                    }
+                case LogFormatSpec::kToken:
+                    _writeStringToken(args.nextToken());
+                    break;
+                case LogFormatSpec::kPointer:
+                    {
+                        size_t param = args.nextPointer();
+                        if ( sizeof(param) == 8 ) param = fleece::endian::encLittle64(param);
+                        else
+                            param = fleece::endian::encLittle32((uint32_t)param);
+                        _writer.write(&param, sizeof(param));
+                        break;
+                    }
+                case LogFormatSpec::kObject:
+                    {
+                        // "%@" substitutes an Objective-C or CoreFoundation object's description.
+                        string description = args.nextObjectDescription();
+                        _writeUVarInt(description.size());
+                        _writer.write(slice(description));
+                        break;
+                    }
+                case LogFormatSpec::kPercent:
+                    break;
+                case LogFormatSpec::kUnknown:
+                    throw invalid_argument("Unknown type in LogEncoder format string");
             }
         }
 
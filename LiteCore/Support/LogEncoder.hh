@@ -24,6 +24,7 @@
 #include <unordered_set>
 
 namespace litecore {
+    class LogArgs;
 
     /** A very fast & compact logging service.
         The output is written in a binary format to avoid the CPU and space overhead of converting
@@ -36,22 +37,26 @@ namespace litecore {
 
         enum ObjectRef : unsigned { None = 0 };
 
+        /** A timestamp, given as a standard time_t (seconds since 1/1/1970) plus microseconds. */
+        struct Timestamp {
+            time_t   secs;
+            unsigned microsecs;
+        };
+
         void vlog(const char* domain, const std::map<unsigned, std::string>&, ObjectRef, const char* format,
                   va_list args) __printflike(5, 0);
 
         void log(const char* domain, const std::map<unsigned, std::string>&, ObjectRef, const char* format, ...)
                 __printflike(5, 6);
 
+        /// Logs a message whose arguments were captured earlier, at time `when`.
+        void log(const char* domain, const std::map<unsigned, std::string>&, ObjectRef, const char* format,
+                 const LogArgs&, Timestamp when);
+
         void flush();
 
         uint64_t tellp();
 
-        /** A timestamp, given as a standard time_t (seconds since 1/1/1970) plus microseconds. */
-        struct Timestamp {
-            time_t   secs;
-            unsigned microsecs;
-        };
-
         /** A way to interact with the output stream safely (since the encoder may be writing to
             it on a background thread.) */
         template <class LAMBDA>
@@ -61,6 +66,9 @@ namespace litecore {
         }
 
       private:
+        template <class ARGS>
+        void _log(const char* domain, const std::map<unsigned, std::string>&, ObjectRef, const char* format,
+                  ARGS& args, const Timestamp* when);
         [[nodiscard]] int64_t _timeElapsed() const;
         void                  _writeUVarInt(uint64_t);
         void                  _writeStringToken(const char* token);
@@ -73,6 +81,7 @@ namespace litecore {
         std::ostream&                        _out;
         std::unique_ptr<actor::Timer>        _flushTimer;
         fleece::Stopwatch                    _st;
+        Timestamp                            _start{};
         int64_t                              _lastElapsed{0};
         int64_t                              _lastSaved{0};
         LogLevel                             _level;
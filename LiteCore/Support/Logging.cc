@@ -12,14 +12,20 @@
 
 #include "Logging.hh"
 #include "StringUtil.hh"
+#include "LogArgs.hh"
 #include "LogEncoder.hh"
 #include "LogDecoder.hh"
 #include "FilePath.hh"
 #include "Error.hh"
+#include "ThreadUtil.hh"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
 #include <string>
 #include <fstream>
 #include <iostream>
 #include <mutex>
+#include <thread>
 #include <ctime>
 
 #if __APPLE__
@@ -81,6 +87,7 @@ namespace litecore {
     static int64_t               sMaxSize  = 1024;  // For rotation
     static string                sInitialMessage;   // For rotation, goes at top of each log
     static mutex                 sLogMutex;
+    static atomic<bool>          sAsync{false};  // Is logging asynchronous?
 
     static const char* const kLevelNames[] = {"debug", "verbose", "info", "warning", "error", nullptr};
     static const char*       kLevels[]     = {"***", "", "", "WARNING", "ERROR"};
@@ -209,6 +216,9 @@ namespace litecore {
 
     void LogDomain::flushLogFiles() {
         unique_lock<mutex> lock(sLogMutex);
+        if ( sAsync ) {
+            while ( _drainQueues() ) {}
+        }
 
         for ( auto& encoder : sLogEncoder )
             if ( encoder ) encoder->flush();
@@ -273,6 +283,9 @@ namespace litecore {
             call_once(f, [] {
                 atexit([] {
                     if ( sLogMutex.try_lock() ) {  // avoid deadlock on crash inside logging code
+                        if ( sAsync ) {
+                            while ( _drainQueues() ) {}
+                        }
                         if ( sLogEncoder[0] ) {
                             for ( auto& encoder : sLogEncoder ) {
                                 encoder->log("", {}, LogEncoder::None, "---- END ----");
@@ -386,12 +399,30 @@ namespace litecore {
 #pragma mark - LOGGING:
 
 
+    // A message logged while logging is asynchronous, waiting to be written.
+    // (If `domain` is null, it's instead a request to unregister the object `objRef`.)
+    struct QueuedLogMessage {
+        LogDomain*            domain;
+        LogLevel              level;
+        unsigned              objRef;
+        bool                  doCallback;
+        const char*           format;       // Must be a string constant, since it's read later
+        LogArgs               args;
+        LogDecoder::Timestamp time{};       // When the message was logged
+        uint64_t              sequence{0};  // Orders the messages of different threads
+    };
+
     static char sFormatBuffer[2048];
 
     void LogDomain::vlog(LogLevel level, unsigned objRef, bool doCallback, const char* fmt, va_list args) {
         if ( _effectiveLevel == LogLevel::Uninitialized ) computeLevel();
         if ( !willLog(level) ) return;
 
+        if ( sAsync ) {
+            enqueue({this, level, objRef, doCallback, fmt, LogArgs(fmt, args), LogDecoder::now()});
+            return;
+        }
+
         unique_lock<mutex> lock(sLogMutex);
 
         // Invoke the client callback:
@@ -510,6 +541,224 @@ namespace litecore {
 #endif
     }
 
+#pragma mark - ASYNCHRONOUS LOGGING:
+
+    // The messages logged by one thread. This is a single-producer, single-consumer ring buffer:
+    // the thread pushes, and whoever holds sLogMutex pops.
+    class LogQueue {
+      public:
+        static constexpr size_t kCapacity = 512;
+
+        bool push(QueuedLogMessage&& msg) {
+            size_t tail = _tail.load(memory_order_relaxed);
+            if ( tail - _head.load(memory_order_acquire) == kCapacity ) return false;
+            _slots[tail % kCapacity] = std::move(msg);
+            _tail.store(tail + 1, memory_order_release);
+            return true;
+        }
+
+        QueuedLogMessage* front() {
+            size_t head = _head.load(memory_order_relaxed);
+            if ( head == _tail.load(memory_order_acquire) ) return nullptr;
+            return &_slots[head % kCapacity];
+        }
+
+        void pop() {
+            size_t head                   = _head.load(memory_order_relaxed);
+            _slots[head % kCapacity].args = {};  // free its memory now
+            _head.store(head + 1, memory_order_release);
+        }
+
+        atomic<unsigned> dropped{0};  // Number of messages dropped because the queue was full
+
+      private:
+        array<QueuedLogMessage, kCapacity> _slots{};
+        atomic<size_t>                     _head{0}, _tail{0};
+    };
+
+    static constexpr int kMaxDrainBatch = 256;  // Messages written per acquisition of sLogMutex
+
+    static mutex                             sQueuesMutex;  // Protects sQueues
+    static vector<shared_ptr<LogQueue>>      sQueues;       // Every thread's LogQueue
+    static thread_local shared_ptr<LogQueue> tLogQueue;     // The current thread's LogQueue
+    static atomic<uint64_t>                  sLogSequence{0};
+    static thread*                           sDrainThread = nullptr;
+    static atomic<thread::id>                sDrainThreadID;
+    static atomic<bool>                      sDrainStop{false}, sDrainSleeping{false};
+    static mutex                             sDrainMutex;
+    static condition_variable                sDrainCond;
+
+    static void wakeDrainThread() {
+        if ( sDrainSleeping.exchange(false) ) {
+            lock_guard<mutex> lock(sDrainMutex);
+            sDrainCond.notify_one();
+        }
+    }
+
+    __printflike(1, 2) static LogArgs captureArgs(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        LogArgs result(fmt, args);
+        va_end(args);
+        return result;
+    }
+
+    bool LogDomain::isAsynchronous() noexcept { return sAsync; }
+
+    void LogDomain::setAsynchronous(bool async) {
+        static mutex      sAsyncMutex;  // Serializes calls to this method
+        lock_guard<mutex> asyncLock(sAsyncMutex);
+        if ( async == sAsync ) return;
+        if ( async ) {
+            // The thread is allocated with `new` so that if it's still running at exit, there's no
+            // `std::thread` destructor to run (which would terminate the process.)
+            sDrainStop   = false;
+            sDrainThread = new thread([] {
+                SetThreadName("LiteCore Logging");
+                sDrainThreadID = this_thread::get_id();
+                while ( true ) {
+                    bool wrote;
+                    {
+                        unique_lock<mutex> lock(sLogMutex);
+                        wrote = _drainQueues();
+                    }
+                    if ( !wrote ) {
+                        if ( sDrainStop ) break;
+                        unique_lock<mutex> lock(sDrainMutex);
+                        sDrainSleeping = true;
+                        // (The timeout covers a wakeup that races with my going to sleep.)
+                        sDrainCond.wait_for(lock, 100ms, [] { return !sDrainSleeping || sDrainStop; });
+                        sDrainSleeping = false;
+                    }
+                }
+            });
+            sAsync = true;
+        } else {
+            sAsync     = false;
+            sDrainStop = true;
+            {
+                lock_guard<mutex> lock(sDrainMutex);
+                sDrainCond.notify_one();
+            }
+            sDrainThread->join();
+            delete sDrainThread;
+            sDrainThread   = nullptr;
+            sDrainThreadID = thread::id();
+            // Write any messages queued after the thread last looked:
+            unique_lock<mutex> lock(sLogMutex);
+            while ( _drainQueues() ) {}
+        }
+    }
+
+    void LogDomain::enqueue(QueuedLogMessage&& msg) {
+        if ( !tLogQueue ) {
+            tLogQueue = make_shared<LogQueue>();
+            lock_guard<mutex> lock(sQueuesMutex);
+            sQueues.push_back(tLogQueue);
+        }
+        msg.sequence = sLogSequence.fetch_add(1, memory_order_relaxed);
+        if ( !tLogQueue->push(std::move(msg)) ) {
+            // The queue is full. Other messages are dropped, but warnings, errors and unregistrations
+            // are written right away, after the older messages so they stay in order.
+            // (The drain thread already holds sLogMutex, so it drops everything.)
+            bool mustWrite = (!msg.domain || msg.level >= LogLevel::Warning) && this_thread::get_id() != sDrainThreadID;
+            if ( !mustWrite ) {
+                ++tLogQueue->dropped;
+                return;
+            }
+            unique_lock<mutex> lock(sLogMutex);
+            while ( tLogQueue->front() && _drainQueues() ) {}
+            try {
+                _writeQueued(msg);
+            } catch ( ... ) {}
+            return;
+        }
+        wakeDrainThread();
+    }
+
+    // Writes queued messages, oldest first; returns false if there were none.
+    // Must have sLogMutex held.
+    bool LogDomain::_drainQueues() {
+        vector<shared_ptr<LogQueue>> queues;
+        {
+            lock_guard<mutex> lock(sQueuesMutex);
+            // Forget the queues of threads that have exited, once they're empty:
+            sQueues.erase(remove_if(sQueues.begin(), sQueues.end(),
+                                    [](auto& q) { return q.use_count() == 1 && !q->front() && q->dropped == 0; }),
+                          sQueues.end());
+            queues = sQueues;
+        }
+
+        bool wrote = false;
+        for ( int n = 0; n < kMaxDrainBatch; ++n ) {
+            LogQueue*         oldestQueue = nullptr;
+            QueuedLogMessage* oldest      = nullptr;
+            for ( auto& queue : queues ) {
+                if ( auto msg = queue->front(); msg && (!oldest || msg->sequence < oldest->sequence) ) {
+                    oldest      = msg;
+                    oldestQueue = queue.get();
+                }
+            }
+            if ( !oldest ) break;
+            try {
+                _writeQueued(*oldest);
+            } catch ( ... ) {}  // A message that can't be written is skipped
+            oldestQueue->pop();
+            wrote = true;
+        }
+
+        for ( auto& queue : queues ) {
+            if ( unsigned dropped = queue->dropped.exchange(0) ) {
+                static const char* const kDroppedFormat = "%u log messages were dropped because logging fell behind";
+                _writeQueued({&kC4Cpp_DefaultLog, LogLevel::Warning, 0, true, kDroppedFormat,
+                              captureArgs(kDroppedFormat, dropped), LogDecoder::now()});
+                wrote = true;
+            }
+        }
+        return wrote;
+    }
+
+    // Must have sLogMutex held
+    void LogDomain::dylog(const QueuedLogMessage& msg) {
+        uint64_t   pos;
+        const auto level   = msg.level;
+        const auto encoder = sLogEncoder[(int)level];
+        const auto file    = sFileOut[(int)level];
+        if ( encoder ) {
+            encoder->log(_name, sObjNames, (LogEncoder::ObjectRef)msg.objRef, msg.format, msg.args,
+                         {msg.time.secs, msg.time.microsecs});
+            pos = encoder->tellp();
+        } else if ( file ) {
+            LogDecoder::writeTimestamp(msg.time, *file);
+            LogDecoder::writeHeader(kLevels[(int)level], _name, *file);
+            if ( msg.objRef ) *file << '{' << getObject(msg.objRef) << '#' << msg.objRef << "} ";
+            *file << msg.args.format(msg.format) << endl;
+            pos = file->tellp();
+        } else {
+            return;
+        }
+
+        if ( pos >= sMaxSize ) { Logging::rotateLog(level); }
+    }
+
+    // Must have sLogMutex held
+    void LogDomain::_writeQueued(const QueuedLogMessage& msg) {
+        if ( !msg.domain ) {
+            sObjNames.erase(msg.objRef);
+            return;
+        }
+        LogDomain& domain = *msg.domain;
+        if ( msg.doCallback && sCallback && msg.level >= _callbackLogLevel() ) {
+            string text = msg.args.format(msg.format);
+            if ( msg.objRef )
+                invokeCallback(domain, msg.level, "{%s#%u} %s", getObject(msg.objRef).c_str(), msg.objRef,
+                               text.c_str());
+            else
+                invokeCallback(domain, msg.level, "%s", text.c_str());
+        }
+        if ( msg.level >= sFileMinLevel ) domain.dylog(msg);
+    }
+
     // Must be called from a method holding sLogMutex
     string LogDomain::getObject(unsigned ref) {
         const auto found = sObjNames.find(ref);
@@ -531,6 +780,11 @@ namespace litecore {
     }
 
     void LogDomain::unregisterObject(unsigned objectRef) {
+        if ( sAsync ) {
+            // The object's name has to stay registered until its queued messages are written:
+            enqueue({nullptr, LogLevel::None, objectRef, false, nullptr, {}});
+            return;
+        }
         unique_lock<mutex> lock(sLogMutex);
         sObjNames.erase(objectRef);
     }
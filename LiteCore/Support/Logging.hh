@@ -46,6 +46,8 @@
 */
 
 namespace litecore {
+    class LogArgs;
+    struct QueuedLogMessage;
 
     enum class LogLevel : int8_t { Uninitialized = -1, Debug, Verbose, Info, Warning, Error, None };
 
@@ -114,6 +116,17 @@ namespace litecore {
 
         static void flushLogFiles();
 
+        /** Turns asynchronous logging on or off. While it's on, logging a message just copies its
+            arguments into a queue belonging to the calling thread, and a background thread formats
+            it, passes it to the callback and writes it to the log file. Threads then don't wait
+            for each other, or for I/O, to log.
+            If a thread's queue is full, its Debug, Verbose and Info messages are dropped (the
+            number dropped is logged later), while Warnings and Errors are written synchronously.
+            Either way, a message's timestamp is the time it was logged, not written. */
+        static void setAsynchronous(bool async);
+
+        static bool isAsynchronous() noexcept;
+
       private:
         friend class Logging;
         static std::string getObject(unsigned);
@@ -129,6 +142,11 @@ namespace litecore {
         static void     _invalidateEffectiveLevels() noexcept;
 
         void dylog(LogLevel level, const char* domain, unsigned objRef, const char* fmt, va_list) __printflike(5, 0);
+        void dylog(const QueuedLogMessage&);
+
+        static void enqueue(QueuedLogMessage&&);
+        static bool _drainQueues();
+        static void _writeQueued(const QueuedLogMessage&);
 
         std::atomic<LogLevel> _effectiveLevel{LogLevel::Uninitialized};
         std::atomic<LogLevel> _level;
@@ -16,6 +16,7 @@
 #    include <direct.h>
 #    include <sys/types.h>
 #    include <sys/stat.h>
+#    include <sys/utime.h>
 #    include <atlbase.h>
 #    include <atlconv.h>
 
@@ -60,6 +61,11 @@ namespace litecore {
 
                                     int MIGRATE_2(access_u8, ::_waccess, int);
 
+    int utime_u8(const char* const path, time_t modTime) {
+        struct _utimbuf times = {modTime, modTime};
+        MIGRATE_ARG(path, ::_wutime(wpath, &times));
+    }
+
     FILE* MIGRATE_2S(fopen_u8, ::_wfopen)
 
 }  // namespace litecore
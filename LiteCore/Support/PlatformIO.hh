@@ -15,6 +15,7 @@
 #ifdef _MSC_VER
 
 #    include <cstdio>
+#    include <ctime>
 #    include <io.h>
 #    include "asprintf.h"
 
@@ -39,6 +40,7 @@ namespace litecore {
     int   unlink_u8(const char* const filename);
     int   chmod_u8(const char* const filename, int mode);
     int   access_u8(const char* const path, int mode);
+    int   utime_u8(const char* const path, time_t modTime);
     FILE* fopen_u8(const char* const path, const char* const mode);
 }  // namespace litecore
 
@@ -47,6 +49,7 @@ namespace litecore {
 #    include <cstdio>
 #    include <sys/stat.h>
 #    include <unistd.h>
+#    include <utime.h>
 
 #    define fdclose ::close
 
@@ -67,6 +70,11 @@ namespace litecore {
 
     inline int access_u8(const char* const path NONNULL, int mode) { return ::access(path, mode); }
 
+    inline int utime_u8(const char* const path NONNULL, time_t modTime) {
+        struct utimbuf times = {modTime, modTime};
+        return ::utime(path, &times);
+    }
+
     inline FILE* fopen_u8(const char* const path NONNULL, const char* const mode NONNULL) {
         return ::fopen(path, mode);
     }
@@ -70,6 +70,26 @@ namespace litecore {
         FILE* _file{nullptr};
     };
 
+#ifndef _WIN32
+    /** Concrete ReadStream that memory-maps a file, so reads are memory copies instead of system
+        calls. Only suitable for files that won't be modified while open, like blobs. */
+    class MappedFileReadStream final : public virtual SeekableReadStream {
+      public:
+        explicit MappedFileReadStream(const FilePath& path);
+        ~MappedFileReadStream() override;
+
+        [[nodiscard]] uint64_t getLength() const override { return _contents.size; }
+
+        void   seek(uint64_t pos) override;
+        size_t read(void* dst NONNULL, size_t count) override;
+        void   close() override;
+
+      private:
+        slice  _contents;  // The mapped file
+        size_t _pos{0};    // Current read position
+    };
+#endif
+
 #ifdef _MSC_VER
 #    pragma warning(disable : 4250)
 #endif
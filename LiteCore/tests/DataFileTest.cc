@@ -17,6 +17,7 @@
 #include "FilePath.hh"
 #include "FleeceImpl.hh"
 #include "SecureRandomize.hh"
+#include "StringUtil.hh"
 #ifndef _MSC_VER
 #    include <sys/stat.h>
 #endif
@@ -968,3 +969,26 @@ N_WAY_TEST_CASE_METHOD(DataFileTestFixture, "Check name mangling", "[DataFile]")
     output = SQLiteKeyStore::transformCollectionName(output, false);
     CHECK(output == expectedFinal);
 }
+
+N_WAY_TEST_CASE_METHOD(DataFileTestFixture, "WAL page count", "[DataFile]") {
+    {
+        ExclusiveTransaction t(db);
+        for ( int i = 0; i < 100; i++ ) createDoc(stringprintf("doc-%03d", i), "some body"_sl, t);
+        t.commit();
+    }
+    int64_t pages = db->spaceStats().walPages;
+    CHECK(pages > 0);
+    CHECK(pages < 1000);  // (below the auto-checkpoint size)
+
+    // Checkpointing doesn't shrink the WAL file, but it does empty the log:
+    CHECK(db->passiveCheckpoint() == 0);
+    CHECK(db->spaceStats().walPages == 0);
+
+    {
+        ExclusiveTransaction t(db);
+        createDoc("another"_sl, "some body"_sl, t);
+        t.commit();
+    }
+    CHECK(db->spaceStats().walPages > 0);
+    CHECK(db->spaceStats().walPages < pages);
+}
@@ -11,6 +11,7 @@
 //
 
 #include "LiteCoreTest.hh"
+#include "DocumentKeys.hh"
 #include "FleeceImpl.hh"
 
 using namespace fleece;
@@ -108,3 +109,23 @@ TEST_CASE_METHOD(DocumentKeysTestFixture, "Create docs", "[SharedKeys]") {
         REQUIRE(root->get(bar) == nullptr);
     }
 }
+
+TEST_CASE_METHOD(DocumentKeysTestFixture, "DocumentKeys stats", "[SharedKeys]") {
+    auto keys = db->documentKeysImpl();
+    {
+        ExclusiveTransaction t(db);
+        createDoc("doc1", R"({"foo": 1, "bar": 2})", t);
+        t.commit();
+    }
+    auto stats = keys->stats();
+    CHECK(stats.count == 2);
+    CHECK(stats.reads >= 1);
+
+    // Keys added by an aborted transaction are forgotten:
+    {
+        ExclusiveTransaction t(db);
+        createDoc("doc2", R"({"zog": 3})", t);
+        t.abort();
+    }
+    CHECK(keys->stats().count == 2);
+}
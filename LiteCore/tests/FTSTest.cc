@@ -14,6 +14,8 @@
 #include "Query.hh"
 #include "StringUtil.hh"
 #include "FleeceImpl.hh"
+#include "SecureRandomize.hh"
+#include "Stopwatch.hh"
 
 #include "LiteCoreTest.hh"
 
@@ -193,6 +195,87 @@ TEST_CASE_METHOD(FTSTest, "Query Full-Text Partial Index", "[Query][FTS]") {
               {2, 4, 0}, {3, 2, 1});
 }
 
+TEST_CASE_METHOD(FTSTest, "Query Full-Text FTS5", "[Query][FTS]") {
+    IndexSpec::Options options{"english", true};
+    options.useFTS5 = true;
+    createIndex(options);
+    // BM25 scores don't order the same way as FTS4's rank(), so sort by docID for a stable order:
+    testQuery("['SELECT', {'WHERE': ['MATCH()', 'sentence', 'the search is'],\
+                    ORDER_BY: [['._id']],\
+                        WHAT: [['.sentence']]}]",
+              {0, 1, 2, 4}, {1, 3, 3, 1});
+    testQuery("SELECT sentence FROM _ WHERE MATCH(sentence, 'f* AND on*') ORDER BY _id", {1, 3}, {3, 3},
+              QueryLanguage::kN1QL);
+
+    // rank() works too (it's computed by BM25):
+    Retained<Query> query = db->compileQuery(
+            "SELECT _id FROM _ WHERE MATCH(sentence, 'search') ORDER BY rank(sentence) DESC"_sl, QueryLanguage::kN1QL);
+    Retained<QueryEnumerator> e(query->createEnumerator());
+    CHECK(e->getRowCount() == 4);
+
+    // Updates are indexed:
+    {
+        ExclusiveTransaction t(store->dataFile());
+        createDoc(t, 4, "Search, search");
+        createDoc(t, 1, "Nothing to see here");
+        t.commit();
+    }
+    testQuery("SELECT sentence FROM _ WHERE MATCH(sentence, 'search') ORDER BY _id", {0, 2, 4}, {1, 3, 2},
+              QueryLanguage::kN1QL);
+}
+
+TEST_CASE_METHOD(FTSTest, "Query Full-Text FTS5 Errors", "[Query][FTS]") {
+    IndexSpec::Options options{};
+    options.useFTS5 = true;
+    ExpectException(error::Domain::LiteCore, error::LiteCoreError::InvalidParameter, [&] {
+        store->createIndex("num", "[[\".sentence\"]]", IndexSpec::kValue, &options);
+    });
+}
+
+TEST_CASE_METHOD(FTSTest, "Full-Text FTS4 vs FTS5 Benchmark", "[Query][FTS][Perf][.slow]") {
+    static constexpr int         kNumDocs = 100000, kWordsPerDoc = 50, kNumQueries = 1000;
+    static constexpr const char* kWords[] = {"alpha", "bravo",  "charlie", "delta",    "echo",     "foxtrot", "golf",
+                                             "hotel", "india",  "juliet",  "kilo",     "lima",     "mike",    "november",
+                                             "oscar", "papa",   "quebec",  "romeo",    "sierra",   "tango",   "uniform",
+                                             "victor", "whiskey", "xray",  "yankee",   "zulu",     "search",  "searching"};
+    constexpr size_t             kNumWords = sizeof(kWords) / sizeof(kWords[0]);
+
+    bool fts5 = GENERATE(false, true);
+    {
+        ExclusiveTransaction t(store->dataFile());
+        for ( int i = 0; i < kNumDocs; i++ ) {
+            string sentence;
+            for ( int w = 0; w < kWordsPerDoc; w++ ) {
+                if ( w > 0 ) sentence += ' ';
+                sentence += kWords[RandomNumber() % kNumWords];
+            }
+            createDoc(t, i, sentence);
+        }
+        t.commit();
+    }
+
+    IndexSpec::Options options{"english", true};
+    options.useFTS5 = fts5;
+    auto      oldSize = db->fileSize();
+    Stopwatch st;
+    createIndex(options);
+    double buildTime = st.elapsed();
+    auto   newSize   = db->fileSize();
+
+    Retained<Query> query = db->compileQuery("SELECT _id FROM _ WHERE MATCH(sentence, 'alpha AND zulu') "
+                                             "ORDER BY rank(sentence) DESC LIMIT 10"_sl,
+                                             QueryLanguage::kN1QL);
+    st.reset();
+    for ( int i = 0; i < kNumQueries; i++ ) {
+        Retained<QueryEnumerator> e(query->createEnumerator());
+        while ( e->next() ) {}
+    }
+    double queryTime = st.elapsed();
+
+    fprintf(stderr, "%s: built index of %d docs in %.3f sec, %.1f MB; ranked MATCH query takes %.3f ms\n",
+            (fts5 ? "FTS5" : "FTS4"), kNumDocs, buildTime, (newSize - oldSize) / 1.0e6, queryTime * 1000 / kNumQueries);
+}
+
 TEST_CASE_METHOD(FTSTest, "Test with array values", "[FTS][Query]") {
     // Tests fix for <https://issues.couchbase.com/browse/CBL-218>
 
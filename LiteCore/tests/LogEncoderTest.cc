@@ -13,13 +13,16 @@
 
 #include "LogEncoder.hh"
 #include "LogDecoder.hh"
+#include "LogArgs.hh"
 #include "LiteCoreTest.hh"
 #include "StringUtil.hh"
 #include "ParseDate.hh"
+#include "Stopwatch.hh"
 #include "fleece/PlatformCompat.hh"
 #include <regex>
 #include <sstream>
 #include <fstream>
+#include <thread>
 
 using namespace std;
 
@@ -470,3 +473,117 @@ TEST_CASE("Logging plaintext", "[Log]") {
 
     LogDomain::writeEncodedLogsTo(prevOptions);  // undo writeEncodedLogsTo() call above
 }
+
+static string formatLogArgs(const char* format, ...) __printflike(1, 2);
+
+static string formatLogArgs(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    LogArgs logArgs(format, args);
+    va_end(args);
+    return logArgs.format(format);
+}
+
+TEST_CASE("LogArgs formatting", "[Log]") {
+    // LogArgs copies the arguments, so the message must be formatted the same as by printf:
+    const char* str = "string";
+    char        expected[256];
+    snprintf(expected, sizeof(expected), "%d %-4i| %u %x %05X %lld %zu %c %.3f %g %s %.*s %8s| %-s 100%%", -5, 7,
+             42u, 255u, 0xABCu, 1234567890123ll, size_t(9), 'M', 3.14159, 2.5, str, 3, "abcdef", "r", "token");
+    CHECK(formatLogArgs("%d %-4i| %u %x %05X %lld %zu %c %.3f %g %s %.*s %8s| %-s 100%%", -5, 7, 42u, 255u, 0xABCu,
+                        1234567890123ll, size_t(9), 'M', 3.14159, 2.5, str, 3, "abcdef", "r", "token")
+          == expected);
+    CHECK(formatLogArgs("no substitutions") == "no substitutions");
+    CHECK(formatLogArgs("null is %s", (const char*)nullptr) == "null is (null)");
+}
+
+TEST_CASE("Logging asynchronously", "[Log]") {
+    char folderName[kFolderBufSize];
+    snprintf(folderName, kFolderBufSize, "Log_Async_%" PRIms "/", chrono::milliseconds(time(nullptr)).count());
+    FilePath tmpLogDir = TestFixture::sTempDir[folderName];
+    tmpLogDir.delRecursive();
+    tmpLogDir.mkdir();
+
+    const LogFileOptions prevOptions = LogDomain::currentLogFileOptions();
+    LogFileOptions       fileOptions{tmpLogDir.canonicalPath(), LogLevel::Info, 1024 * 1024, 5, true};
+    LogDomain::writeEncodedLogsTo(fileOptions, "Hello");
+    LogDomain::setAsynchronous(true);
+    CHECK(LogDomain::isAsynchronous());
+
+    // Each thread logs through an object that's destroyed before the queues are flushed,
+    // so its name has to outlive it until its messages are written:
+    constexpr int  kThreads = 4, kMessages = 200;  // (few enough that none are dropped)
+    vector<thread> threads;
+    for ( int t = 0; t < kThreads; ++t ) {
+        threads.emplace_back([t] {
+            LogObject obj("async-" + to_string(t));
+            for ( int i = 0; i < kMessages; ++i ) obj.doLog("thread %d message %d", t, i);
+        });
+    }
+    for ( auto& thr : threads ) thr.join();
+    LogDomain::flushLogFiles();
+    LogDomain::setAsynchronous(false);
+    CHECK(!LogDomain::isAsynchronous());
+
+    vector<string> infoFiles;
+    tmpLogDir.forEachFile([&infoFiles](const FilePath& f) {
+        if ( f.path().find("info") != string::npos ) { infoFiles.push_back(f.path()); }
+    });
+    REQUIRE(infoFiles.size() == 1);
+
+    // Every message must be there, with each thread's in the order they were logged:
+    ifstream    fin(infoFiles[0]);
+    string      line;
+    vector<int> nextMessage(kThreads, 0);
+    while ( getline(fin, line) ) {
+        int  t, i;
+        auto pos = line.find("thread ");
+        if ( pos == string::npos || sscanf(line.c_str() + pos, "thread %d message %d", &t, &i) != 2 ) continue;
+        REQUIRE((t >= 0 && t < kThreads));
+        CHECK(line.find("{async-" + to_string(t) + "#") != string::npos);
+        CHECK(i == nextMessage[t]);
+        nextMessage[t] = i + 1;
+    }
+    for ( int t = 0; t < kThreads; ++t ) CHECK(nextMessage[t] == kMessages);
+
+    LogDomain::writeEncodedLogsTo(prevOptions);  // undo writeEncodedLogsTo() call above
+}
+
+TEST_CASE("Logging throughput", "[Log][Perf][.slow]") {
+    char folderName[kFolderBufSize];
+    snprintf(folderName, kFolderBufSize, "Log_Perf_%" PRIms "/", chrono::milliseconds(time(nullptr)).count());
+    FilePath tmpLogDir = TestFixture::sTempDir[folderName];
+    tmpLogDir.delRecursive();
+    tmpLogDir.mkdir();
+
+    const LogFileOptions prevOptions = LogDomain::currentLogFileOptions();
+    LogFileOptions       fileOptions{tmpLogDir.canonicalPath(), LogLevel::Info, 100 * 1024 * 1024, 2, false};
+    LogDomain::writeEncodedLogsTo(fileOptions, "Hello");
+    auto prevCallbackLevel = LogDomain::callbackLogLevel();
+    LogDomain::setCallbackLogLevel(LogLevel::None);
+
+    constexpr int kMessages = 100000;
+    for ( bool async : {false, true} ) {
+        LogDomain::setAsynchronous(async);
+        for ( int nThreads : {1, 2, 4, 8} ) {
+            Stopwatch      st;
+            vector<thread> threads;
+            for ( int t = 0; t < nThreads; ++t ) {
+                threads.emplace_back([t] {
+                    LogObject obj("perf");
+                    for ( int i = 0; i < kMessages; ++i ) obj.doLog("thread %d message %d of %s", t, i, "many");
+                });
+            }
+            for ( auto& thr : threads ) thr.join();
+            double callTime = st.elapsed();
+            LogDomain::flushLogFiles();
+            double totalTime = st.elapsed();
+            fprintf(stderr, "%-5s %d thread(s): %10.0f calls/sec; all written in %.3f sec\n",
+                    (async ? "async" : "sync"), nThreads, nThreads * kMessages / callTime, totalTime);
+        }
+    }
+
+    LogDomain::setAsynchronous(false);
+    LogDomain::setCallbackLogLevel(prevCallbackLevel);
+    LogDomain::writeEncodedLogsTo(prevOptions);  // undo writeEncodedLogsTo() call above
+}
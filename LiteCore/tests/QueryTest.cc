@@ -13,6 +13,7 @@
 #include "QueryTest.hh"
 #include "SQLiteDataFile.hh"
 #include "Benchmark.hh"
+#include "SecureRandomize.hh"
 #include <cstdint>
 #include <ctime>
 #include <cfloat>
@@ -82,6 +83,59 @@ N_WAY_TEST_CASE_METHOD(QueryTest, "Create/Delete Array Index", "[Query][ArrayInd
     store->deleteIndex("nums"_sl);
 }
 
+N_WAY_TEST_CASE_METHOD(QueryTest, "Create Index With Progress", "[Query]") {
+    addNumberedDocs(1, 100);
+    addArrayDocs(101, 100);
+
+    auto [type, expression] = GENERATE(pair<IndexSpec::Type, const char*>{IndexSpec::kValue, R"([[".num"]])"},
+                                       pair<IndexSpec::Type, const char*>{IndexSpec::kArray, R"([[".numbers"]])"},
+                                       pair<IndexSpec::Type, const char*>{IndexSpec::kFullText, R"([[".type"]])"});
+    vector<float> reports;
+    IndexSpec     spec("idx", type, alloc_slice(slice(expression)));
+    spec.progress        = [&](float fraction) { reports.push_back(fraction); };
+    spec.maxBuildThreads = 1;
+    CHECK(store->createIndex(spec));
+
+    REQUIRE(reports.size() >= 2);
+    CHECK(reports.front() == 0.0f);
+    CHECK(reports.back() == 1.0f);
+    CHECK(std::is_sorted(reports.begin(), reports.end()));
+
+    // Creating it again does nothing, but still reports completion:
+    reports.clear();
+    CHECK(!store->createIndex(spec));
+    REQUIRE(!reports.empty());
+    CHECK(reports.back() == 1.0f);
+
+    int64_t rowCount = rowsInQuery(json5("{WHAT: [['.num']], WHERE: ['>=', ['.num'], 50]}"));
+    CHECK(rowCount == 51);
+}
+
+N_WAY_TEST_CASE_METHOD(QueryTest, "Index Build Threads Benchmark", "[Query][Perf][.slow]") {
+    static constexpr int kNumDocs = 500000;
+    {
+        ExclusiveTransaction t(store->dataFile());
+        for ( int i = 0; i < kNumDocs; i++ ) {
+            writeDoc(slice(stringWithFormat("rec-%07d", i)), DocumentFlags::kNone, t, [=](Encoder& enc) {
+                enc.writeKey("num");
+                enc.writeInt(RandomNumber());
+                enc.writeKey("name");
+                enc.writeString(stringWithFormat("name-%08x", RandomNumber()));
+            });
+        }
+        t.commit();
+    }
+    for ( unsigned threads : {1u, 2u, 4u, 8u} ) {
+        IndexSpec spec("byName", IndexSpec::kValue, alloc_slice(R"([[".name"], [".num"]])"_sl));
+        spec.maxBuildThreads = threads;
+        Stopwatch st;
+        REQUIRE(store->createIndex(spec));
+        st.stop();
+        Log("Built index of %d docs with %u sorter thread(s) in %.3f sec", kNumDocs, threads, st.elapsed());
+        store->deleteIndex("byName"_sl);
+    }
+}
+
 TEST_CASE_METHOD(QueryTest, "Create Partial Index", "[Query]") {
     addNumberedDocs(1, 100);
     addArrayDocs(101, 100);
@@ -121,6 +175,47 @@ N_WAY_TEST_CASE_METHOD(QueryTest, "Partial Index with NOT MISSING", "[Query]") {
     checkOptimized(query);
 }
 
+N_WAY_TEST_CASE_METHOD(QueryTest, "Create Partial Index With Where Option", "[Query]") {
+    addNumberedDocs(1, 100);
+    addArrayDocs(101, 100);
+
+    SECTION("JSON") {
+        IndexSpec::Options options{};
+        options.where = R"(["=",[".type"],"number"])";
+        CHECK(store->createIndex("nums"_sl, R"([[".num"]])"_sl, IndexSpec::kValue, &options));
+        CHECK(!store->createIndex("nums"_sl, R"([[".num"]])"_sl, IndexSpec::kValue, &options));
+    }
+    SECTION("N1QL") {
+        IndexSpec::Options options{};
+        options.where = "type = 'number'";
+        CHECK(store->createIndex("nums"_sl, "num"_sl, QueryLanguage::kN1QL, IndexSpec::kValue, &options));
+    }
+
+    Retained<Query> query = store->compileQuery(json5("['AND', ['=', ['.type'], 'number'], "
+                                                      "['>=', ['.', 'num'], 30], ['<=', ['.', 'num'], 40]]"));
+    checkOptimized(query);
+    CHECK(query->createEnumerator()->getRowCount() == 11);
+
+    query = store->compileQuery(json5("['AND', ['>=', ['.', 'num'], 30], ['<=', ['.', 'num'], 40]]"));
+    checkOptimized(query, false);
+
+    int64_t rowCount;
+    ((SQLiteDataFile&)store->dataFile()).inspectIndex("nums"_sl, rowCount);
+    CHECK(rowCount == 100);
+}
+
+N_WAY_TEST_CASE_METHOD(QueryTest, "Partial Index Where Option Errors", "[Query]") {
+    IndexSpec::Options options{};
+    options.where = R"(["=",[".type"],"number"])";
+    ExpectException(error::Domain::LiteCore, error::LiteCoreError::InvalidParameter, [&] {
+        store->createIndex("fts"_sl, R"([[".text"]])"_sl, IndexSpec::kFullText, &options);
+    });
+    ExpectException(error::Domain::LiteCore, error::LiteCoreError::InvalidQuery, [&] {
+        store->createIndex("nums"_sl, R"({"WHAT":[[".num"]], "WHERE":["=",[".type"],"number"]})"_sl,
+                           IndexSpec::kValue, &options);
+    });
+}
+
 N_WAY_TEST_CASE_METHOD(QueryTest, "Query SELECT", "[Query]") {
     addNumberedDocs();
     // Use a (SQL) query based on the Fleece "num" property:
@@ -1570,6 +1665,76 @@ N_WAY_TEST_CASE_METHOD(ArrayQueryTest, "Query UNNEST", "[Query]") {
                    true);
 }
 
+N_WAY_TEST_CASE_METHOD(ArrayQueryTest, "Query UNNEST With Lazy Index", "[Query][ArrayIndex]") {
+    addArrayDocs(1, 90);
+
+    IndexSpec::Options options{};
+    options.lazy = true;
+    CHECK(store->createIndex("numbersIndex"_sl, R"([[".numbers"]])", IndexSpec::kArray, &options));
+    CHECK(store->lazyIndexesNeedUpdate());
+
+    query = store->compileQuery(json5("['SELECT', {\
+                                          FROM: [{as: 'doc'}, \
+                                                 {as: 'num', 'unnest': ['.doc.numbers']}],\
+                                          WHERE: ['=', ['.num'], 'eight-eight']}]"));
+    checkOptimized(query);
+
+    Log("-------- Querying stale index --------");
+    query->setAllowStaleIndexes(true);
+    checkQuery(88, 0);
+
+    Log("-------- Querying up-to-date index --------");
+    query->setAllowStaleIndexes(false);
+    checkQuery(88, 3);
+    CHECK(!store->lazyIndexesNeedUpdate());
+
+    Log("-------- Adding docs --------");
+    addArrayDocs(91, 10);
+    CHECK(store->lazyIndexesNeedUpdate());
+    query->setAllowStaleIndexes(true);
+    checkQuery(88, 3);
+
+    Log("-------- Updating index in batches --------");
+    {
+        ExclusiveTransaction t(store->dataFile());
+        CHECK(store->updateLazyIndexes(4));
+        CHECK(store->updateLazyIndexes(4));
+        CHECK(!store->updateLazyIndexes(4));
+        t.commit();
+    }
+    checkQuery(88, 6);
+
+    Log("-------- Purging a doc --------");
+    deleteDoc("rec-093"_sl, true);
+    query->setAllowStaleIndexes(false);
+    checkQuery(88, 5);
+
+    Log("-------- Index info --------");
+    auto indexes = store->getIndexes();
+    REQUIRE(indexes.size() == 1);
+    CHECK(indexes[0].isLazy());
+
+    Log("-------- Mixing lazy and non-lazy indexes on one table --------");
+    ExpectException(error::Domain::LiteCore, error::LiteCoreError::InvalidParameter, [&] {
+        store->createIndex("numbersIndex2"_sl, R"([[".numbers"], [".key"]])", IndexSpec::kArray);
+    });
+    CHECK(store->createIndex("numbersIndex2"_sl, R"([[".numbers"], [".key"]])", IndexSpec::kArray, &options));
+
+    Log("-------- Deleting index --------");
+    store->deleteIndex("numbersIndex"_sl);
+    store->deleteIndex("numbersIndex2"_sl);
+    CHECK(!store->lazyIndexesNeedUpdate());
+}
+
+N_WAY_TEST_CASE_METHOD(QueryTest, "Lazy Index Errors", "[Query]") {
+    IndexSpec::Options options{};
+    options.lazy = true;
+    ExpectException(error::Domain::LiteCore, error::LiteCoreError::InvalidParameter,
+                    [&] { store->createIndex("nums"_sl, R"([[".num"]])"_sl, IndexSpec::kValue, &options); });
+    ExpectException(error::Domain::LiteCore, error::LiteCoreError::InvalidParameter,
+                    [&] { store->createIndex("fts"_sl, R"([[".text"]])"_sl, IndexSpec::kFullText, &options); });
+}
+
 N_WAY_TEST_CASE_METHOD(ArrayQueryTest, "Query ANY expression", "[Query]") {
     addArrayDocs(1, 90);
 
@@ -17,6 +17,8 @@
 #include "Benchmark.hh"
 #include "fleece/Fleece.hh"
 #include "SecureDigest.hh"
+#include "RawRevTree.hh"
+#include "RevTree.hh"
 #include "slice_stream.hh"
 
 using namespace fleece;
@@ -141,6 +143,100 @@ N_WAY_TEST_CASE_METHOD(C4Test, "Document FindDocAncestors", "[Document][C]") {
     }
 }
 
+// Builds a rev-tree with a main branch `depth` revs deep, and a closed-off conflicting branch
+// from every 10th rev, then marks one rev as current on remote #1.
+static void buildRevTree(litecore::RevTree& tree, unsigned depth) {
+    using namespace litecore;
+    alloc_slice body("{\"foo\":17}"_sl);
+    char        digest[21];
+    auto        makeRevID = [&](unsigned gen, unsigned branch) {
+        snprintf(digest, sizeof(digest), "%010u%010u", branch, gen);
+        return revidBuffer(gen, slice(digest, 20));
+    };
+    int         status;
+    revidBuffer parent;
+    for ( unsigned gen = 1; gen <= depth; ++gen ) {
+        revidBuffer rev = makeRevID(gen, 0);
+        REQUIRE(tree.insert(rev.getRevID(), body, Rev::kNoFlags, parent.getRevID(), false, false, status));
+        if ( gen % 10 == 5 && gen < depth ) {
+            revidBuffer branch = makeRevID(gen + 1, gen);
+            REQUIRE(tree.insert(branch.getRevID(), body, Rev::kDeleted, rev.getRevID(), true, true, status));
+        }
+        parent = rev;
+    }
+    tree.setLatestRevisionOnRemote(1, tree[depth / 2]);
+}
+
+TEST_CASE("RevTreeView", "[RevTree]") {
+    using namespace litecore;
+    RevTree tree;
+    buildRevTree(tree, 30);
+    auto [body, extra] = tree.encode();
+
+    RevTree     decoded(body, extra, 1_seq);
+    RevTreeView view(body, extra);
+    REQUIRE(view.size() == decoded.size());
+    CHECK(view.currentRevision().revID == decoded.currentRevision()->revID);
+    for ( unsigned i = 0; i < view.size(); ++i ) {
+        const Rev* rev  = decoded[i];
+        auto       info = view.get(i);
+        CHECK(info.index == i);
+        CHECK(info.revID == rev->revID);
+        CHECK(info.flags == rev->flags);
+        CHECK(info.bodyAvailable == rev->isBodyAvailable());
+        CHECK(info.parentIndex == (rev->parent ? rev->parent->index() : RevTreeView::kNoRev));
+        auto found = view.get(rev->revID);
+        REQUIRE(found);
+        CHECK(found->index == i);
+        for ( unsigned j = 0; j < view.size(); ++j ) CHECK(view.isAncestorOf(i, j) == rev->isAncestorOf(decoded[j]));
+    }
+    CHECK(!view.get(revidBuffer("99-ffff"_sl).getRevID()));
+    CHECK(view.latestRevisionOnRemote(1) == decoded.latestRevisionOnRemote(1)->index());
+    CHECK(view.latestRevisionOnRemote(2) == RevTreeView::kNoRev);
+
+    unsigned n = 0;
+    view.forEachRevision([&](const RevTreeView::RevInfo& info) {
+        CHECK(info.revID == decoded[n++]->revID);
+        return n < 5;
+    });
+    CHECK(n == 5);
+
+    // Truncated data is detected:
+    ExpectingExceptions x;
+    CHECK_THROWS(RevTreeView(body, slice(extra.buf, extra.size / 2)));
+}
+
+TEST_CASE("RevTreeView Benchmark", "[RevTree][Perf][.slow]") {
+    using namespace litecore;
+    for ( unsigned depth : {10u, 100u, 1000u, 10000u} ) {
+        RevTree tree;
+        buildRevTree(tree, depth);
+        auto [body, extra] = tree.encode();
+        revidBuffer target(tree[tree.size() - 1]->revID);  // the root, so lookups scan the whole tree
+        const unsigned kIterations = 1000000 / depth;
+
+        // What findDocAncestors does: look up a rev, and check whether it's an ancestor of current
+        Stopwatch st;
+        for ( unsigned i = 0; i < kIterations; ++i ) {
+            RevTree    decoded(body, extra, 1_seq);
+            const Rev* rev = decoded[target.getRevID()];
+            REQUIRE(rev->isAncestorOf(decoded.currentRevision()));
+        }
+        double decodeTime = st.elapsed();
+
+        Stopwatch st2;
+        for ( unsigned i = 0; i < kIterations; ++i ) {
+            RevTreeView view(body, extra);
+            auto        rev = view.get(target.getRevID());
+            REQUIRE(view.isAncestorOf(rev->index, 0));
+        }
+        double viewTime = st2.elapsed();
+
+        fprintf(stderr, "Depth %5u (%5zu revs): RevTree %8.2f us, RevTreeView %8.2f us  (%.1fx)\n", depth,
+                tree.size(), decodeTime * 1e6 / kIterations, viewTime * 1e6 / kIterations, decodeTime / viewTime);
+    }
+}
+
 // Repro case for https://github.com/couchbase/couchbase-lite-core/issues/478
 N_WAY_TEST_CASE_METHOD(C4Test, "Document Clobber Remote Rev", "[Document][C]") {
     if ( !isRevTrees() ) return;
@@ -29,9 +29,17 @@
 #include "c4ExceptionUtils.hh"  // for ExpectingExceptions
 #include "slice_stream.hh"
 #include <chrono>
+#include <cstdio>
 #include <regex>
 #include <string>
 
+#if defined(__linux__)
+#    include <sys/sendfile.h>
+#elif defined(__APPLE__)
+#    include <sys/socket.h>
+#    include <sys/uio.h>
+#endif
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdocumentation"
 #include "mbedtls/error.h"
@@ -241,6 +249,52 @@ namespace litecore::net {
         return written;
     }
 
+    ssize_t TCPSocket::sendFile(FILE* file, uint64_t length) {
+        uint64_t sent = 0;
+#if defined(__linux__) || defined(__APPLE__)
+        // TLS has to encrypt the data in user space, but a plain socket can use sendfile:
+        if ( _socket && !dynamic_cast<tls_socket*>(_socket.get()) ) {
+            int   fileFD = fileno(file), socketFD = fileDescriptor();
+            off_t offset = ftello(file);
+            while ( sent < length ) {
+#    ifdef __linux__
+                ssize_t n = ::sendfile(socketFD, fileFD, &offset, size_t(min(length - sent, uint64_t(1) << 30)));
+                int     rc = (n < 0) ? -1 : 0;
+                if ( n < 0 ) n = 0;
+#    else
+                auto n  = off_t(length - sent);  // on return, the number of bytes sent
+                int  rc = ::sendfile(fileFD, socketFD, offset, &n, nullptr, 0);
+                offset += n;
+#    endif
+                sent += n;
+                if ( rc < 0 ) {
+                    if ( errno == EINTR ) continue;
+                    setError(POSIXDomain, errno);
+                    return -1;
+                } else if ( n == 0 ) {
+                    break;  // file is shorter than expected
+                }
+            }
+            fseeko(file, offset, SEEK_SET);
+            return narrow_cast<ssize_t>(sent);
+        }
+#endif
+        uint8_t buffer[32 * 1024];
+        while ( sent < length ) {
+            size_t n = fread(buffer, 1, size_t(min(length - sent, uint64_t(sizeof(buffer)))), file);
+            if ( n == 0 ) {
+                if ( ferror(file) ) {
+                    setError(POSIXDomain, errno);
+                    return -1;
+                }
+                break;
+            }
+            if ( write_n(slice(buffer, n)) < 0 ) return -1;
+            sent += n;
+        }
+        return narrow_cast<ssize_t>(sent);
+    }
+
     ssize_t TCPSocket::write(vector<slice>& ioByteRanges) {
         // We are going to cast slice[] to iovec[] since they are identical structs,
         // but make sure they are actualy identical:
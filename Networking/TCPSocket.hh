@@ -112,6 +112,10 @@ namespace litecore::net {
 
         [[nodiscard]] bool atReadEOF() const { return _eofOnRead; }
 
+        /// True if data has already been read from the socket but not yet returned by a read
+        /// method. (The socket won't become readable again on account of that data.)
+        [[nodiscard]] bool hasUnreadData() const { return _unreadLen > 0; }
+
         //-------- WRITING:
 
         /// Writes to the socket and returns the number of bytes written:
@@ -126,6 +130,11 @@ namespace litecore::net {
         /// unsent bytes. (This will always be the 1st in the vector on return.)
         ssize_t write(std::vector<fleece::slice>& ioByteRanges) MUST_USE_RESULT;
 
+        /// Writes `length` bytes from a file, starting at its current position, and returns the
+        /// number of bytes written. Without TLS this uses `sendfile`, so the data goes from the
+        /// file to the socket without being copied through user space. Blocking mode only.
+        ssize_t sendFile(FILE* file NONNULL, uint64_t length) MUST_USE_RESULT;
+
         [[nodiscard]] bool atWriteEOF() const { return _eofOnWrite; }
 
         //-------- [NON]BLOCKING AND WAITING:
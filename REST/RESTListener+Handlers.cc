@@ -15,6 +15,7 @@
 #include "c4Collection.hh"
 #include "c4Document.hh"
 #include "c4Database.hh"
+#include "c4BlobStore.hh"
 #include "c4DocEnumerator.hh"
 #include "fleece/Expert.hh"
 #include <functional>
@@ -252,9 +253,9 @@ namespace litecore::REST {
         }
     }
 
-    // Core code for create/update/delete operation on a single doc.
-    bool RESTListener::modifyDoc(Dict body, string docID, const string& revIDQuery, bool deleting, bool newEdits,
-                                 C4Collection* coll, fleece::JSONEncoder& json, C4Error* outError) noexcept {
+    // Parses and validates a create/update/delete operation on a single doc.
+    bool RESTListener::parseDocChange(Dict body, string docID, const string& revIDQuery, bool deleting, bool newEdits,
+                                      C4Collection* coll, DocChange& change, C4Error* outError) noexcept {
         try {
             if ( !deleting && !body ) {
                 c4error_return(WebSocketDomain, (int)HTTPStatus::BadRequest, C4STR("body must be a JSON object"),
@@ -291,39 +292,59 @@ namespace litecore::REST {
 
             if ( body["_deleted"_sl].asBool() ) deleting = true;
 
+            // Encode body as Fleece (and strip _id and _rev):
+            if ( body )
+                change.body =
+                        C4Document::encodeStrippingOldMetaProperties(body, coll->getDatabase()->getFleeceSharedKeys());
+            if ( !docID.empty() ) change.docID = alloc_slice(docID);
+            change.revID    = alloc_slice(revID);
+            change.deleting = deleting;
+            change.newEdits = newEdits;
+            return true;
+        } catch ( ... ) {
+            *outError = C4Error::fromCurrentException();
+            return false;
+        }
+    }
+
+    C4DocPutRequest RESTListener::DocChange::putRequest() {
+        history[0]           = revID;
+        C4DocPutRequest put  = {};
+        put.allocedBody      = {(void*)body.buf, body.size};
+        put.docID            = docID;
+        put.revFlags         = (deleting ? kRevDeleted : 0);
+        put.existingRevision = !newEdits;
+        put.allowConflict    = false;
+        put.history          = history;
+        put.historyCount     = revID ? 1 : 0;
+        put.save             = true;
+        return put;
+    }
+
+    void RESTListener::writeSavedDoc(C4Document* doc, JSONEncoder& json) {
+        json.writeKey("ok"_sl);
+        json.writeBool(true);
+        json.writeKey("id"_sl);
+        json.writeString(doc->docID());
+        json.writeKey("rev"_sl);
+        json.writeString(doc->selectedRev().revID);
+    }
+
+    // Core code for create/update/delete operation on a single doc.
+    bool RESTListener::modifyDoc(Dict body, string docID, const string& revIDQuery, bool deleting, bool newEdits,
+                                 C4Collection* coll, fleece::JSONEncoder& json, C4Error* outError) noexcept {
+        DocChange change;
+        if ( !parseDocChange(body, std::move(docID), revIDQuery, deleting, newEdits, coll, change, outError) )
+            return false;
+        try {
             Retained<C4Document> doc;
             {
                 C4Database::Transaction t(coll->getDatabase());
-
-                // Encode body as Fleece (and strip _id and _rev):
-                alloc_slice encodedBody;
-                if ( body )
-                    encodedBody =
-                            doc->encodeStrippingOldMetaProperties(body, coll->getDatabase()->getFleeceSharedKeys());
-
-                // Save the revision:
-                C4Slice         history[1] = {revID};
-                C4DocPutRequest put        = {};
-                put.allocedBody            = {(void*)encodedBody.buf, encodedBody.size};
-                if ( !docID.empty() ) put.docID = slice(docID);
-                put.revFlags         = (deleting ? kRevDeleted : 0);
-                put.existingRevision = !newEdits;
-                put.allowConflict    = false;
-                put.history          = history;
-                put.historyCount     = revID ? 1 : 0;
-                put.save             = true;
-
-                doc = coll->putDocument(put, nullptr, outError);
+                doc = coll->putDocument(change.putRequest(), nullptr, outError);
                 if ( !doc ) return false;
                 t.commit();
             }
-
-            json.writeKey("ok"_sl);
-            json.writeBool(true);
-            json.writeKey("id"_sl);
-            json.writeString(doc->docID());
-            json.writeKey("rev"_sl);
-            json.writeString(doc->selectedRev().revID);
+            writeSavedDoc(doc, json);
             return true;
         } catch ( ... ) {
             *outError = C4Error::fromCurrentException();
@@ -366,20 +387,59 @@ namespace litecore::REST {
         Value v        = body["new_edits"];
         bool  newEdits = v ? v.asBool() : true;
 
-        C4Database::Transaction t(coll->getDatabase());
+        // Parse all the docs, then save the valid ones in one batch:
+        size_t            count = docs.count();
+        vector<DocChange> changes(count);
+        vector<C4Error>   errors(count);
+        vector<size_t>    valid;
+        for ( size_t i = 0; i < count; ++i ) {
+            if ( parseDocChange(docs[uint32_t(i)].asDict(), "", "", false, newEdits, coll, changes[i], &errors[i]) )
+                valid.push_back(i);
+        }
+
+        vector<C4DocPutRequest> requests;
+        requests.reserve(valid.size());
+        for ( size_t i : valid ) requests.push_back(changes[i].putRequest());
+        vector<C4Error> putErrors(valid.size());
+
+        vector<Retained<C4Document>> saved(count);
+        try {
+            C4Database::Transaction t(coll->getDatabase());
+            auto putDocs = coll->putDocuments(requests.data(), requests.size(), putErrors.data());
+            t.commit();
+            for ( size_t j = 0; j < valid.size(); ++j ) {
+                saved[valid[j]]  = putDocs[j];
+                errors[valid[j]] = putErrors[j];
+            }
+        } catch ( ... ) { return rq.respondWithError(C4Error::fromCurrentException()); }
 
         auto& json = rq.jsonEncoder();
         json.beginArray();
-        for ( Array::iterator i(docs); i; ++i ) {
+        for ( size_t i = 0; i < count; ++i ) {
             json.beginDict();
-            Dict    doc = i.value().asDict();
-            C4Error error;
-            if ( !modifyDoc(doc, "", "", false, newEdits, coll, json, &error) ) rq.writeErrorJSON(error);
+            if ( saved[i] ) writeSavedDoc(saved[i], json);
+            else
+                rq.writeErrorJSON(errors[i]);
             json.endDict();
         }
         json.endArray();
+    }
+
+#pragma mark - BLOB HANDLERS:
 
-        t.commit();
+    // GET /db/_blob/sha1-... returns the contents of a blob, given its digest.
+    void RESTListener::handleGetBlob(RequestResponse& rq, C4Database* db) {
+        auto key = C4BlobKey::withDigestString(rq.path(2));
+        if ( !key ) return rq.respondWithStatus(HTTPStatus::BadRequest, "Invalid blob digest");
+        C4BlobStore& store = db->getBlobStore();
+        if ( store.isStoredAsFile(*key) ) {
+            // Send the file itself, which the socket can do without copying it through memory:
+            rq.writeFile(string(store.getFilePath(*key)));
+        } else {
+            if ( store.getSize(*key) < 0 ) return rq.respondWithStatus(HTTPStatus::NotFound);
+            rq.write(store.getContents(*key));
+        }
+        rq.setHeader("Content-Type", "application/octet-stream");
     }
 
 }  // namespace litecore::REST
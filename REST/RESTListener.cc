@@ -65,7 +65,8 @@ namespace litecore::REST {
             // Top-level special handlers:
             addHandler(Method::GET, "/_all_dbs", &RESTListener::handleGetAllDBs);
             addHandler(Method::GET, "/_active_tasks", &RESTListener::handleActiveTasks);
-            addHandler(Method::POST, "/_replicate", &RESTListener::handleReplicate);
+            // (A non-continuous replication makes the request wait until it finishes.)
+            addHandler(Method::POST, "/_replicate", &RESTListener::handleReplicate, true);
 
             // Database:
             addCollectionHandler(Method::GET, "/[^_][^/]*|/[^_][^/]*/", &RESTListener::handleGetDatabase);
@@ -76,6 +77,7 @@ namespace litecore::REST {
             // Database-level special handlers:
             addCollectionHandler(Method::GET, "/[^_][^/]*/_all_docs", &RESTListener::handleGetAllDocs);
             addCollectionHandler(Method::POST, "/[^_][^/]*/_bulk_docs", &RESTListener::handleBulkDocs);
+            addDBHandler(Method::GET, "/[^_][^/]*/_blob/[^_][^/]*", &RESTListener::handleGetBlob);
 
             // Document:
             addCollectionHandler(Method::GET, "/[^_][^/]*/[^_].*", &RESTListener::handleGetDoc);
@@ -240,9 +242,9 @@ namespace litecore::REST {
 
 #pragma mark - UTILITIES:
 
-    void RESTListener::addHandler(Method method, const char* uri, HandlerMethod handler) {
+    void RESTListener::addHandler(Method method, const char* uri, HandlerMethod handler, bool mayBlock) {
         using namespace std::placeholders;
-        _server->addHandler(method, uri, bind(handler, this, _1));
+        _server->addHandler(method, uri, bind(handler, this, _1), mayBlock);
     }
 
     void RESTListener::addDBHandler(Method method, const char* uri, DBHandlerMethod handler) {
@@ -100,7 +100,7 @@ namespace litecore::REST {
         using DBHandlerMethod         = void (RESTListener::*)(RequestResponse&, C4Database*);
         using CollectionHandlerMethod = void (RESTListener::*)(RequestResponse&, C4Collection*);
 
-        void addHandler(net::Method, const char* uri, HandlerMethod);
+        void addHandler(net::Method, const char* uri, HandlerMethod, bool mayBlock = false);
         void addDBHandler(net::Method, const char* uri, DBHandlerMethod);
         void addCollectionHandler(net::Method, const char* uri, CollectionHandlerMethod);
 
@@ -129,8 +129,26 @@ namespace litecore::REST {
         void handleModifyDoc(RequestResponse&, C4Collection*);
         void handleBulkDocs(RequestResponse&, C4Collection*);
 
-        bool modifyDoc(fleece::Dict body, std::string docID, const std::string& revIDQuery, bool deleting,
-                       bool newEdits, C4Collection* coll, fleece::JSONEncoder& json, C4Error* outError) noexcept;
+        void handleGetBlob(RequestResponse&, C4Database*);
+
+        /// A document change parsed from a request, ready to be saved.
+        struct DocChange {
+            fleece::alloc_slice docID;
+            fleece::alloc_slice revID;
+            fleece::alloc_slice body;  // Fleece-encoded, without the `_id` and `_rev` properties
+            bool                deleting{}, newEdits{};
+            C4Slice             history[1]{};
+
+            /// A request to save the change. It points into this object, so keep this object around.
+            C4DocPutRequest putRequest();
+        };
+
+        static bool parseDocChange(fleece::Dict body, std::string docID, const std::string& revIDQuery,
+                                   bool deleting, bool newEdits, C4Collection* coll, DocChange& change,
+                                   C4Error* outError) noexcept;
+        static void writeSavedDoc(C4Document*, fleece::JSONEncoder& json);
+        bool        modifyDoc(fleece::Dict body, std::string docID, const std::string& revIDQuery, bool deleting,
+                              bool newEdits, C4Collection* coll, fleece::JSONEncoder& json, C4Error* outError) noexcept;
 
         std::unique_ptr<FilePath>  _directory;
         const bool                 _allowCreateDB, _allowDeleteDB, _allowCreateCollection, _allowDeleteCollection;
@@ -27,9 +27,7 @@
 #include <utility>
 #include <utility>
 
-#ifdef _MSC_VER
-#    include "PlatformIO.hh"
-#endif
+#include "PlatformIO.hh"
 
 using namespace std;
 using namespace std::chrono;
@@ -67,6 +65,11 @@ namespace litecore::REST {
 
         if ( !HTTPLogic::parseHeaders(in, _headers) ) return false;
 
+        slice connection = header("Connection");
+        if ( version == "HTTP/1.1"_sl ) _keepAlive = !connection.caseEquivalent("close"_sl);
+        else
+            _keepAlive = connection.caseEquivalent("keep-alive"_sl);
+
         _method = method;
         return true;
     }
@@ -110,11 +113,17 @@ namespace litecore::REST {
         : _server(server), _socket(std::move(socket)) {
         auto request = _socket->readToDelimiter("\r\n\r\n"_sl);
         if ( !request ) {
-            handleSocketError();
+            // A keep-alive connection that the client closed between requests isn't an error:
+            if ( _socket->atReadEOF() ) Log("Connection closed by client");
+            else
+                handleSocketError();
             return;
         }
         if ( !readFromHTTP(request) ) return;
-        if ( _method == Method::POST || _method == Method::PUT ) {
+        // Any request may have a body, and it has to be consumed before the next request on the
+        // same connection can be read:
+        if ( _method == Method::POST || _method == Method::PUT || header("Content-Length")
+             || header("Transfer-Encoding") ) {
             if ( !_socket->readHTTPBody(_headers, _body) ) {
                 handleSocketError();
                 return;
@@ -297,6 +306,17 @@ namespace litecore::REST {
         free(str);
     }
 
+    void RequestResponse::writeFile(const string& path) {
+        Assert(!_finished && !_bodyFile && !_jsonEncoder);
+        _bodyFile.reset(fopen_u8(path.c_str(), "rb"));
+        if ( !_bodyFile ) error::_throwErrno("Couldn't open %s", path.c_str());
+        fseeko(_bodyFile.get(), 0, SEEK_END);
+        auto length = ftello(_bodyFile.get());
+        fseeko(_bodyFile.get(), 0, SEEK_SET);
+        if ( length < 0 ) error::_throwErrno();
+        setContentLength(uint64_t(length));
+    }
+
     fleece::JSONEncoder& RequestResponse::jsonEncoder() {
         if ( !_jsonEncoder ) _jsonEncoder = std::make_unique<fleece::JSONEncoder>();
         return *_jsonEncoder;
@@ -312,13 +332,28 @@ namespace litecore::REST {
 
         alloc_slice responseData = _responseWriter.finish();
         if ( _contentLength < 0 ) setContentLength(responseData.size);
+        else if ( _bodyFile )
+            Assert(responseData.size == 0, "Can't write a response body as well as a file");
         else
             Assert(_contentLength == responseData.size);
+        if ( _status != HTTPStatus::Upgraded ) setHeader("Connection", (_keepAlive ? "keep-alive" : "close"));
 
         sendHeaders();
 
         Log("Now sending body...");
-        if ( _socket->write_n(responseData) < 0 ) handleSocketError();
+        if ( _bodyFile ) {
+            ssize_t sent = _socket->sendFile(_bodyFile.get(), uint64_t(_contentLength));
+            if ( sent < 0 ) {
+                handleSocketError();
+            } else if ( sent < _contentLength ) {
+                // The file shrank; the client will see a short body, so the connection is unusable:
+                WarnError("Response body file was shorter than its Content-Length");
+                _keepAlive = false;
+            }
+            _bodyFile.reset();
+        } else if ( _socket->write_n(responseData) < 0 ) {
+            handleSocketError();
+        }
         _finished = true;
     }
 
@@ -342,6 +377,14 @@ namespace litecore::REST {
 
     unique_ptr<ResponderSocket> RequestResponse::extractSocket() {
         finish();
+        _socket->setTimeout(0);  // the new owner manages its own timeouts
+        return std::move(_socket);
+    }
+
+    unique_ptr<ResponderSocket> RequestResponse::extractKeepAliveSocket() {
+        if ( !_finished || !_keepAlive || !_socket || _status == HTTPStatus::Upgraded || _socket->error().code != 0
+             || !_socket->connected() )
+            return nullptr;
         return std::move(_socket);
     }
 
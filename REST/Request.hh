@@ -14,6 +14,7 @@
 #include "Response.hh"
 #include "HTTPTypes.hh"
 #include "Writer.hh"
+#include <cstdio>
 #include <functional>
 #include <map>
 #include <memory>
@@ -47,6 +48,10 @@ namespace litecore::REST {
         int64_t     intQuery(const char* param, int64_t defaultValue = 0) const;
         bool        boolQuery(const char* param, bool defaultValue = false) const;
 
+        /** True if the client wants the connection kept open for another request: the HTTP/1.1
+            default unless it sent "Connection: close"; HTTP/1.0 only with "Connection: keep-alive". */
+        bool keepAlive() const { return _keepAlive; }
+
       protected:
         friend class Server;
 
@@ -58,6 +63,7 @@ namespace litecore::REST {
         Method      _method{Method::None};
         std::string _path;
         std::string _queries;
+        bool        _keepAlive{false};
     };
 
     /** Incoming HTTP request (inherited from Request), plus setters for the response. */
@@ -93,6 +99,10 @@ namespace litecore::REST {
 
         void printf(const char* format, ...) __printflike(2, 3);
 
+        /// Makes the contents of a file the response body; nothing else may be written. The file
+        /// is opened immediately (throwing if it can't be), and sent after the handler returns.
+        void writeFile(const std::string& path);
+
         fleece::JSONEncoder& jsonEncoder();
 
         void writeStatusJSON(HTTPStatus status, const char* message = nullptr);
@@ -119,6 +129,9 @@ namespace litecore::REST {
         void sendHeaders();
         void handleSocketError();
 
+        // After `finish`, returns the socket if it can be reused for the next request, else null.
+        std::unique_ptr<net::ResponderSocket> extractKeepAliveSocket();
+
       private:
         friend class Server;
 
@@ -136,11 +149,12 @@ namespace litecore::REST {
         bool           _endedHeaders{false};  // True after headers are ended
         int64_t        _contentLength{-1};    // Content-Length, once it's set
 
-        fleece::Writer                       _responseWriter;   // Output stream for response body
-        std::unique_ptr<fleece::JSONEncoder> _jsonEncoder;      // Used for writing JSON to response
-        fleece::alloc_slice                  _responseBody;     // Finished response body
-        fleece::slice                        _unsentBody;       // Unsent portion of _responseBody
-        bool                                 _finished{false};  // Finished configuring the response?
+        fleece::Writer                        _responseWriter;              // Output stream for response body
+        std::unique_ptr<fleece::JSONEncoder>  _jsonEncoder;                 // Used for writing JSON to response
+        fleece::alloc_slice                   _responseBody;                // Finished response body
+        fleece::slice                         _unsentBody;                  // Unsent portion of _responseBody
+        std::unique_ptr<FILE, int (*)(FILE*)> _bodyFile{nullptr, &fclose};  // File to send as the response body
+        bool                                  _finished{false};             // Finished configuring the response?
     };
 
 }  // namespace litecore::REST
@@ -19,7 +19,9 @@
 #include "Certificate.hh"
 #include "Error.hh"
 #include "StringUtil.hh"
+#include "ThreadUtil.hh"
 #include "c4ListenerInternal.hh"
+#include <algorithm>
 #include <memory>
 #include <mutex>
 
@@ -51,12 +53,21 @@ namespace litecore::REST {
         error::_throw(error::LiteCoreError::Unimplemented);
     }
 
-    Server::Server() {
+    Server::Server()
+        : _connectionCount(make_shared<atomic<int>>(0))
+        , _workQueue(make_shared<WorkQueue>())
+        , _idleTimer([this] { closeIdleConnections(false); }) {
         if ( !ListenerLog ) ListenerLog = c4log_getDomain("Listener", true);
     }
 
     Server::~Server() { stop(); }
 
+    unsigned Server::maxWorkerThreads() {
+        // Handlers spend much of their time waiting on the database or the network, so allow
+        // more of them than there are cores:
+        return std::clamp(2 * thread::hardware_concurrency(), 4u, 16u);
+    }
+
     uint16_t Server::port() const {
         Assert(_acceptor);
 
@@ -108,24 +119,44 @@ namespace litecore::REST {
         _acceptor   = std::make_unique<acceptor>(*ifAddr);
         if ( !*_acceptor ) error::_throw(error::POSIX, _acceptor->last_error());
         _acceptor->set_non_blocking();
+        for ( unsigned i = maxWorkerThreads(); i > 0; --i ) _workers.emplace_back(runWorker, _workQueue);
+        _idleTimer.fireAfter(kIdleTimeout);
         c4log(ListenerLog, kC4LogInfo, "Server listening on port %d", this->port());
         awaitConnection();
     }
 
     void Server::stop() {
-        lock_guard<mutex> lock(_mutex);
-
-        // Either we never had an acceptor, or the one we tried to create
-        // failed to become valid, either way don't continue
-        if ( !_acceptor || !*_acceptor ) return;
-
-        c4log(ListenerLog, kC4LogInfo, "Stopping server");
-        Poller::instance().removeListeners(_acceptor->handle());
-        _acceptor->close();
-        _acceptor.reset();
-        _rules.clear();
+        {
+            lock_guard<mutex> lock(_mutex);
+
+            // Either we never had an acceptor, or the one we tried to create
+            // failed to become valid, either way don't continue
+            if ( !_acceptor || !*_acceptor ) return;
+
+            c4log(ListenerLog, kC4LogInfo, "Stopping server");
+            Poller::instance().removeListeners(_acceptor->handle());
+            _acceptor->close();
+            _acceptor.reset();
+            _rules.clear();
+            _routes  = {};
+            _stopped = true;
+        }
+        _idleTimer.stop();
+        closeIdleConnections(true);
+
+        // Let the workers finish the requests they're handling, then exit. (If this is a worker,
+        // it's detached; it shares ownership of the queue, so it can outlive me.)
+        _workQueue->close();
+        for ( auto& worker : _workers ) {
+            if ( worker.get_id() == this_thread::get_id() ) worker.detach();
+            else
+                worker.join();
+        }
+        _workers.clear();
     }
 
+#pragma mark - CONNECTIONS:
+
     void Server::awaitConnection() {
         lock_guard<mutex> lock(_mutex);
         if ( !_acceptor ) return;
@@ -151,12 +182,12 @@ namespace litecore::REST {
             }
             if ( sock ) {
                 sock.set_non_blocking(false);
-                // We are in the poller thread and go handle the client connection in a new thead to avoid
-                // blocking the polling thread.
-                thread handleThread([selfRetain = Retained<Server>{this}, sock = std::move(sock), this]() mutable {
-                    this->handleConnection(std::move(sock));
+                // We are in the poller thread, so hand the connection to a worker to avoid
+                // blocking the polling thread. (std::function has to be copyable, hence shared_ptr.)
+                auto sockPtr = make_shared<tcp_socket>(std::move(sock));
+                enqueue([selfRetain = Retained<Server>(this), sockPtr] {
+                    selfRetain->handleConnection(std::move(*sockPtr));
                 });
-                handleThread.detach();
             }
         } catch ( const std::exception& x ) {
             c4log(ListenerLog, kC4LogWarning, "Caught C++ exception accepting connection: %s", x.what());
@@ -165,8 +196,26 @@ namespace litecore::REST {
         awaitConnection();
     }
 
+    void Server::enqueue(function<void()> task) { _workQueue->push(task); }
+
+    // Body of a worker thread: runs tasks from the queue until it's closed by `stop`.
+    // Every task retains the Server, so it stays alive while the task runs.
+    void Server::runWorker(shared_ptr<WorkQueue> queue) {
+        SetThreadName("CBL Listener");
+        while ( auto task = queue->pop() ) {
+            try {
+                task();
+            } catch ( const std::exception& x ) {
+                c4log(ListenerLog, kC4LogWarning, "Caught C++ exception handling connection: %s", x.what());
+            }
+        }
+    }
+
     void Server::handleConnection(sockpp::stream_socket&& sock) {
+        if ( _stopped ) return;
         auto responder = make_unique<ResponderSocket>(_tlsContext);
+        // A stalled client mustn't tie up a worker thread forever:
+        responder->setTimeout(kIOTimeoutSecs);
         if ( !responder->acceptSocket(std::move(sock)) || (_tlsContext && !responder->wrapTLS()) ) {
             c4log(ListenerLog, kC4LogError, "Error accepting incoming connection: %s",
                   responder->error().description().c_str());
@@ -180,36 +229,194 @@ namespace litecore::REST {
             else
                 c4log(ListenerLog, kC4LogVerbose, "Accepted connection from %s", responder->peerAddress().c_str());
         }
-        RequestResponse rq(this, std::move(responder));
-        if ( rq.isValid() ) {
-            dispatchRequest(&rq);
-            rq.finish();
+        ++*_connectionCount;
+        responder->onClose([count = _connectionCount] { --*count; });
+        handleRequest(std::move(responder));
+    }
+
+    // Reads and handles one request. If the connection is kept alive, it then goes back to
+    // waiting on the Poller for the next request.
+    void Server::handleRequest(Connection socket) {
+        if ( _stopped ) return;
+        unique_ptr<RequestResponse> rq(new RequestResponse(this, std::move(socket)));
+        if ( !rq->isValid() ) return;
+        if ( handlerMayBlock(*rq) ) {
+            // Give the request a thread of its own, so it doesn't tie up a worker; otherwise
+            // enough of these at once could leave no worker free to handle anything else.
+            thread([selfRetain = Retained<Server>(this), rq = std::move(rq)]() mutable {
+                SetThreadName("CBL Listener");
+                try {
+                    selfRetain->finishRequest(std::move(rq));
+                } catch ( const std::exception& x ) {
+                    c4log(ListenerLog, kC4LogWarning, "Caught C++ exception handling connection: %s", x.what());
+                }
+            }).detach();
+        } else {
+            finishRequest(std::move(rq));
+        }
+    }
+
+    // Dispatches a request to its handler and sends the response.
+    void Server::finishRequest(unique_ptr<RequestResponse> rq) {
+        dispatchRequest(rq.get());
+        if ( _stopped ) rq->_keepAlive = false;
+        rq->finish();
+        if ( auto next = rq->extractKeepAliveSocket() ) awaitRequest(std::move(next));
+    }
+
+    // Parks a keep-alive connection until more data arrives on it, or it times out.
+    void Server::awaitRequest(Connection socket) {
+        if ( socket->hasUnreadData() ) {
+            // The next (pipelined) request was read along with the previous one, so the socket
+            // won't become readable; handle it now.
+            auto socketPtr = make_shared<Connection>(std::move(socket));
+            enqueue([selfRetain = Retained<Server>(this), socketPtr] {
+                selfRetain->handleRequest(std::move(*socketPtr));
+            });
+            return;
+        }
+        lock_guard<mutex> lock(_mutex);
+        if ( _stopped ) return;
+        uint64_t id   = ++_nextConnectionID;
+        auto     sock = socket.get();
+        _idleConnections.emplace(id, IdleConnection{std::move(socket), actor::Timer::clock::now() + kIdleTimeout});
+        sock->onReadable([selfRetain = Retained<Server>(this), id] { selfRetain->wakeIdleConnection(id); });
+    }
+
+    // Called on the Poller thread when an idle connection becomes readable (or closes.)
+    void Server::wakeIdleConnection(uint64_t id) {
+        Connection socket;
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto              i = _idleConnections.find(id);
+            if ( i == _idleConnections.end() ) return;  // it already timed out
+            socket = std::move(i->second.socket);
+            _idleConnections.erase(i);
+        }
+        auto socketPtr = make_shared<Connection>(std::move(socket));
+        enqueue([selfRetain = Retained<Server>(this), socketPtr] {
+            selfRetain->handleRequest(std::move(*socketPtr));
+        });
+    }
+
+    // Closes idle connections that have expired, or all of them. Called periodically by _idleTimer.
+    void Server::closeIdleConnections(bool all) {
+        vector<Connection> closing;
+        {
+            lock_guard<mutex> lock(_mutex);
+            auto              now = actor::Timer::clock::now();
+            for ( auto i = _idleConnections.begin(); i != _idleConnections.end(); ) {
+                if ( all || i->second.expiration <= now ) {
+                    i->second.socket->cancelCallbacks();
+                    closing.push_back(std::move(i->second.socket));
+                    i = _idleConnections.erase(i);
+                } else {
+                    ++i;
+                }
+            }
+            if ( !_stopped ) _idleTimer.fireAfter(kIdleTimeout / 4);
         }
+        if ( !closing.empty() )
+            c4log(ListenerLog, kC4LogVerbose, "Closing %zu idle connection(s)", closing.size());
+        // The sockets close as `closing` goes out of scope, after the mutex is unlocked.
     }
 
+#pragma mark - ROUTING:
+
     void Server::setExtraHeaders(const std::map<std::string, std::string>& headers) {
         lock_guard<mutex> lock(_mutex);
         _extraHeaders = headers;
     }
 
-    void Server::addHandler(Methods methods, const string& patterns, const Handler& handler) {
+    void Server::addHandler(Methods methods, const string& patterns, const Handler& handler, bool mayBlock) {
         lock_guard<mutex> lock(_mutex);
         split(patterns, "|", [&](string_view pattern) {
-            _rules.push_back({methods, string(pattern), regex(pattern.data(), pattern.size()), handler});
+            URIRule rule{methods, string(pattern), nullopt, handler, mayBlock};
+            if ( !addRoute(pattern, _rules.size()) ) rule.regex.emplace(pattern.data(), pattern.size());
+            _rules.push_back(std::move(rule));
         });
     }
 
+    // Adds a pattern to the route tree, if it's simple enough; else returns false.
+    bool Server::addRoute(string_view pattern, size_t ruleIndex) {
+        static constexpr string_view kAnyComponent = "[^_][^/]*", kRestOfPath = "[^_].*";
+        if ( pattern.empty() || pattern[0] != '/' ) return false;
+
+        vector<string_view> components;
+        split(pattern.substr(1), "/", [&](string_view component) { components.push_back(component); });
+        bool rest = (components.back() == kRestOfPath);
+        if ( rest ) components.pop_back();
+        for ( string_view component : components ) {
+            if ( component != kAnyComponent && component.find_first_of(".[]()*+?^$\\{}|") != string_view::npos )
+                return false;
+        }
+
+        RouteNode* node = &_routes;
+        for ( string_view component : components ) {
+            auto& child = (component == kAnyComponent) ? node->anyComponent : node->literals[string(component)];
+            if ( !child ) child = make_unique<RouteNode>();
+            node = child.get();
+        }
+        (rest ? node->restRules : node->rules).push_back(ruleIndex);
+        return true;
+    }
+
+    // Walks the route tree, lowering `best` to the index of any earlier rule that matches.
+    // `path` is the rest of the request path, following a "/".
+    void Server::findRules(const RouteNode& node, string_view path, Method method, size_t& best) const {
+        auto check = [&](const vector<size_t>& rules) {
+            // Rule lists are in ascending order, so the first match is the earliest:
+            for ( size_t i : rules ) {
+                if ( i >= best ) break;
+                if ( _rules[i].methods & method ) {
+                    best = i;
+                    break;
+                }
+            }
+        };
+
+        if ( !path.empty() && path[0] != '_' ) check(node.restRules);
+
+        size_t      slash     = path.find('/');
+        string_view component = path.substr(0, slash);
+        auto        descend   = [&](const RouteNode& child) {
+            if ( slash == string_view::npos ) check(child.rules);
+            else
+                findRules(child, path.substr(slash + 1), method, best);
+        };
+        if ( auto i = node.literals.find(string(component)); i != node.literals.end() ) descend(*i->second);
+        if ( node.anyComponent && !component.empty() && component[0] != '_' ) descend(*node.anyComponent);
+    }
+
     Server::URIRule* Server::findRule(Method method, const string& path) {
-        //lock_guard<mutex> lock(_mutex);       // called from dispatchResponder which locks
-        for ( auto& rule : _rules ) {
-            if ( (rule.methods & method) && regex_match(path.c_str(), rule.regex) ) return &rule;
+        //lock_guard<mutex> lock(_mutex);       // called from dispatchRequest which locks
+        size_t best = _rules.size();
+        if ( !path.empty() && path[0] == '/' ) findRules(_routes, string_view(path).substr(1), method, best);
+        // Patterns that aren't in the route tree have to be tried one at a time:
+        for ( size_t i = 0; i < best; ++i ) {
+            auto& rule = _rules[i];
+            if ( rule.regex && (rule.methods & method) && regex_match(path.c_str(), *rule.regex) ) {
+                best = i;
+                break;
+            }
         }
-        return nullptr;
+        return (best < _rules.size()) ? &_rules[best] : nullptr;
+    }
+
+    static Method requestMethod(RequestResponse& rq) {
+        Method method = rq.method();
+        if ( method == Method::GET && rq.header("Connection") == "Upgrade"_sl ) method = Method::UPGRADE;
+        return method;
+    }
+
+    bool Server::handlerMayBlock(RequestResponse& rq) {
+        lock_guard<mutex> lock(_mutex);
+        auto              rule = findRule(requestMethod(rq), rq.path());
+        return rule && rule->mayBlock;
     }
 
     void Server::dispatchRequest(RequestResponse* rq) {
-        Method method = rq->method();
-        if ( method == Method::GET && rq->header("Connection") == "Upgrade"_sl ) method = Method::UPGRADE;
+        Method method = requestMethod(*rq);
 
         c4log(ListenerLog, kC4LogInfo, "%s %s", MethodName(method), rq->path().c_str());
 
@@ -222,24 +429,30 @@ namespace litecore::REST {
             }
         }
 
-        lock_guard<mutex> lock(_mutex);
-
-        ++_connectionCount;
-        Retained<Server> retainedSelf = this;
-        rq->onClose([=] { --retainedSelf->_connectionCount; });
-
         try {
-            string pathStr(rq->path());
-            auto   rule = findRule(method, pathStr);
-            if ( rule ) {
-                c4log(ListenerLog, kC4LogInfo, "Matched rule %s for path %s", rule->pattern.c_str(), pathStr.c_str());
-                rule->handler(*rq);
-            } else if ( nullptr == (rule = findRule(Methods::ALL, pathStr)) ) {
-                c4log(ListenerLog, kC4LogInfo, "No rule matched path %s", pathStr.c_str());
+            string  pathStr(rq->path());
+            Handler handler;
+            bool    pathMatched = false;
+            {
+                // Copy the handler, so that requests can be handled concurrently without the lock:
+                lock_guard<mutex> lock(_mutex);
+                if ( auto rule = findRule(method, pathStr); rule ) {
+                    c4log(ListenerLog, kC4LogInfo, "Matched rule %s for path %s", rule->pattern.c_str(),
+                          pathStr.c_str());
+                    handler = rule->handler;
+                } else if ( nullptr == (rule = findRule(Methods::ALL, pathStr)) ) {
+                    c4log(ListenerLog, kC4LogInfo, "No rule matched path %s", pathStr.c_str());
+                } else {
+                    c4log(ListenerLog, kC4LogInfo, "Wrong method for rule %s for path %s", rule->pattern.c_str(),
+                          pathStr.c_str());
+                    pathMatched = true;
+                }
+            }
+            if ( handler ) {
+                handler(*rq);
+            } else if ( !pathMatched ) {
                 rq->respondWithStatus(HTTPStatus::NotFound, "Not found");
             } else {
-                c4log(ListenerLog, kC4LogInfo, "Wrong method for rule %s for path %s", rule->pattern.c_str(),
-                      pathStr.c_str());
                 if ( method == Method::UPGRADE ) rq->respondWithStatus(HTTPStatus::Forbidden, "No upgrade available");
                 else
                     rq->respondWithStatus(HTTPStatus::MethodNotAllowed, "Method not allowed");
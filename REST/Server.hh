@@ -14,13 +14,17 @@
 #include "fleece/RefCounted.hh"
 #include "fleece/InstanceCounted.hh"
 #include "Request.hh"
+#include "Channel.hh"
 #include "StringUtil.hh"
+#include "Timer.hh"
 #include <atomic>
 #include <map>
 #include <mutex>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include <regex>
 
@@ -35,14 +39,18 @@ namespace litecore::crypto {
 }
 
 namespace litecore::net {
+    class ResponderSocket;
     class TLSContext;
-}
+}  // namespace litecore::net
 
 namespace litecore::REST {
 
     using namespace fleece;
 
-    /** HTTP server with configurable URI handlers. */
+    /** HTTP server with configurable URI handlers.
+        Connections are accepted on the shared `Poller` thread and handed to a fixed pool of worker
+        threads, which read a request, dispatch it and write the response. HTTP/1.1 keep-alive is
+        supported: between requests an idle connection waits on the `Poller`, not on a worker. */
     class Server final
         : public fleece::RefCounted
         , public fleece::InstanceCountedIn<Server> {
@@ -73,19 +81,34 @@ namespace litecore::REST {
         using Handler = std::function<void(RequestResponse&)>;
 
         /** Registers a handler function for a URI pattern.
-            Patterns use glob syntax: <http://man7.org/linux/man-pages/man7/glob.7.html>
+            Patterns are regular expressions matched against the entire path.
             Multiple patterns can be joined with a "|".
-            Patterns are tested in the order the handlers are added, and the first match is used.*/
-        void addHandler(net::Methods, const std::string& pattern, const Handler&);
+            Patterns are tested in the order the handlers are added, and the first match is used.
+            Patterns made of literal path components, `[^_][^/]*` (any component not starting
+            with "_"), a trailing `[^_].*` (the rest of the path) and an optional trailing "/" are
+            compiled into a tree that's matched a component at a time; others use `std::regex`.
+            If `mayBlock` is true, the handler can take a long time (e.g. waiting for a replication
+            to finish), so it's run on a thread of its own instead of tying up a worker thread. */
+        void addHandler(net::Methods, const std::string& pattern, const Handler&, bool mayBlock = false);
+
+        int connectionCount() { return *_connectionCount; }
+
+        /** Maximum number of requests handled at once; more wait in a queue. */
+        static unsigned maxWorkerThreads();
 
-        int connectionCount() { return _connectionCount; }
+        /** How long a keep-alive connection may sit idle before the server closes it. */
+        static constexpr auto kIdleTimeout = std::chrono::seconds(30);
+
+        /** Read/write timeout for a connection while a request is being handled. */
+        static constexpr double kIOTimeoutSecs = 30.0;
 
       protected:
         struct URIRule {
-            net::Methods methods;
-            std::string  pattern;
-            std::regex   regex;
-            Handler      handler;
+            net::Methods              methods;
+            std::string               pattern;
+            std::optional<std::regex> regex;  // only if the pattern can't go in the route tree
+            Handler                   handler;
+            bool                      mayBlock;  // run on its own thread, not a worker
         };
 
         URIRule* findRule(net::Method method, const std::string& path);
@@ -94,19 +117,52 @@ namespace litecore::REST {
         void dispatchRequest(RequestResponse*);
 
       private:
+        // A node of the route tree. Each level matches one component of the path.
+        struct RouteNode {
+            std::unordered_map<std::string, std::unique_ptr<RouteNode>> literals;      // exact components
+            std::unique_ptr<RouteNode>                                  anyComponent;  // `[^_][^/]*`
+            std::vector<size_t>                                         rules;      // rules ending here
+            std::vector<size_t>                                         restRules;  // ...ending in `[^_].*`
+        };
+
+        using Connection = std::unique_ptr<net::ResponderSocket>;
+        using WorkQueue  = actor::Channel<std::function<void()>>;
+
+        struct IdleConnection {
+            Connection                      socket;
+            actor::Timer::clock::time_point expiration;
+        };
+
+        bool addRoute(std::string_view pattern, size_t ruleIndex);
+        void findRules(const RouteNode&, std::string_view path, net::Method, size_t& best) const;
         void awaitConnection();
         void acceptConnection();
-        void handleConnection(sockpp::stream_socket&&);
-
-        fleece::Retained<crypto::Identity> _identity;
-        fleece::Retained<net::TLSContext>  _tlsContext;
-        std::unique_ptr<sockpp::acceptor>  _acceptor;
-        std::mutex                         _mutex;
-        std::vector<URIRule>               _rules;
-        std::map<std::string, std::string> _extraHeaders;
-        uint16_t                           _port{};
-        std::atomic<int>                   _connectionCount{0};
-        Authenticator                      _authenticator;
+        void        enqueue(std::function<void()>);
+        static void runWorker(std::shared_ptr<WorkQueue>);
+        void        handleConnection(sockpp::stream_socket&&);
+        void        handleRequest(Connection);
+        void        finishRequest(std::unique_ptr<RequestResponse>);
+        bool        handlerMayBlock(RequestResponse&);
+        void awaitRequest(Connection);
+        void wakeIdleConnection(uint64_t id);
+        void closeIdleConnections(bool all);
+
+        fleece::Retained<crypto::Identity>           _identity;
+        fleece::Retained<net::TLSContext>            _tlsContext;
+        std::unique_ptr<sockpp::acceptor>            _acceptor;
+        std::mutex                                   _mutex;
+        std::vector<URIRule>                         _rules;
+        RouteNode                                    _routes;  // Tree of rules, matched by path component
+        std::map<std::string, std::string>           _extraHeaders;
+        uint16_t                                     _port{};
+        std::shared_ptr<std::atomic<int>>            _connectionCount;  // shared with sockets' onClose
+        Authenticator                                _authenticator;
+        std::shared_ptr<WorkQueue>                   _workQueue;        // Tasks for the worker threads
+        std::vector<std::thread>                     _workers;          // Worker threads
+        std::unordered_map<uint64_t, IdleConnection> _idleConnections;  // Keep-alive connections
+        uint64_t                                     _nextConnectionID{0};
+        actor::Timer                                 _idleTimer;  // Closes expired idle connections
+        std::atomic<bool>                            _stopped{false};
     };
 
 }  // namespace litecore::REST
@@ -12,16 +12,25 @@
 
 #include "c4Test.hh"
 #include "Error.hh"
+#include "c4BlobStore.h"
 #include "c4Collection.h"
 #include "c4Database.h"
 #include "c4Replicator.h"
 #include "ListenerHarness.hh"
 #include "FilePath.hh"
+#include "Headers.hh"
+#include "HTTPLogic.hh"
 #include "Response.hh"
 #include "NetworkInterfaces.hh"
+#include "netUtils.hh"
+#include "TCPSocket.hh"
+#include "slice_stream.hh"
+#include "Stopwatch.hh"
 #include "fleece/Mutable.hh"
 #include "ReplicatorAPITest.hh"
+#include <algorithm>
 #include <optional>
+#include <thread>
 #include <utility>
 
 using namespace litecore;
@@ -306,6 +315,107 @@ TEST_CASE_METHOD(C4RESTTest, "REST unknown special top-level", "[REST][Listener]
     request("GET", "/_", HTTPStatus::NotFound);
 }
 
+static string rawGET(const string& path, bool closeAfter = false) {
+    string rq = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+    if ( closeAfter ) rq += "Connection: close\r\n";
+    return rq + "\r\n";
+}
+
+// Reads an HTTP response from an open connection. Returns the HTTP status, or 0 on error.
+static int readRawResponse(ClientSocket& socket) {
+    alloc_slice response = socket.readToDelimiter("\r\n\r\n"_sl);
+    if ( !response ) return 0;
+    slice_istream in(response);
+    if ( !in.readToDelimiter(" "_sl) ) return 0;
+    auto status = int(in.readDecimal());
+    (void)in.readToDelimiter("\r\n"_sl);
+    websocket::Headers headers;
+    alloc_slice        body;
+    if ( !HTTPLogic::parseHeaders(in, headers) || !socket.readHTTPBody(headers, body) ) return 0;
+    return status;
+}
+
+// Sends a GET request on an open connection and reads the response. Returns the HTTP status,
+// or 0 on error. (Unlike `Response`, this lets a test reuse a keep-alive connection.)
+static int sendRawGET(ClientSocket& socket, const string& path, bool closeAfter = false) {
+    if ( socket.write_n(slice(rawGET(path, closeAfter))) <= 0 ) return 0;
+    return readRawResponse(socket);
+}
+
+TEST_CASE_METHOD(C4RESTTest, "REST keep-alive", "[REST][Listener][C]") {
+    share(db, "db"_sl);
+    ClientSocket socket;
+    REQUIRE(socket.connect(Address("http"_sl, "localhost"_sl, c4listener_getPort(listener()), "/"_sl)));
+
+    // Several requests can be sent on one connection:
+    CHECK(sendRawGET(socket, "/") == 200);
+    CHECK(sendRawGET(socket, "/db") == 200);
+    CHECK(sendRawGET(socket, "/_foo") == 404);
+    unsigned connections = 0;
+    c4listener_getConnectionStatus(listener(), &connections, nullptr);
+    CHECK(connections == 1);
+    CHECK(sendRawGET(socket, "/db/", true) == 200);
+
+    // After a "Connection: close" request, the server closes the connection:
+    char buf[1];
+    CHECK(socket.read(buf, 1) == 0);
+    CHECK(socket.atReadEOF());
+}
+
+TEST_CASE_METHOD(C4RESTTest, "REST pipelined requests", "[REST][Listener][C]") {
+    share(db, "db"_sl);
+    ClientSocket socket;
+    REQUIRE(socket.connect(Address("http"_sl, "localhost"_sl, c4listener_getPort(listener()), "/"_sl)));
+    socket.setTimeout(5);  // fail quickly, instead of waiting for the server's idle timeout
+
+    // Requests sent together are all answered, even though the server reads them in one go:
+    REQUIRE(socket.write_n(slice(rawGET("/") + rawGET("/db") + rawGET("/_foo"))) > 0);
+    CHECK(readRawResponse(socket) == 200);
+    CHECK(readRawResponse(socket) == 200);
+    CHECK(readRawResponse(socket) == 404);
+}
+
+TEST_CASE_METHOD(C4RESTTest, "REST Load Benchmark", "[REST][Listener][C][Perf][.slow]") {
+    static constexpr int kRequestsPerClient = 1000;
+    share(db, "db"_sl);
+    Address address("http"_sl, "localhost"_sl, c4listener_getPort(listener()), "/"_sl);
+
+    for ( int concurrency : {1, 4, 16, 64} ) {
+        vector<vector<double>> latencies(concurrency);
+        atomic<int>            failures{0};
+        vector<thread>         clients;
+        Stopwatch              st;
+        for ( int c = 0; c < concurrency; ++c ) {
+            clients.emplace_back([&, c] {
+                ClientSocket socket;
+                if ( !socket.connect(address) ) {
+                    ++failures;
+                    return;
+                }
+                for ( int i = 0; i < kRequestsPerClient; ++i ) {
+                    Stopwatch requestTime;
+                    if ( sendRawGET(socket, "/") != 200 ) {
+                        ++failures;
+                        return;
+                    }
+                    latencies[c].push_back(requestTime.elapsedMS());
+                }
+            });
+        }
+        for ( auto& client : clients ) client.join();
+        double elapsed = st.elapsed();
+
+        vector<double> all;
+        for ( auto& l : latencies ) all.insert(all.end(), l.begin(), l.end());
+        REQUIRE(!all.empty());
+        sort(all.begin(), all.end());
+        double p99 = all[min(all.size() - 1, all.size() * 99 / 100)];
+        fprintf(stderr, "%2d clients: %8.0f requests/sec, p99 latency %6.2f ms\n", concurrency,
+                double(all.size()) / elapsed, p99);
+        CHECK(failures == 0);
+    }
+}
+
 #    pragma mark - DATABASE:
 
 TEST_CASE_METHOD(C4RESTTest, "REST GET database", "[REST][Listener][C]") {
@@ -588,6 +698,24 @@ TEST_CASE_METHOD(C4RESTTest, "REST _bulk_docs", "[REST][Listener][C]") {
     CHECK(doc["error"].asString() == "Not Found"_sl);
 }
 
+TEST_CASE_METHOD(C4RESTTest, "REST GET blob", "[REST][Listener][C]") {
+    // Big enough that the blob store memory-maps it:
+    string blob;
+    for ( int i = 0; blob.size() < 200000; i++ ) blob += "This is line " + to_string(i) + " of the blob.\n";
+    C4BlobStore* store = c4db_getBlobStore(db, ERROR_INFO());
+    REQUIRE(store);
+    C4BlobKey key;
+    REQUIRE(c4blob_create(store, slice(blob), nullptr, &key, WITH_ERROR()));
+    alloc_slice digest = c4blob_keyToString(key);
+
+    auto r = request("GET", "/db/_blob/" + URLEncode(digest), HTTPStatus::OK);
+    CHECK(r->header("Content-Type") == "application/octet-stream"_sl);
+    CHECK(r->body() == slice(blob));
+
+    request("GET", "/db/_blob/" + URLEncode("sha1-QneWo5IYIQ0ZrbCG0hXPGC6jy7E="), HTTPStatus::NotFound);
+    request("GET", "/db/_blob/sha1-bogus", HTTPStatus::BadRequest);
+}
+
 #    pragma mark - HTTP AUTH:
 
 TEST_CASE_METHOD(C4RESTTest, "REST HTTP auth missing", "[REST][Listener][C]") {
@@ -0,0 +1,53 @@
+//
+// BlobDownloadBudget.cc
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#include "BlobDownloadBudget.hh"
+#include "Error.hh"
+#include <algorithm>
+
+namespace litecore::repl {
+    using namespace std;
+
+    BlobDownloadBudget::StartResult BlobDownloadBudget::start(const C4BlobKey& key, uint64_t length, Waiter waiter) {
+        unique_lock lock(_mutex);
+        StartResult result = kStarted;
+        for ( auto& download : _downloads ) {
+            if ( download.key == key ) result = kDuplicate;
+        }
+        if ( result == kStarted && !_downloads.empty()
+             && (_downloads.size() >= _maxDownloads || _bytes + length > _maxBytes) )
+            result = kNoCapacity;
+        if ( result != kStarted ) {
+            // Registering the waiter under the lock ensures it can't miss the next `finished` call:
+            if ( waiter ) _waiters.push_back(std::move(waiter));
+            return result;
+        }
+        _downloads.push_back({key, length});
+        _bytes += length;
+        return kStarted;
+    }
+
+    void BlobDownloadBudget::finished(const C4BlobKey& key, uint64_t length) {
+        vector<Waiter> waiters;
+        {
+            unique_lock lock(_mutex);
+            auto i = find_if(_downloads.begin(), _downloads.end(), [&](auto& d) { return d.key == key; });
+            Assert(i != _downloads.end() && i->length == length);
+            _downloads.erase(i);
+            _bytes -= length;
+            waiters.swap(_waiters);
+        }
+        // Call the waiters outside the lock, since they may call back into me:
+        for ( auto& waiter : waiters ) waiter();
+    }
+
+}  // namespace litecore::repl
@@ -0,0 +1,64 @@
+//
+// BlobDownloadBudget.hh
+//
+// Copyright 2026-Present Couchbase, Inc.
+//
+// Use of this software is governed by the Business Source License included
+// in the file licenses/BSL-Couchbase.txt.  As of the Change Date specified
+// in that file, in accordance with the Business Source License, use of this
+// software will be governed by the Apache License, Version 2.0, included in
+// the file licenses/APL2.txt.
+//
+
+#pragma once
+#include "c4BlobStoreTypes.h"
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace litecore::repl {
+
+    /** Limits the blob downloads in progress over one replicator connection, by count and by total
+        size, and keeps the same blob from being downloaded twice at once.
+
+        IncomingRevs call `start` before requesting a blob and `finished` when it's done (or has
+        failed.) A blob that can't start right away waits until some other download finishes; the
+        caller passes a callback to `start` to find out when to try again.
+
+        This is shared by the IncomingRevs of all collections, so it's thread-safe. */
+    class BlobDownloadBudget {
+      public:
+        using Waiter = std::function<void()>;
+
+        BlobDownloadBudget(unsigned maxDownloads, uint64_t maxBytes)
+            : _maxDownloads(maxDownloads), _maxBytes(maxBytes) {}
+
+        enum StartResult {
+            kStarted,     ///< The caller should download the blob, then call `finished`
+            kDuplicate,   ///< The blob is already being downloaded; wait for it to finish
+            kNoCapacity,  ///< Too many downloads are in progress; wait for one to finish
+        };
+
+        /// Reserves room to download a blob. One download is always allowed, however large.
+        /// If the blob can't start, and `waiter` isn't empty, it will be called (once, on an
+        /// arbitrary thread) the next time any download finishes.
+        StartResult start(const C4BlobKey&, uint64_t length, Waiter waiter);
+
+        /// Releases the room reserved by a successful `start`, and calls the waiters.
+        void finished(const C4BlobKey&, uint64_t length);
+
+      private:
+        struct Download {
+            C4BlobKey key;
+            uint64_t  length;
+        };
+
+        std::mutex            _mutex;
+        unsigned const        _maxDownloads;
+        uint64_t const        _maxBytes;
+        std::vector<Download> _downloads;  // Downloads in progress (there are only a few)
+        uint64_t              _bytes{0};   // Total length of _downloads
+        std::vector<Waiter>   _waiters;
+    };
+
+}  // namespace litecore::repl
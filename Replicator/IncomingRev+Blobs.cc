@@ -16,6 +16,7 @@
 #include "StringUtil.hh"
 #include "MessageBuilder.hh"
 #include "c4BlobStore.hh"
+#include <algorithm>
 #include <atomic>
 
 using namespace fleece;
@@ -28,67 +29,182 @@ namespace litecore::repl {
     static std::atomic_int sMaxOpenWriters{0};
 #endif
 
-    // Looks for another blob to download; when they're all done, finishes up the revision.
-    void IncomingRev::fetchNextBlob() {
-        while ( _blob != _pendingBlobs.end() ) {
-            if ( startBlob() ) return;
-            ++_blob;
+    // Starts downloading the blobs that aren't in the local store yet, as many at once as the
+    // Replicator's BlobDownloadBudget allows. When they've all arrived, inserts the revision.
+    void IncomingRev::fetchBlobs() {
+        C4BlobStore*        blobStore = _db->blobStore();
+        BlobDownloadBudget& budget    = replicator()->blobDownloads();
+        for ( auto i = _blobsToFetch.begin(); i != _blobsToFetch.end(); ) {
+            const PendingBlob& blob = **i;
+            if ( blobStore->getSize(blob.key) >= 0 ) {
+                i = _blobsToFetch.erase(i);  // already have it
+                continue;
+            }
+
+            BlobDownloadBudget::Waiter waiter;
+            if ( !_waitingForBlobDownloads ) {
+                waiter = [self = Retained<IncomingRev>(this), rev = _rev] {
+                    self->enqueue(FUNCTION_TO_QUEUE(IncomingRev::_blobDownloadFinished), rev);
+                };
+            }
+            auto result = budget.start(blob.key, blob.length, std::move(waiter));
+            if ( result == BlobDownloadBudget::kStarted ) {
+                i = _blobsToFetch.erase(i);
+                startDownload(blob);
+            } else {
+                _waitingForBlobDownloads = true;
+                if ( result == BlobDownloadBudget::kNoCapacity ) break;
+                // Another IncomingRev is downloading this blob; look for it again when it's done:
+                ++i;
+            }
         }
 
-        // All blobs completed, now finish:
-        if ( _rev->error.code == 0 ) {
+        if ( _blobsToFetch.empty() && _downloads.empty() ) {
             logVerbose("All blobs received, now inserting revision");
             insertRevision();
-        } else {
-            finish();
         }
     }
 
-    // If the blob described by `_blob` exists locally, returns false.
-    // Else sends a request for its data.
-    bool IncomingRev::startBlob() {
-        Assert(!_writer);
-        if ( _db->blobStore()->getSize(_blob->key) >= 0 ) return false;  // already have it
+    // Called (via the BlobDownloadBudget) after some blob download on the connection has finished.
+    void IncomingRev::_blobDownloadFinished(Retained<RevToInsert> rev) {
+        if ( rev != _rev ) return;  // I've finished that revision since
+        _waitingForBlobDownloads = false;
+        if ( !_blobsToFetch.empty() ) fetchBlobs();
+    }
 
-        logVerbose("Requesting blob (%" PRIu64 " bytes, compress=%d)", _blob->length, _blob->compressible);
+    void IncomingRev::startDownload(const PendingBlob& blob) {
+        _downloads.emplace_back(new BlobDownload{++_lastDownloadID, &blob});
+        BlobDownload& download = *_downloads.back();
+        addProgress({0, blob.length});
+        C4BlobStore* blobStore = _db->blobStore();
+        requestBlob(download, blobStore->isChunked() && blob.length >= C4BlobStore::kMinChunkedBlobSize);
+    }
 
-        addProgress({0, _blob->length});
-        _blobBytesWritten = 0;
+    // Returns the download with the given ID, or null if it's been aborted. (Replies to requests
+    // are looked up by ID since they may arrive after their download, or even revision, is gone.)
+    IncomingRev::BlobDownload* IncomingRev::findDownload(unsigned id) {
+        for ( auto& download : _downloads ) {
+            if ( download->id == id ) return download.get();
+        }
+        return nullptr;
+    }
 
+    // Sends a "getAttachment" request. If `chunked` is true, the peer may reply with the blob's
+    // chunk manifest instead of its data, if it has the blob stored in chunks.
+    void IncomingRev::requestBlob(BlobDownload& download, bool chunked) {
+        const PendingBlob& blob = *download.blob;
+        logVerbose("Requesting blob (%" PRIu64 " bytes, compress=%d, chunks=%d)", blob.length, blob.compressible,
+                   chunked);
         MessageBuilder req("getAttachment"_sl);
         assignCollectionToMsg(req, collectionIndex());
-        req["digest"_sl] = _blob->key.digestString();
-        req["docID"]     = _blob->docID;
-        if ( _blob->compressible ) req["compress"_sl] = "true"_sl;
-        sendRequest(req, [=](const blip::MessageProgress& progress) {
+        req["digest"_sl] = blob.key.digestString();
+        req["docID"]     = blob.docID;
+        if ( blob.compressible ) req["compress"_sl] = "true"_sl;
+        req["deflate"_sl] = "true"_sl;  // I can take the data as stored, if the peer stores it compressed
+        if ( chunked ) req["chunks"_sl] = "true"_sl;
+        sendRequest(req, [=, id = download.id](const blip::MessageProgress& progress) {
             //... After request is sent:
-            if ( _blob != _pendingBlobs.end() ) {
+            BlobDownload* download = findDownload(id);
+            if ( !download ) return;
+            if ( progress.state == MessageProgress::kDisconnected ) {
+                // Set some error, so my IncomingRev will know I didn't complete [CBL-608]
+                blobGotError(*download, {POSIXDomain, ECONNRESET});
+            } else if ( progress.reply ) {
+                if ( progress.reply->isError() ) {
+                    auto err = progress.reply->getError();
+                    logError("Got error response: %.*s %d '%.*s'", SPLAT(err.domain), err.code, SPLAT(err.message));
+                    blobGotError(*download, blipToC4Error(err));
+                } else if ( progress.reply->boolProperty("chunked"_sl) ) {
+                    if ( progress.state == MessageProgress::kComplete )
+                        gotChunkManifest(*download, progress.reply->body());
+                } else {
+                    bool complete = progress.state == MessageProgress::kComplete;
+                    auto data     = progress.reply->extractBody();
+                    bool ok       = (progress.reply->property("encoding"_sl) == "deflate"_sl)
+                                            ? inflateToBlob(*download, data)
+                                            : writeToBlob(*download, data);
+                    if ( !ok ) return;
+                    if ( complete || data.size > 0 ) notifyBlobProgress(*download, complete);
+                    if ( complete ) finishBlob(*download);
+                }
+            }
+        });
+    }
+
+    // Received a blob's chunk manifest. Copies the chunks the local store already has, and
+    // requests the rest one at a time, so only the parts of the blob that changed are transferred.
+    void IncomingRev::gotChunkManifest(BlobDownload& download, slice manifest) {
+        auto chunks = DecodeChunkManifest(manifest);
+        if ( !chunks ) {
+            blobGotError(download, {LiteCoreDomain, kC4ErrorCorruptData});
+            return;
+        }
+        uint64_t localBytes = 0, totalBytes = TotalChunkLength(*chunks);
+        for ( auto& chunk : *chunks ) {
+            if ( _db->blobStore()->hasChunk(chunk.key) ) localBytes += chunk.length;
+        }
+        logVerbose("Blob has %zu chunks; %" PRIu64 " of %" PRIu64 " bytes are already here", chunks->size(),
+                   localBytes, totalBytes);
+        if ( localBytes < totalBytes / 4 ) {
+            // Not enough to make up for a round-trip per chunk; get the whole blob instead:
+            requestBlob(download, false);
+            return;
+        }
+        download.chunks    = std::move(*chunks);
+        download.nextChunk = 0;
+        fetchNextChunk(download);
+    }
+
+    void IncomingRev::fetchNextChunk(BlobDownload& download) {
+        C4BlobStore* blobStore = _db->blobStore();
+        for ( ; download.nextChunk < download.chunks.size(); ++download.nextChunk ) {
+            C4BlobKey chunkKey = download.chunks[download.nextChunk].key;
+            if ( alloc_slice data = blobStore->getChunkContents(chunkKey); data ) {
+                if ( !writeToBlob(download, data) ) return;
+                continue;
+            }
+
+            MessageBuilder req("getAttachmentChunk"_sl);
+            assignCollectionToMsg(req, collectionIndex());
+            req["digest"_sl] = chunkKey.digestString();
+            if ( download.blob->compressible ) req["compress"_sl] = "true"_sl;
+            sendRequest(req, [=, id = download.id](const blip::MessageProgress& progress) {
+                BlobDownload* download = findDownload(id);
+                if ( !download ) return;
                 if ( progress.state == MessageProgress::kDisconnected ) {
-                    // Set some error, so my IncomingRev will know I didn't complete [CBL-608]
-                    blobGotError({POSIXDomain, ECONNRESET});
-                } else if ( progress.reply ) {
+                    blobGotError(*download, {POSIXDomain, ECONNRESET});
+                } else if ( progress.state == MessageProgress::kComplete ) {
                     if ( progress.reply->isError() ) {
                         auto err = progress.reply->getError();
                         logError("Got error response: %.*s %d '%.*s'", SPLAT(err.domain), err.code, SPLAT(err.message));
-                        blobGotError(blipToC4Error(err));
-                    } else {
-                        bool complete = progress.state == MessageProgress::kComplete;
-                        auto data     = progress.reply->extractBody();
-                        writeToBlob(data);
-                        if ( complete || data.size > 0 ) notifyBlobProgress(complete);
-                        if ( complete ) finishBlob();
+                        blobGotError(*download, blipToC4Error(err));
+                        return;
+                    }
+                    alloc_slice data = progress.reply->body();
+                    if ( C4BlobKey::computeDigestOfContent(data) != chunkKey ) {
+                        blobGotError(*download, {LiteCoreDomain, kC4ErrorCorruptData});
+                        return;
                     }
+                    if ( !writeToBlob(*download, data) ) return;
+                    notifyBlobProgress(*download, false);
+                    ++download->nextChunk;
+                    fetchNextChunk(*download);
                 }
-            }
-        });
-        return true;
+            });
+            return;
+        }
+
+        // All the chunks are written; installing the blob verifies its digest:
+        download.chunks.clear();
+        notifyBlobProgress(download, true);
+        finishBlob(download);
     }
 
-    // Writes data to the blob on disk.
-    void IncomingRev::writeToBlob(const alloc_slice& data) {
+    // Writes data to the blob on disk. On failure, fails the revision and returns false.
+    bool IncomingRev::writeToBlob(BlobDownload& download, slice data) {
         try {
-            if ( _writer == nullptr ) {
-                _writer = make_unique<C4WriteStream>(*_db->blobStore());
+            if ( download.writer == nullptr ) {
+                download.writer = make_unique<C4WriteStream>(*_db->blobStore());
 #if DEBUG
                 int n = ++sNumOpenWriters;
                 if ( n > sMaxOpenWriters ) {
@@ -99,46 +215,71 @@ namespace litecore::repl {
 #endif
             }
             if ( data.size > 0 ) {
-                _writer->write(data);
-                _blobBytesWritten += data.size;
+                download.writer->write(data);
+                download.bytesWritten += data.size;
                 addProgress({data.size, 0});
             }
-        } catch ( ... ) { blobGotError(C4Error::fromCurrentException()); }
+            return true;
+        } catch ( ... ) {
+            blobGotError(download, C4Error::fromCurrentException());
+            return false;
+        }
+    }
+
+    // Decodes blob data that the peer sent in DEFLATE format, and writes it to the blob.
+    bool IncomingRev::inflateToBlob(BlobDownload& download, slice data) {
+        try {
+            if ( !download.inflater ) download.inflater = make_unique<blip::Inflater>();
+            slice_istream input(data);
+            uint8_t       buffer[32 * 1024];
+            while ( true ) {
+                slice_ostream output(buffer, sizeof(buffer));
+                size_t        inputSize = input.size;
+                download.inflater->write(input, output, blip::Codec::Mode::NoFlush);
+                slice decoded = output.output();
+                if ( decoded.size > 0 && !writeToBlob(download, decoded) ) return false;
+                if ( input.size == 0 && output.capacity() > 0 ) break;
+                if ( decoded.size == 0 && input.size == inputSize )
+                    C4Error::raise(LiteCoreDomain, kC4ErrorCorruptData, "Invalid DEFLATE-encoded blob data");
+            }
+            return true;
+        } catch ( ... ) {
+            blobGotError(download, C4Error::fromCurrentException());
+            return false;
+        }
     }
 
     // Saves the blob to the database, and starts working on the next one (if any).
-    void IncomingRev::finishBlob() {
-        logVerbose("Finished receiving blob %s (%" PRIu64 " bytes)", _blob->key.digestString().c_str(), _blob->length);
+    void IncomingRev::finishBlob(BlobDownload& download) {
+        const PendingBlob& blob = *download.blob;
+        logVerbose("Finished receiving blob %s (%" PRIu64 " bytes)", blob.key.digestString().c_str(), blob.length);
         try {
-            _writer->install(&_blob->key);
+            download.writer->install(&blob.key);
         } catch ( ... ) {
-            blobGotError(C4Error::fromCurrentException());
+            blobGotError(download, C4Error::fromCurrentException());
             return;
         }
-        closeBlobWriter();
-
-        ++_blob;
-        fetchNextBlob();
+        endDownload(download);
+        fetchBlobs();
     }
 
-    void IncomingRev::blobGotError(C4Error err) {
-        closeBlobWriter();
-        // Bump bytes-completed to end so as not to mess up overall progress:
-        addProgress({_blob->length - _blobBytesWritten, 0});
+    // Fails the revision, abandoning all its downloads.
+    void IncomingRev::blobGotError(BlobDownload&, C4Error err) {
+        abortBlobDownloads();
         failWithError(err);
     }
 
     // Sends periodic notifications to the Replicator if desired.
-    void IncomingRev::notifyBlobProgress(bool always) {
+    void IncomingRev::notifyBlobProgress(const BlobDownload& download, bool always) {
         if ( progressNotificationLevel() < 2 ) return;
         auto now = actor::Timer::clock::now();
         if ( always || now - _lastNotifyTime > 250ms ) {
             _lastNotifyTime = now;
             Replicator::BlobProgress prog{Dir::kPulling,
                                           nullslice,  // TODO: Collection support
-                                          _blob->docID,
-                                          _blob->docProperty,
-                                          _blob->key,
+                                          download.blob->docID,
+                                          download.blob->docProperty,
+                                          download.blob->key,
                                           status().progress.unitsCompleted,
                                           status().progress.unitsTotal};
             logVerbose("blob progress: %" PRIu64 " / %" PRIu64, prog.bytesCompleted, prog.bytesTotal);
@@ -146,14 +287,29 @@ namespace litecore::repl {
         }
     }
 
-    void IncomingRev::closeBlobWriter() {
+    // Closes a download's blob writer, releases its share of the BlobDownloadBudget, and deletes it.
+    void IncomingRev::endDownload(BlobDownload& download) {
 #if DEBUG
-        if ( _writer ) {
+        if ( download.writer ) {
             int n = --sNumOpenWriters;
             logVerbose("Closed blob writer  [%d open]", n);
         }
 #endif
-        _writer = nullptr;
+        replicator()->blobDownloads().finished(download.blob->key, download.blob->length);
+        auto i = std::find_if(_downloads.begin(), _downloads.end(), [&](auto& d) { return d.get() == &download; });
+        Assert(i != _downloads.end());
+        _downloads.erase(i);
+    }
+
+    // Stops all downloads in progress; any further replies to their requests will be ignored.
+    void IncomingRev::abortBlobDownloads() {
+        _blobsToFetch.clear();
+        while ( !_downloads.empty() ) {
+            BlobDownload& download = *_downloads.back();
+            // Bump bytes-completed to end so as not to mess up overall progress:
+            addProgress({download.blob->length - download.bytesWritten, 0});
+            endDownload(download);
+        }
     }
 
 }  // namespace litecore::repl
@@ -43,8 +43,8 @@ namespace litecore::repl {
         Signpost::begin(Signpost::handlingRev, _serialNumber);
         _parent                = _puller;  // Necessary because Worker clears _parent when first completed
         _provisionallyInserted = false;
-        DebugAssert(_pendingCallbacks == 0 && !_writer && _pendingBlobs.empty());
-        _blob = _pendingBlobs.end();
+        DebugAssert(_pendingCallbacks == 0 && _downloads.empty() && _pendingBlobs.empty());
+        _waitingForBlobDownloads = false;
     }
 
     // Read the 'rev' message, then parse either synchronously or asynchronously.
@@ -237,20 +237,19 @@ namespace litecore::repl {
                 _rev->flags |= kRevHasAttachments;
                 _pendingBlobs.push_back({_rev->docID, alloc_slice(FLDeepIterator_GetPathString(i)), key,
                                          blob["length"_sl].asUnsigned(), C4Blob::isLikelyCompressible(blob)});
-                _blob = _pendingBlobs.begin();
             });
         }
 
         // Call the custom validation function if any:
         if ( !performPullValidation(root) ) {
             _pendingBlobs.clear();
-            _blob = _pendingBlobs.end();
             return;
         }
 
-        // Request the first blob, or if there are none, insert the revision into the DB:
+        // Request the blobs, or if there are none, insert the revision into the DB:
         if ( !_pendingBlobs.empty() ) {
-            fetchNextBlob();
+            for ( auto& blob : _pendingBlobs ) _blobsToFetch.push_back(&blob);
+            fetchBlobs();
         } else {
             insertRevision();
         }
@@ -271,7 +270,7 @@ namespace litecore::repl {
 
     // Asks the Inserter (via the Puller) to insert the revision into the database.
     void IncomingRev::insertRevision() {
-        Assert(_blob == _pendingBlobs.end());
+        Assert(_blobsToFetch.empty() && _downloads.empty());
         Assert(_rev->error.code == 0);
         Assert(_rev->deltaSrc || _rev->doc || _rev->revocationMode != RevocationMode::kNone);
         increment(_pendingCallbacks);
@@ -329,9 +328,8 @@ namespace litecore::repl {
 
         // Free up memory now that I'm done:
         Assert(_pendingCallbacks == 0);
-        closeBlobWriter();
+        abortBlobDownloads();
         _pendingBlobs.clear();
-        _blob = _pendingBlobs.end();
         _rev->trim();
 
         _puller->revWasHandled(this);
@@ -345,7 +343,8 @@ namespace litecore::repl {
     }
 
     Worker::ActivityLevel IncomingRev::computeActivityLevel() const {
-        if ( Worker::computeActivityLevel() == kC4Busy || _pendingCallbacks > 0 || (_blob != _pendingBlobs.end()) ) {
+        if ( Worker::computeActivityLevel() == kC4Busy || _pendingCallbacks > 0 || !_blobsToFetch.empty()
+             || !_downloads.empty() ) {
             return kC4Busy;
         } else {
             return kC4Stopped;
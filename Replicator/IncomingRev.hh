@@ -12,6 +12,8 @@
 
 #pragma once
 #include "Worker.hh"
+#include "BlobChunker.hh"
+#include "Codec.hh"
 #include "ReplicatorTypes.hh"
 #include "RemoteSequence.hh"
 #include "Timer.hh"
@@ -63,13 +65,30 @@ namespace litecore::repl {
         void        finish();
 
         // blob stuff:
-        void fetchNextBlob();
-        bool startBlob();
-        void writeToBlob(const fleece::alloc_slice&);
-        void finishBlob();
-        void blobGotError(C4Error);
-        void notifyBlobProgress(bool always);
-        void closeBlobWriter();
+        struct BlobDownload {
+            unsigned                        id;
+            const PendingBlob*              blob;  // Points into _pendingBlobs
+            std::unique_ptr<C4WriteStream>  writer;
+            std::unique_ptr<blip::Inflater> inflater;  // Decodes blob data sent DEFLATE-encoded
+            uint64_t                        bytesWritten{};
+            std::vector<BlobChunk>          chunks;       // Chunks of the blob, if fetching by chunk
+            size_t                          nextChunk{};  // Index in chunks of the next to fetch
+        };
+
+        void          fetchBlobs();
+        void          _blobDownloadFinished(Retained<RevToInsert>);
+        void          startDownload(const PendingBlob&);
+        BlobDownload* findDownload(unsigned id);
+        void          requestBlob(BlobDownload&, bool chunked);
+        void          gotChunkManifest(BlobDownload&, slice manifest);
+        void          fetchNextChunk(BlobDownload&);
+        bool          writeToBlob(BlobDownload&, slice);
+        bool          inflateToBlob(BlobDownload&, slice);
+        void          finishBlob(BlobDownload&);
+        void          blobGotError(BlobDownload&, C4Error);
+        void          notifyBlobProgress(const BlobDownload&, bool always);
+        void          endDownload(BlobDownload&);
+        void          abortBlobDownloads();
 
         Puller*                   _puller;
         Retained<blip::MessageIn> _revMessage;
@@ -80,14 +99,15 @@ namespace litecore::repl {
         uint32_t                  _serialNumber{0};
         std::atomic<bool>         _provisionallyInserted{false};
         // blob stuff:
-        std::vector<PendingBlob>                 _pendingBlobs;
-        std::vector<PendingBlob>::const_iterator _blob;
-        std::unique_ptr<C4WriteStream>           _writer;
-        uint64_t                                 _blobBytesWritten{};
-        actor::Timer::time                       _lastNotifyTime;
-        bool                                     _mayContainBlobs{};
-        bool                                     _mayContainEncryptedProperties{};
-        uint64_t                                 _bodySize{};
+        std::vector<PendingBlob>                   _pendingBlobs;
+        std::vector<const PendingBlob*>            _blobsToFetch;  // Blobs not downloaded or started yet
+        std::vector<std::unique_ptr<BlobDownload>> _downloads;     // Downloads in progress
+        unsigned                                   _lastDownloadID{0};
+        bool                                       _waitingForBlobDownloads{};  // Registered w/ BlobDownloadBudget?
+        actor::Timer::time                         _lastNotifyTime;
+        bool                                       _mayContainBlobs{};
+        bool                                       _mayContainEncryptedProperties{};
+        uint64_t                                   _bodySize{};
     };
 
 }  // namespace litecore::repl
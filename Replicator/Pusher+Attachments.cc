@@ -93,9 +93,32 @@ namespace litecore::repl {
         unique_ptr<C4ReadStream> blob = readBlobFromRequest(req, digest, progress);
         if ( !blob ) return;
 
+        if ( req->boolProperty("chunks"_sl) ) {
+            // The peer would rather get the chunk manifest, if the blob is stored in chunks, so it
+            // can request only the chunks it doesn't have:
+            if ( alloc_slice manifest = _db->blobStore()->getChunkManifest(progress.key); manifest ) {
+                logVerbose("Sending chunk manifest of blob %.*s", SPLAT(digest));
+                MessageBuilder reply(req);
+                reply["chunked"_sl] = "true"_sl;
+                reply.write(manifest);
+                req->respond(reply);
+                return;
+            }
+        }
+
         increment(_blobsInFlight);
         MessageBuilder reply(req);
         reply.compressed = req->boolProperty("compress"_sl);
+        if ( req->boolProperty("deflate"_sl) ) {
+            // The peer accepts DEFLATE-encoded data, so if the blob is stored compressed, send that
+            // as-is instead of decompressing it and having BLIP compress it again:
+            if ( auto compressed = _db->blobStore()->openCompressedReadStream(progress.key); compressed ) {
+                blob                 = std::move(compressed);
+                progress.bytesTotal  = blob->getLength();
+                reply["encoding"_sl] = "deflate"_sl;
+                reply.compressed     = false;
+            }
+        }
         logVerbose("Sending blob %.*s (length=%" PRId64 ", compress=%d)", SPLAT(digest), blob->getLength(),
                    reply.compressed);
         Retained<Replicator> repl = replicator();
@@ -107,6 +130,23 @@ namespace litecore::repl {
 
     void Pusher::_attachmentSent() { decrement(_blobsInFlight); }
 
+    // Incoming request for one chunk of a blob that's stored in chunks:
+    void Pusher::handleGetAttachmentChunk(Retained<MessageIn> req) {
+        try {
+            slice digest = req->property("digest"_sl);
+            auto  key    = C4BlobKey::withDigestString(digest);
+            if ( !key ) C4Error::raise(LiteCoreDomain, kC4ErrorInvalidParameter, "Missing or invalid 'digest'");
+            alloc_slice data = _db->blobStore()->getChunkContents(*key);
+            if ( !data ) C4Error::raise(LiteCoreDomain, kC4ErrorNotFound, "No such blob chunk");
+
+            logVerbose("Sending blob chunk %.*s (length=%zu)", SPLAT(digest), data.size);
+            MessageBuilder reply(req);
+            reply.compressed = req->boolProperty("compress"_sl);
+            reply.write(data);
+            req->respond(reply);
+        } catch ( ... ) { req->respondWithError(c4ToBLIPError(C4Error::fromCurrentException())); }
+    }
+
     // Incoming request to prove I have an attachment that I'm pushing, without sending it:
     void Pusher::handleProveAttachment(Retained<MessageIn> request) {
         slice                    digest;
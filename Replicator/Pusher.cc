@@ -44,6 +44,7 @@ namespace litecore::repl {
         replicator->registerWorkerHandler(this, "subChanges", &Pusher::handleSubChanges);
         replicator->registerWorkerHandler(this, "getAttachment", &Pusher::handleGetAttachment);
         replicator->registerWorkerHandler(this, "proveAttachment", &Pusher::handleProveAttachment);
+        replicator->registerWorkerHandler(this, "getAttachmentChunk", &Pusher::handleGetAttachmentChunk);
     }
 
     // Begins active push, starting from the next sequence after sinceSequence
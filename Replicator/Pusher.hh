@@ -88,6 +88,7 @@ namespace litecore::repl {
         // Pusher+Attachments.cc:
         void                     handleGetAttachment(Retained<blip::MessageIn>);
         void                     handleProveAttachment(Retained<blip::MessageIn>);
+        void                     handleGetAttachmentChunk(Retained<blip::MessageIn>);
         void                     _attachmentSent();
         unique_ptr<C4ReadStream> readBlobFromRequest(blip::MessageIn* req NONNULL, slice& outDigest,
                                                      Replicator::BlobProgress& outProgress);
@@ -69,7 +69,8 @@ namespace litecore::repl {
         : Worker(new Connection(webSocket, options->properties, {}), nullptr, options, db, "Repl", kNotCollectionIndex)
         , _delegate(&delegate)
         , _connectionState(connection().state())
-        , _docsEnded(this, "docsEnded", &Replicator::notifyEndedDocuments, tuning::kMinDocEndedInterval, 100) {
+        , _docsEnded(this, "docsEnded", &Replicator::notifyEndedDocuments, tuning::kMinDocEndedInterval, 100)
+        , _blobDownloads(tuning::kMaxBlobDownloads, tuning::kMaxBlobDownloadBytes) {
         try {
             // Post-conditions:
             //   collectionOpts.size() > 0
@@ -92,6 +93,7 @@ namespace litecore::repl {
             // it dispatches the message to appropriate workers.
             for ( auto profile : {
                           "subChanges", "getAttachment", "proveAttachment",  // passive pushers
+                          "getAttachmentChunk",
                           "changes", "proposeChanges", "rev", "norev"        // passive pullers
                   } ) {
                 registerHandler(profile, &Replicator::delegateCollectionSpecificMessageToWorker);
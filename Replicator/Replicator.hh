@@ -12,6 +12,7 @@
 
 #pragma once
 #include "Worker.hh"
+#include "BlobDownloadBudget.hh"
 #include "Checkpointer.hh"
 #include "BLIPConnection.hh"
 #include "Batcher.hh"
@@ -103,6 +104,9 @@ namespace litecore::repl {
 
         void docRemoteAncestorChanged(alloc_slice docID, alloc_slice revID, CollectionIndex);
 
+        /** Limits the blob downloads that IncomingRevs can have in progress at once. */
+        BlobDownloadBudget& blobDownloads() { return _blobDownloads; }
+
         Retained<Replicator> replicatorIfAny() override { return this; }
 
         // exposed for unit tests:
@@ -252,6 +256,7 @@ namespace litecore::repl {
         bool                  _waitingToCallDelegate{};  // Is an async call to reportStatus pending?
         ReplicatedRevBatcher  _docsEnded;                // Recently-completed revs
         vector<SubReplicator> _subRepls;
+        BlobDownloadBudget    _blobDownloads;  // Shared by all IncomingRevs
         bool                  _getCollectionsRequested{};  // True while "getCollections" request pending
         alloc_slice           _remoteURL;
         bool                  _setMsgHandlerFor3_0_ClientDone{false};
@@ -12,6 +12,7 @@
 
 #pragma once
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 
 namespace litecore::repl::tuning {
@@ -54,6 +55,14 @@ namespace litecore::repl::tuning {
            (and are thus holding onto the document bodies in memory.) */
     constexpr unsigned kMaxActiveIncomingRevs = 100;
 
+    /* Maximum number of blobs (attachments) being downloaded at once, over all IncomingRevs.
+           Each one has a request in flight and a blob file open for writing. */
+    constexpr unsigned kMaxBlobDownloads = 8;
+
+    /* Maximum total length of the blobs being downloaded at once. A single blob larger than
+           this can still be downloaded, but only by itself. */
+    constexpr uint64_t kMaxBlobDownloadBytes = 16 * 1024 * 1024;
+
 
     //// Pusher:
 
@@ -727,6 +727,40 @@ TEST_CASE_METHOD(ReplicatorLoopbackTest, "Pull Lots Of Attachments", "[Pull][blo
     CHECK(_blobPullProgressCallbacks >= kNumDocs * kNumBlobsPerDoc);
 }
 
+TEST_CASE_METHOD(ReplicatorLoopbackTest, "Pull Attachment-Heavy Docs Benchmark", "[Perf][.slow][Pull][blob]") {
+    // Each doc has some blobs of its own, plus one that's shared with other docs:
+    static const int    kNumDocs = 500, kNumBlobsPerDoc = 4, kNumSharedBlobs = 20;
+    static const size_t kBlobSize = 50000;
+    Log("Creating %d docs, with %d blobs of %zu bytes each ...", kNumDocs, kNumBlobsPerDoc, kBlobSize);
+    {
+        TransactionHelper t(db);
+        for ( int iDoc = 0; iDoc < kNumDocs; ++iDoc ) {
+            vector<string> attachments;
+            for ( int iAtt = 0; iAtt < kNumBlobsPerDoc - 1; iAtt++ ) {
+                string att = format("doc#%d attachment #%d ", iDoc, iAtt);
+                att.resize(kBlobSize, char('a' + (iDoc + iAtt) % 26));
+                attachments.push_back(att);
+            }
+            string shared = format("shared attachment #%d ", iDoc % kNumSharedBlobs);
+            shared.resize(kBlobSize, '*');
+            attachments.push_back(shared);
+            string docID = format("doc%03d", iDoc);
+            addDocWithAttachments(db, _collSpec, slice(docID), attachments, "application/octet-stream");
+            ++_expectedDocumentCount;
+        }
+    }
+
+    Stopwatch st;
+    runPullReplication();
+    double time = st.elapsed();
+    size_t nBlobs = kNumDocs * (kNumBlobsPerDoc - 1) + kNumSharedBlobs;
+    Log("Pulled %d docs with %zu distinct blobs in %.3f sec (%.1f MB/sec)", kNumDocs, nBlobs, time,
+        double(nBlobs * kBlobSize) / time / 1.0e6);
+
+    compareDatabases();
+    validateCheckpoints(db2, db, format("{\"remote\":%d}", kNumDocs).c_str());
+}
+
 TEST_CASE_METHOD(ReplicatorLoopbackTest, "Push Uncompressible Blob", "[Push][blob]") {
     // Test case for issue #354
     alloc_slice       image       = readFile(sFixturesDir + "for#354.jpg");
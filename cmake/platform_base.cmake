@@ -31,15 +31,19 @@ function(set_litecore_source_base)
         Crypto/PublicKey.cc
         Crypto/SecureDigest.cc
         Crypto/SecureSymmetricCrypto.cc
+        LiteCore/BlobStore/BlobChunker.cc
         LiteCore/BlobStore/BlobStreams.cc
         LiteCore/BlobStore/Stream.cc
         LiteCore/Database/BackgroundDB.cc
+        LiteCore/Database/BlobReferences.cc
         LiteCore/Database/DatabaseImpl.cc
         LiteCore/Database/DatabaseImpl+Upgrade.cc
+        LiteCore/Database/DatabaseMaintainer.cc
         LiteCore/Database/Housekeeper.cc
         LiteCore/Database/LegacyAttachments.cc
         LiteCore/Database/LiveQuerier.cc
         LiteCore/Database/PrebuiltCopier.cc
+        LiteCore/Database/ReadConnectionPool.cc
         LiteCore/Database/SequenceTracker.cc
         LiteCore/Database/TreeDocument.cc
         LiteCore/Database/Upgrader.cc
@@ -53,6 +57,7 @@ function(set_litecore_source_base)
         LiteCore/Query/SQLiteFleeceEach.cc
         LiteCore/Query/SQLiteFleeceFunctions.cc
         LiteCore/Query/SQLiteFleeceUtil.cc
+        LiteCore/Query/SQLiteFTS5Extensions.cc
         LiteCore/Query/SQLiteFTSRankFunction.cc
         LiteCore/Query/SQLiteKeyStore+ArrayIndexes.cc
         LiteCore/Query/SQLiteKeyStore+FTSIndexes.cc
@@ -73,6 +78,7 @@ function(set_litecore_source_base)
         LiteCore/RevTrees/VersionVector.cc
         LiteCore/Storage/BothKeyStore.cc
         LiteCore/Storage/DataFile.cc
+        LiteCore/Storage/DocumentKeys.cc
         LiteCore/Storage/KeyStore.cc
         LiteCore/Storage/Record.cc
         LiteCore/Storage/RecordEnumerator.cc
@@ -90,6 +96,7 @@ function(set_litecore_source_base)
         vendor/SQLiteCpp/src/Transaction.cpp
         Replicator/c4Replicator.cc
         Replicator/c4Replicator_CAPI.cc
+        Replicator/BlobDownloadBudget.cc
         Replicator/c4Socket.cc
         Replicator/ChangesFeed.cc
         Replicator/Checkpoint.cc
@@ -114,6 +121,7 @@ function(set_litecore_source_base)
         LiteCore/Support/Error.cc
         LiteCore/Support/EncryptedStream.cc
         LiteCore/Support/FilePath.cc
+        LiteCore/Support/LogArgs.cc
         LiteCore/Support/LogDecoder.cc
         LiteCore/Support/LogEncoder.cc
         LiteCore/Support/PlatformIO.cc